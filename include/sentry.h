@@ -1836,6 +1836,32 @@ SENTRY_API void sentry_options_set_crash_reporting_mode(
 SENTRY_API sentry_crash_reporting_mode_t
 sentry_options_get_crash_reporting_mode(const sentry_options_t *opts);
 
+/**
+ * Enables a crash daemon that is shared between processes.
+ *
+ * By default, every process that starts the `native` backend spawns its own
+ * crash daemon. With this enabled, the processes of the same user that use
+ * the same database path and DSN register with a single daemon instead. The
+ * first of them starts it, and it keeps running while any of them is alive.
+ * This saves a daemon per process in services with many worker processes,
+ * and crashes of different processes are processed concurrently.
+ *
+ * The shared daemon sends crashes with the transport settings of the process
+ * that started it. If it cannot be reached, the process falls back to a
+ * daemon of its own.
+ *
+ * This setting only has an effect when using the `native` backend on Linux.
+ * It is disabled by default.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_crash_daemon_shared(
+    sentry_options_t *opts, int enabled);
+
+/**
+ * Returns whether the crash daemon is shared between processes.
+ */
+SENTRY_EXPERIMENTAL_API int sentry_options_get_crash_daemon_shared(
+    const sentry_options_t *opts);
+
 /**
  * Enables a wait for the crash report upload to be finished before shutting
  * down. This is disabled by default.
@@ -2351,6 +2377,114 @@ SENTRY_EXPERIMENTAL_API void sentry_options_set_http_retry(
 SENTRY_EXPERIMENTAL_API int sentry_options_get_http_retry(
     const sentry_options_t *opts);
 
+/**
+ * Sets the number of requests that the HTTP transport sends concurrently.
+ *
+ * Envelopes are distributed over the transport threads by their data
+ * category, so that a slow request, for example with a large attachment, does
+ * not hold back logs, metrics or sessions. Envelopes of the same category are
+ * still sent one after the other, in order.
+ *
+ * Only applicable for the curl transport. Values above 8 are capped.
+ *
+ * Defaults to 1. Setting 0 restores the default.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_http_concurrency(
+    sentry_options_t *opts, size_t concurrency);
+SENTRY_EXPERIMENTAL_API size_t sentry_options_get_http_concurrency(
+    const sentry_options_t *opts);
+
+/**
+ * Sets the number of envelopes that each HTTP transport thread can queue.
+ *
+ * Errors and sessions are sent before transactions, which are sent before
+ * logs and metrics. Once the queue is full, envelopes with the lowest
+ * priority are dropped to make room for more important ones, and recorded as
+ * `queue_overflow` in client reports. Dropped envelopes are not written to
+ * disk, which includes those that are left over from a previous run and
+ * submitted all at once on startup.
+ *
+ * Only applicable for HTTP transports.
+ *
+ * Defaults to 0, which does not limit the queue.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_http_queue_capacity(
+    sentry_options_t *opts, size_t capacity);
+SENTRY_EXPERIMENTAL_API size_t sentry_options_get_http_queue_capacity(
+    const sentry_options_t *opts);
+
+/**
+ * Sets the maximum size in bytes of an envelope that the HTTP transport
+ * combines from queued envelopes.
+ *
+ * Before sending an envelope with logs, metrics, sessions or client reports,
+ * the transport merges other queued envelopes of these kinds into it, so that
+ * they are all sent with a single request. Envelopes with events,
+ * transactions or attachments are always sent on their own.
+ *
+ * Only applicable for HTTP transports.
+ *
+ * Defaults to 0, which disables coalescing.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_http_coalesce_size(
+    sentry_options_t *opts, size_t size);
+SENTRY_EXPERIMENTAL_API size_t sentry_options_get_http_coalesce_size(
+    const sentry_options_t *opts);
+
+/**
+ * Sets the time in milliseconds that the HTTP transport holds back envelopes
+ * that can be coalesced, to wait for more of them to be queued. See
+ * `sentry_options_set_http_coalesce_size`.
+ *
+ * Defaults to 0, which only coalesces envelopes that are already queued.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_http_coalesce_delay(
+    sentry_options_t *opts, uint64_t delay_ms);
+SENTRY_EXPERIMENTAL_API uint64_t sentry_options_get_http_coalesce_delay(
+    const sentry_options_t *opts);
+
+/**
+ * The codecs that the HTTP transport can compress request bodies with.
+ */
+typedef enum {
+    SENTRY_HTTP_COMPRESSION_NONE = 0,
+    SENTRY_HTTP_COMPRESSION_GZIP = 1,
+    SENTRY_HTTP_COMPRESSION_ZSTD = 2,
+} sentry_http_compression_t;
+
+/**
+ * Sets the codec and level that the HTTP transport compresses request bodies
+ * with. A `level` of 0 uses the default level of the codec, otherwise it is
+ * passed on to the codec: 1 to 9 for gzip, and 1 to 19 for zstd, with higher
+ * levels trading CPU time for smaller bodies.
+ *
+ * gzip is only available if the SDK is built with
+ * `SENTRY_TRANSPORT_COMPRESSION`, zstd only if it is built with
+ * `SENTRY_TRANSPORT_ZSTD`. If the codec is not available, zstd falls back to
+ * gzip, and gzip to sending bodies uncompressed.
+ *
+ * Only applicable for HTTP transports.
+ *
+ * Defaults to gzip at its default level.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_http_compression(
+    sentry_options_t *opts, sentry_http_compression_t codec, int level);
+SENTRY_EXPERIMENTAL_API sentry_http_compression_t
+sentry_options_get_http_compression(const sentry_options_t *opts);
+
+/**
+ * Sets the size in bytes below which request bodies are sent uncompressed, as
+ * compressing them costs more than it saves.
+ *
+ * Only applicable for HTTP transports.
+ *
+ * Defaults to 128.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_http_compression_threshold(
+    sentry_options_t *opts, size_t threshold);
+SENTRY_EXPERIMENTAL_API size_t sentry_options_get_http_compression_threshold(
+    const sentry_options_t *opts);
+
 /**
  * Enables or disables out-of-band upload of large attachments.
  *
@@ -2384,6 +2518,25 @@ SENTRY_EXPERIMENTAL_API void sentry_options_set_logs_with_attributes(
 SENTRY_EXPERIMENTAL_API int sentry_options_get_logs_with_attributes(
     const sentry_options_t *opts);
 
+/**
+ * Enables or disables deferred formatting of structured logs.
+ *
+ * When enabled, `sentry_log_X()` only captures the format string, its
+ * arguments and the current scope attributes on the calling thread. Formatting
+ * the message and extracting the message parameters is done on the batching
+ * thread when the logs are flushed.
+ *
+ * Logs are formatted eagerly regardless of this option when a
+ * `before_send_log` hook is set, debug output is enabled, or the format string
+ * uses `*` width/precision, positional arguments, `%n` or wide characters.
+ *
+ * Disabled by default.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_logs_deferred(
+    sentry_options_t *opts, int logs_deferred);
+SENTRY_EXPERIMENTAL_API int sentry_options_get_logs_deferred(
+    const sentry_options_t *opts);
+
 /**
  * Enables or disables client reports.
  *
@@ -2507,6 +2660,58 @@ SENTRY_EXPERIMENTAL_API void sentry_options_set_enable_metrics(
 SENTRY_EXPERIMENTAL_API int sentry_options_get_enable_metrics(
     const sentry_options_t *opts);
 
+/**
+ * Sets the number of items that each internal log and metric buffer can hold.
+ *
+ * Logs and metrics are buffered per producer thread group and sent in batches.
+ * Items which don't fit into the buffers until the next flush are dropped and
+ * recorded as `queue_overflow` in client reports.
+ *
+ * Defaults to 100. Setting 0 restores the default.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_batch_capacity(
+    sentry_options_t *opts, size_t capacity);
+SENTRY_EXPERIMENTAL_API size_t sentry_options_get_batch_capacity(
+    const sentry_options_t *opts);
+
+/**
+ * Sets the maximum size in bytes of the serialized payload of a single log or
+ * metric batch. Larger batches are split into multiple envelopes.
+ *
+ * Defaults to 1 MiB. Setting 0 disables the limit.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_batch_max_bytes(
+    sentry_options_t *opts, size_t max_bytes);
+SENTRY_EXPERIMENTAL_API size_t sentry_options_get_batch_max_bytes(
+    const sentry_options_t *opts);
+
+/**
+ * Sets the interval in milliseconds after which partially filled log and
+ * metric buffers are flushed.
+ *
+ * Defaults to 5000. Setting 0 restores the default.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_batch_flush_interval(
+    sentry_options_t *opts, uint64_t interval_ms);
+SENTRY_EXPERIMENTAL_API uint64_t sentry_options_get_batch_flush_interval(
+    const sentry_options_t *opts);
+
+/**
+ * Enables or disables adaptive batching of logs and metrics.
+ *
+ * When enabled, batches start at 100 items and double in size every time a
+ * buffer fills up before the flush interval expires, up to the configured
+ * `batch_capacity`. Once the load subsides, the batch size shrinks again.
+ * Under sustained load, this results in fewer, larger envelopes. Use together
+ * with a `batch_capacity` above the default.
+ *
+ * Disabled by default.
+ */
+SENTRY_EXPERIMENTAL_API void sentry_options_set_batch_adaptive(
+    sentry_options_t *opts, int adaptive);
+SENTRY_EXPERIMENTAL_API int sentry_options_get_batch_adaptive(
+    const sentry_options_t *opts);
+
 /**
  * Type of the `before_send_metric` callback.
  *
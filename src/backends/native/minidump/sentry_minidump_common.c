@@ -9,10 +9,168 @@
 #    include "sentry_minidump_format.h"
 
 #    include <errno.h>
+#    include <fcntl.h>
 #    include <string.h>
 #    include <time.h>
 #    include <unistd.h>
 
+/**
+ * Size of the write-combining buffer. Records that do not fit are written to
+ * the file directly.
+ */
+#    define MINIDUMP_BUFFER_SIZE (256 * 1024)
+
+struct minidump_buffer_s {
+    uint8_t *data;
+    size_t len;
+};
+
+/**
+ * Writes all of `iov` at `offset`, independent of the file position.
+ */
+static bool
+pwritev_all(int fd, struct iovec *iov, int iov_count, uint64_t offset)
+{
+    while (iov_count > 0) {
+#    if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+        ssize_t n = pwritev(fd, iov, iov_count, (off_t)offset);
+#    else
+        ssize_t n = pwrite(fd, iov->iov_base, iov->iov_len, (off_t)offset);
+#    endif
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            SENTRY_WARNF("minidump write failed: %s", strerror(errno));
+            return false;
+        }
+        offset += (uint64_t)n;
+        size_t left = (size_t)n;
+        while (iov_count > 0 && left >= iov->iov_len) {
+            left -= iov->iov_len;
+            iov++;
+            iov_count--;
+        }
+        if (left > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + left;
+            iov->iov_len -= left;
+        }
+    }
+    return true;
+}
+
+int
+sentry__minidump_buffer_begin(
+    minidump_writer_base_t *writer, uint64_t size_hint)
+{
+#    if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+    if (size_hint > 0 && fallocate(writer->fd, 0, 0, (off_t)size_hint) != 0) {
+        // not supported by every filesystem, the file grows as it is written
+        SENTRY_DEBUGF("minidump preallocation failed: %s", strerror(errno));
+    }
+#    else
+    (void)size_hint;
+#    endif
+
+    minidump_buffer_t *buffer = SENTRY_MAKE(minidump_buffer_t);
+    if (!buffer) {
+        return -1;
+    }
+    buffer->data = sentry_malloc(MINIDUMP_BUFFER_SIZE);
+    if (!buffer->data) {
+        sentry_free(buffer);
+        return -1;
+    }
+    buffer->len = 0;
+    writer->buffer = buffer;
+    return 0;
+}
+
+int
+sentry__minidump_buffer_flush(minidump_writer_base_t *writer)
+{
+    minidump_buffer_t *buffer = writer->buffer;
+    if (!buffer || buffer->len == 0) {
+        return 0;
+    }
+    // the staged records end at the current offset
+    struct iovec iov = { buffer->data, buffer->len };
+    uint64_t offset = writer->current_offset - buffer->len;
+    buffer->len = 0;
+    return pwritev_all(writer->fd, &iov, 1, offset) ? 0 : -1;
+}
+
+int
+sentry__minidump_buffer_end(minidump_writer_base_t *writer)
+{
+    minidump_buffer_t *buffer = writer->buffer;
+    if (!buffer) {
+        return 0;
+    }
+    int rv = sentry__minidump_buffer_flush(writer);
+    if (ftruncate(writer->fd, (off_t)writer->current_offset) != 0) {
+        SENTRY_WARNF("minidump truncate failed: %s", strerror(errno));
+        rv = -1;
+    }
+    sentry_free(buffer->data);
+    sentry_free(buffer);
+    writer->buffer = NULL;
+    return rv;
+}
+
+int
+sentry__minidump_write_iov(
+    minidump_writer_base_t *writer, struct iovec *iov, int iov_count)
+{
+    if (sentry__minidump_buffer_flush(writer) != 0) {
+        return -1;
+    }
+    size_t size = 0;
+    for (int i = 0; i < iov_count; i++) {
+        size += iov[i].iov_len;
+    }
+    if (!pwritev_all(writer->fd, iov, iov_count, writer->current_offset)) {
+        return -1;
+    }
+    writer->current_offset += size;
+    if (!writer->buffer) {
+        // keep the file position in sync for the unbuffered `write` calls
+        lseek(writer->fd, (off_t)writer->current_offset, SEEK_SET);
+    }
+    return 0;
+}
+
+/**
+ * Stages a record and its padding in the write-combining buffer.
+ */
+static bool
+buffer_write(minidump_writer_base_t *writer, const void *data, size_t size,
+    size_t padding)
+{
+    minidump_buffer_t *buffer = writer->buffer;
+    size_t total = size + padding;
+    if (total > MINIDUMP_BUFFER_SIZE - buffer->len
+        && sentry__minidump_buffer_flush(writer) != 0) {
+        return false;
+    }
+    if (total > MINIDUMP_BUFFER_SIZE) {
+        static const uint8_t zeros[4] = { 0 };
+        struct iovec iov[2] = {
+            { (void *)data, size },
+            { (void *)zeros, padding },
+        };
+        if (!pwritev_all(writer->fd, iov, padding > 0 ? 2 : 1,
+                writer->current_offset)) {
+            return false;
+        }
+    } else {
+        memcpy(buffer->data + buffer->len, data, size);
+        memset(buffer->data + buffer->len + size, 0, padding);
+        buffer->len += total;
+    }
+    writer->current_offset += total;
+    return true;
+}
+
 minidump_rva_t
 sentry__minidump_write_data(
     minidump_writer_base_t *writer, const void *data, size_t size)
@@ -24,6 +182,11 @@ sentry__minidump_write_data(
     }
     minidump_rva_t rva = (minidump_rva_t)writer->current_offset;
 
+    if (writer->buffer) {
+        size_t padding = (4 - ((writer->current_offset + size) % 4)) % 4;
+        return buffer_write(writer, data, size, padding) ? rva : 0;
+    }
+
     ssize_t written = write(writer->fd, data, size);
     if (written != (ssize_t)size) {
         SENTRY_WARNF("minidump write failed: %s", strerror(errno));
@@ -53,9 +216,8 @@ sentry__minidump_write_data(
     return rva;
 }
 
-int
-sentry__minidump_write_header(
-    minidump_writer_base_t *writer, uint32_t stream_count)
+static minidump_header_t
+make_header(uint32_t stream_count)
 {
     minidump_header_t header = {
         .signature = MINIDUMP_SIGNATURE,
@@ -66,6 +228,14 @@ sentry__minidump_write_header(
         .time_date_stamp = (uint32_t)time(NULL),
         .flags = 0,
     };
+    return header;
+}
+
+int
+sentry__minidump_write_header(
+    minidump_writer_base_t *writer, uint32_t stream_count)
+{
+    minidump_header_t header = make_header(stream_count);
 
     // Write directly instead of via write_data to avoid corrupting
     // current_offset. This function is called after seeking back to
@@ -79,6 +249,18 @@ sentry__minidump_write_header(
     return 0;
 }
 
+int
+sentry__minidump_write_directory(minidump_writer_base_t *writer,
+    const minidump_directory_t *directories, uint32_t stream_count)
+{
+    minidump_header_t header = make_header(stream_count);
+    struct iovec iov[2] = {
+        { &header, sizeof(header) },
+        { (void *)directories, stream_count * sizeof(minidump_directory_t) },
+    };
+    return pwritev_all(writer->fd, iov, 2, 0) ? 0 : -1;
+}
+
 /**
  * Decode a UTF-8 sequence and return the Unicode code point.
  * Advances *src past the decoded bytes.
@@ -4,6 +4,13 @@
 #include "sentry_minidump_format.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <sys/uio.h>
+
+/**
+ * Write-combining buffer that small records are staged in, so that the many
+ * small structures of a minidump reach the file in a few large writes.
+ */
+typedef struct minidump_buffer_s minidump_buffer_t;
 
 /**
  * Common minidump writer base structure
@@ -12,6 +19,7 @@
 typedef struct {
     int fd;
     uint64_t current_offset;
+    minidump_buffer_t *buffer;
 } minidump_writer_base_t;
 
 /**
@@ -26,6 +34,49 @@ typedef struct {
 minidump_rva_t sentry__minidump_write_data(
     minidump_writer_base_t *writer, const void *data, size_t size);
 
+/**
+ * Start staging writes in a write-combining buffer. The file is preallocated
+ * to `size_hint` bytes where supported, so that it does not grow with every
+ * write. Without a buffer, all writes go to the file directly.
+ *
+ * @param writer Pointer to writer base
+ * @param size_hint Estimated size of the whole minidump, or 0
+ * @return 0 on success, -1 if writes stay unbuffered
+ */
+int sentry__minidump_buffer_begin(
+    minidump_writer_base_t *writer, uint64_t size_hint);
+
+/**
+ * Write all staged records to the file
+ *
+ * @param writer Pointer to writer base
+ * @return 0 on success, -1 on failure
+ */
+int sentry__minidump_buffer_flush(minidump_writer_base_t *writer);
+
+/**
+ * Flush and free the write-combining buffer, and truncate the file to the
+ * end of the written streams, dropping the unused part of the preallocation.
+ * The file position is undefined afterwards.
+ *
+ * @param writer Pointer to writer base
+ * @return 0 on success, -1 on failure
+ */
+int sentry__minidump_buffer_end(minidump_writer_base_t *writer);
+
+/**
+ * Write a bulk record from several buffers at the current offset, bypassing
+ * the write-combining buffer. Unlike `sentry__minidump_write_data`, this does
+ * not pad the record, callers include their own padding.
+ *
+ * @param writer Pointer to writer base
+ * @param iov Buffers to write, modified on partial writes
+ * @param iov_count Number of buffers
+ * @return 0 on success, -1 on failure
+ */
+int sentry__minidump_write_iov(
+    minidump_writer_base_t *writer, struct iovec *iov, int iov_count);
+
 /**
  * Write minidump header
  *
@@ -36,6 +87,18 @@ minidump_rva_t sentry__minidump_write_data(
 int sentry__minidump_write_header(
     minidump_writer_base_t *writer, uint32_t stream_count);
 
+/**
+ * Write minidump header and stream directory at the start of the file, with a
+ * single write that does not depend on the file position
+ *
+ * @param writer Pointer to writer base
+ * @param directories Directory entries of all streams
+ * @param stream_count Number of streams in the minidump
+ * @return 0 on success, -1 on failure
+ */
+int sentry__minidump_write_directory(minidump_writer_base_t *writer,
+    const minidump_directory_t *directories, uint32_t stream_count);
+
 /**
  * Write UTF-16LE string for minidump
  * Converts UTF-8 string to UTF-16LE with length prefix
@@ -20,11 +20,13 @@
 #    include <unistd.h>
 
 #    include "../../../modulefinder/sentry_modulefinder_linux.h"
+#    include "../sentry_crash_module_cache.h"
 #    include "sentry_alloc.h"
 #    include "sentry_logger.h"
 #    include "sentry_minidump_common.h"
 #    include "sentry_minidump_format.h"
 #    include "sentry_minidump_writer.h"
+#    include "sentry_utils.h"
 
 // NT_PRSTATUS is defined in linux/elf.h but we can't include that
 // because it conflicts with elf.h. Define it here if not available.
@@ -90,6 +92,7 @@ typedef struct {
     // Base fields (must match minidump_writer_base_t layout)
     int fd;
     uint64_t current_offset;
+    minidump_buffer_t *buffer;
 
     // Linux-specific fields
     const sentry_crash_context_t *crash_ctx;
@@ -98,10 +101,9 @@ typedef struct {
     memory_mapping_t mappings[SENTRY_CRASH_MAX_MAPPINGS];
     size_t mapping_count;
 
-    // Threads
-    pid_t tids[SENTRY_CRASH_MAX_THREADS];
-    char thread_names[SENTRY_CRASH_MAX_THREADS]
-                     [16]; // From /proc/[pid]/task/[tid]/comm
+    // Threads, allocated for all tasks of the process
+    pid_t *tids;
+    char (*thread_names)[16]; // From /proc/[pid]/task/[tid]/comm
     size_t thread_count;
 
     // Ptrace state
@@ -379,6 +381,168 @@ read_process_memory(
     return bytes_read;
 }
 
+/**
+ * Upper bound for a single captured range, and the size of the staging buffer
+ * that batches of ranges are read into.
+ */
+#    define MEMORY_CAPTURE_MAX_SIZE (4 * 1024 * 1024)
+
+/**
+ * The number of ranges read with a single `process_vm_readv` call.
+ */
+#    define MEMORY_CAPTURE_MAX_IOV 256
+
+/**
+ * A range of the crashed process's memory to include in the minidump.
+ * All ranges of a stream are planned first, then read in batches with as few
+ * `process_vm_readv` calls as possible and written with a single `pwritev` per
+ * batch. `captured` and `rva` are 0 if the range could not be captured.
+ */
+typedef struct {
+    uint64_t addr;
+    size_t size;
+    size_t captured;
+    minidump_rva_t rva;
+} memory_capture_t;
+
+/**
+ * Reads a batch of ranges into the buffers of `local`. The kernel stops a
+ * vectored read at the first range that cannot be read in full, which is then
+ * read on its own with the ptrace fallback, before the rest of the batch.
+ */
+static void
+read_capture_batch(minidump_writer_t *writer, memory_capture_t *captures,
+    struct iovec *local, struct iovec *remote, size_t count)
+{
+    pid_t tid = writer->crash_ctx->crashed_tid;
+    size_t done = 0;
+    while (done < count) {
+        ssize_t nread = process_vm_readv(
+            tid, local + done, count - done, remote + done, count - done, 0);
+        if (nread < 0 && errno != EFAULT) {
+            // process_vm_readv is unavailable, read everything via ptrace
+            break;
+        }
+        size_t left = nread > 0 ? (size_t)nread : 0;
+        while (done < count && left >= captures[done].size) {
+            captures[done].captured = captures[done].size;
+            left -= captures[done].size;
+            done++;
+        }
+        if (done < count) {
+            ssize_t n = read_process_memory(writer, captures[done].addr,
+                local[done].iov_base, captures[done].size);
+            captures[done].captured = n > 0 ? (size_t)n : 0;
+            done++;
+        }
+    }
+    for (; done < count; done++) {
+        ssize_t n = read_process_memory(writer, captures[done].addr,
+            local[done].iov_base, captures[done].size);
+        captures[done].captured = n > 0 ? (size_t)n : 0;
+    }
+}
+
+/**
+ * Appends the captured part of every range of a batch to the minidump with a
+ * single vectored write, padding each range to the 4-byte alignment that
+ * `write_data` maintains.
+ */
+static void
+write_capture_batch(minidump_writer_t *writer, memory_capture_t *captures,
+    const struct iovec *local, size_t count)
+{
+    static const uint8_t zeros[4] = { 0 };
+    struct iovec iov[MEMORY_CAPTURE_MAX_IOV * 2];
+    int iov_count = 0;
+    uint64_t offset = writer->current_offset;
+
+    for (size_t i = 0; i < count; i++) {
+        memory_capture_t *capture = &captures[i];
+        // RVAs are 32 bit, see `sentry__minidump_write_data`
+        if (capture->captured == 0 || offset > UINT32_MAX) {
+            capture->captured = 0;
+            capture->rva = 0;
+            continue;
+        }
+        capture->rva = (minidump_rva_t)offset;
+        iov[iov_count].iov_base = local[i].iov_base;
+        iov[iov_count++].iov_len = capture->captured;
+        size_t padding = (4 - (capture->captured % 4)) % 4;
+        if (padding > 0) {
+            iov[iov_count].iov_base = (void *)zeros;
+            iov[iov_count++].iov_len = padding;
+        }
+        offset += capture->captured + padding;
+    }
+
+    if (iov_count > 0
+        && sentry__minidump_write_iov(
+               (minidump_writer_base_t *)writer, iov, iov_count)
+            != 0) {
+        for (size_t i = 0; i < count; i++) {
+            captures[i].captured = 0;
+            captures[i].rva = 0;
+        }
+    }
+}
+
+/**
+ * Reads and writes all planned ranges, in batches that fit into a staging
+ * buffer that is reused for all of them.
+ */
+static void
+capture_memory(
+    minidump_writer_t *writer, memory_capture_t *captures, size_t count)
+{
+    size_t staging_size = 0;
+    for (size_t i = 0; i < count; i++) {
+        captures[i].captured = 0;
+        captures[i].rva = 0;
+        staging_size += captures[i].size;
+    }
+    if (staging_size == 0 || !ptrace_attach_process(writer)) {
+        return;
+    }
+    if (staging_size > MEMORY_CAPTURE_MAX_SIZE) {
+        staging_size = MEMORY_CAPTURE_MAX_SIZE;
+    }
+    uint8_t *staging = sentry_malloc(staging_size);
+    if (!staging) {
+        SENTRY_WARN("failed to allocate minidump staging buffer");
+        return;
+    }
+
+    struct iovec local[MEMORY_CAPTURE_MAX_IOV];
+    struct iovec remote[MEMORY_CAPTURE_MAX_IOV];
+    size_t i = 0;
+    while (i < count) {
+        size_t batch = 0;
+        size_t used = 0;
+        while (i + batch < count && batch < MEMORY_CAPTURE_MAX_IOV
+            && captures[i + batch].size <= staging_size - used) {
+            memory_capture_t *capture = &captures[i + batch];
+            local[batch].iov_base = staging + used;
+            local[batch].iov_len = capture->size;
+            remote[batch].iov_base = (void *)(uintptr_t)capture->addr;
+            remote[batch].iov_len = capture->size;
+            used += capture->size;
+            batch++;
+        }
+        if (batch == 0) {
+            // larger than any planned range may be, skip it
+            i++;
+            continue;
+        }
+        read_capture_batch(writer, captures + i, local, remote, batch);
+        write_capture_batch(writer, captures + i, local, batch);
+        i += batch;
+    }
+
+    SENTRY_DEBUGF("captured %zu memory ranges", count);
+    sentry_free(staging);
+}
+
 /**
  * Parse /proc/[pid]/maps to get memory mappings
  */
@@ -460,11 +624,25 @@ enumerate_threads(minidump_writer_t *writer)
         return -1;
     }
 
-    writer->thread_count = 0;
+    // Count the tasks first, with some room for threads that are started
+    // while we enumerate them
+    size_t capacity = 16;
     struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        capacity += entry->d_name[0] != '.' ? 1 : 0;
+    }
+    rewinddir(dir);
 
-    while ((entry = readdir(dir))
-        && writer->thread_count < SENTRY_CRASH_MAX_THREADS) {
+    writer->tids = sentry_malloc(sizeof(pid_t) * capacity);
+    writer->thread_names
+        = sentry_malloc(sizeof(*writer->thread_names) * capacity);
+    if (!writer->tids || !writer->thread_names) {
+        closedir(dir);
+        return -1;
+    }
+    writer->thread_count = 0;
+
+    while ((entry = readdir(dir)) && writer->thread_count < capacity) {
         if (entry->d_name[0] == '.') {
             continue;
         }
@@ -505,13 +683,20 @@ enumerate_threads(minidump_writer_t *writer)
     return 0;
 }
 
+static void
+free_threads(minidump_writer_t *writer)
+{
+    sentry_free(writer->tids);
+    sentry_free(writer->thread_names);
+    writer->tids = NULL;
+    writer->thread_names = NULL;
+    writer->thread_count = 0;
+}
+
 // Use common minidump functions (cast writer to base type)
 #    define write_data(writer, data, size)                                     \
         sentry__minidump_write_data(                                           \
             (minidump_writer_base_t *)(writer), (data), (size))
-#    define write_header(writer, stream_count)                                 \
-        sentry__minidump_write_header(                                         \
-            (minidump_writer_base_t *)(writer), (stream_count))
 #    define write_minidump_string(writer, str)                                 \
         sentry__minidump_write_string((minidump_writer_base_t *)(writer), (str))
 #    define get_context_size() sentry__minidump_get_context_size()
@@ -812,350 +997,6 @@ write_thread_context(
 #    endif
 }
 
-/**
- * Extract Build ID from ELF file
- * Returns the Build ID length, or 0 if not found
- */
-static size_t
-extract_elf_build_id(const char *elf_path, uint8_t *build_id, size_t max_len)
-{
-    int fd = open(elf_path, O_RDONLY);
-    if (fd < 0) {
-        return 0;
-    }
-
-    // Read ELF header
-#    if defined(__x86_64__) || defined(__aarch64__)
-    Elf64_Ehdr ehdr;
-#    else
-    Elf32_Ehdr ehdr;
-#    endif
-
-    if (read(fd, &ehdr, sizeof(ehdr)) != sizeof(ehdr)) {
-        close(fd);
-        return 0;
-    }
-
-    // Verify ELF magic
-    if (memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0) {
-        close(fd);
-        return 0;
-    }
-
-    // Read section headers
-    // Cast to size_t to prevent integer overflow (uint16_t * uint16_t promotes
-    // to int, which can overflow)
-    size_t shdr_size = (size_t)ehdr.e_shentsize * ehdr.e_shnum;
-    void *shdr_buf = sentry_malloc(shdr_size);
-    if (!shdr_buf) {
-        close(fd);
-        return 0;
-    }
-
-    if (lseek(fd, ehdr.e_shoff, SEEK_SET) != (off_t)ehdr.e_shoff
-        || read(fd, shdr_buf, shdr_size) != (ssize_t)shdr_size) {
-        sentry_free(shdr_buf);
-        close(fd);
-        return 0;
-    }
-
-#    if defined(__x86_64__) || defined(__aarch64__)
-    Elf64_Shdr *sections = (Elf64_Shdr *)shdr_buf;
-#    else
-    Elf32_Shdr *sections = (Elf32_Shdr *)shdr_buf;
-#    endif
-
-    // Look for .note.gnu.build-id section
-    size_t build_id_len = 0;
-    for (int i = 0; i < ehdr.e_shnum; i++) {
-        if (sections[i].sh_type == SHT_NOTE) {
-            // Read note section
-            size_t note_size = sections[i].sh_size;
-            if (note_size > 4096)
-                continue; // Sanity check
-
-            void *note_buf = sentry_malloc(note_size);
-            if (!note_buf)
-                continue;
-
-            if (lseek(fd, sections[i].sh_offset, SEEK_SET)
-                    == (off_t)sections[i].sh_offset
-                && read(fd, note_buf, note_size) == (ssize_t)note_size) {
-
-                // Parse notes
-                uint8_t *ptr = (uint8_t *)note_buf;
-                uint8_t *end = ptr + note_size;
-
-                while (ptr + 12 <= end) {
-#    if defined(__x86_64__) || defined(__aarch64__)
-                    Elf64_Nhdr *nhdr = (Elf64_Nhdr *)ptr;
-#    else
-                    Elf32_Nhdr *nhdr = (Elf32_Nhdr *)ptr;
-#    endif
-                    ptr += sizeof(*nhdr);
-
-                    // Use aligned sizes in bounds check since pointer advances
-                    // by aligned amounts. Also check for zero advancement to
-                    // prevent infinite loop on malformed notes (e.g., overflow
-                    // on 32-bit when n_namesz/n_descsz are near UINT32_MAX)
-                    size_t aligned_namesz = ((nhdr->n_namesz + 3) & ~3);
-                    size_t aligned_descsz = ((nhdr->n_descsz + 3) & ~3);
-                    if (aligned_namesz == 0 && aligned_descsz == 0)
-                        break; // Prevent infinite loop
-                    if (ptr + aligned_namesz + aligned_descsz > end)
-                        break;
-
-                    // Check if this is GNU Build ID (type 3, name "GNU\0")
-                    if (nhdr->n_type == 3 && nhdr->n_namesz == 4
-                        && memcmp(ptr, "GNU", 4) == 0) {
-
-                        ptr += aligned_namesz;
-                        size_t len = nhdr->n_descsz < max_len ? nhdr->n_descsz
-                                                              : max_len;
-                        memcpy(build_id, ptr, len);
-                        build_id_len = len;
-                        sentry_free(note_buf);
-                        goto done;
-                    }
-
-                    ptr += aligned_namesz;
-                    ptr += aligned_descsz;
-                }
-            }
-
-            sentry_free(note_buf);
-        }
-    }
-
-done:
-    sentry_free(shdr_buf);
-    close(fd);
-    return build_id_len;
-}
-
-/**
- * Compute the virtual memory size of an ELF file from its PT_LOAD segments.
- * This matches Crashpad's behavior: size = max(p_vaddr + p_memsz) -
- * min(p_vaddr) across all PT_LOAD segments, rather than using page-aligned
- * /proc/maps sizes.
- * Returns the computed size, or 0 on failure (caller should fall back to
- * /proc/maps size).
- */
-static uint64_t
-compute_elf_size_from_phdrs(const char *elf_path)
-{
-    int fd = open(elf_path, O_RDONLY);
-    if (fd < 0) {
-        return 0;
-    }
-
-#    if defined(__x86_64__) || defined(__aarch64__)
-    Elf64_Ehdr ehdr;
-#    else
-    Elf32_Ehdr ehdr;
-#    endif
-
-    if (read(fd, &ehdr, sizeof(ehdr)) != sizeof(ehdr)
-        || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 || ehdr.e_phnum == 0) {
-        close(fd);
-        return 0;
-    }
-
-    // Read program headers
-    size_t phdr_size = (size_t)ehdr.e_phentsize * ehdr.e_phnum;
-    void *phdr_buf = sentry_malloc(phdr_size);
-    if (!phdr_buf) {
-        close(fd);
-        return 0;
-    }
-
-    if (lseek(fd, ehdr.e_phoff, SEEK_SET) != (off_t)ehdr.e_phoff
-        || read(fd, phdr_buf, phdr_size) != (ssize_t)phdr_size) {
-        sentry_free(phdr_buf);
-        close(fd);
-        return 0;
-    }
-
-#    if defined(__x86_64__) || defined(__aarch64__)
-    Elf64_Phdr *phdrs = (Elf64_Phdr *)phdr_buf;
-#    else
-    Elf32_Phdr *phdrs = (Elf32_Phdr *)phdr_buf;
-#    endif
-
-    uint64_t min_vaddr = UINT64_MAX;
-    uint64_t max_vaddr = 0;
-    bool found_load = false;
-
-    for (int i = 0; i < ehdr.e_phnum; i++) {
-        if (phdrs[i].p_type == PT_LOAD) {
-            found_load = true;
-            if (phdrs[i].p_vaddr < min_vaddr) {
-                min_vaddr = phdrs[i].p_vaddr;
-            }
-            uint64_t end = phdrs[i].p_vaddr + phdrs[i].p_memsz;
-            if (end > max_vaddr) {
-                max_vaddr = end;
-            }
-        }
-    }
-
-    sentry_free(phdr_buf);
-    close(fd);
-
-    if (!found_load || max_vaddr <= min_vaddr) {
-        return 0;
-    }
-
-    return max_vaddr - min_vaddr;
-}
-
-/**
- * Read the DT_SONAME from an ELF file's dynamic section.
- * Crashpad uses SONAME as the module name, falling back to the /proc/maps
- * path. This function reads the .dynamic section to find DT_SONAME and
- * resolves it through .dynstr.
- * Returns true if SONAME was found and written to soname_buf.
- */
-static bool
-read_elf_soname(const char *elf_path, char *soname_buf, size_t soname_buf_size)
-{
-    int fd = open(elf_path, O_RDONLY);
-    if (fd < 0) {
-        return false;
-    }
-
-#    if defined(__x86_64__) || defined(__aarch64__)
-    Elf64_Ehdr ehdr;
-    typedef Elf64_Dyn DynT;
-    typedef Elf64_Shdr ShdrT;
-#    else
-    Elf32_Ehdr ehdr;
-    typedef Elf32_Dyn DynT;
-    typedef Elf32_Shdr ShdrT;
-#    endif
-
-    bool result = false;
-
-    if (read(fd, &ehdr, sizeof(ehdr)) != sizeof(ehdr)
-        || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0) {
-        close(fd);
-        return false;
-    }
-
-    // Read section headers to find .dynamic and .dynstr
-    size_t shdr_size = (size_t)ehdr.e_shentsize * ehdr.e_shnum;
-    void *shdr_buf = sentry_malloc(shdr_size);
-    if (!shdr_buf) {
-        close(fd);
-        return false;
-    }
-
-    if (lseek(fd, ehdr.e_shoff, SEEK_SET) != (off_t)ehdr.e_shoff
-        || read(fd, shdr_buf, shdr_size) != (ssize_t)shdr_size) {
-        sentry_free(shdr_buf);
-        close(fd);
-        return false;
-    }
-
-    ShdrT *sections = (ShdrT *)shdr_buf;
-
-    // Find .dynamic and .dynstr sections
-    ShdrT *dynamic_shdr = NULL;
-    ShdrT *dynstr_shdr = NULL;
-    for (int i = 0; i < ehdr.e_shnum; i++) {
-        if (sections[i].sh_type == SHT_DYNAMIC) {
-            dynamic_shdr = &sections[i];
-        } else if (sections[i].sh_type == SHT_STRTAB && !dynstr_shdr) {
-            // The .dynstr is typically the first SHT_STRTAB that is also
-            // referenced by a SHT_DYNAMIC section's sh_link
-            dynstr_shdr = &sections[i];
-        }
-    }
-
-    // Use sh_link from .dynamic to find the correct string table
-    if (dynamic_shdr && dynamic_shdr->sh_link < ehdr.e_shnum) {
-        dynstr_shdr = &sections[dynamic_shdr->sh_link];
-    } else {
-        // Discard the SHT_STRTAB fallback — it may be .shstrtab, not .dynstr
-        dynstr_shdr = NULL;
-    }
-
-    if (!dynamic_shdr || !dynstr_shdr) {
-        sentry_free(shdr_buf);
-        close(fd);
-        return false;
-    }
-
-    // Read .dynstr
-    size_t dynstr_size = dynstr_shdr->sh_size;
-    if (dynstr_size > 1024 * 1024) { // Sanity: max 1MB
-        sentry_free(shdr_buf);
-        close(fd);
-        return false;
-    }
-    char *dynstr = sentry_malloc(dynstr_size);
-    if (!dynstr) {
-        sentry_free(shdr_buf);
-        close(fd);
-        return false;
-    }
-    if (lseek(fd, dynstr_shdr->sh_offset, SEEK_SET)
-            != (off_t)dynstr_shdr->sh_offset
-        || read(fd, dynstr, dynstr_size) != (ssize_t)dynstr_size) {
-        sentry_free(dynstr);
-        sentry_free(shdr_buf);
-        close(fd);
-        return false;
-    }
-
-    // Read .dynamic entries and find DT_SONAME
-    size_t dyn_size = dynamic_shdr->sh_size;
-    void *dyn_buf = sentry_malloc(dyn_size);
-    if (!dyn_buf) {
-        sentry_free(dynstr);
-        sentry_free(shdr_buf);
-        close(fd);
-        return false;
-    }
-    if (lseek(fd, dynamic_shdr->sh_offset, SEEK_SET)
-            != (off_t)dynamic_shdr->sh_offset
-        || read(fd, dyn_buf, dyn_size) != (ssize_t)dyn_size) {
-        sentry_free(dyn_buf);
-        sentry_free(dynstr);
-        sentry_free(shdr_buf);
-        close(fd);
-        return false;
-    }
-
-    DynT *dyn_entries = (DynT *)dyn_buf;
-    size_t dyn_count = dyn_size / sizeof(DynT);
-
-    for (size_t i = 0; i < dyn_count; i++) {
-        if (dyn_entries[i].d_tag == DT_SONAME) {
-            size_t name_offset = dyn_entries[i].d_un.d_val;
-            if (name_offset < dynstr_size) {
-                const char *soname = dynstr + name_offset;
-                size_t len = strnlen(soname, dynstr_size - name_offset);
-                if (len > 0 && len < soname_buf_size) {
-                    memcpy(soname_buf, soname, len);
-                    soname_buf[len] = '\0';
-                    result = true;
-                }
-            }
-            break;
-        }
-        if (dyn_entries[i].d_tag == DT_NULL) {
-            break;
-        }
-    }
-
-    sentry_free(dyn_buf);
-    sentry_free(dynstr);
-    sentry_free(shdr_buf);
-    close(fd);
-    return result;
-}
-
 /**
  * Write CodeView record with Build ID
  */
@@ -1195,15 +1036,15 @@ write_cv_record(minidump_writer_t *writer, const char *module_path,
 }
 
 /**
- * Write stack memory for a thread
- * Returns RVA to stack data, and sets stack_size_out and stack_start_out
+ * Plan the capture of a thread's stack memory, which is read and written
+ * together with the stacks of all other threads by `capture_memory`.
  */
-static minidump_rva_t
-write_thread_stack(minidump_writer_t *writer, uint64_t stack_pointer,
-    size_t *stack_size_out, uint64_t *stack_start_out)
+static void
+plan_thread_stack(const minidump_writer_t *writer, uint64_t stack_pointer,
+    memory_capture_t *capture)
 {
     SENTRY_DEBUGF(
-        "write_thread_stack: SP=0x%llx", (unsigned long long)stack_pointer);
+        "plan_thread_stack: SP=0x%llx", (unsigned long long)stack_pointer);
 
     // On x86_64, include the red zone (128 bytes below SP)
     // Leaf functions can use this area without adjusting SP
@@ -1270,50 +1111,19 @@ write_thread_stack(minidump_writer_t *writer, uint64_t stack_pointer,
         stack_size = SENTRY_CRASH_MAX_STACK_SIZE;
     }
 
-    void *stack_buffer = sentry_malloc(stack_size);
-    if (!stack_buffer) {
-        *stack_size_out = 0;
-        *stack_start_out = 0;
-        return 0;
-    }
-
-    // Read stack memory from crashed process (including red zone if applicable)
-    ssize_t nread
-        = read_process_memory(writer, capture_start, stack_buffer, stack_size);
-
-    minidump_rva_t rva = 0;
-    if (nread > 0) {
-        rva = write_data(writer, stack_buffer, nread);
-        // Only set size/start if write succeeded; rva=0 with size>0 would
-        // cause parsers to read stack data from offset 0 (the minidump header).
-        *stack_size_out = rva ? (size_t)nread : 0;
-        *stack_start_out = rva ? capture_start : 0;
-        SENTRY_DEBUGF(
-            "Read %zd bytes of stack memory from 0x%llx (SP was 0x%llx)", nread,
-            (unsigned long long)capture_start,
-            (unsigned long long)stack_pointer);
-    } else {
-        SENTRY_WARNF(
-            "Failed to read stack memory from process %d at 0x%llx (size %zu): "
-            "%s",
-            writer->crash_ctx->crashed_pid, (unsigned long long)capture_start,
-            stack_size, strerror(errno));
-        *stack_size_out = 0;
-        *stack_start_out = 0;
-    }
-
-    sentry_free(stack_buffer);
-    return rva;
+    capture->addr = capture_start;
+    capture->size = stack_size;
 }
 
 /**
  * Capture a thread's context and stack via ptrace.
- * Writes the thread context and stack memory into the minidump and updates
- * the thread entry accordingly. Returns true on success.
+ * Writes the thread context into the minidump, updates the thread entry
+ * accordingly, and plans the capture of its stack memory. Returns true on
+ * success.
  */
 static bool
-ptrace_capture_thread(
-    minidump_writer_t *writer, minidump_thread_t *thread, const char *reason)
+ptrace_capture_thread(minidump_writer_t *writer, minidump_thread_t *thread,
+    memory_capture_t *stack, const char *reason)
 {
     SENTRY_DEBUGF(
         "Thread %u: %s, attempting ptrace capture", thread->thread_id, reason);
@@ -1348,17 +1158,10 @@ ptrace_capture_thread(
 #    endif
 
     if (ptrace_sp != 0) {
-        size_t stack_size = 0;
-        uint64_t stack_start = 0;
-        thread->stack.memory.rva
-            = write_thread_stack(writer, ptrace_sp, &stack_size, &stack_start);
-        thread->stack.memory.size = stack_size;
-        thread->stack.start_address = stack_start;
+        plan_thread_stack(writer, ptrace_sp, stack);
 
-        SENTRY_DEBUGF("Thread %u: wrote ptrace context at RVA "
-                      "0x%x, stack at RVA 0x%x (size %zu)",
-            thread->thread_id, thread->thread_context.rva,
-            thread->stack.memory.rva, stack_size);
+        SENTRY_DEBUGF("Thread %u: wrote ptrace context at RVA 0x%x",
+            thread->thread_id, thread->thread_context.rva);
     }
 
     return true;
@@ -1383,6 +1186,15 @@ write_thread_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
         return -1;
     }
 
+    memory_capture_t *stacks
+        = sentry_malloc(sizeof(memory_capture_t) * writer->thread_count);
+    if (!stacks) {
+        SENTRY_WARN("Failed to allocate thread stack captures");
+        sentry_free(thread_list);
+        return -1;
+    }
+    memset(stacks, 0, sizeof(memory_capture_t) * writer->thread_count);
+
     thread_list->count = writer->thread_count;
 
     // Fill in thread info with context and stack
@@ -1397,15 +1209,17 @@ write_thread_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
 
         // Try to find this thread in the captured threads
         const ucontext_t *uctx = NULL;
+        const sentry_crash_thread_t *ctx_threads
+            = sentry__crash_context_threads(writer->crash_ctx);
         size_t num_threads = writer->crash_ctx->platform.num_threads;
         // Bounds check to prevent out-of-bounds access on corrupted crash
         // context
-        if (num_threads > SENTRY_CRASH_MAX_THREADS) {
-            num_threads = SENTRY_CRASH_MAX_THREADS;
+        if (num_threads > writer->crash_ctx->thread_table.capacity) {
+            num_threads = writer->crash_ctx->thread_table.capacity;
         }
         for (size_t j = 0; j < num_threads; j++) {
-            if (writer->crash_ctx->platform.threads[j].tid == writer->tids[i]) {
-                uctx = &writer->crash_ctx->platform.threads[j].context;
+            if (ctx_threads[j].tid == writer->tids[i]) {
+                uctx = &ctx_threads[j].context;
                 break;
             }
         }
@@ -1437,20 +1251,10 @@ write_thread_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
                 thread->thread_id, (unsigned long long)sp);
 
             if (sp != 0) {
-                size_t stack_size = 0;
-                uint64_t stack_start = 0;
-                thread->stack.memory.rva
-                    = write_thread_stack(writer, sp, &stack_size, &stack_start);
-                thread->stack.memory.size = stack_size;
-                thread->stack.start_address = stack_start;
-
-                SENTRY_DEBUGF("Thread %u: wrote context at RVA 0x%x, stack at "
-                              "RVA 0x%x (size %zu)",
-                    thread->thread_id, thread->thread_context.rva,
-                    thread->stack.memory.rva, stack_size);
+                plan_thread_stack(writer, sp, &stacks[i]);
             } else {
                 // SP is 0, try to get registers via ptrace
-                ptrace_capture_thread(writer, thread, "SP is 0");
+                ptrace_capture_thread(writer, thread, &stacks[i], "SP is 0");
             }
         } else {
             // No context from signal handler - capture via ptrace.
@@ -1458,9 +1262,31 @@ write_thread_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
             // context. For all other threads, we need to attach via ptrace to
             // get their registers and stack memory.
             ptrace_capture_thread(
-                writer, thread, "no context from signal handler");
+                writer, thread, &stacks[i], "no context from signal handler");
+        }
+    }
+
+    // Read and write the stacks of all threads at once, in as few batches as
+    // possible, instead of one allocation, read and write per thread
+    capture_memory(writer, stacks, writer->thread_count);
+    for (size_t i = 0; i < writer->thread_count; i++) {
+        minidump_thread_t *thread = &thread_list->threads[i];
+        // Only set size/start if the write succeeded; rva=0 with size>0 would
+        // cause parsers to read stack data from offset 0 (the minidump header).
+        thread->stack.memory.rva = stacks[i].rva;
+        thread->stack.memory.size = (uint32_t)stacks[i].captured;
+        thread->stack.start_address = stacks[i].rva ? stacks[i].addr : 0;
+        if (stacks[i].size > 0 && !stacks[i].rva) {
+            SENTRY_WARNF("Failed to capture stack memory of thread %u at "
+                         "0x%llx (size %zu)",
+                thread->thread_id, (unsigned long long)stacks[i].addr,
+                stacks[i].size);
+        } else if (stacks[i].rva) {
+            SENTRY_DEBUGF("Thread %u: stack at RVA 0x%x (size %zu)",
+                thread->thread_id, stacks[i].rva, stacks[i].captured);
         }
     }
+    sentry_free(stacks);
 
     dir->stream_type = MINIDUMP_STREAM_THREAD_LIST;
     dir->rva = write_data(writer, thread_list, list_size);
@@ -1591,15 +1417,20 @@ resolve_modules(const minidump_writer_t *writer, resolved_module_t *modules,
         module_count++;
     }
 
-    // Extract Build IDs, ELF sizes, and SONAMEs for each resolved module
+    // Look up Build IDs, ELF sizes, and SONAMEs for each resolved module.
+    // The daemon cached them while it was waiting, so that the ELF files do
+    // not need to be parsed during the crash.
     for (size_t i = 0; i < module_count; i++) {
-        modules[i].build_id_len = extract_elf_build_id(
-            modules[i].name, modules[i].build_id, sizeof(modules[i].build_id));
-        modules[i].elf_size = compute_elf_size_from_phdrs(modules[i].name);
-        if (!read_elf_soname(modules[i].name, modules[i].soname,
-                sizeof(modules[i].soname))) {
-            modules[i].soname[0] = '\0';
+        sentry_crash_module_identity_t identity;
+        if (!sentry__crash_module_cache_get(modules[i].name, &identity)) {
+            continue;
         }
+        modules[i].build_id_len
+            = MIN(identity.build_id_len, sizeof(modules[i].build_id));
+        memcpy(modules[i].build_id, identity.build_id,
+            modules[i].build_id_len);
+        modules[i].elf_size = identity.elf_size;
+        memcpy(modules[i].soname, identity.soname, sizeof(modules[i].soname));
     }
 
     return module_count;
@@ -1612,16 +1443,15 @@ write_module_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
         writer->mapping_count);
 
     // Resolve mappings into deduplicated modules with correct base/size.
-    // Use a stack-allocated array with a reasonable max
-    // (SENTRY_CRASH_MAX_MODULES).
+    // Every module has at least one mapping, which bounds their number.
+    size_t max_modules = MAX(writer->mapping_count, 1);
     resolved_module_t *resolved
-        = sentry_malloc(sizeof(resolved_module_t) * SENTRY_CRASH_MAX_MODULES);
+        = sentry_malloc(sizeof(resolved_module_t) * max_modules);
     if (!resolved) {
         return -1;
     }
 
-    size_t module_count
-        = resolve_modules(writer, resolved, SENTRY_CRASH_MAX_MODULES);
+    size_t module_count = resolve_modules(writer, resolved, max_modules);
 
     size_t list_size
         = sizeof(uint32_t) + (module_count * sizeof(minidump_module_t));
@@ -1634,24 +1464,8 @@ write_module_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
     module_list->count = module_count;
     SENTRY_DEBUGF("Writing %zu modules to minidump", module_count);
 
-    // First pass: populate module list entries
-    typedef struct {
-        uint8_t build_id[32];
-        size_t build_id_len;
-        char *name;
-        uint64_t base;
-        uint32_t size;
-    } module_info_t;
-    module_info_t *mod_infos = NULL;
-    if (module_count > 0) {
-        mod_infos = sentry_malloc(sizeof(module_info_t) * module_count);
-        if (!mod_infos) {
-            sentry_free(module_list);
-            sentry_free(resolved);
-            return -1;
-        }
-    }
-
+    // Write the module names and CV records first, so that the list can be
+    // written in one go with all RVAs filled in, instead of patching them in
     for (size_t i = 0; i < module_count; i++) {
         minidump_module_t *module = &module_list->modules[i];
         memset(module, 0, sizeof(*module));
@@ -1666,132 +1480,34 @@ write_module_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
         uint32_t version_sig = 0xFEEF04BD;
         memcpy(&module->version_info[0], &version_sig, sizeof(version_sig));
 
-        // Store info for later writing — prefer SONAME over full path
-        mod_infos[i].name
+        // Prefer SONAME over full path
+        const char *name
             = resolved[i].soname[0] ? resolved[i].soname : resolved[i].name;
-        mod_infos[i].base = resolved[i].base;
-        mod_infos[i].size = module->size_of_image;
-        memcpy(mod_infos[i].build_id, resolved[i].build_id,
-            sizeof(mod_infos[i].build_id));
-        mod_infos[i].build_id_len = resolved[i].build_id_len;
+        module->module_name_rva = write_minidump_string(writer, name);
+
+        if (resolved[i].build_id_len > 0) {
+            module->cv_record.rva = write_cv_record(writer, "",
+                resolved[i].build_id, resolved[i].build_id_len);
+            if (module->cv_record.rva) {
+                module->cv_record.size
+                    = sizeof(uint32_t) + resolved[i].build_id_len;
+            }
+        }
 
-        SENTRY_DEBUGF("Module: %s base=0x%llx size=0x%x build_id_len=%zu",
+        SENTRY_DEBUGF("Module: %s base=0x%llx size=0x%x build_id_len=%zu "
+                      "name_rva=0x%x cv_rva=0x%x",
             resolved[i].name, (unsigned long long)resolved[i].base,
-            mod_infos[i].size, mod_infos[i].build_id_len);
+            module->size_of_image, resolved[i].build_id_len,
+            module->module_name_rva, module->cv_record.rva);
     }
 
-    // NOTE: do NOT free `resolved` here — mod_infos[i].name may point into
-    // resolved[i].soname, which lives inside the resolved array. We free it
-    // after the second pass that writes module names to the minidump file.
-
-    // Write the module list structure FIRST (with zero RVAs)
     dir->stream_type = MINIDUMP_STREAM_MODULE_LIST;
     dir->rva = write_data(writer, module_list, list_size);
     dir->data_size = list_size;
-
     if (dir->rva == 0) {
         SENTRY_WARN("failed to write module list structure");
-        sentry_free(mod_infos);
-        sentry_free(module_list);
-        sentry_free(resolved);
-        return -1;
-    }
-
-    // Guard against uint32_t RVA overflow. Minidump RVAs are 32-bit, so the
-    // entire file must stay under 4GB. In practice this never happens, but
-    // check defensively to avoid silently corrupt seek+patch writes below.
-    if (writer->current_offset > UINT32_MAX) {
-        SENTRY_WARN("minidump offset exceeds uint32_t range, skipping module "
-                    "name/CV patching");
-        sentry_free(mod_infos);
-        sentry_free(module_list);
-        sentry_free(resolved);
-        return dir->rva ? 0 : -1;
     }
 
-    // Second pass: write module names and CV records, then update module list
-    for (size_t i = 0; i < module_count; i++) {
-        // Write module name
-        minidump_rva_t name_rva
-            = write_minidump_string(writer, mod_infos[i].name);
-
-        // Write CV record if we have a Build ID
-        minidump_rva_t cv_rva = 0;
-        uint32_t cv_size = 0;
-        if (mod_infos[i].build_id_len > 0) {
-            cv_rva = write_cv_record(
-                writer, "", mod_infos[i].build_id, mod_infos[i].build_id_len);
-            cv_size = sizeof(uint32_t) + mod_infos[i].build_id_len;
-            SENTRY_DEBUGF("CV Record: signature=0x4270454c, build_id_len=%zu",
-                mod_infos[i].build_id_len);
-        }
-
-        // Third pass: update specific fields in the module structure via lseek
-        // Save position AFTER writing name and CV record
-        off_t saved_pos = lseek(writer->fd, 0, SEEK_CUR);
-        if (saved_pos == (off_t)-1) {
-            SENTRY_WARNF("Failed to get current position for module %zu", i);
-            continue;
-        }
-
-        // Update module_name_rva field
-        off_t name_rva_offset = dir->rva + sizeof(uint32_t)
-            + (i * sizeof(minidump_module_t))
-            + offsetof(minidump_module_t, module_name_rva);
-
-        if (lseek(writer->fd, name_rva_offset, SEEK_SET)
-            == (off_t)name_rva_offset) {
-            if (write(writer->fd, &name_rva, sizeof(name_rva))
-                != sizeof(name_rva)) {
-                SENTRY_WARNF(
-                    "Failed to write module_name_rva for module %zu", i);
-            }
-        }
-
-        // Update cv_record fields (size and rva)
-        if (cv_size > 0) {
-            off_t cv_offset = dir->rva + sizeof(uint32_t)
-                + (i * sizeof(minidump_module_t))
-                + offsetof(minidump_module_t, cv_record);
-
-            SENTRY_DEBUGF("  Seeking to CV offset: 0x%llx for module %zu",
-                (unsigned long long)cv_offset, i);
-
-            off_t actual_offset = lseek(writer->fd, cv_offset, SEEK_SET);
-            if (actual_offset == (off_t)cv_offset) {
-                // Write size first, then rva (order in structure)
-                ssize_t written1 = write(writer->fd, &cv_size, sizeof(cv_size));
-                ssize_t written2 = write(writer->fd, &cv_rva, sizeof(cv_rva));
-
-                if (written1 == sizeof(cv_size) && written2 == sizeof(cv_rva)) {
-                    SENTRY_DEBUGF(
-                        "  Updated module[%zu]: name_rva=0x%x, cv_rva=0x%x, "
-                        "cv_size=%u",
-                        i, name_rva, cv_rva, cv_size);
-                } else {
-                    SENTRY_WARNF("Failed to write CV record for module %zu: "
-                                 "written1=%zd, written2=%zd",
-                        i, written1, written2);
-                }
-            } else {
-                SENTRY_WARNF("Failed to seek to CV offset 0x%llx for module "
-                             "%zu (got 0x%llx)",
-                    (unsigned long long)cv_offset, i,
-                    (unsigned long long)actual_offset);
-            }
-        }
-
-        if (lseek(writer->fd, saved_pos, SEEK_SET) != saved_pos) {
-            SENTRY_WARNF(
-                "Failed to restore position after module %zu update", i);
-        }
-    }
-
-    // Final flush to ensure all writes are committed
-    fsync(writer->fd);
-    SENTRY_DEBUG("Flushed all module updates to disk");
-
-    sentry_free(mod_infos);
     sentry_free(resolved);
     sentry_free(module_list);
     return dir->rva ? 0 : -1;
@@ -1943,6 +1659,37 @@ should_include_region(const memory_mapping_t *mapping,
     return false;
 }
 
+/**
+ * Returns how much of an included mapping is captured, starting at its start.
+ */
+static uint64_t
+region_capture_size(const minidump_writer_t *writer,
+    const memory_mapping_t *mapping, uint64_t crash_addr)
+{
+    uint64_t region_size = mapping->end - mapping->start;
+
+    // For SMART mode, cap module header pages to one page (4096 bytes).
+    // We only need the ELF header, not the entire read-only segment.
+    // Skip the cap if this region contains the crash address, since
+    // that memory is the most important for debugging.
+    if (writer->crash_ctx->minidump_mode == SENTRY_MINIDUMP_MODE_SMART
+        && mapping->offset == 0 && mapping->name[0] != '\0'
+        && mapping->name[0] != '['
+        && !(crash_addr >= mapping->start && crash_addr < mapping->end)) {
+        const uint64_t MODULE_HEADER_SIZE = 4096;
+        if (region_size > MODULE_HEADER_SIZE) {
+            region_size = MODULE_HEADER_SIZE;
+        }
+    }
+
+    // Limit individual region size to 4MB to avoid huge dumps
+    // (should_include_region already limits heap to 4MB for SMART mode)
+    if (region_size > MEMORY_CAPTURE_MAX_SIZE) {
+        region_size = MEMORY_CAPTURE_MAX_SIZE;
+    }
+    return region_size;
+}
+
 /**
  * Write memory list stream (heap memory based on minidump mode)
  */
@@ -1952,85 +1699,63 @@ write_memory_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
     // Get crash address for SMART mode filtering
     uint64_t crash_addr = (uint64_t)writer->crash_ctx->platform.siginfo.si_addr;
 
-    // Count regions to include based on mode
+    memory_capture_t *regions = sentry_malloc(
+        sizeof(memory_capture_t) * (writer->mapping_count + 1));
+    if (!regions) {
+        return -1;
+    }
+
+    // Plan the regions to include based on mode. Adjacent regions of the same
+    // mapping, like the segments of a module or a heap split by permissions,
+    // are merged into a single range. Different mappings are kept apart, so
+    // that one that cannot be read does not fail its neighbors.
     size_t region_count = 0;
+    const memory_mapping_t *mergeable = NULL;
     for (size_t i = 0; i < writer->mapping_count; i++) {
-        if (should_include_region(&writer->mappings[i],
+        if (!should_include_region(&writer->mappings[i],
                 writer->crash_ctx->minidump_mode, crash_addr)) {
+            mergeable = NULL;
+            continue;
+        }
+
+        memory_mapping_t *mapping = &writer->mappings[i];
+        uint64_t region_size = region_capture_size(writer, mapping, crash_addr);
+
+        memory_capture_t *prev
+            = region_count ? &regions[region_count - 1] : NULL;
+        if (mergeable && prev->addr + prev->size == mapping->start
+            && prev->size + region_size <= MEMORY_CAPTURE_MAX_SIZE
+            && strcmp(mergeable->name, mapping->name) == 0) {
+            prev->size += (size_t)region_size;
+        } else {
+            regions[region_count].addr = mapping->start;
+            regions[region_count].size = (size_t)region_size;
             region_count++;
         }
+        // only a range that covers its whole mapping can be extended
+        mergeable
+            = region_size == mapping->end - mapping->start ? mapping : NULL;
     }
 
+    capture_memory(writer, regions, region_count);
+
     // Allocate memory list
     size_t list_size = sizeof(uint32_t)
         + (region_count * sizeof(minidump_memory_descriptor_t));
     minidump_memory_list_t *memory_list = sentry_malloc(list_size);
     if (!memory_list) {
+        sentry_free(regions);
         return -1;
     }
 
     memory_list->count = region_count;
-
-    // Write memory regions
-    size_t mem_idx = 0;
-    for (size_t i = 0; i < writer->mapping_count && mem_idx < region_count;
-        i++) {
-        if (!should_include_region(&writer->mappings[i],
-                writer->crash_ctx->minidump_mode, crash_addr)) {
-            continue;
-        }
-
-        memory_mapping_t *mapping = &writer->mappings[i];
-        minidump_memory_descriptor_t *mem = &memory_list->ranges[mem_idx++];
-
-        uint64_t region_size = mapping->end - mapping->start;
-
-        // For SMART mode, cap module header pages to one page (4096 bytes).
-        // We only need the ELF header, not the entire read-only segment.
-        // Skip the cap if this region contains the crash address, since
-        // that memory is the most important for debugging.
-        if (writer->crash_ctx->minidump_mode == SENTRY_MINIDUMP_MODE_SMART
-            && mapping->offset == 0 && mapping->name[0] != '\0'
-            && mapping->name[0] != '['
-            && !(crash_addr >= mapping->start && crash_addr < mapping->end)) {
-            const uint64_t MODULE_HEADER_SIZE = 4096;
-            if (region_size > MODULE_HEADER_SIZE) {
-                region_size = MODULE_HEADER_SIZE;
-            }
-        }
-
-        // Limit individual region size to 4MB to avoid huge dumps
-        // (should_include_region already limits heap to 4MB for SMART mode)
-        const size_t MAX_REGION_SIZE = 4 * 1024 * 1024; // 4MB
-        if (region_size > MAX_REGION_SIZE) {
-            region_size = MAX_REGION_SIZE;
-        }
-
-        // Allocate buffer for region memory
-        void *region_buffer = sentry_malloc(region_size);
-        if (!region_buffer) {
-            mem->start_address = mapping->start;
-            mem->memory.size = 0;
-            mem->memory.rva = 0;
-            continue;
-        }
-
-        // Read memory from crashed process
-        ssize_t nread = read_process_memory(
-            writer, mapping->start, region_buffer, region_size);
-
-        if (nread > 0) {
-            mem->start_address = mapping->start;
-            mem->memory.rva = write_data(writer, region_buffer, nread);
-            mem->memory.size = mem->memory.rva ? (uint32_t)nread : 0;
-        } else {
-            mem->start_address = mapping->start;
-            mem->memory.size = 0;
-            mem->memory.rva = 0;
-        }
-
-        sentry_free(region_buffer);
+    for (size_t i = 0; i < region_count; i++) {
+        minidump_memory_descriptor_t *mem = &memory_list->ranges[i];
+        mem->start_address = regions[i].addr;
+        mem->memory.rva = regions[i].rva;
+        mem->memory.size = (uint32_t)regions[i].captured;
     }
+    sentry_free(regions);
 
     dir->stream_type = MINIDUMP_STREAM_MEMORY_LIST;
     dir->rva = write_data(writer, memory_list, list_size);
@@ -2131,6 +1856,44 @@ write_linux_maps_stream(minidump_writer_t *writer, minidump_directory_t *dir)
     return dir->rva ? 0 : -1;
 }
 
+/**
+ * Typical stack usage of a thread, for estimating the minidump size.
+ */
+#    define MINIDUMP_ESTIMATED_STACK_SIZE (16 * 1024)
+
+/**
+ * Estimates the size of the minidump from the threads, mappings and memory
+ * regions it will contain, so that the file can be preallocated in one go.
+ */
+static uint64_t
+estimate_minidump_size(const minidump_writer_t *writer)
+{
+    uint64_t crash_addr = (uint64_t)writer->crash_ctx->platform.siginfo.si_addr;
+
+    // thread list entries, contexts, names and stacks
+    uint64_t size = writer->current_offset
+        + writer->thread_count
+            * (sizeof(minidump_thread_t) + get_context_size()
+                + sizeof(minidump_thread_name_t) + sizeof(uint32_t)
+                + 2 * sizeof(writer->thread_names[0])
+                + MINIDUMP_ESTIMATED_STACK_SIZE);
+
+    // modules with their names and CV records, the memory list, and the maps
+    // stream with one line per mapping
+    size += writer->mapping_count
+        * (sizeof(minidump_module_t) + sizeof(minidump_memory_descriptor_t)
+            + 2 * sizeof(writer->mappings[0].name));
+
+    for (size_t i = 0; i < writer->mapping_count; i++) {
+        if (should_include_region(&writer->mappings[i],
+                writer->crash_ctx->minidump_mode, crash_addr)) {
+            size += region_capture_size(
+                writer, &writer->mappings[i], crash_addr);
+        }
+    }
+    return size;
+}
+
 /**
  * Main minidump writing function for Linux
  */
@@ -2155,6 +1918,7 @@ sentry__write_minidump(
     // Parse process information
     if (parse_proc_maps(&writer) < 0 || enumerate_threads(&writer) < 0) {
         close(writer.fd);
+        free_threads(&writer);
         unlink(output_path);
         return -1;
     }
@@ -2188,10 +1952,16 @@ sentry__write_minidump(
             ptrace(PTRACE_DETACH, ctx->crashed_tid, NULL, NULL);
         }
         close(writer.fd);
+        free_threads(&writer);
         unlink(output_path);
         return -1;
     }
 
+    // Stage the many small records in a write-combining buffer. The memory
+    // ranges bypass it, and the header and directory are written last.
+    sentry__minidump_buffer_begin(
+        (minidump_writer_base_t *)&writer, estimate_minidump_size(&writer));
+
     // Write streams
     minidump_directory_t directories[8];
     int result = 0;
@@ -2235,46 +2005,28 @@ sentry__write_minidump(
         directories[7].rva = 0;
     }
 
-    if (result < 0) {
-        if (writer.ptrace_attached) {
-            ptrace(PTRACE_DETACH, ctx->crashed_tid, NULL, NULL);
-        }
-        close(writer.fd);
-        unlink(output_path);
-        return -1;
+    if (sentry__minidump_buffer_end((minidump_writer_base_t *)&writer) < 0) {
+        result = -1;
     }
 
     // Write header and directory at the beginning
-    if (lseek(writer.fd, 0, SEEK_SET) < 0) {
-        if (writer.ptrace_attached) {
-            ptrace(PTRACE_DETACH, ctx->crashed_tid, NULL, NULL);
-        }
-        close(writer.fd);
-        unlink(output_path);
-        return -1;
-    }
-
-    if (write_header(&writer, stream_count) < 0) {
-        if (writer.ptrace_attached) {
-            ptrace(PTRACE_DETACH, ctx->crashed_tid, NULL, NULL);
-        }
-        close(writer.fd);
-        unlink(output_path);
-        return -1;
-    }
-
-    // Write only the directory entries we actually used
-    size_t dir_size = stream_count * sizeof(minidump_directory_t);
-    if (write(writer.fd, directories, dir_size) != (ssize_t)dir_size) {
+    if (result < 0
+        || sentry__minidump_write_directory(
+               (minidump_writer_base_t *)&writer, directories, stream_count)
+            < 0) {
         if (writer.ptrace_attached) {
             ptrace(PTRACE_DETACH, ctx->crashed_tid, NULL, NULL);
         }
         close(writer.fd);
+        free_threads(&writer);
         unlink(output_path);
         return -1;
     }
 
+    // Make sure the finished minidump is on disk before it is reported
+    fsync(writer.fd);
     close(writer.fd);
+    free_threads(&writer);
 
     // Detach from process if we attached
     if (writer.ptrace_attached) {
@@ -55,6 +55,7 @@ typedef struct {
     // Base fields (must match minidump_writer_base_t layout)
     int fd;
     uint64_t current_offset;
+    minidump_buffer_t *buffer;
 
     // macOS-specific fields
     const sentry_crash_context_t *crash_ctx;
@@ -523,8 +524,8 @@ write_thread_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
             thread_count = writer->crash_ctx->platform.num_threads;
             // Bounds check to prevent out-of-bounds access on corrupted crash
             // context
-            if (thread_count > SENTRY_CRASH_MAX_THREADS) {
-                thread_count = SENTRY_CRASH_MAX_THREADS;
+            if (thread_count > writer->crash_ctx->thread_table.capacity) {
+                thread_count = writer->crash_ctx->thread_table.capacity;
             }
             SENTRY_DEBUGF("Using %u threads from crash context", thread_count);
         } else {
@@ -620,11 +621,12 @@ write_thread_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
 
             // Use thread ID captured in signal handler (portable across
             // processes)
-            thread->thread_id = writer->crash_ctx->platform.threads[i].tid;
+            const sentry_crash_thread_t *ctx_thread
+                = &sentry__crash_context_threads(writer->crash_ctx)[i];
+            thread->thread_id = ctx_thread->tid;
 
             // Write thread context (registers)
-            const _STRUCT_MCONTEXT *state
-                = &writer->crash_ctx->platform.threads[i].state;
+            const _STRUCT_MCONTEXT *state = &ctx_thread->state;
             thread->thread_context.rva = write_thread_context(writer, state);
             thread->thread_context.size
                 = thread->thread_context.rva ? get_context_size() : 0;
@@ -639,10 +641,8 @@ write_thread_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
             sp = SENTRY__ARM64_GET_SP(state->__ss);
 #    endif
 
-            const char *stack_path
-                = writer->crash_ctx->platform.threads[i].stack_path;
-            uint64_t saved_stack_size
-                = writer->crash_ctx->platform.threads[i].stack_size;
+            const char *stack_path = ctx_thread->stack_path;
+            uint64_t saved_stack_size = ctx_thread->stack_size;
 
             if (stack_path[0] != '\0' && saved_stack_size > 0) {
                 // Read stack from file
@@ -756,8 +756,8 @@ write_module_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
     uint32_t module_count = writer->crash_ctx->module_count;
 
     // Bounds check to prevent out-of-bounds access on corrupted crash context
-    if (module_count > SENTRY_CRASH_MAX_MODULES) {
-        module_count = SENTRY_CRASH_MAX_MODULES;
+    if (module_count > writer->crash_ctx->module_table.capacity) {
+        module_count = writer->crash_ctx->module_table.capacity;
     }
 
     size_t list_size
@@ -773,7 +773,10 @@ write_module_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
         minidump_module_t *mdmodule = &module_list->modules[i];
         memset(mdmodule, 0, sizeof(*mdmodule));
 
-        const sentry_module_info_t *module = &writer->crash_ctx->modules[i];
+        const sentry_module_info_t *module
+            = &sentry__crash_context_modules(writer->crash_ctx)[i];
+        const char *module_name = sentry__crash_context_string(
+            writer->crash_ctx, module->name_offset);
 
         // Set module base address and size
         mdmodule->base_of_image = module->base_address;
@@ -785,7 +788,7 @@ write_module_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
         memcpy(&mdmodule->version_info[0], &version_sig, sizeof(version_sig));
 
         // Write module name as UTF-16 string
-        mdmodule->module_name_rva = write_minidump_string(writer, module->name);
+        mdmodule->module_name_rva = write_minidump_string(writer, module_name);
 
         // Write CodeView record with UUID for symbolication
         // Try to use UUID captured in signal handler first
@@ -807,15 +810,15 @@ write_module_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
             has_uuid = true;
         } else {
             // Fallback: Extract UUID from Mach-O file
-            has_uuid = extract_macho_uuid(module->name, uuid);
+            has_uuid = extract_macho_uuid(module_name, uuid);
         }
 
         if (has_uuid) {
-            minidump_rva_t cv_rva = write_cv_record(writer, module->name, uuid);
+            minidump_rva_t cv_rva = write_cv_record(writer, module_name, uuid);
             if (cv_rva) {
                 mdmodule->cv_record.rva = cv_rva;
                 mdmodule->cv_record.size
-                    = sizeof(cv_info_pdb70_t) + strlen(module->name);
+                    = sizeof(cv_info_pdb70_t) + strlen(module_name);
             }
         }
     }
@@ -896,12 +899,14 @@ should_include_region_macos(const memory_region_t *region,
 
         // Include first page of loaded modules (Mach-O headers) for offline
         // symbolication, matching breakpad/crashpad behavior.
+        const sentry_module_info_t *modules
+            = sentry__crash_context_modules(crash_ctx);
         uint32_t mod_count = crash_ctx->module_count;
-        if (mod_count > SENTRY_CRASH_MAX_MODULES) {
-            mod_count = SENTRY_CRASH_MAX_MODULES;
+        if (mod_count > crash_ctx->module_table.capacity) {
+            mod_count = crash_ctx->module_table.capacity;
         }
         for (uint32_t i = 0; i < mod_count; i++) {
-            if (region->address == crash_ctx->modules[i].base_address) {
+            if (region->address == modules[i].base_address) {
                 return true;
             }
         }
@@ -935,6 +940,8 @@ write_module_headers_from_capture(minidump_writer_t *writer,
         return 0;
     }
 
+    const sentry_module_info_t *modules
+        = sentry__crash_context_modules(writer->crash_ctx);
     uint8_t buf[4096];
     size_t written_count = 0;
 
@@ -943,14 +950,14 @@ write_module_headers_from_capture(minidump_writer_t *writer,
         minidump_memory_descriptor_t *mem = &ranges[i];
 
         if (nread > 0) {
-            mem->start_address = writer->crash_ctx->modules[i].base_address;
+            mem->start_address = modules[i].base_address;
             mem->memory.rva = write_data(writer, buf, (size_t)nread);
             mem->memory.size = mem->memory.rva ? (uint32_t)nread : 0;
             if (mem->memory.size > 0) {
                 written_count++;
             }
         } else {
-            mem->start_address = writer->crash_ctx->modules[i].base_address;
+            mem->start_address = modules[i].base_address;
             mem->memory.size = 0;
             mem->memory.rva = 0;
         }
@@ -1023,13 +1030,14 @@ write_memory_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
             if (mode == SENTRY_MINIDUMP_MODE_SMART
                 && !(crash_addr >= region->address
                     && crash_addr < region->address + region->size)) {
+                const sentry_module_info_t *modules
+                    = sentry__crash_context_modules(writer->crash_ctx);
                 uint32_t mod_count = writer->crash_ctx->module_count;
-                if (mod_count > SENTRY_CRASH_MAX_MODULES) {
-                    mod_count = SENTRY_CRASH_MAX_MODULES;
+                if (mod_count > writer->crash_ctx->module_table.capacity) {
+                    mod_count = writer->crash_ctx->module_table.capacity;
                 }
                 for (uint32_t j = 0; j < mod_count; j++) {
-                    if (region->address
-                        == writer->crash_ctx->modules[j].base_address) {
+                    if (region->address == modules[j].base_address) {
                         if (region_size > 4096) {
                             region_size = 4096;
                         }
@@ -1093,8 +1101,8 @@ write_memory_list_stream(minidump_writer_t *writer, minidump_directory_t *dir)
     // Mach-O header (including dyld shared cache modules that don't exist as
     // individual files on disk).
     uint32_t mod_count = writer->crash_ctx->module_count;
-    if (mod_count > SENTRY_CRASH_MAX_MODULES) {
-        mod_count = SENTRY_CRASH_MAX_MODULES;
+    if (mod_count > writer->crash_ctx->module_table.capacity) {
+        mod_count = writer->crash_ctx->module_table.capacity;
     }
 
     size_t list_size
@@ -0,0 +1,170 @@
+#include "sentry_boot.h"
+
+#include "sentry_crash_context.h"
+
+#include "sentry_alloc.h"
+#include "sentry_sync.h"
+#include "sentry_utils.h"
+
+#include <string.h>
+
+// Alignment of the tables, enough for the register state in the thread
+// entries and to keep each table on its own cache line
+#define TABLE_ALIGNMENT 64
+
+static size_t
+align_table(size_t offset)
+{
+    return (offset + TABLE_ALIGNMENT - 1) & ~(size_t)(TABLE_ALIGNMENT - 1);
+}
+
+/**
+ * Computes the offsets of the tables for the given capacities, and returns
+ * the total size, or 0 if it does not fit the 32-bit offsets.
+ */
+static size_t
+layout_tables(size_t threads, size_t modules, size_t strings,
+    sentry_crash_table_t *thread_table, sentry_crash_table_t *module_table,
+    sentry_crash_table_t *string_table)
+{
+    if (threads > UINT32_MAX / sizeof(sentry_crash_thread_t)
+        || modules > UINT32_MAX / sizeof(sentry_module_info_t)
+        || strings > UINT32_MAX) {
+        return 0;
+    }
+    // offset 0 of the string table is the empty string
+    strings = MAX(strings, 1);
+
+    uint64_t thread_offset = align_table(sizeof(sentry_crash_context_t));
+    uint64_t module_offset = align_table(
+        thread_offset + threads * sizeof(sentry_crash_thread_t));
+    uint64_t string_offset = align_table(
+        module_offset + modules * sizeof(sentry_module_info_t));
+    uint64_t size = align_table(string_offset + strings);
+    if (size > UINT32_MAX) {
+        return 0;
+    }
+
+    thread_table->offset = (uint32_t)thread_offset;
+    thread_table->capacity = (uint32_t)threads;
+    module_table->offset = (uint32_t)module_offset;
+    module_table->capacity = (uint32_t)modules;
+    string_table->offset = (uint32_t)string_offset;
+    string_table->capacity = (uint32_t)strings;
+    return (size_t)size;
+}
+
+size_t
+sentry__crash_context_size(size_t threads, size_t modules, size_t strings)
+{
+    sentry_crash_table_t thread_table;
+    sentry_crash_table_t module_table;
+    sentry_crash_table_t string_table;
+    return layout_tables(threads, modules, strings, &thread_table,
+        &module_table, &string_table);
+}
+
+void
+sentry__crash_context_init(sentry_crash_context_t *ctx, size_t threads,
+    size_t modules, size_t strings)
+{
+    sentry_crash_table_t thread_table;
+    sentry_crash_table_t module_table;
+    sentry_crash_table_t string_table;
+    size_t size = layout_tables(threads, modules, strings, &thread_table,
+        &module_table, &string_table);
+
+    memset(ctx, 0, size);
+    ctx->magic = SENTRY_CRASH_MAGIC;
+    ctx->version = SENTRY_CRASH_VERSION;
+    ctx->size = (uint32_t)size;
+    ctx->thread_table = thread_table;
+    ctx->module_table = module_table;
+    ctx->string_table = string_table;
+    ctx->strings_used = 1;
+    sentry__atomic_store(&ctx->state, SENTRY_CRASH_STATE_READY);
+    sentry__atomic_store(&ctx->sequence, 0);
+}
+
+static bool
+table_fits(const sentry_crash_table_t *table, size_t entry_size, size_t size)
+{
+    return table->offset >= sizeof(sentry_crash_context_t)
+        && (uint64_t)table->offset + (uint64_t)table->capacity * entry_size
+        <= size;
+}
+
+bool
+sentry__crash_context_validate(const sentry_crash_context_t *ctx, size_t size)
+{
+    return size >= sizeof(sentry_crash_context_t)
+        && ctx->magic == SENTRY_CRASH_MAGIC
+        && ctx->version == SENTRY_CRASH_VERSION && ctx->size <= size
+        && table_fits(
+            &ctx->thread_table, sizeof(sentry_crash_thread_t), ctx->size)
+        && table_fits(
+            &ctx->module_table, sizeof(sentry_module_info_t), ctx->size)
+        && table_fits(&ctx->string_table, 1, ctx->size)
+        && ctx->string_table.capacity > 0
+        && ctx->strings_used <= ctx->string_table.capacity;
+}
+
+sentry_crash_context_t *
+sentry__crash_context_grow(const sentry_crash_context_t *ctx, size_t threads,
+    size_t modules, size_t strings)
+{
+    threads = MAX(threads, ctx->thread_table.capacity);
+    modules = MAX(modules, ctx->module_table.capacity);
+    strings = MAX(strings, ctx->string_table.capacity);
+
+    sentry_crash_table_t thread_table;
+    sentry_crash_table_t module_table;
+    sentry_crash_table_t string_table;
+    size_t size = layout_tables(threads, modules, strings, &thread_table,
+        &module_table, &string_table);
+    if (!size) {
+        return NULL;
+    }
+    sentry_crash_context_t *grown = sentry_malloc(size);
+    if (!grown) {
+        return NULL;
+    }
+    memset(grown, 0, size);
+    memcpy(grown, ctx, sizeof(sentry_crash_context_t));
+    grown->size = (uint32_t)size;
+    grown->thread_table = thread_table;
+    grown->module_table = module_table;
+    grown->string_table = string_table;
+
+    memcpy(sentry__crash_context_threads(grown),
+        sentry__crash_context_threads(ctx),
+        ctx->thread_table.capacity * sizeof(sentry_crash_thread_t));
+    memcpy(sentry__crash_context_modules(grown),
+        sentry__crash_context_modules(ctx),
+        ctx->module_table.capacity * sizeof(sentry_module_info_t));
+    uint32_t strings_used
+        = MIN(ctx->strings_used, ctx->string_table.capacity);
+    memcpy((char *)grown + string_table.offset,
+        (const char *)ctx + ctx->string_table.offset, strings_used);
+    grown->strings_used = MAX(strings_used, 1);
+    return grown;
+}
+
+uint32_t
+sentry__crash_context_add_string(
+    sentry_crash_context_t *ctx, const char *str, size_t len)
+{
+    uint32_t used = ctx->strings_used;
+    if (len == 0 || used > ctx->string_table.capacity
+        || len >= ctx->string_table.capacity - used) {
+        return 0;
+    }
+    // no memcpy, since this runs in the signal handler on macOS
+    char *dest = (char *)ctx + ctx->string_table.offset + used;
+    for (size_t i = 0; i < len; i++) {
+        dest[i] = str[i];
+    }
+    dest[len] = '\0';
+    ctx->strings_used = used + (uint32_t)len + 1;
+    return used;
+}
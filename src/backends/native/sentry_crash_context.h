@@ -30,11 +30,15 @@ typedef DWORD pid_t;
 #endif
 
 #define SENTRY_CRASH_MAGIC 0x53454E54 // "SENT"
-#define SENTRY_CRASH_VERSION 1
-
-// Limits for crash context (used in shared memory and minidump writers)
-#define SENTRY_CRASH_MAX_THREADS 256
-#define SENTRY_CRASH_MAX_MODULES 512
+#define SENTRY_CRASH_VERSION 3
+
+// Minimum capacities of the thread and module tables in the crash context.
+// The tables are sized at init for twice the threads and modules the process
+// has at that point, but never below these.
+#define SENTRY_CRASH_MIN_THREADS 64
+#define SENTRY_CRASH_MIN_MODULES 128
+// String table bytes reserved per module (module and PDB names)
+#define SENTRY_CRASH_STRINGS_PER_MODULE 512
 #define SENTRY_CRASH_MAX_MAPPINGS 4096
 
 // Max path length in crash context
@@ -59,6 +63,14 @@ typedef DWORD pid_t;
 #define SENTRY_CRASH_ITEM_HEADER_SIZE 256 // Item headers (event, minidump)
 #define SENTRY_CRASH_READ_BUFFER_SIZE 8192 // General read buffer
 
+// Scope and breadcrumb journal sizes
+#define SENTRY_CRASH_JOURNAL_SCOPE_SIZE (64 * 1024) // Per scope buffer
+#define SENTRY_CRASH_JOURNAL_MAX_BREADCRUMBS 256 // Breadcrumb index entries
+#define SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE                                  \
+    (256 * 1024) // Breadcrumb ring buffer
+#define SENTRY_CRASH_JOURNAL_MAX_BREADCRUMB_SIZE                               \
+    (SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE / 8) // Largest single breadcrumb
+
 // String formatting buffer sizes
 #define SENTRY_CRASH_TIMESTAMP_SIZE 32 // Timestamp strings
 
@@ -92,6 +104,8 @@ typedef DWORD pid_t;
     5000 // 5 seconds between daemon health checks
 #define SENTRY_CRASH_HANDLER_POLL_INTERVAL_MS                                  \
     100 // 100ms poll interval in exception handler
+#define SENTRY_CRASH_SHARED_DAEMON_IDLE_TIMEOUT_MS                             \
+    30000 // 30 seconds a shared daemon waits for apps before it exits
 
 // Compatibility macros for arm64e (PAC - Pointer Authentication Codes).
 // On arm64e, __darwin_arm_thread_state64 uses opaque members for pointer
@@ -131,11 +145,11 @@ typedef enum {
 typedef struct {
     uint64_t base_address;
     uint64_t size;
-    char name[SENTRY_CRASH_MAX_PATH];
+    uint32_t name_offset; // Module path in the string table
     uint8_t uuid[16]; // Module UUID for symbolication
     uint32_t pdb_age; // PDB age (Windows PE only, appended to debug_id)
 #if defined(SENTRY_PLATFORM_WINDOWS)
-    char pdb_name[SENTRY_CRASH_MAX_PATH]; // PDB filename (Windows PE only)
+    uint32_t pdb_name_offset; // PDB filename in the string table (PE only)
 #endif
 } sentry_module_info_t;
 
@@ -168,11 +182,12 @@ typedef struct {
     size_t backtrace_count;
     uint64_t backtrace_ips[SENTRY_CRASH_MAX_BACKTRACE_FRAMES];
 
-    // Additional thread contexts (for multi-thread dumps)
+    // Number of entries in the thread table (for multi-thread dumps)
     size_t num_threads;
-    sentry_thread_context_linux_t threads[SENTRY_CRASH_MAX_THREADS];
 } sentry_crash_platform_linux_t;
 
+typedef sentry_thread_context_linux_t sentry_crash_thread_t;
+
 #elif defined(SENTRY_PLATFORM_MACOS)
 
 #    include <mach/mach.h>
@@ -200,11 +215,12 @@ typedef struct {
     // Mach thread state
     thread_t mach_thread;
 
-    // Additional thread contexts
+    // Number of entries in the thread table
     size_t num_threads;
-    sentry_thread_context_darwin_t threads[SENTRY_CRASH_MAX_THREADS];
 } sentry_crash_platform_darwin_t;
 
+typedef sentry_thread_context_darwin_t sentry_crash_thread_t;
+
 #elif defined(SENTRY_PLATFORM_WINDOWS)
 
 // Disable warning C4324: structure was padded due to alignment specifier
@@ -237,25 +253,82 @@ typedef struct {
     // (needed for out-of-process minidump writing with ClientPointers=TRUE)
     EXCEPTION_POINTERS *exception_pointers;
 
-    // Additional thread contexts
+    // Number of entries in the thread table
     DWORD num_threads;
-    sentry_thread_context_windows_t threads[SENTRY_CRASH_MAX_THREADS];
 } sentry_crash_platform_windows_t;
 
+typedef sentry_thread_context_windows_t sentry_crash_thread_t;
+
 #    ifdef _MSC_VER
 #        pragma warning(pop)
 #    endif
 
 #endif
 
+/**
+ * Location of a breadcrumb in the journal's breadcrumb ring buffer.
+ */
+typedef struct {
+    uint32_t offset; // Position in the stream of all breadcrumb bytes
+    uint32_t len;
+} sentry_crash_journal_entry_t;
+
+/**
+ * Scope and breadcrumb journal, updated in place by the app whenever the scope
+ * changes or a breadcrumb is added, and read by the daemon at crash time.
+ * See `sentry_crash_journal.h`.
+ */
+typedef struct {
+    // Number of scope snapshots written so far. Snapshot `n` lives in
+    // `scope[n % 2]`, so the previous snapshot stays intact while the next
+    // one is written.
+    volatile long scope_seq;
+    uint32_t scope_len[2];
+    char scope[2][SENTRY_CRASH_JOURNAL_SCOPE_SIZE];
+
+    // Number of breadcrumbs the daemon attaches to the scope event
+    uint32_t max_breadcrumbs;
+    // Number of breadcrumbs written so far
+    volatile long breadcrumb_count;
+    // Number of breadcrumb bytes written so far, including the breadcrumb
+    // that is currently being written (wraps around)
+    volatile long breadcrumb_head;
+    sentry_crash_journal_entry_t
+        breadcrumb_index[SENTRY_CRASH_JOURNAL_MAX_BREADCRUMBS];
+    char breadcrumbs[SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE];
+} sentry_crash_journal_t;
+
+/**
+ * Location of a variable-length table in the crash context. The offset is
+ * relative to the start of the context, so that the app and the daemon can
+ * map it at different addresses.
+ */
+typedef struct {
+    uint32_t offset;
+    uint32_t capacity; // Entries, or bytes for the string table
+} sentry_crash_table_t;
+
 /**
  * Shared memory structure for crash communication.
  * This MUST be safe to write from signal handlers (no allocations, no locks).
+ *
+ * The structure is the fixed header of the context. The thread, module and
+ * string tables follow it, sized at init from the process, and are accessed
+ * via `sentry__crash_context_threads`, `sentry__crash_context_modules` and
+ * `sentry__crash_context_string`.
  */
 typedef struct {
     // Header with magic + version for validation
     uint32_t magic;
     uint32_t version;
+    // Size of the whole context, including the tables
+    uint32_t size;
+
+    sentry_crash_table_t thread_table;
+    sentry_crash_table_t module_table;
+    sentry_crash_table_t string_table;
+    // Bytes of the string table in use. Offset 0 is the empty string.
+    uint32_t strings_used;
 
     // Atomic state machine (accessed via sentry__atomic_* functions)
     volatile long state;
@@ -292,8 +365,6 @@ typedef struct {
     char database_path[SENTRY_CRASH_MAX_PATH]; // Database directory for all
                                                // files
     char event_path[SENTRY_CRASH_MAX_PATH];
-    char breadcrumb1_path[SENTRY_CRASH_MAX_PATH];
-    char breadcrumb2_path[SENTRY_CRASH_MAX_PATH];
     char envelope_path[SENTRY_CRASH_MAX_PATH];
     char external_reporter_path[SENTRY_CRASH_MAX_PATH];
     char dsn[SENTRY_CRASH_MAX_PATH]; // Sentry DSN for uploading crashes
@@ -306,14 +377,77 @@ typedef struct {
     // Minidump output path (filled by daemon)
     char minidump_path[SENTRY_CRASH_MAX_PATH];
 
-    // Module information (captured in signal handler from dyld)
+    // Number of entries in the module table (captured in signal handler from
+    // dyld)
     uint32_t module_count;
-    sentry_module_info_t modules[SENTRY_CRASH_MAX_MODULES];
+
+    // Scope and breadcrumbs (updated by app, read by daemon)
+    sentry_crash_journal_t journal;
 
 } sentry_crash_context_t;
 
-// Shared memory size: calculated at compile-time based on actual struct size
-// Add 8KB padding for safety and future additions
-#define SENTRY_CRASH_SHM_SIZE (sizeof(sentry_crash_context_t) + (8 * 1024))
+/**
+ * Returns the size of a crash context with room for `threads` threads,
+ * `modules` modules and `strings` bytes of strings.
+ */
+size_t sentry__crash_context_size(
+    size_t threads, size_t modules, size_t strings);
+
+/**
+ * Initializes the `size` bytes at `ctx` as an empty crash context, with tables
+ * for as many threads and modules as fit.
+ */
+void sentry__crash_context_init(sentry_crash_context_t *ctx, size_t threads,
+    size_t modules, size_t strings);
+
+/**
+ * Checks the header of a crash context that was mapped with `size` bytes, and
+ * that all of its tables lie within them.
+ */
+bool sentry__crash_context_validate(
+    const sentry_crash_context_t *ctx, size_t size);
+
+/**
+ * Returns a copy of the crash context with room for at least `threads`
+ * threads, `modules` modules and `strings` bytes of strings, or NULL if it
+ * cannot be allocated. The copy must be freed with `sentry_free`.
+ */
+sentry_crash_context_t *sentry__crash_context_grow(
+    const sentry_crash_context_t *ctx, size_t threads, size_t modules,
+    size_t strings);
+
+/**
+ * Copies `len` bytes of `str` into the string table and returns their offset,
+ * or 0 (the empty string) if the table is full.
+ * This is signal-safe.
+ */
+uint32_t sentry__crash_context_add_string(
+    sentry_crash_context_t *ctx, const char *str, size_t len);
+
+static inline sentry_crash_thread_t *
+sentry__crash_context_threads(const sentry_crash_context_t *ctx)
+{
+    return (sentry_crash_thread_t *)((char *)ctx + ctx->thread_table.offset);
+}
+
+static inline sentry_module_info_t *
+sentry__crash_context_modules(const sentry_crash_context_t *ctx)
+{
+    return (sentry_module_info_t *)((char *)ctx + ctx->module_table.offset);
+}
+
+/**
+ * Returns the string at `offset` in the string table, or the empty string if
+ * the offset is out of bounds.
+ */
+static inline const char *
+sentry__crash_context_string(const sentry_crash_context_t *ctx, uint32_t offset)
+{
+    if (offset >= ctx->strings_used
+        || ctx->strings_used > ctx->string_table.capacity) {
+        return "";
+    }
+    return (const char *)ctx + ctx->string_table.offset + offset;
+}
 
 #endif
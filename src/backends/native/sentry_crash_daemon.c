@@ -5,6 +5,8 @@
 #include "sentry_attachment.h"
 #include "sentry_core.h"
 #include "sentry_crash_ipc.h"
+#include "sentry_crash_journal.h"
+#include "sentry_crash_module_cache.h"
 #include "sentry_database.h"
 #include "sentry_envelope.h"
 #include "sentry_json.h"
@@ -35,6 +37,7 @@
 #    include <errno.h>
 #    include <fcntl.h>
 #    include <inttypes.h>
+#    include <poll.h>
 #    include <signal.h>
 #    include <sys/stat.h>
 #    include <sys/types.h>
@@ -323,7 +326,7 @@ get_signal_name(int signum)
  * Build registers value from crash context for a specific thread.
  *
  * @param ctx The crash context
- * @param thread_idx Index of the thread in ctx->platform.threads[]
+ * @param thread_idx Index of the thread in the thread table of ctx
  *                   Pass SIZE_MAX to use the crashed thread context
  * @return Registers value object
  */
@@ -337,7 +340,7 @@ build_registers_from_ctx(const sentry_crash_context_t *ctx, size_t thread_idx)
     const ucontext_t *uctx = &ctx->platform.context;
     if (thread_idx != SIZE_MAX && ctx->platform.num_threads > 0
         && thread_idx < ctx->platform.num_threads) {
-        uctx = &ctx->platform.threads[thread_idx].context;
+        uctx = &sentry__crash_context_threads(ctx)[thread_idx].context;
     }
 
 #    if defined(__x86_64__)
@@ -400,7 +403,7 @@ build_registers_from_ctx(const sentry_crash_context_t *ctx, size_t thread_idx)
     const _STRUCT_MCONTEXT *mctx = &ctx->platform.mcontext;
     if (thread_idx != SIZE_MAX && ctx->platform.num_threads > 0
         && thread_idx < ctx->platform.num_threads) {
-        mctx = &ctx->platform.threads[thread_idx].state;
+        mctx = &sentry__crash_context_threads(ctx)[thread_idx].state;
     }
 
 #    if defined(__x86_64__)
@@ -460,7 +463,7 @@ build_registers_from_ctx(const sentry_crash_context_t *ctx, size_t thread_idx)
     const CONTEXT *wctx = &ctx->platform.context;
     if (thread_idx != SIZE_MAX && ctx->platform.num_threads > 0
         && thread_idx < ctx->platform.num_threads) {
-        wctx = &ctx->platform.threads[thread_idx].context;
+        wctx = &sentry__crash_context_threads(ctx)[thread_idx].context;
     }
 
 #    if defined(_M_AMD64)
@@ -593,16 +596,19 @@ static void
 enrich_frame_with_module_info(
     const sentry_crash_context_t *ctx, sentry_value_t frame, uint64_t addr)
 {
+    const sentry_module_info_t *modules = sentry__crash_context_modules(ctx);
     for (uint32_t i = 0; i < ctx->module_count; i++) {
-        const sentry_module_info_t *mod = &ctx->modules[i];
+        const sentry_module_info_t *mod = &modules[i];
         if (addr >= mod->base_address && addr < mod->base_address + mod->size) {
+            const char *name
+                = sentry__crash_context_string(ctx, mod->name_offset);
             // Set package to full module path (matches minidump format)
             sentry_value_set_by_key(
-                frame, "package", sentry_value_new_string(mod->name));
+                frame, "package", sentry_value_new_string(name));
             // Note: Do NOT set image_addr on frames - it's not present in
             // minidump-derived events and may cause symbolicator issues
-            SENTRY_DEBUGF("Frame 0x%llx -> module %s", (unsigned long long)addr,
-                mod->name);
+            SENTRY_DEBUGF(
+                "Frame 0x%llx -> module %s", (unsigned long long)addr, name);
             return;
         }
     }
@@ -616,7 +622,7 @@ enrich_frame_with_module_info(
  * unwinding. Reads the captured stack memory and walks the frame chain.
  *
  * @param ctx The crash context
- * @param thread_idx Index of the thread in ctx->platform.threads[]
+ * @param thread_idx Index of the thread in the thread table of ctx
  *                   Pass SIZE_MAX to use the crashed thread from mcontext
  * @return Stacktrace value with frames array
  */
@@ -640,7 +646,8 @@ build_stacktrace_for_thread(
     const ucontext_t *thread_context = &ctx->platform.context;
     if (thread_idx != SIZE_MAX && ctx->platform.num_threads > 0
         && thread_idx < ctx->platform.num_threads) {
-        thread_context = &ctx->platform.threads[thread_idx].context;
+        thread_context
+            = &sentry__crash_context_threads(ctx)[thread_idx].context;
     }
 
 #    if defined(__x86_64__)
@@ -675,7 +682,8 @@ build_stacktrace_for_thread(
     const CONTEXT *thread_context = &ctx->platform.context;
     if (thread_idx != SIZE_MAX && ctx->platform.num_threads > 0
         && thread_idx < ctx->platform.num_threads) {
-        thread_context = &ctx->platform.threads[thread_idx].context;
+        thread_context
+            = &sentry__crash_context_threads(ctx)[thread_idx].context;
     }
 
 #    if defined(_M_AMD64)
@@ -710,7 +718,7 @@ build_stacktrace_for_thread(
         if (idx == SIZE_MAX) {
             idx = 0;
             for (size_t i = 0; i < ctx->platform.num_threads; i++) {
-                if (ctx->platform.threads[i].tid
+                if (sentry__crash_context_threads(ctx)[i].tid
                     == (uint64_t)ctx->crashed_tid) {
                     idx = i;
                     break;
@@ -727,7 +735,7 @@ build_stacktrace_for_thread(
         }
 
         const sentry_thread_context_darwin_t *thread
-            = &ctx->platform.threads[idx];
+            = &sentry__crash_context_threads(ctx)[idx];
 
         // Use IP/FP/SP from the thread state (matches saved stack)
 #    if defined(__x86_64__)
@@ -813,7 +821,7 @@ build_stacktrace_for_thread(
     if (thread_idx != SIZE_MAX && ctx->platform.num_threads > 0
         && thread_idx < ctx->platform.num_threads) {
         const sentry_thread_context_windows_t *tctx
-            = &ctx->platform.threads[thread_idx];
+            = &sentry__crash_context_threads(ctx)[thread_idx];
         walk_context = &tctx->context;
         walk_thread_id = tctx->thread_id;
     }
@@ -1053,132 +1061,63 @@ build_stacktrace_for_thread(
     return stacktrace;
 }
 
-#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
-#    include <elf.h>
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)         \
+    || defined(SENTRY_PLATFORM_WINDOWS)
+static size_t
+grown_capacity(size_t needed, size_t capacity)
+{
+    // grow geometrically, so that a context is only moved a few times
+    return needed > capacity ? MAX(needed, capacity * 2) : capacity;
+}
 
 /**
- * Extract Build ID from ELF file (for debug_meta)
- * Returns the Build ID length, or 0 if not found
+ * Makes room for `threads` threads, `modules` modules and `strings` more bytes
+ * of strings in the crash context. The shared memory keeps the size the app
+ * chose at init, so a context that outgrows it is moved into daemon memory,
+ * which is freed by `sentry__process_crash`.
  */
-static size_t
-extract_elf_build_id_for_module(
-    const char *elf_path, uint8_t *build_id, size_t max_len)
+static bool
+reserve_crash_context(sentry_crash_context_t **ctx,
+    const sentry_crash_context_t *shared, size_t threads, size_t modules,
+    size_t strings)
 {
-    int fd = open(elf_path, O_RDONLY);
-    if (fd < 0) {
-        return 0;
-    }
-
-    // Read ELF header
-#    if defined(__x86_64__) || defined(__aarch64__)
-    Elf64_Ehdr ehdr;
-#    else
-    Elf32_Ehdr ehdr;
-#    endif
-
-    if (read(fd, &ehdr, sizeof(ehdr)) != sizeof(ehdr)) {
-        close(fd);
-        return 0;
-    }
-
-    // Verify ELF magic
-    if (memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0) {
-        close(fd);
-        return 0;
-    }
-
-    // Read section headers
-    size_t shdr_size = ehdr.e_shentsize * ehdr.e_shnum;
-    void *shdr_buf = sentry_malloc(shdr_size);
-    if (!shdr_buf) {
-        close(fd);
-        return 0;
+    sentry_crash_context_t *current = *ctx;
+    strings += current->strings_used;
+    if (threads <= current->thread_table.capacity
+        && modules <= current->module_table.capacity
+        && strings <= current->string_table.capacity) {
+        return true;
     }
 
-    if (lseek(fd, ehdr.e_shoff, SEEK_SET) != (off_t)ehdr.e_shoff
-        || read(fd, shdr_buf, shdr_size) != (ssize_t)shdr_size) {
-        sentry_free(shdr_buf);
-        close(fd);
-        return 0;
+    sentry_crash_context_t *grown = sentry__crash_context_grow(current,
+        grown_capacity(threads, current->thread_table.capacity),
+        grown_capacity(modules, current->module_table.capacity),
+        grown_capacity(strings, current->string_table.capacity));
+    if (!grown) {
+        SENTRY_WARN("failed to grow the crash context");
+        return false;
     }
-
-#    if defined(__x86_64__) || defined(__aarch64__)
-    Elf64_Shdr *sections = (Elf64_Shdr *)shdr_buf;
-#    else
-    Elf32_Shdr *sections = (Elf32_Shdr *)shdr_buf;
-#    endif
-
-    // Look for .note.gnu.build-id section
-    size_t build_id_len = 0;
-    for (int i = 0; i < ehdr.e_shnum; i++) {
-        if (sections[i].sh_type == SHT_NOTE) {
-            // Read note section
-            size_t note_size = sections[i].sh_size;
-            if (note_size > 4096) {
-                continue; // Sanity check
-            }
-
-            void *note_buf = sentry_malloc(note_size);
-            if (!note_buf) {
-                continue;
-            }
-
-            if (lseek(fd, sections[i].sh_offset, SEEK_SET)
-                    == (off_t)sections[i].sh_offset
-                && read(fd, note_buf, note_size) == (ssize_t)note_size) {
-
-                // Parse notes
-                uint8_t *ptr = (uint8_t *)note_buf;
-                uint8_t *end = ptr + note_size;
-
-                while (ptr + 12 <= end) {
-#    if defined(__x86_64__) || defined(__aarch64__)
-                    Elf64_Nhdr *nhdr = (Elf64_Nhdr *)ptr;
-#    else
-                    Elf32_Nhdr *nhdr = (Elf32_Nhdr *)ptr;
-#    endif
-                    ptr += sizeof(*nhdr);
-
-                    if (ptr + nhdr->n_namesz + nhdr->n_descsz > end) {
-                        break;
-                    }
-
-                    // Check if this is GNU Build ID (type 3, name "GNU\0")
-                    if (nhdr->n_type == 3 && nhdr->n_namesz == 4
-                        && memcmp(ptr, "GNU", 4) == 0) {
-
-                        ptr += ((nhdr->n_namesz + 3) & ~3); // Align to 4 bytes
-                        size_t len = nhdr->n_descsz < max_len ? nhdr->n_descsz
-                                                              : max_len;
-                        memcpy(build_id, ptr, len);
-                        build_id_len = len;
-                        sentry_free(note_buf);
-                        goto done;
-                    }
-
-                    ptr += ((nhdr->n_namesz + 3) & ~3);
-                    ptr += ((nhdr->n_descsz + 3) & ~3);
-                }
-            }
-
-            sentry_free(note_buf);
-        }
+    SENTRY_DEBUGF("moved the crash context into daemon memory (%u bytes)",
+        grown->size);
+    if (current != shared) {
+        sentry_free(current);
     }
-
-done:
-    sentry_free(shdr_buf);
-    close(fd);
-    return build_id_len;
+    *ctx = grown;
+    return true;
 }
+#endif
 
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
 /**
  * Capture modules from /proc/<pid>/maps for debug_meta
- * This is called from the daemon to populate ctx->modules[] on Linux,
+ * This is called from the daemon to populate the module table on Linux,
  * since the signal handler cannot safely enumerate modules.
  */
 static void
-capture_modules_from_proc_maps(sentry_crash_context_t *ctx)
+capture_modules_from_proc_maps(
+    sentry_crash_context_t **ctx_ptr, const sentry_crash_context_t *shared)
 {
+    sentry_crash_context_t *ctx = *ctx_ptr;
     char maps_path[64];
     snprintf(maps_path, sizeof(maps_path), "/proc/%d/maps", ctx->crashed_pid);
 
@@ -1191,8 +1130,7 @@ capture_modules_from_proc_maps(sentry_crash_context_t *ctx)
     char line[1024];
     ctx->module_count = 0;
 
-    while (fgets(line, sizeof(line), f)
-        && ctx->module_count < SENTRY_CRASH_MAX_MODULES) {
+    while (fgets(line, sizeof(line), f)) {
 
         // Parse line: "start-end perms offset dev inode pathname"
         unsigned long long start, end, offset;
@@ -1223,11 +1161,13 @@ capture_modules_from_proc_maps(sentry_crash_context_t *ctx)
         }
 
         // Check if this file is already captured - if so, extend size if needed
+        sentry_module_info_t *modules = sentry__crash_context_modules(ctx);
         sentry_module_info_t *existing_mod = NULL;
         for (uint32_t j = 0; j < ctx->module_count; j++) {
-            if (strncmp(ctx->modules[j].name, pathname, len) == 0
-                && ctx->modules[j].name[len] == '\0') {
-                existing_mod = &ctx->modules[j];
+            const char *name
+                = sentry__crash_context_string(ctx, modules[j].name_offset);
+            if (strncmp(name, pathname, len) == 0 && name[len] == '\0') {
+                existing_mod = &modules[j];
                 break;
             }
         }
@@ -1245,7 +1185,13 @@ capture_modules_from_proc_maps(sentry_crash_context_t *ctx)
             continue;
         }
 
-        sentry_module_info_t *mod = &ctx->modules[ctx->module_count];
+        if (!reserve_crash_context(
+                ctx_ptr, shared, 0, ctx->module_count + 1, len + 1)) {
+            break;
+        }
+        ctx = *ctx_ptr;
+        sentry_module_info_t *mod
+            = &sentry__crash_context_modules(ctx)[ctx->module_count];
 
         // Calculate base address: for PIE binaries, the file offset tells us
         // how far into the file this mapping starts, so we subtract it to get
@@ -1255,21 +1201,22 @@ capture_modules_from_proc_maps(sentry_crash_context_t *ctx)
         mod->size = end - mod->base_address;
 
         // Copy pathname
-        size_t copy_len
-            = len < sizeof(mod->name) - 1 ? len : sizeof(mod->name) - 1;
-        memcpy(mod->name, pathname, copy_len);
-        mod->name[copy_len] = '\0';
+        mod->name_offset = sentry__crash_context_add_string(ctx, pathname, len);
+        const char *name = sentry__crash_context_string(ctx, mod->name_offset);
 
-        // Extract Build ID from ELF file
+        // Look up the Build ID the daemon cached while it was waiting
         memset(mod->uuid, 0, sizeof(mod->uuid));
         mod->pdb_age = 0; // Not used on Linux, only for Windows PE modules
-        extract_elf_build_id_for_module(
-            mod->name, mod->uuid, sizeof(mod->uuid));
+        sentry_crash_module_identity_t identity;
+        if (sentry__crash_module_cache_get(name, &identity)) {
+            memcpy(mod->uuid, identity.build_id,
+                MIN(identity.build_id_len, sizeof(mod->uuid)));
+        }
 
         // Convert to little-endian GUID format for Sentry debug_id
         sentry__uuid_swap_guid_bytes(mod->uuid);
 
-        SENTRY_DEBUGF("Captured module: %s base=0x%llx size=0x%llx", mod->name,
+        SENTRY_DEBUGF("Captured module: %s base=0x%llx size=0x%llx", name,
             (unsigned long long)mod->base_address,
             (unsigned long long)mod->size);
 
@@ -1281,14 +1228,70 @@ capture_modules_from_proc_maps(sentry_crash_context_t *ctx)
         ctx->crashed_pid);
 }
 
+/**
+ * Loads the module cache persisted in the database directory of `ctx`, and
+ * stores its path in `cache_path`, or an empty path to keep the cache in
+ * memory only.
+ */
+static void
+load_module_cache(
+    const sentry_crash_context_t *ctx, char *cache_path, size_t path_size)
+{
+    if (snprintf(cache_path, path_size, "%s/module-cache", ctx->database_path)
+        >= (int)path_size) {
+        cache_path[0] = '\0';
+    }
+    sentry__crash_module_cache_load(cache_path);
+}
+
+/**
+ * Caches the identities of all modules mapped into the app, and persists them
+ * for the next run if any were added.
+ */
+static void
+refresh_module_cache(pid_t app_pid, const char *cache_path)
+{
+    size_t parsed = sentry__crash_module_cache_warm(app_pid);
+    if (parsed > 0) {
+        SENTRY_DEBUGF("Cached the identities of %zu new modules", parsed);
+        if (cache_path[0] != '\0') {
+            sentry__crash_module_cache_save(cache_path);
+        }
+    }
+}
+
+/**
+ * Reads the name of the thread `tid` of `pid` into `name`.
+ */
+static void
+read_thread_name(pid_t pid, pid_t tid, char *name, size_t name_size)
+{
+    name[0] = '\0';
+    char comm_path[64];
+    snprintf(comm_path, sizeof(comm_path), "/proc/%d/task/%d/comm", pid, tid);
+    FILE *comm_file = fopen(comm_path, "r");
+    if (comm_file) {
+        if (fgets(name, (int)name_size, comm_file)) {
+            // Trim trailing newline
+            size_t len = strlen(name);
+            if (len > 0 && name[len - 1] == '\n') {
+                name[len - 1] = '\0';
+            }
+        }
+        fclose(comm_file);
+    }
+}
+
 /**
  * Enumerate threads from /proc/<pid>/task for the native event
- * This is called from the daemon to populate ctx->platform.threads[] on Linux,
+ * This is called from the daemon to populate the thread table on Linux,
  * since the signal handler can only capture the crashing thread.
  */
 static void
-enumerate_threads_from_proc(sentry_crash_context_t *ctx)
+enumerate_threads_from_proc(
+    sentry_crash_context_t **ctx_ptr, const sentry_crash_context_t *shared)
 {
+    sentry_crash_context_t *ctx = *ctx_ptr;
     char task_path[64];
     snprintf(task_path, sizeof(task_path), "/proc/%d/task", ctx->crashed_pid);
 
@@ -1299,31 +1302,16 @@ enumerate_threads_from_proc(sentry_crash_context_t *ctx)
     }
 
     // Keep the crashed thread at index 0 (already captured by signal handler)
-    pid_t crashed_tid = ctx->platform.threads[0].tid;
+    sentry_crash_thread_t *threads = sentry__crash_context_threads(ctx);
+    pid_t crashed_tid = threads[0].tid;
     size_t thread_count = 1; // Start at 1 since we already have crashed thread
 
     // Read thread name for the crashed thread (index 0)
-    ctx->platform.threads[0].name[0] = '\0';
-    {
-        char comm_path[64];
-        snprintf(comm_path, sizeof(comm_path), "/proc/%d/task/%d/comm",
-            ctx->crashed_pid, crashed_tid);
-        FILE *comm_file = fopen(comm_path, "r");
-        if (comm_file) {
-            if (fgets(ctx->platform.threads[0].name,
-                    sizeof(ctx->platform.threads[0].name), comm_file)) {
-                // Trim trailing newline
-                size_t len = strlen(ctx->platform.threads[0].name);
-                if (len > 0 && ctx->platform.threads[0].name[len - 1] == '\n') {
-                    ctx->platform.threads[0].name[len - 1] = '\0';
-                }
-            }
-            fclose(comm_file);
-        }
-    }
+    read_thread_name(ctx->crashed_pid, crashed_tid, threads[0].name,
+        sizeof(threads[0].name));
 
     struct dirent *entry;
-    while ((entry = readdir(dir)) && thread_count < SENTRY_CRASH_MAX_THREADS) {
+    while ((entry = readdir(dir))) {
         if (entry->d_name[0] == '.') {
             continue;
         }
@@ -1333,31 +1321,20 @@ enumerate_threads_from_proc(sentry_crash_context_t *ctx)
             continue; // Skip invalid or already-captured crashed thread
         }
 
+        if (!reserve_crash_context(ctx_ptr, shared, thread_count + 1, 0, 0)) {
+            break;
+        }
+        ctx = *ctx_ptr;
+        sentry_crash_thread_t *thread
+            = &sentry__crash_context_threads(ctx)[thread_count];
+
         // Add this thread (without full context - just the TID)
-        ctx->platform.threads[thread_count].tid = tid;
-        memset(&ctx->platform.threads[thread_count].context, 0,
-            sizeof(ctx->platform.threads[thread_count].context));
+        thread->tid = tid;
+        memset(&thread->context, 0, sizeof(thread->context));
 
         // Read thread name from /proc/[pid]/task/[tid]/comm
-        ctx->platform.threads[thread_count].name[0] = '\0';
-        char comm_path[64];
-        snprintf(comm_path, sizeof(comm_path), "/proc/%d/task/%d/comm",
-            ctx->crashed_pid, tid);
-        FILE *comm_file = fopen(comm_path, "r");
-        if (comm_file) {
-            if (fgets(ctx->platform.threads[thread_count].name,
-                    sizeof(ctx->platform.threads[thread_count].name),
-                    comm_file)) {
-                // Trim trailing newline
-                size_t len = strlen(ctx->platform.threads[thread_count].name);
-                if (len > 0
-                    && ctx->platform.threads[thread_count].name[len - 1]
-                        == '\n') {
-                    ctx->platform.threads[thread_count].name[len - 1] = '\0';
-                }
-            }
-            fclose(comm_file);
-        }
+        read_thread_name(
+            ctx->crashed_pid, tid, thread->name, sizeof(thread->name));
 
         thread_count++;
     }
@@ -1697,8 +1674,10 @@ extract_pdb_info_from_process(HANDLE hProcess, uint64_t module_base,
  * Capture modules from the crashed process for debug_meta on Windows
  */
 static void
-capture_modules_from_process(sentry_crash_context_t *ctx)
+capture_modules_from_process(
+    sentry_crash_context_t **ctx_ptr, const sentry_crash_context_t *shared)
 {
+    sentry_crash_context_t *ctx = *ctx_ptr;
     HANDLE hProcess = OpenProcess(
         PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE, ctx->crashed_pid);
     if (!hProcess) {
@@ -1707,24 +1686,28 @@ capture_modules_from_process(sentry_crash_context_t *ctx)
         return;
     }
 
-    HMODULE hMods[SENTRY_CRASH_MAX_MODULES];
-    DWORD cbNeeded;
-
-    if (!EnumProcessModules(hProcess, hMods, sizeof(hMods), &cbNeeded)) {
+    // Ask for the number of modules first, then fetch all of them
+    DWORD cbNeeded = 0;
+    if (!EnumProcessModules(hProcess, NULL, 0, &cbNeeded) || cbNeeded == 0) {
         SENTRY_WARN("EnumProcessModules failed");
         CloseHandle(hProcess);
         return;
     }
-
-    DWORD module_count = cbNeeded / sizeof(HMODULE);
-    if (module_count > SENTRY_CRASH_MAX_MODULES) {
-        module_count = SENTRY_CRASH_MAX_MODULES;
+    DWORD cbAllocated = cbNeeded;
+    HMODULE *hMods = sentry_malloc(cbAllocated);
+    if (!hMods
+        || !EnumProcessModules(hProcess, hMods, cbAllocated, &cbNeeded)) {
+        SENTRY_WARN("EnumProcessModules failed");
+        sentry_free(hMods);
+        CloseHandle(hProcess);
+        return;
     }
 
+    // Modules loaded in between are skipped
+    DWORD module_count = MIN(cbNeeded, cbAllocated) / sizeof(HMODULE);
+
     ctx->module_count = 0;
     for (DWORD i = 0; i < module_count; i++) {
-        sentry_module_info_t *mod = &ctx->modules[ctx->module_count];
-
         // Get module file name
         char modName[MAX_PATH];
         if (!GetModuleFileNameExA(
@@ -1739,22 +1722,35 @@ capture_modules_from_process(sentry_crash_context_t *ctx)
             continue;
         }
 
+        // Room for the module, and its module and PDB names
+        if (!reserve_crash_context(
+                ctx_ptr, shared, 0, ctx->module_count + 1, 2 * MAX_PATH)) {
+            break;
+        }
+        ctx = *ctx_ptr;
+        sentry_module_info_t *mod
+            = &sentry__crash_context_modules(ctx)[ctx->module_count];
+
         mod->base_address = (uint64_t)(uintptr_t)modInfo.lpBaseOfDll;
         mod->size = (uint64_t)modInfo.SizeOfImage;
-        strncpy(mod->name, modName, sizeof(mod->name) - 1);
-        mod->name[sizeof(mod->name) - 1] = '\0';
+        mod->name_offset
+            = sentry__crash_context_add_string(ctx, modName, strlen(modName));
 
         // Extract PDB GUID, age, and filename from PE debug directory
+        char pdbName[MAX_PATH];
         extract_pdb_info_from_process(hProcess, mod->base_address, mod->uuid,
-            &mod->pdb_age, mod->pdb_name, sizeof(mod->pdb_name));
+            &mod->pdb_age, pdbName, sizeof(pdbName));
+        mod->pdb_name_offset
+            = sentry__crash_context_add_string(ctx, pdbName, strlen(pdbName));
 
         SENTRY_DEBUGF("Captured module: %s base=0x%llx size=0x%llx pdb_age=%u",
-            mod->name, (unsigned long long)mod->base_address,
+            modName, (unsigned long long)mod->base_address,
             (unsigned long long)mod->size, mod->pdb_age);
 
         ctx->module_count++;
     }
 
+    sentry_free(hMods);
     CloseHandle(hProcess);
     SENTRY_DEBUGF("Captured %u modules from process %d", ctx->module_count,
         ctx->crashed_pid);
@@ -1767,8 +1763,9 @@ static bool
 thread_id_exists(
     const sentry_crash_context_t *ctx, DWORD thread_id, DWORD count)
 {
+    const sentry_crash_thread_t *threads = sentry__crash_context_threads(ctx);
     for (DWORD i = 0; i < count; i++) {
-        if (ctx->platform.threads[i].thread_id == thread_id) {
+        if (threads[i].thread_id == thread_id) {
             return true;
         }
     }
@@ -1814,12 +1811,15 @@ get_thread_name(HANDLE hThread, sentry_thread_context_windows_t *tctx)
  * per-thread metadata from the Sentry event payload.
  */
 static void
-enumerate_threads_from_process(sentry_crash_context_t *ctx)
+enumerate_threads_from_process(
+    sentry_crash_context_t **ctx_ptr, const sentry_crash_context_t *shared)
 {
 #    if defined(SENTRY_PLATFORM_XBOX)
-    (void)ctx;
+    (void)ctx_ptr;
+    (void)shared;
     return;
 #    else
+    sentry_crash_context_t *ctx = *ctx_ptr;
     HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
     if (hSnapshot == INVALID_HANDLE_VALUE) {
         SENTRY_WARN("CreateToolhelp32Snapshot failed");
@@ -1833,7 +1833,8 @@ enumerate_threads_from_process(sentry_crash_context_t *ctx)
     // Retrieve the name for the crashed thread (index 0)
     HANDLE hCrashedThread
         = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, crashed_tid);
-    get_thread_name(hCrashedThread, &ctx->platform.threads[0]);
+    sentry_crash_thread_t *crashed_thread = sentry__crash_context_threads(ctx);
+    get_thread_name(hCrashedThread, crashed_thread);
     if (hCrashedThread) {
         CloseHandle(hCrashedThread);
     }
@@ -1841,7 +1842,7 @@ enumerate_threads_from_process(sentry_crash_context_t *ctx)
     SENTRY_DEBUGF(
         "enumerate_threads: start, crashed_tid=%lu, threads[0].id=%lu",
         (unsigned long)crashed_tid,
-        (unsigned long)ctx->platform.threads[0].thread_id);
+        (unsigned long)crashed_thread->thread_id);
 
     THREADENTRY32 te32;
     te32.dwSize = sizeof(THREADENTRY32);
@@ -1850,8 +1851,7 @@ enumerate_threads_from_process(sentry_crash_context_t *ctx)
         do {
             // Skip if not our process, is the crashed thread, or already seen
             if (te32.th32OwnerProcessID != (DWORD)ctx->crashed_pid
-                || te32.th32ThreadID == crashed_tid
-                || thread_count >= SENTRY_CRASH_MAX_THREADS) {
+                || te32.th32ThreadID == crashed_tid) {
                 continue;
             }
 
@@ -1873,8 +1873,17 @@ enumerate_threads_from_process(sentry_crash_context_t *ctx)
                 continue;
             }
 
+            if (!reserve_crash_context(
+                    ctx_ptr, shared, thread_count + 1, 0, 0)) {
+                CloseHandle(hThread);
+                break;
+            }
+            ctx = *ctx_ptr;
+            sentry_crash_thread_t *thread
+                = &sentry__crash_context_threads(ctx)[thread_count];
+
             // Retrieve thread name before suspending
-            get_thread_name(hThread, &ctx->platform.threads[thread_count]);
+            get_thread_name(hThread, thread);
 
             // Suspend thread to safely capture context
             // (likely already suspended due to crash, but be safe)
@@ -1902,8 +1911,8 @@ enumerate_threads_from_process(sentry_crash_context_t *ctx)
             }
 
             // Store thread info with captured context
-            ctx->platform.threads[thread_count].thread_id = te32.th32ThreadID;
-            ctx->platform.threads[thread_count].context = thread_ctx;
+            thread->thread_id = te32.th32ThreadID;
+            thread->context = thread_ctx;
             thread_count++;
 
             SENTRY_DEBUGF("Captured context for thread %lu",
@@ -1931,16 +1940,15 @@ build_stacktrace_from_ctx(const sentry_crash_context_t *ctx)
 }
 
 /**
- * Build native crash event with exception, mechanism, and debug_meta
+ * Read the base event of the crashed process.
  *
- * @param ctx Crash context
- * @param event_file_path Path to event file from parent process
+ * The event file written by the crash handler takes precedence. Without it,
+ * the event is rebuilt from the scope and breadcrumbs journaled in shared
+ * memory. Returns null if neither is available.
  */
 static sentry_value_t
-build_native_crash_event(
-    const sentry_crash_context_t *ctx, const char *event_file_path)
+read_base_event(const sentry_crash_context_t *ctx, const char *event_file_path)
 {
-    // Read base event from parent's file
     sentry_value_t event = sentry_value_new_null();
     if (event_file_path && event_file_path[0]) {
         sentry_path_t *ev_path = sentry__path_from_str(event_file_path);
@@ -1951,11 +1959,28 @@ build_native_crash_event(
             sentry__path_free(ev_path);
             if (event_json && event_size > 0) {
                 event = sentry__value_from_json(event_json, event_size);
-                sentry_free(event_json);
             }
+            sentry_free(event_json);
         }
     }
+    if (sentry_value_is_null(event)) {
+        SENTRY_DEBUG("no event file from parent, reading crash journal");
+        event = sentry__crash_journal_read_event(&ctx->journal);
+    }
+    return event;
+}
 
+/**
+ * Build native crash event with exception, mechanism, and debug_meta
+ *
+ * @param ctx Crash context
+ * @param event_file_path Path to event file from parent process
+ */
+static sentry_value_t
+build_native_crash_event(
+    const sentry_crash_context_t *ctx, const char *event_file_path)
+{
+    sentry_value_t event = read_base_event(ctx, event_file_path);
     if (sentry_value_is_null(event)) {
         event = sentry_value_new_event();
     }
@@ -2030,7 +2055,7 @@ build_native_crash_event(
         // Add all captured threads
         for (size_t i = 0; i < ctx->platform.num_threads; i++) {
             const sentry_thread_context_darwin_t *tctx
-                = &ctx->platform.threads[i];
+                = &sentry__crash_context_threads(ctx)[i];
             sentry_value_t thread = sentry_value_new_object();
 
             sentry_value_set_by_key(
@@ -2058,7 +2083,7 @@ build_native_crash_event(
         // Add all captured threads
         for (size_t i = 0; i < ctx->platform.num_threads; i++) {
             const sentry_thread_context_linux_t *tctx
-                = &ctx->platform.threads[i];
+                = &sentry__crash_context_threads(ctx)[i];
             sentry_value_t thread = sentry_value_new_object();
 
             sentry_value_set_by_key(
@@ -2094,7 +2119,7 @@ build_native_crash_event(
             (unsigned long)ctx->platform.num_threads);
         for (DWORD i = 0; i < ctx->platform.num_threads; i++) {
             const sentry_thread_context_windows_t *tctx
-                = &ctx->platform.threads[i];
+                = &sentry__crash_context_threads(ctx)[i];
             sentry_value_t thread = sentry_value_new_object();
 
             sentry_value_set_by_key(
@@ -2144,14 +2169,17 @@ build_native_crash_event(
     }
 
     // Add debug_meta with module images from crashed process
-    // (ctx->modules[] was captured in the signal handler of the crashed
+    // (the module table was captured in the signal handler of the crashed
     // process)
     SENTRY_DEBUGF("Module count for debug_meta: %u", ctx->module_count);
     if (ctx->module_count > 0) {
         sentry_value_t images = sentry_value_new_list();
 
         for (uint32_t i = 0; i < ctx->module_count; i++) {
-            const sentry_module_info_t *mod = &ctx->modules[i];
+            const sentry_module_info_t *mod
+                = &sentry__crash_context_modules(ctx)[i];
+            const char *mod_name
+                = sentry__crash_context_string(ctx, mod->name_offset);
             sentry_value_t image = sentry_value_new_object();
 
             // Set image type based on platform
@@ -2180,9 +2208,9 @@ build_native_crash_event(
 #endif
 
             // Set code_file (path to the module)
-            if (mod->name[0]) {
+            if (mod_name[0]) {
                 sentry_value_set_by_key(
-                    image, "code_file", sentry_value_new_string(mod->name));
+                    image, "code_file", sentry_value_new_string(mod_name));
             }
 
             // Set image_addr as hex string
@@ -2199,8 +2227,8 @@ build_native_crash_event(
             // Set code_id for PE modules (TimeDateStamp + SizeOfImage)
             // Format: 8-digit zero-padded timestamp (uppercase) + size
             // (uppercase) Must match sentry_modulefinder_windows.c format
-            if (mod->name[0]) {
-                DWORD timestamp = get_pe_timestamp(mod->name);
+            if (mod_name[0]) {
+                DWORD timestamp = get_pe_timestamp(mod_name);
                 if (timestamp != 0) {
                     char code_id_buf[32];
                     snprintf(code_id_buf, sizeof(code_id_buf), "%08lX%lX",
@@ -2249,9 +2277,11 @@ build_native_crash_event(
             }
 
             // Set debug_file (path to PDB file for symbolication)
-            if (mod->pdb_name[0]) {
-                sentry_value_set_by_key(image, "debug_file",
-                    sentry_value_new_string(mod->pdb_name));
+            const char *pdb_name
+                = sentry__crash_context_string(ctx, mod->pdb_name_offset);
+            if (pdb_name[0]) {
+                sentry_value_set_by_key(
+                    image, "debug_file", sentry_value_new_string(pdb_name));
             }
 #else
             // Set debug_id from UUID (macOS/Linux)
@@ -2527,18 +2557,14 @@ write_envelope_with_minidump(const sentry_options_t *options,
     size_t event_size = 0;
     char *event_json = NULL;
     char *event_id = NULL;
-    sentry_path_t *ev_path = sentry__path_from_str(event_msgpack_path);
-    if (ev_path) {
-        event_json = sentry__path_read_to_buffer(ev_path, &event_size);
-        sentry__path_free(ev_path);
-        if (event_json && event_size > 0) {
-            sentry_value_t event
-                = sentry__value_from_json(event_json, event_size);
-            event_id = sentry__string_clone(sentry_value_as_string(
-                sentry_value_get_by_key(event, "event_id")));
-            sentry_value_decref(event);
-        }
+    sentry_value_t event = read_base_event(ctx, event_msgpack_path);
+    if (!sentry_value_is_null(event)) {
+        event_json = sentry_value_to_json(event);
+        event_size = event_json ? strlen(event_json) : 0;
+        event_id = sentry__string_clone(sentry_value_as_string(
+            sentry_value_get_by_key(event, "event_id")));
     }
+    sentry_value_decref(event);
 
     // Open envelope file for writing
 #if defined(SENTRY_PLATFORM_UNIX)
@@ -2749,6 +2775,29 @@ write_envelope_with_minidump(const sentry_options_t *options,
     return true;
 }
 
+/**
+ * Sends an envelope of the crash of the app that owns `ctx`, or caches or
+ * discards it while that app lacks the required user consent. The consent is
+ * taken from the context of the app rather than from the run of the daemon,
+ * which a shared daemon has only one of for all of its apps.
+ */
+static void
+capture_crash_envelope(const sentry_options_t *options,
+    sentry_crash_context_t *ctx, sentry_envelope_t *envelope)
+{
+    if (!ctx->require_user_consent
+        || sentry__atomic_fetch(&ctx->user_consent)
+            == SENTRY_USER_CONSENT_GIVEN) {
+        sentry__transport_send_envelope(options->transport, envelope);
+        return;
+    }
+    bool cached = options->cache_keep
+        && sentry__run_write_cache(options->run, envelope, 0);
+    SENTRY_INFO(cached ? "caching envelope due to missing user consent"
+                       : "discarding envelope due to missing user consent");
+    sentry_envelope_free(envelope);
+}
+
 /**
  * Process crash and generate minidump
  * Uses Sentry's API to reuse all existing functionality
@@ -2760,12 +2809,19 @@ sentry__process_crash(const sentry_options_t *options, sentry_crash_ipc_t *ipc)
 {
     SENTRY_DEBUG("Processing crash - START");
 
+    // The context moves into daemon memory if the threads and modules that
+    // are enumerated below do not fit the shared memory
     sentry_crash_context_t *ctx = ipc->shmem;
 
     // Mark as processing
     sentry__atomic_store(&ctx->state, SENTRY_CRASH_STATE_PROCESSING);
     SENTRY_DEBUG("Marked state as PROCESSING");
 
+    // The counts were written by the crashed app, keep them within the tables
+    ctx->platform.num_threads
+        = MIN(ctx->platform.num_threads, ctx->thread_table.capacity);
+    ctx->module_count = MIN(ctx->module_count, ctx->module_table.capacity);
+
     // Check crash reporting mode
     int mode = ctx->crash_reporting_mode;
     SENTRY_DEBUGF("Crash reporting mode: %d", mode);
@@ -2930,11 +2986,11 @@ sentry__process_crash(const sentry_options_t *options, sentry_crash_ipc_t *ipc)
     if (use_native_mode) {
         if (ctx->module_count == 0) {
             SENTRY_DEBUG("Capturing modules from /proc/maps for debug_meta");
-            capture_modules_from_proc_maps(ctx);
+            capture_modules_from_proc_maps(&ctx, ipc->shmem);
         }
         if (ctx->platform.num_threads <= 1) {
             SENTRY_DEBUG("Enumerating threads from /proc/task");
-            enumerate_threads_from_proc(ctx);
+            enumerate_threads_from_proc(&ctx, ipc->shmem);
         }
     }
 #endif
@@ -2944,11 +3000,11 @@ sentry__process_crash(const sentry_options_t *options, sentry_crash_ipc_t *ipc)
     if (use_native_mode) {
         if (ctx->module_count == 0) {
             SENTRY_DEBUG("Capturing modules from crashed process");
-            capture_modules_from_process(ctx);
+            capture_modules_from_process(&ctx, ipc->shmem);
         }
         if (ctx->platform.num_threads <= 1) {
             SENTRY_DEBUG("Enumerating threads from crashed process");
-            enumerate_threads_from_process(ctx);
+            enumerate_threads_from_process(&ctx, ipc->shmem);
         }
     }
 #endif
@@ -3010,11 +3066,6 @@ sentry__process_crash(const sentry_options_t *options, sentry_crash_ipc_t *ipc)
     }
 #endif
 
-    if (options->run) {
-        sentry__atomic_store(&options->run->user_consent,
-            sentry__atomic_fetch(&ctx->user_consent));
-    }
-
     sentry_path_t *env_path = sentry__path_from_str(envelope_path);
     if (!env_path) {
         SENTRY_WARN("Failed to create envelope path");
@@ -3046,7 +3097,7 @@ sentry__process_crash(const sentry_options_t *options, sentry_crash_ipc_t *ipc)
         }
         if (options && options->transport && options->run) {
             SENTRY_DEBUG("Capturing crash envelope");
-            sentry__capture_envelope(options->transport, envelope, options);
+            capture_crash_envelope(options, ctx, envelope);
             SENTRY_DEBUG("Crash envelope captured (queued)");
         } else {
             SENTRY_WARN("No transport available for sending envelope");
@@ -3085,8 +3136,7 @@ cleanup:
                     sentry_envelope_t *run_envelope
                         = sentry__envelope_from_path(file_path);
                     if (run_envelope) {
-                        sentry__capture_envelope(
-                            options->transport, run_envelope, options);
+                        capture_crash_envelope(options, ctx, run_envelope);
                         envelope_count++;
                     } else {
                         SENTRY_WARNF("Failed to load envelope: %s", path_str);
@@ -3120,6 +3170,9 @@ cleanup:
     SENTRY_DEBUG("Crash processing completed successfully");
 
 done:
+    if (ctx != ipc->shmem) {
+        sentry_free(ctx);
+    }
     SENTRY_DEBUG("Processing crash - END");
     SENTRY_DEBUG("Crash processing complete");
 }
@@ -3171,48 +3224,21 @@ daemon_file_logger(
     fflush(log_file); // Flush immediately to ensure logs are written
 }
 
-#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
-int
-sentry__crash_daemon_main(
-    pid_t app_pid, uint64_t app_tid, int notify_eventfd, int ready_eventfd)
-#elif defined(SENTRY_PLATFORM_MACOS)
-int
-sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, int notify_pipe_read,
-    int ready_pipe_write, int shm_fd)
-#elif defined(SENTRY_PLATFORM_WINDOWS)
-int
-sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
-    HANDLE ready_event_handle)
-#endif
+/**
+ * Opens the log file `log_name` of the daemon in the database directory of
+ * `ctx`, and routes the SDK logger to it.
+ */
+static FILE *
+open_daemon_log(const sentry_crash_context_t *ctx, const char *log_name)
 {
-    // Initialize IPC first (attach to shared memory created by parent)
-    // We need this to get the database path for logging
-#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
-    sentry_crash_ipc_t *ipc = sentry__crash_ipc_init_daemon(
-        app_pid, app_tid, notify_eventfd, ready_eventfd);
-#elif defined(SENTRY_PLATFORM_MACOS)
-    sentry_crash_ipc_t *ipc = sentry__crash_ipc_init_daemon(
-        app_pid, app_tid, notify_pipe_read, ready_pipe_write, shm_fd);
-#elif defined(SENTRY_PLATFORM_WINDOWS)
-    sentry_crash_ipc_t *ipc = sentry__crash_ipc_init_daemon(
-        app_pid, app_tid, event_handle, ready_event_handle);
-#endif
-    if (!ipc) {
-        return 1;
-    }
-
-    // Set up logging to file for daemon BEFORE redirecting streams
-    // Use same naming scheme as shared memory (PID ^ TID hash) to handle
-    // multiple threads in same process
     char log_path[SENTRY_CRASH_MAX_PATH];
     FILE *log_file = NULL;
-    uint32_t id = (uint32_t)((app_pid ^ (app_tid & 0xFFFFFFFF)) & 0xFFFFFFFF);
 
 #if defined(SENTRY_PLATFORM_WINDOWS)
     // On Windows, convert UTF-8 path to wide characters for proper file
     // handling
-    int log_path_len = snprintf(log_path, sizeof(log_path),
-        "%s\\sentry-daemon-%08x.log", ipc->shmem->database_path, id);
+    int log_path_len = snprintf(log_path, sizeof(log_path), "%s\\%s.log",
+        ctx->database_path, log_name);
 
     if (log_path_len > 0 && log_path_len < (int)sizeof(log_path)) {
         wchar_t *wlog_path = sentry__string_to_wstr(log_path);
@@ -3222,8 +3248,8 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
         }
     }
 #else
-    int log_path_len = snprintf(log_path, sizeof(log_path),
-        "%s/sentry-daemon-%08x.log", ipc->shmem->database_path, id);
+    int log_path_len = snprintf(log_path, sizeof(log_path), "%s/%s.log",
+        ctx->database_path, log_name);
 
     if (log_path_len > 0 && log_path_len < (int)sizeof(log_path)) {
         log_file = fopen(log_path, "w");
@@ -3236,20 +3262,23 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
 
         // Set up Sentry logger to write to file
         // Use log level from parent's debug setting
-        sentry_level_t log_level = ipc->shmem->debug_enabled
-            ? SENTRY_LEVEL_DEBUG
-            : SENTRY_LEVEL_INFO;
+        sentry_level_t log_level
+            = ctx->debug_enabled ? SENTRY_LEVEL_DEBUG : SENTRY_LEVEL_INFO;
         sentry_logger_t file_logger = { .logger_func = daemon_file_logger,
             .logger_data = log_file,
             .logger_level = log_level };
         sentry__logger_set_global(file_logger);
         sentry__logger_enable();
-
-        SENTRY_DEBUG("=== Daemon starting ===");
-        SENTRY_DEBUGF("App PID: %lu", (unsigned long)app_pid);
-        SENTRY_DEBUGF("Database path: %s", ipc->shmem->database_path);
     }
+    return log_file;
+}
 
+/**
+ * Detaches the standard streams of the daemon from the app.
+ */
+static void
+detach_std_streams(void)
+{
 #if defined(SENTRY_PLATFORM_UNIX)
     // Close standard streams to avoid interfering with parent
     close(STDIN_FILENO);
@@ -3274,25 +3303,30 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
 
     (void)freopen("NUL", "w", stderr);
 #endif
+}
 
+/**
+ * Creates the options of the daemon from the configuration the app stored in
+ * `ctx`, and starts the transport.
+ */
+static sentry_options_t *
+daemon_options_new(const sentry_crash_context_t *ctx, FILE *log_file)
+{
     // Initialize Sentry options for daemon (reuses all SDK infrastructure)
     // Options are passed explicitly to all functions, no global state
     sentry_options_t *options = sentry_options_new();
     if (!options) {
         SENTRY_ERROR("sentry_options_new() failed");
-        if (log_file) {
-            fclose(log_file);
-        }
-        return 1;
+        return NULL;
     }
 
     // Use debug logging and screenshot settings from parent process
-    sentry_options_set_debug(options, ipc->shmem->debug_enabled);
-    options->attach_screenshot = ipc->shmem->attach_screenshot;
-    options->cache_keep = ipc->shmem->cache_keep;
-    options->enable_large_attachments = ipc->shmem->enable_large_attachments;
+    sentry_options_set_debug(options, ctx->debug_enabled);
+    options->attach_screenshot = ctx->attach_screenshot;
+    options->cache_keep = ctx->cache_keep;
+    options->enable_large_attachments = ctx->enable_large_attachments;
     options->http_retry = false;
-    options->shutdown_timeout = ipc->shmem->shutdown_timeout;
+    options->shutdown_timeout = ctx->shutdown_timeout;
 
     // Set custom logger that writes to file
     if (log_file) {
@@ -3300,48 +3334,45 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
     }
 
     // Set DSN if configured
-    if (ipc->shmem->dsn[0] != '\0') {
-        SENTRY_DEBUGF("Setting DSN: %s", ipc->shmem->dsn);
-        sentry_options_set_dsn(options, ipc->shmem->dsn);
+    if (ctx->dsn[0] != '\0') {
+        SENTRY_DEBUGF("Setting DSN: %s", ctx->dsn);
+        sentry_options_set_dsn(options, ctx->dsn);
     } else {
         SENTRY_DEBUG("No DSN configured");
     }
 
     // Set transport configuration from parent process options
-    if (ipc->shmem->ca_certs[0] != '\0') {
-        SENTRY_DEBUGF("Setting CA certs: %s", ipc->shmem->ca_certs);
-        sentry_options_set_ca_certs(options, ipc->shmem->ca_certs);
+    if (ctx->ca_certs[0] != '\0') {
+        SENTRY_DEBUGF("Setting CA certs: %s", ctx->ca_certs);
+        sentry_options_set_ca_certs(options, ctx->ca_certs);
     }
 
-    if (ipc->shmem->proxy[0] != '\0') {
-        SENTRY_DEBUGF("Setting proxy: %s", ipc->shmem->proxy);
-        sentry_options_set_proxy(options, ipc->shmem->proxy);
+    if (ctx->proxy[0] != '\0') {
+        SENTRY_DEBUGF("Setting proxy: %s", ctx->proxy);
+        sentry_options_set_proxy(options, ctx->proxy);
     }
 
-    if (ipc->shmem->user_agent[0] != '\0') {
-        SENTRY_DEBUGF("Setting user agent: %s", ipc->shmem->user_agent);
+    if (ctx->user_agent[0] != '\0') {
+        SENTRY_DEBUGF("Setting user agent: %s", ctx->user_agent);
         sentry_free(options->user_agent);
-        options->user_agent = sentry__string_clone(ipc->shmem->user_agent);
+        options->user_agent = sentry__string_clone(ctx->user_agent);
     }
 
     // Create run with database path
     SENTRY_DEBUG("Creating run with database path");
-    sentry_path_t *db_path = sentry__path_from_str(ipc->shmem->database_path);
+    sentry_path_t *db_path = sentry__path_from_str(ctx->database_path);
     if (db_path) {
+        // User consent is checked per crash, see `capture_crash_envelope`
         options->run = sentry__run_new(db_path);
-        if (options->run) {
-            options->run->require_user_consent
-                = ipc->shmem->require_user_consent;
-        }
         sentry__path_free(db_path);
     }
 
     // Set external crash reporter if configured
-    if (ipc->shmem->external_reporter_path[0] != '\0') {
+    if (ctx->external_reporter_path[0] != '\0') {
         SENTRY_DEBUGF("Setting external reporter: %s",
-            ipc->shmem->external_reporter_path);
+            ctx->external_reporter_path);
         sentry_path_t *reporter
-            = sentry__path_from_str(ipc->shmem->external_reporter_path);
+            = sentry__path_from_str(ctx->external_reporter_path);
         if (reporter) {
             options->external_crash_reporter = reporter;
         }
@@ -3356,6 +3387,88 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
     }
 
     SENTRY_DEBUG("Daemon options fully initialized");
+    return options;
+}
+
+/**
+ * Sends or dumps the pending envelopes, and frees the options of the daemon.
+ */
+static void
+daemon_options_free(sentry_options_t *options)
+{
+    if (!options) {
+        return;
+    }
+    size_t dumped_envelopes = 0;
+    if (options->transport) {
+        // Wait for the configured SDK shutdown timeout to send pending
+        // envelopes (crash envelope + logs envelope, etc.).
+        int rv = sentry__transport_shutdown(
+            options->transport, options->shutdown_timeout);
+        if (rv != 0) {
+            SENTRY_WARN("transport did not shut down cleanly");
+        }
+        dumped_envelopes
+            = sentry__transport_dump_queue(options->transport, options->run);
+        if (rv == 0 && !dumped_envelopes && options->run) {
+            sentry__run_clean(options->run, true);
+        }
+    }
+    sentry_options_free(options);
+}
+
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+int
+sentry__crash_daemon_main(
+    pid_t app_pid, uint64_t app_tid, int notify_eventfd, int ready_eventfd)
+#elif defined(SENTRY_PLATFORM_MACOS)
+int
+sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, int notify_pipe_read,
+    int ready_pipe_write, int shm_fd)
+#elif defined(SENTRY_PLATFORM_WINDOWS)
+int
+sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
+    HANDLE ready_event_handle)
+#endif
+{
+    // Initialize IPC first (attach to shared memory created by parent)
+    // We need this to get the database path for logging
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+    sentry_crash_ipc_t *ipc = sentry__crash_ipc_init_daemon(
+        app_pid, app_tid, notify_eventfd, ready_eventfd);
+#elif defined(SENTRY_PLATFORM_MACOS)
+    sentry_crash_ipc_t *ipc = sentry__crash_ipc_init_daemon(
+        app_pid, app_tid, notify_pipe_read, ready_pipe_write, shm_fd);
+#elif defined(SENTRY_PLATFORM_WINDOWS)
+    sentry_crash_ipc_t *ipc = sentry__crash_ipc_init_daemon(
+        app_pid, app_tid, event_handle, ready_event_handle);
+#endif
+    if (!ipc) {
+        return 1;
+    }
+
+    // Set up logging to file for daemon BEFORE redirecting streams
+    // Use same naming scheme as shared memory (PID ^ TID hash) to handle
+    // multiple threads in same process
+    char log_name[SENTRY_CRASH_IPC_NAME_SIZE];
+    uint32_t id = (uint32_t)((app_pid ^ (app_tid & 0xFFFFFFFF)) & 0xFFFFFFFF);
+    snprintf(log_name, sizeof(log_name), "sentry-daemon-%08x", id);
+    FILE *log_file = open_daemon_log(ipc->shmem, log_name);
+    if (log_file) {
+        SENTRY_DEBUG("=== Daemon starting ===");
+        SENTRY_DEBUGF("App PID: %lu", (unsigned long)app_pid);
+        SENTRY_DEBUGF("Database path: %s", ipc->shmem->database_path);
+    }
+
+    detach_std_streams();
+
+    sentry_options_t *options = daemon_options_new(ipc->shmem, log_file);
+    if (!options) {
+        if (log_file) {
+            fclose(log_file);
+        }
+        return 1;
+    }
 
 #if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
     // Use the inherited eventfd from parent
@@ -3384,6 +3497,14 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
     SENTRY_DEBUG("Signaling ready to parent");
     sentry__crash_ipc_signal_ready(ipc);
 
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+    // Resolve the identities of the app's modules while waiting, so that a
+    // crash only needs to look them up
+    char module_cache_path[SENTRY_CRASH_MAX_PATH];
+    load_module_cache(ipc->shmem, module_cache_path, sizeof(module_cache_path));
+    refresh_module_cache(app_pid, module_cache_path);
+#endif
+
     SENTRY_DEBUG("Entering main loop");
 
     // Daemon main loop
@@ -3419,29 +3540,19 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
             SENTRY_DEBUG("Parent process exited without crash");
             break;
         }
+
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+        // pick up modules that were loaded since
+        if (!wait_result) {
+            refresh_module_cache(app_pid, module_cache_path);
+        }
+#endif
     }
 
     SENTRY_DEBUG("Daemon exiting");
 
     // Cleanup
-    if (options) {
-        size_t dumped_envelopes = 0;
-        if (options->transport) {
-            // Wait for the configured SDK shutdown timeout to send pending
-            // envelopes (crash envelope + logs envelope, etc.).
-            int rv = sentry__transport_shutdown(
-                options->transport, options->shutdown_timeout);
-            if (rv != 0) {
-                SENTRY_WARN("transport did not shut down cleanly");
-            }
-            dumped_envelopes = sentry__transport_dump_queue(
-                options->transport, options->run);
-            if (rv == 0 && !dumped_envelopes && options->run) {
-                sentry__run_clean(options->run, true);
-            }
-        }
-        sentry_options_free(options);
-    }
+    daemon_options_free(options);
     if (crash_processed) {
         // Mark as done
         SENTRY_DEBUG("Marking crash state as DONE");
@@ -3451,6 +3562,9 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
         sentry__crash_ipc_unlink(ipc);
     }
     sentry__crash_ipc_free(ipc);
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+    sentry__crash_module_cache_clear();
+#endif
 
     // Close log file
     if (log_file) {
@@ -3460,6 +3574,43 @@ sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
     return 0;
 }
 
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+/**
+ * Replaces the forked child with the daemon executable at `handler_path`, or
+ * the `sentry-crash` next to the app. Never returns.
+ */
+static void
+exec_daemon(char **argv, const char *handler_path)
+{
+    if (handler_path && handler_path[0] != '\0') {
+        execv(handler_path, argv);
+    } else {
+        char exe_path[SENTRY_CRASH_MAX_PATH];
+        char daemon_exec_path[SENTRY_CRASH_MAX_PATH];
+
+        ssize_t exe_len
+            = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
+        if (exe_len > 0) {
+            exe_path[exe_len] = '\0';
+            const char *slash = strrchr(exe_path, '/');
+            if (slash) {
+                size_t dir_len = (size_t)(slash - exe_path + 1);
+                if (dir_len + strlen("sentry-crash")
+                    < sizeof(daemon_exec_path)) {
+                    memcpy(daemon_exec_path, exe_path, dir_len);
+                    strcpy(daemon_exec_path + dir_len, "sentry-crash");
+                    execv(daemon_exec_path, argv);
+                }
+            }
+        }
+    }
+
+    // exec failed - exit with error
+    perror("Failed to exec sentry-crash");
+    _exit(1);
+}
+#endif
+
 #if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
 pid_t
 sentry__crash_daemon_start(pid_t app_pid, uint64_t app_tid, int notify_eventfd,
@@ -3591,33 +3742,7 @@ sentry__crash_daemon_start(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
 
         char *argv[]
             = { "sentry-crash", pid_str, tid_str, notify_str, ready_str, NULL };
-
-        if (handler_path && handler_path[0] != '\0') {
-            execv(handler_path, argv);
-        } else {
-            char exe_path[SENTRY_CRASH_MAX_PATH];
-            char daemon_exec_path[SENTRY_CRASH_MAX_PATH];
-
-            ssize_t exe_len
-                = readlink("/proc/self/exe", exe_path, sizeof(exe_path) - 1);
-            if (exe_len > 0) {
-                exe_path[exe_len] = '\0';
-                const char *slash = strrchr(exe_path, '/');
-                if (slash) {
-                    size_t dir_len = (size_t)(slash - exe_path + 1);
-                    if (dir_len + strlen("sentry-crash")
-                        < sizeof(daemon_exec_path)) {
-                        memcpy(daemon_exec_path, exe_path, dir_len);
-                        strcpy(daemon_exec_path + dir_len, "sentry-crash");
-                        execv(daemon_exec_path, argv);
-                    }
-                }
-            }
-        }
-
-        // exec failed - exit with error
-        perror("Failed to exec sentry-crash");
-        _exit(1);
+        exec_daemon(argv, handler_path);
     }
 
     // Parent process - return daemon PID
@@ -3733,6 +3858,358 @@ sentry__crash_daemon_start(pid_t app_pid, uint64_t app_tid, HANDLE event_handle,
 #endif
 }
 
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+
+#    define SHARED_DAEMON_RETRY_INTERVAL_MS 10
+
+/**
+ * An app that is served by a shared daemon.
+ */
+typedef struct {
+    sentry_crash_ipc_t *ipc;
+    const sentry_options_t *options;
+    int wake_fd;
+    // The crash of the app is being processed, on `thread` if `has_thread`
+    bool crashed;
+    bool has_thread;
+    sentry_threadid_t thread;
+    volatile long processed;
+} shared_app_t;
+
+typedef struct {
+    sentry_options_t *options;
+    // Wakes up the main loop when a crash was processed
+    int wake_fd;
+    shared_app_t **apps;
+    size_t app_count;
+    size_t app_capacity;
+} shared_daemon_t;
+
+static bool
+add_shared_app(shared_daemon_t *daemon, sentry_crash_ipc_t *ipc)
+{
+    if (daemon->app_count == daemon->app_capacity) {
+        size_t capacity = daemon->app_capacity ? daemon->app_capacity * 2 : 16;
+        shared_app_t **apps = sentry_malloc(sizeof(shared_app_t *) * capacity);
+        if (!apps) {
+            return false;
+        }
+        if (daemon->app_count) {
+            memcpy(apps, daemon->apps,
+                sizeof(shared_app_t *) * daemon->app_count);
+        }
+        sentry_free(daemon->apps);
+        daemon->apps = apps;
+        daemon->app_capacity = capacity;
+    }
+    shared_app_t *app = SENTRY_MAKE(shared_app_t);
+    if (!app) {
+        return false;
+    }
+    memset(app, 0, sizeof(*app));
+    app->ipc = ipc;
+    app->options = daemon->options;
+    app->wake_fd = daemon->wake_fd;
+    daemon->apps[daemon->app_count++] = app;
+    SENTRY_DEBUGF("Serving app %d (%zu apps)", (int)ipc->parent_handle,
+        daemon->app_count);
+    return true;
+}
+
+/**
+ * Stops serving the app at `index`, once its crash was processed or it went
+ * away. The last app takes its place.
+ */
+static void
+remove_shared_app(shared_daemon_t *daemon, size_t index)
+{
+    shared_app_t *app = daemon->apps[index];
+    if (app->has_thread) {
+        sentry__thread_join(app->thread);
+        sentry__thread_free(&app->thread);
+    }
+    if (app->crashed || !is_parent_alive(app->ipc->parent_handle)) {
+        sentry__crash_ipc_unlink(app->ipc);
+    }
+    SENTRY_DEBUGF("Removing app %d", (int)app->ipc->parent_handle);
+    sentry__crash_ipc_free(app->ipc);
+    sentry_free(app);
+    daemon->apps[index] = daemon->apps[--daemon->app_count];
+}
+
+SENTRY_THREAD_FN
+process_shared_crash(void *data)
+{
+    shared_app_t *app = data;
+    sentry__process_crash(app->options, app->ipc);
+
+    // Wait for the crash to be sent, like a dedicated daemon does before it
+    // marks the crash as done
+    sentry__transport_flush(
+        app->options->transport, app->options->shutdown_timeout);
+    sentry__atomic_store(&app->ipc->shmem->state, SENTRY_CRASH_STATE_DONE);
+
+    sentry__atomic_store(&app->processed, 1);
+    uint64_t val = 1;
+    ssize_t written = write(app->wake_fd, &val, sizeof(val));
+    (void)written;
+    return 0;
+}
+
+/**
+ * Processes the crash of `app` on its own thread, so that the crashes of
+ * other apps are processed concurrently.
+ */
+static void
+start_shared_crash(shared_app_t *app)
+{
+    SENTRY_DEBUGF(
+        "Crash notification from app %d", (int)app->ipc->parent_handle);
+    app->crashed = true;
+    sentry__thread_init(&app->thread);
+    app->has_thread
+        = sentry__thread_spawn(&app->thread, &process_shared_crash, app) == 0;
+    if (!app->has_thread) {
+        SENTRY_WARN("Failed to start crash thread, processing crash inline");
+        process_shared_crash(app);
+    }
+}
+
+/**
+ * Handles the events of the apps, in reverse so that removing an app does
+ * not skip another. `pfds` holds the notification and connection of each
+ * app, after the two of the daemon.
+ */
+static void
+handle_shared_apps(shared_daemon_t *daemon, const struct pollfd *pfds,
+    int ready, const char *module_cache_path)
+{
+    for (size_t i = daemon->app_count; i > 0; i--) {
+        shared_app_t *app = daemon->apps[i - 1];
+        if (app->crashed) {
+            if (sentry__atomic_fetch(&app->processed)) {
+                remove_shared_app(daemon, i - 1);
+            }
+            continue;
+        }
+
+        const struct pollfd *notify_pfd = &pfds[2 * i];
+        const struct pollfd *conn_pfd = &pfds[2 * i + 1];
+        if (ready > 0 && (notify_pfd->revents & POLLIN)) {
+            uint64_t val;
+            ssize_t result = read(app->ipc->notify_fd, &val, sizeof(val));
+            (void)result;
+            long state = sentry__atomic_fetch(&app->ipc->shmem->state);
+            if (state == SENTRY_CRASH_STATE_CRASHED) {
+                start_shared_crash(app);
+                continue;
+            }
+        }
+
+        if (ready > 0 && conn_pfd->revents) {
+            // The app closed its connection, so it shut down or exited
+            remove_shared_app(daemon, i - 1);
+        } else if (ready == 0) {
+            if (!is_parent_alive(app->ipc->parent_handle)) {
+                remove_shared_app(daemon, i - 1);
+            } else {
+                // pick up modules that were loaded since
+                refresh_module_cache(
+                    app->ipc->parent_handle, module_cache_path);
+            }
+        }
+    }
+}
+
+static void
+shared_daemon_free(shared_daemon_t *daemon)
+{
+    while (daemon->app_count > 0) {
+        remove_shared_app(daemon, daemon->app_count - 1);
+    }
+    sentry_free(daemon->apps);
+    daemon_options_free(daemon->options);
+    if (daemon->wake_fd >= 0) {
+        close(daemon->wake_fd);
+    }
+}
+
+int
+sentry__crash_daemon_shared_main(const char *name)
+{
+    int listen_fd = sentry__crash_ipc_listen(name);
+    if (listen_fd < 0) {
+        // another daemon serves these apps already
+        return 1;
+    }
+
+    // The app that started the daemon registers first, and configures it
+    sentry_crash_ipc_t *first = NULL;
+    struct pollfd listen_pfd = { .fd = listen_fd, .events = POLLIN };
+    if (poll(&listen_pfd, 1, SENTRY_CRASH_DAEMON_READY_TIMEOUT_MS) > 0) {
+        first = sentry__crash_ipc_accept(listen_fd);
+    }
+    if (!first) {
+        close(listen_fd);
+        return 1;
+    }
+
+    FILE *log_file = open_daemon_log(first->shmem, name);
+    if (log_file) {
+        SENTRY_DEBUG("=== Shared daemon starting ===");
+        SENTRY_DEBUGF("Database path: %s", first->shmem->database_path);
+    }
+
+    detach_std_streams();
+
+    shared_daemon_t daemon;
+    memset(&daemon, 0, sizeof(daemon));
+    daemon.wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    daemon.options = daemon_options_new(first->shmem, log_file);
+    char module_cache_path[SENTRY_CRASH_MAX_PATH];
+    load_module_cache(
+        first->shmem, module_cache_path, sizeof(module_cache_path));
+    if (!daemon.options || daemon.wake_fd < 0
+        || !add_shared_app(&daemon, first)) {
+        SENTRY_ERROR("Failed to initialize shared daemon");
+        sentry__crash_ipc_free(first);
+        shared_daemon_free(&daemon);
+        close(listen_fd);
+        if (log_file) {
+            fclose(log_file);
+        }
+        return 1;
+    }
+    refresh_module_cache(first->parent_handle, module_cache_path);
+
+    SENTRY_DEBUG("Entering shared main loop");
+
+    struct pollfd *pfds = NULL;
+    size_t pfd_capacity = 0;
+    uint64_t idle_since = 0;
+    while (true) {
+        size_t pfd_count = 2 + 2 * daemon.app_count;
+        if (pfd_count > pfd_capacity) {
+            sentry_free(pfds);
+            pfd_capacity = pfd_count * 2;
+            pfds = sentry_malloc(sizeof(struct pollfd) * pfd_capacity);
+            if (!pfds) {
+                SENTRY_ERROR("Failed to allocate poll descriptors");
+                break;
+            }
+        }
+        pfds[0] = (struct pollfd) { .fd = listen_fd, .events = POLLIN };
+        pfds[1] = (struct pollfd) { .fd = daemon.wake_fd, .events = POLLIN };
+        for (size_t i = 0; i < daemon.app_count; i++) {
+            // a crashed app is only waited for until its crash is processed
+            const shared_app_t *app = daemon.apps[i];
+            pfds[2 + 2 * i] = (struct pollfd) {
+                .fd = app->crashed ? -1 : app->ipc->notify_fd,
+                .events = POLLIN,
+            };
+            pfds[3 + 2 * i] = (struct pollfd) {
+                .fd = app->crashed ? -1 : app->ipc->daemon_fd,
+                .events = POLLIN,
+            };
+        }
+
+        int ready = poll(
+            pfds, (nfds_t)pfd_count, SENTRY_CRASH_DAEMON_WAIT_TIMEOUT_MS);
+        if (ready < 0 && errno != EINTR) {
+            SENTRY_WARNF("poll failed: %s", strerror(errno));
+            break;
+        }
+        if (ready > 0 && (pfds[1].revents & POLLIN)) {
+            uint64_t val;
+            ssize_t result = read(daemon.wake_fd, &val, sizeof(val));
+            (void)result;
+        }
+
+        handle_shared_apps(&daemon, pfds, ready, module_cache_path);
+
+        if (ready > 0 && (pfds[0].revents & POLLIN)) {
+            sentry_crash_ipc_t *ipc = sentry__crash_ipc_accept(listen_fd);
+            if (ipc && add_shared_app(&daemon, ipc)) {
+                refresh_module_cache(ipc->parent_handle, module_cache_path);
+            } else if (ipc) {
+                sentry__crash_ipc_free(ipc);
+            }
+        }
+
+        // Linger for a while without apps, for apps that restart
+        if (daemon.app_count > 0) {
+            idle_since = 0;
+        } else if (!idle_since) {
+            idle_since = sentry__monotonic_time();
+        } else if (sentry__monotonic_time() - idle_since
+            >= SENTRY_CRASH_SHARED_DAEMON_IDLE_TIMEOUT_MS) {
+            SENTRY_DEBUG("No apps left");
+            break;
+        }
+    }
+
+    SENTRY_DEBUG("Shared daemon exiting");
+
+    // Stop accepting apps first, so that new apps start another daemon
+    close(listen_fd);
+    sentry_free(pfds);
+    shared_daemon_free(&daemon);
+    sentry__crash_module_cache_clear();
+
+    if (log_file) {
+        fclose(log_file);
+    }
+    return 0;
+}
+
+/**
+ * Starts a shared daemon listening on `name`. It is detached from the app, so
+ * that no app has to reap it.
+ */
+static bool
+spawn_shared_daemon(const char *name, const char *handler_path)
+{
+    pid_t pid = fork();
+    if (pid < 0) {
+        SENTRY_WARN("Failed to fork shared daemon process");
+        return false;
+    } else if (pid == 0) {
+        setsid();
+        // fork again, so that the daemon is reparented to init
+        if (fork() != 0) {
+            _exit(0);
+        }
+        char *argv[] = { "sentry-crash", "--shared", (char *)name, NULL };
+        exec_daemon(argv, handler_path);
+    }
+    waitpid(pid, NULL, 0);
+    return true;
+}
+
+pid_t
+sentry__crash_daemon_register(sentry_crash_ipc_t *ipc, const char *name,
+    uint64_t app_tid, const char *handler_path)
+{
+    pid_t daemon_pid = sentry__crash_ipc_register(ipc, name, app_tid);
+    if (daemon_pid > 0 || !spawn_shared_daemon(name, handler_path)) {
+        return daemon_pid;
+    }
+
+    // Apps that start at the same time may each start a daemon, of which only
+    // one gets to listen. Retry until that one accepts the app.
+    for (int waited = 0; waited < SENTRY_CRASH_DAEMON_READY_TIMEOUT_MS;
+        waited += SHARED_DAEMON_RETRY_INTERVAL_MS) {
+        usleep(SHARED_DAEMON_RETRY_INTERVAL_MS * 1000);
+        daemon_pid = sentry__crash_ipc_register(ipc, name, app_tid);
+        if (daemon_pid > 0) {
+            return daemon_pid;
+        }
+    }
+    return -1;
+}
+
+#endif
+
 // When built as standalone executable, provide main entry point
 #ifdef SENTRY_CRASH_DAEMON_STANDALONE
 
@@ -3758,7 +4235,13 @@ main(int argc, char **argv)
 {
     // Expected arguments:
     //   Linux:  <app_pid> <app_tid> <notify_handle> <ready_handle>
+    //           or --shared <socket_name> for a shared daemon
     //   macOS:  <app_pid> <app_tid> <notify_handle> <ready_handle> <shm_fd>
+#    if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+    if (argc == 3 && strcmp(argv[1], "--shared") == 0) {
+        return sentry__crash_daemon_shared_main(argv[2]);
+    }
+#    endif
 #    if defined(SENTRY_PLATFORM_MACOS)
     if (argc < 6) {
         fprintf(stderr,
@@ -55,6 +55,27 @@ int sentry__crash_daemon_main(pid_t app_pid, uint64_t app_tid,
     HANDLE event_handle, HANDLE ready_event_handle);
 #endif
 
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+/**
+ * Registers the app with the shared crash daemon listening on `name`, and
+ * starts that daemon first if no app with the same configuration did yet.
+ *
+ * @param ipc App side of the crash IPC
+ * @param name Socket name from `sentry__crash_ipc_shared_name`
+ * @param app_tid Parent application thread ID
+ * @return Daemon PID on success, -1 on failure
+ */
+pid_t sentry__crash_daemon_register(sentry_crash_ipc_t *ipc, const char *name,
+    uint64_t app_tid, const char *handler_path);
+
+/**
+ * Shared daemon main loop, which serves every app that registers on the
+ * socket `name`, and processes their crashes concurrently. Exits once no app
+ * was left for a while.
+ */
+int sentry__crash_daemon_shared_main(const char *name);
+#endif
+
 /**
  * Process crash and generate minidump with envelope
  *
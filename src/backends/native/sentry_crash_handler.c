@@ -286,10 +286,11 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
     // Note: We DON'T enumerate threads here using opendir/readdir because
     // they allocate memory (not signal-safe). The daemon's minidump writer
     // will enumerate threads out-of-process by calling enumerate_threads().
+    sentry_crash_thread_t *crashed_thread = sentry__crash_context_threads(ctx);
     ctx->platform.num_threads = 1;
-    ctx->platform.threads[0].tid = ctx->crashed_tid;
-    signal_safe_memcpy(&ctx->platform.threads[0].context, uctx,
-        sizeof(ctx->platform.threads[0].context));
+    crashed_thread->tid = ctx->crashed_tid;
+    signal_safe_memcpy(
+        &crashed_thread->context, uctx, sizeof(crashed_thread->context));
 
     // Capture backtrace using libunwind (DWARF-based, works without frame
     // pointers). This runs in the signal handler, which is safe because
@@ -328,6 +329,7 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
         sizeof(ctx->platform.mcontext));
 
     // Capture all threads (signal-safe on macOS)
+    sentry_crash_thread_t *ctx_threads = sentry__crash_context_threads(ctx);
     ctx->platform.num_threads = 0;
     task_t task = mach_task_self();
     thread_act_array_t threads = NULL;
@@ -340,13 +342,14 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
 
     kern_return_t kr = task_threads(task, &threads, &thread_count);
     if (kr == KERN_SUCCESS) {
-        // Limit to available space
-        if (thread_count > SENTRY_CRASH_MAX_THREADS) {
-            thread_count = SENTRY_CRASH_MAX_THREADS;
+        // Limit to the thread table, which was sized for twice the threads
+        // at init
+        if (thread_count > ctx->thread_table.capacity) {
+            thread_count = ctx->thread_table.capacity;
         }
 
         for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
-            ctx->platform.threads[i].thread = threads[i];
+            ctx_threads[i].thread = threads[i];
 
             // Get thread ID (portable across processes)
             thread_identifier_info_data_t identifier_info;
@@ -355,9 +358,9 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
             if (thread_info(threads[i], THREAD_IDENTIFIER_INFO,
                     (thread_info_t)&identifier_info, &identifier_info_count)
                 == KERN_SUCCESS) {
-                ctx->platform.threads[i].tid = identifier_info.thread_id;
+                ctx_threads[i].tid = identifier_info.thread_id;
             } else {
-                ctx->platform.threads[i].tid = 0;
+                ctx_threads[i].tid = 0;
             }
 
             // For the crashing thread, use the context from the signal handler
@@ -367,52 +370,52 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
             if (is_crashing_thread) {
                 // Use register state from signal handler context
 #        if defined(__x86_64__)
-                ctx->platform.threads[i].state.__ss.__rax
+                ctx_threads[i].state.__ss.__rax
                     = uctx->uc_mcontext->__ss.__rax;
-                ctx->platform.threads[i].state.__ss.__rbx
+                ctx_threads[i].state.__ss.__rbx
                     = uctx->uc_mcontext->__ss.__rbx;
-                ctx->platform.threads[i].state.__ss.__rcx
+                ctx_threads[i].state.__ss.__rcx
                     = uctx->uc_mcontext->__ss.__rcx;
-                ctx->platform.threads[i].state.__ss.__rdx
+                ctx_threads[i].state.__ss.__rdx
                     = uctx->uc_mcontext->__ss.__rdx;
-                ctx->platform.threads[i].state.__ss.__rdi
+                ctx_threads[i].state.__ss.__rdi
                     = uctx->uc_mcontext->__ss.__rdi;
-                ctx->platform.threads[i].state.__ss.__rsi
+                ctx_threads[i].state.__ss.__rsi
                     = uctx->uc_mcontext->__ss.__rsi;
-                ctx->platform.threads[i].state.__ss.__rbp
+                ctx_threads[i].state.__ss.__rbp
                     = uctx->uc_mcontext->__ss.__rbp;
-                ctx->platform.threads[i].state.__ss.__rsp
+                ctx_threads[i].state.__ss.__rsp
                     = uctx->uc_mcontext->__ss.__rsp;
-                ctx->platform.threads[i].state.__ss.__r8
+                ctx_threads[i].state.__ss.__r8
                     = uctx->uc_mcontext->__ss.__r8;
-                ctx->platform.threads[i].state.__ss.__r9
+                ctx_threads[i].state.__ss.__r9
                     = uctx->uc_mcontext->__ss.__r9;
-                ctx->platform.threads[i].state.__ss.__r10
+                ctx_threads[i].state.__ss.__r10
                     = uctx->uc_mcontext->__ss.__r10;
-                ctx->platform.threads[i].state.__ss.__r11
+                ctx_threads[i].state.__ss.__r11
                     = uctx->uc_mcontext->__ss.__r11;
-                ctx->platform.threads[i].state.__ss.__r12
+                ctx_threads[i].state.__ss.__r12
                     = uctx->uc_mcontext->__ss.__r12;
-                ctx->platform.threads[i].state.__ss.__r13
+                ctx_threads[i].state.__ss.__r13
                     = uctx->uc_mcontext->__ss.__r13;
-                ctx->platform.threads[i].state.__ss.__r14
+                ctx_threads[i].state.__ss.__r14
                     = uctx->uc_mcontext->__ss.__r14;
-                ctx->platform.threads[i].state.__ss.__r15
+                ctx_threads[i].state.__ss.__r15
                     = uctx->uc_mcontext->__ss.__r15;
-                ctx->platform.threads[i].state.__ss.__rip
+                ctx_threads[i].state.__ss.__rip
                     = uctx->uc_mcontext->__ss.__rip;
-                ctx->platform.threads[i].state.__ss.__rflags
+                ctx_threads[i].state.__ss.__rflags
                     = uctx->uc_mcontext->__ss.__rflags;
-                ctx->platform.threads[i].state.__ss.__cs
+                ctx_threads[i].state.__ss.__cs
                     = uctx->uc_mcontext->__ss.__cs;
-                ctx->platform.threads[i].state.__ss.__fs
+                ctx_threads[i].state.__ss.__fs
                     = uctx->uc_mcontext->__ss.__fs;
-                ctx->platform.threads[i].state.__ss.__gs
+                ctx_threads[i].state.__ss.__gs
                     = uctx->uc_mcontext->__ss.__gs;
 #        elif defined(__aarch64__)
                 // Copy entire thread state struct. This preserves raw
                 // register values including PAC-signed pointers on arm64e.
-                ctx->platform.threads[i].state.__ss = uctx->uc_mcontext->__ss;
+                ctx_threads[i].state.__ss = uctx->uc_mcontext->__ss;
 #        endif
             } else {
                 // Capture thread state from thread_get_state for other threads
@@ -421,14 +424,14 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
                 mach_msg_type_number_t state_count = MACHINE_THREAD_STATE_COUNT;
                 kern_return_t state_kr
                     = thread_get_state(threads[i], MACHINE_THREAD_STATE,
-                        (thread_state_t)&ctx->platform.threads[i].state.__ss,
+                        (thread_state_t)&ctx_threads[i].state.__ss,
                         &state_count);
                 if (state_kr != KERN_SUCCESS) {
                     // Failed to get state, but continue with other threads
-                    signal_safe_memzero(&ctx->platform.threads[i].state,
-                        sizeof(ctx->platform.threads[i].state));
-                    ctx->platform.threads[i].stack_path[0] = '\0';
-                    ctx->platform.threads[i].stack_size = 0;
+                    signal_safe_memzero(&ctx_threads[i].state,
+                        sizeof(ctx_threads[i].state));
+                    ctx_threads[i].stack_path[0] = '\0';
+                    ctx_threads[i].stack_size = 0;
                     continue;
                 }
             }
@@ -436,9 +439,9 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
             // Capture stack memory for this thread
             uint64_t sp;
 #        if defined(__x86_64__)
-            sp = ctx->platform.threads[i].state.__ss.__rsp;
+            sp = ctx_threads[i].state.__ss.__rsp;
 #        elif defined(__aarch64__)
-            sp = SENTRY__ARM64_GET_SP(ctx->platform.threads[i].state.__ss);
+            sp = SENTRY__ARM64_GET_SP(ctx_threads[i].state.__ss);
 #        else
             sp = 0;
 #        endif
@@ -495,26 +498,26 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
 
                         if (written > 0) {
                             // Successfully saved stack (even if partial)
-                            safe_strncpy(ctx->platform.threads[i].stack_path,
+                            safe_strncpy(ctx_threads[i].stack_path,
                                 stack_path,
-                                sizeof(ctx->platform.threads[i].stack_path));
-                            ctx->platform.threads[i].stack_size
+                                sizeof(ctx_threads[i].stack_path));
+                            ctx_threads[i].stack_size
                                 = (size_t)written;
                         } else {
-                            ctx->platform.threads[i].stack_path[0] = '\0';
-                            ctx->platform.threads[i].stack_size = 0;
+                            ctx_threads[i].stack_path[0] = '\0';
+                            ctx_threads[i].stack_size = 0;
                         }
                     } else {
-                        ctx->platform.threads[i].stack_path[0] = '\0';
-                        ctx->platform.threads[i].stack_size = 0;
+                        ctx_threads[i].stack_path[0] = '\0';
+                        ctx_threads[i].stack_size = 0;
                     }
                 } else {
-                    ctx->platform.threads[i].stack_path[0] = '\0';
-                    ctx->platform.threads[i].stack_size = 0;
+                    ctx_threads[i].stack_path[0] = '\0';
+                    ctx_threads[i].stack_size = 0;
                 }
             } else {
-                ctx->platform.threads[i].stack_path[0] = '\0';
-                ctx->platform.threads[i].stack_size = 0;
+                ctx_threads[i].stack_path[0] = '\0';
+                ctx_threads[i].stack_size = 0;
             }
         }
         ctx->platform.num_threads = thread_count;
@@ -528,14 +531,14 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
     }
 
     // Capture module information from dyld (signal-safe on macOS)
+    sentry_module_info_t *ctx_modules = sentry__crash_context_modules(ctx);
     ctx->module_count = 0;
     uint32_t image_count = _dyld_image_count();
-    if (image_count > SENTRY_CRASH_MAX_MODULES) {
-        image_count = SENTRY_CRASH_MAX_MODULES;
+    if (image_count > ctx->module_table.capacity) {
+        image_count = ctx->module_table.capacity;
     }
 
-    for (uint32_t i = 0;
-        i < image_count && ctx->module_count < SENTRY_CRASH_MAX_MODULES; i++) {
+    for (uint32_t i = 0; i < image_count; i++) {
         const struct mach_header *header = _dyld_get_image_header(i);
         const char *name = _dyld_get_image_name(i);
         intptr_t slide = _dyld_get_image_vmaddr_slide(i);
@@ -544,7 +547,7 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
             continue;
         }
 
-        sentry_module_info_t *module = &ctx->modules[ctx->module_count++];
+        sentry_module_info_t *module = &ctx_modules[ctx->module_count++];
         // _dyld_get_image_header() returns the actual loaded address (slide
         // already applied) We use the header address directly as the base
         // address for symbolication
@@ -595,8 +598,9 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
         }
         module->size = size;
 
-        // Copy module name (signal-safe)
-        safe_strncpy(module->name, name, sizeof(module->name));
+        // Copy module name into the string table (signal-safe)
+        module->name_offset
+            = sentry__crash_context_add_string(ctx, name, safe_strlen(name));
     }
 
     // Save module header pages to a single file for the daemon.
@@ -621,8 +625,8 @@ crash_signal_handler(int signum, siginfo_t *info, void *context)
                 // each module's slot stays aligned at 4096-byte boundaries.
                 static const char zero_page[4096] = { 0 };
                 for (uint32_t mi = 0; mi < ctx->module_count; mi++) {
-                    const void *base = (const void *)(uintptr_t)ctx->modules[mi]
-                                           .base_address;
+                    const void *base
+                        = (const void *)(uintptr_t)ctx_modules[mi].base_address;
                     ssize_t written = write(hdr_fd, base, 4096);
                     if (written < 0) {
                         // Write failed (EFAULT etc.) - write zeros to
@@ -920,9 +924,10 @@ crash_exception_filter(EXCEPTION_POINTERS *exception_info)
     // Instead, we rely on MiniDumpWriteDump (called by the daemon process)
     // which safely captures all thread contexts from outside the crashed
     // process using the debugger API with ClientPointers=TRUE.
+    sentry_crash_thread_t *crashed_thread = sentry__crash_context_threads(ctx);
     ctx->platform.num_threads = 1;
-    ctx->platform.threads[0].thread_id = GetCurrentThreadId();
-    ctx->platform.threads[0].context = *exception_info->ContextRecord;
+    crashed_thread->thread_id = GetCurrentThreadId();
+    crashed_thread->context = *exception_info->ContextRecord;
 
     // Call Sentry's exception handler
     sentry_ucontext_t sentry_uctx = { 0 };
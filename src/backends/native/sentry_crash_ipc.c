@@ -3,11 +3,113 @@
 #include "sentry_alloc.h"
 #include "sentry_logger.h"
 #include "sentry_sync.h"
+#include "sentry_utils.h"
 
 #include <stdio.h>
 #include <string.h>
 
 #if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+#    include <dirent.h>
+#elif defined(SENTRY_PLATFORM_MACOS)
+#    include <mach-o/dyld.h>
+#elif defined(SENTRY_PLATFORM_WINDOWS)
+#    include <psapi.h>
+#    include <tlhelp32.h>
+#endif
+
+/**
+ * Counts the threads and loaded modules of the current process.
+ */
+static void
+count_threads_and_modules(size_t *threads, size_t *modules)
+{
+    *threads = 0;
+    *modules = 0;
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+    DIR *dir = opendir("/proc/self/task");
+    if (dir) {
+        struct dirent *entry;
+        while ((entry = readdir(dir))) {
+            if (entry->d_name[0] != '.') {
+                (*threads)++;
+            }
+        }
+        closedir(dir);
+    }
+
+    // every module has a file mapping at offset 0
+    FILE *f = fopen("/proc/self/maps", "r");
+    if (f) {
+        char line[1024];
+        while (fgets(line, sizeof(line), f)) {
+            unsigned long long start, end, offset;
+            char perms[5];
+            int pathname_offset = 0;
+            if (sscanf(line, "%llx-%llx %4s %llx %*s %*s %n", &start, &end,
+                    perms, &offset, &pathname_offset)
+                    == 4
+                && offset == 0 && pathname_offset > 0
+                && line[pathname_offset] == '/') {
+                (*modules)++;
+            }
+        }
+        fclose(f);
+    }
+#elif defined(SENTRY_PLATFORM_MACOS)
+    thread_act_array_t thread_list;
+    mach_msg_type_number_t thread_count = 0;
+    if (task_threads(mach_task_self(), &thread_list, &thread_count)
+        == KERN_SUCCESS) {
+        for (mach_msg_type_number_t i = 0; i < thread_count; i++) {
+            mach_port_deallocate(mach_task_self(), thread_list[i]);
+        }
+        vm_deallocate(mach_task_self(), (vm_address_t)thread_list,
+            thread_count * sizeof(thread_act_t));
+        *threads = thread_count;
+    }
+    *modules = _dyld_image_count();
+#elif defined(SENTRY_PLATFORM_WINDOWS)
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snapshot != INVALID_HANDLE_VALUE) {
+        DWORD pid = GetCurrentProcessId();
+        THREADENTRY32 entry;
+        entry.dwSize = sizeof(entry);
+        if (Thread32First(snapshot, &entry)) {
+            do {
+                if (entry.th32OwnerProcessID == pid) {
+                    (*threads)++;
+                }
+            } while (Thread32Next(snapshot, &entry));
+        }
+        CloseHandle(snapshot);
+    }
+
+    DWORD needed = 0;
+    if (EnumProcessModules(GetCurrentProcess(), NULL, 0, &needed)) {
+        *modules = needed / sizeof(HMODULE);
+    }
+#endif
+}
+
+/**
+ * Returns the capacities of the crash context tables for the app, with room
+ * for twice the threads and modules it has right now, and the size of the
+ * context with them.
+ */
+static size_t
+app_context_capacity(size_t *threads, size_t *modules, size_t *strings)
+{
+    count_threads_and_modules(threads, modules);
+    *threads = MAX(*threads * 2, SENTRY_CRASH_MIN_THREADS);
+    *modules = MAX(*modules * 2, SENTRY_CRASH_MIN_MODULES);
+    *strings = *modules * SENTRY_CRASH_STRINGS_PER_MODULE;
+    SENTRY_DEBUGF("sizing crash context for %zu threads and %zu modules",
+        *threads, *modules);
+    return sentry__crash_context_size(*threads, *modules, *strings);
+}
+
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)         \
+    || defined(SENTRY_PLATFORM_MACOS)
 
 #    include <errno.h>
 #    include <fcntl.h>
@@ -16,6 +118,91 @@
 #    include <sys/stat.h>
 #    include <unistd.h>
 
+/**
+ * Maps the crash context of the app from `fd`. A valid context that already
+ * exists is kept, otherwise the file is resized for the current process and
+ * a new context is initialized. Returns MAP_FAILED on failure.
+ */
+static sentry_crash_context_t *
+map_app_context(int fd, bool exists, size_t *size)
+{
+    if (exists) {
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            SENTRY_WARNF("failed to stat shared memory: %s", strerror(errno));
+            return MAP_FAILED;
+        }
+        if ((size_t)st.st_size >= sizeof(sentry_crash_context_t)) {
+            sentry_crash_context_t *ctx = mmap(NULL, (size_t)st.st_size,
+                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (ctx != MAP_FAILED) {
+                if (sentry__crash_context_validate(ctx, (size_t)st.st_size)) {
+                    *size = (size_t)st.st_size;
+                    return ctx;
+                }
+                munmap(ctx, (size_t)st.st_size);
+            }
+        }
+    }
+
+    size_t threads, modules, strings;
+    *size = app_context_capacity(&threads, &modules, &strings);
+    if (!*size || ftruncate(fd, (off_t)*size) < 0) {
+        SENTRY_WARNF("failed to resize shared memory: %s", strerror(errno));
+        return MAP_FAILED;
+    }
+    sentry_crash_context_t *ctx
+        = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ctx == MAP_FAILED) {
+        SENTRY_WARNF("failed to map shared memory: %s", strerror(errno));
+        return MAP_FAILED;
+    }
+    sentry__crash_context_init(ctx, threads, modules, strings);
+    return ctx;
+}
+
+/**
+ * Maps the crash context the app created in `fd`, with the size the app
+ * chose for it. Returns MAP_FAILED if it cannot be mapped or is invalid.
+ */
+static sentry_crash_context_t *
+map_daemon_context(int fd, size_t *size)
+{
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        SENTRY_WARNF(
+            "daemon: failed to stat shared memory: %s", strerror(errno));
+        return MAP_FAILED;
+    }
+    *size = (size_t)st.st_size;
+    if (*size < sizeof(sentry_crash_context_t)) {
+        SENTRY_WARN("daemon: shared memory is too small");
+        return MAP_FAILED;
+    }
+    sentry_crash_context_t *ctx
+        = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ctx == MAP_FAILED) {
+        SENTRY_WARNF(
+            "daemon: failed to map shared memory: %s", strerror(errno));
+        return MAP_FAILED;
+    }
+    if (!sentry__crash_context_validate(ctx, *size)) {
+        SENTRY_WARN("daemon: invalid shared memory context");
+        munmap(ctx, *size);
+        return MAP_FAILED;
+    }
+    return ctx;
+}
+
+#endif
+
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+
+#    include <poll.h>
+#    include <stddef.h>
+#    include <sys/socket.h>
+#    include <sys/un.h>
+
 sentry_crash_ipc_t *
 sentry__crash_ipc_init_app(sem_t *init_sem)
 {
@@ -25,6 +212,7 @@ sentry__crash_ipc_init_app(sem_t *init_sem)
     }
     ipc->is_daemon = false;
     ipc->init_sem = init_sem; // Use provided semaphore (managed by backend)
+    ipc->daemon_fd = -1;
 
     // Create shared memory with unique name based on PID and thread ID
     // macOS has a 31-character limit for POSIX shared memory names (PSEMNAMLEN)
@@ -61,51 +249,10 @@ sentry__crash_ipc_init_app(sem_t *init_sem)
         return NULL;
     }
 
-    // Verify and resize shared memory (both new and existing)
-    if (shm_exists) {
-        // Check if existing shared memory has correct size
-        struct stat st;
-        if (fstat(ipc->shm_fd, &st) < 0) {
-            SENTRY_WARNF("failed to stat shared memory: %s", strerror(errno));
-            close(ipc->shm_fd);
-            if (ipc->init_sem) {
-                sem_post(ipc->init_sem);
-            }
-            sentry_free(ipc);
-            return NULL;
-        }
-        if (st.st_size != SENTRY_CRASH_SHM_SIZE) {
-            // Existing shm has wrong size, resize it
-            if (ftruncate(ipc->shm_fd, SENTRY_CRASH_SHM_SIZE) < 0) {
-                SENTRY_WARNF("failed to resize existing shared memory: %s",
-                    strerror(errno));
-                close(ipc->shm_fd);
-                if (ipc->init_sem) {
-                    sem_post(ipc->init_sem);
-                }
-                sentry_free(ipc);
-                return NULL;
-            }
-        }
-    } else {
-        // New shared memory, set size
-        if (ftruncate(ipc->shm_fd, SENTRY_CRASH_SHM_SIZE) < 0) {
-            SENTRY_WARNF("failed to resize shared memory: %s", strerror(errno));
-            close(ipc->shm_fd);
-            shm_unlink(ipc->shm_name);
-            if (ipc->init_sem) {
-                sem_post(ipc->init_sem);
-            }
-            sentry_free(ipc);
-            return NULL;
-        }
-    }
-
-    // Map shared memory
-    ipc->shmem = mmap(NULL, SENTRY_CRASH_SHM_SIZE, PROT_READ | PROT_WRITE,
-        MAP_SHARED, ipc->shm_fd, 0);
+    // Map shared memory, sized for the threads and modules of the process
+    // (an existing context is kept if it is valid)
+    ipc->shmem = map_app_context(ipc->shm_fd, shm_exists, &ipc->shm_size);
     if (ipc->shmem == MAP_FAILED) {
-        SENTRY_WARNF("failed to map shared memory: %s", strerror(errno));
         close(ipc->shm_fd);
         if (!shm_exists) {
             shm_unlink(ipc->shm_name);
@@ -121,7 +268,7 @@ sentry__crash_ipc_init_app(sem_t *init_sem)
     ipc->notify_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
     if (ipc->notify_fd < 0) {
         SENTRY_WARNF("failed to create eventfd: %s", strerror(errno));
-        munmap(ipc->shmem, SENTRY_CRASH_SHM_SIZE);
+        munmap(ipc->shmem, ipc->shm_size);
         close(ipc->shm_fd);
         if (!shm_exists) {
             shm_unlink(ipc->shm_name);
@@ -138,7 +285,7 @@ sentry__crash_ipc_init_app(sem_t *init_sem)
     if (ipc->ready_fd < 0) {
         SENTRY_WARNF("failed to create ready eventfd: %s", strerror(errno));
         close(ipc->notify_fd);
-        munmap(ipc->shmem, SENTRY_CRASH_SHM_SIZE);
+        munmap(ipc->shmem, ipc->shm_size);
         close(ipc->shm_fd);
         if (!shm_exists) {
             shm_unlink(ipc->shm_name);
@@ -150,15 +297,6 @@ sentry__crash_ipc_init_app(sem_t *init_sem)
         return NULL;
     }
 
-    // Initialize shared memory only if newly created
-    if (!shm_exists) {
-        memset(ipc->shmem, 0, SENTRY_CRASH_SHM_SIZE);
-        ipc->shmem->magic = SENTRY_CRASH_MAGIC;
-        ipc->shmem->version = SENTRY_CRASH_VERSION;
-        sentry__atomic_store(&ipc->shmem->state, SENTRY_CRASH_STATE_READY);
-        sentry__atomic_store(&ipc->shmem->sequence, 0);
-    }
-
     // Release semaphore after initialization
     if (ipc->init_sem) {
         sem_post(ipc->init_sem);
@@ -179,6 +317,7 @@ sentry__crash_ipc_init_daemon(
         return NULL;
     }
     ipc->is_daemon = true;
+    ipc->daemon_fd = -1;
 
     // Open existing shared memory created by app (using PID and thread ID)
     // Must match the format in sentry__crash_ipc_init_app
@@ -193,21 +332,9 @@ sentry__crash_ipc_init_daemon(
         return NULL;
     }
 
-    // Map shared memory
-    ipc->shmem = mmap(NULL, SENTRY_CRASH_SHM_SIZE, PROT_READ | PROT_WRITE,
-        MAP_SHARED, ipc->shm_fd, 0);
+    // Map and validate shared memory
+    ipc->shmem = map_daemon_context(ipc->shm_fd, &ipc->shm_size);
     if (ipc->shmem == MAP_FAILED) {
-        SENTRY_WARNF(
-            "daemon: failed to map shared memory: %s", strerror(errno));
-        close(ipc->shm_fd);
-        sentry_free(ipc);
-        return NULL;
-    }
-
-    // Validate shared memory
-    if (ipc->shmem->magic != SENTRY_CRASH_MAGIC) {
-        SENTRY_WARN("daemon: invalid shared memory magic");
-        munmap(ipc->shmem, SENTRY_CRASH_SHM_SIZE);
         close(ipc->shm_fd);
         sentry_free(ipc);
         return NULL;
@@ -284,7 +411,7 @@ sentry__crash_ipc_free(sentry_crash_ipc_t *ipc)
     }
 
     if (ipc->shmem && ipc->shmem != MAP_FAILED) {
-        munmap(ipc->shmem, SENTRY_CRASH_SHM_SIZE);
+        munmap(ipc->shmem, ipc->shm_size);
     }
 
     if (ipc->shm_fd >= 0) {
@@ -303,9 +430,233 @@ sentry__crash_ipc_free(sentry_crash_ipc_t *ipc)
         close(ipc->ready_fd);
     }
 
+    if (ipc->daemon_fd >= 0) {
+        close(ipc->daemon_fd);
+    }
+
     sentry_free(ipc);
 }
 
+#    define SHARED_REGISTRATION_MAGIC 0x53524547 // "SREG"
+#    define SHARED_REGISTRATION_TIMEOUT_MS 1000
+
+/**
+ * Sent by the app when it registers with a shared daemon, together with its
+ * notification eventfd. The PID of the app is taken from the credentials of
+ * the connection.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t app_tid;
+} shared_registration_t;
+
+static uint64_t
+fnv1a(uint64_t hash, const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+void
+sentry__crash_ipc_shared_name(
+    char *name, size_t name_size, const sentry_crash_context_t *ctx)
+{
+    // FNV-1a of everything the daemon takes from the app that registers
+    // first, so that only apps which agree on it share a daemon. Strings are
+    // hashed with their terminators to keep them apart.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    const char *strings[] = { ctx->database_path, ctx->dsn,
+        ctx->external_reporter_path, ctx->ca_certs, ctx->proxy,
+        ctx->user_agent };
+    for (size_t i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+        hash = fnv1a(hash, strings[i], strlen(strings[i]) + 1);
+    }
+    const uint8_t flags[] = { ctx->debug_enabled, ctx->attach_screenshot,
+        ctx->cache_keep, ctx->require_user_consent,
+        ctx->enable_large_attachments };
+    hash = fnv1a(hash, flags, sizeof(flags));
+    hash = fnv1a(
+        hash, &ctx->shutdown_timeout, sizeof(ctx->shutdown_timeout));
+    snprintf(name, name_size, "sentry-crash-%u-%016llx", (unsigned)getuid(),
+        (unsigned long long)hash);
+}
+
+/**
+ * Fills in the abstract socket address for `name`, which needs no file and
+ * goes away with the daemon.
+ */
+static socklen_t
+shared_address(struct sockaddr_un *addr, const char *name)
+{
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    size_t len = MIN(strlen(name), sizeof(addr->sun_path) - 1);
+    memcpy(addr->sun_path + 1, name, len);
+    return (socklen_t)(offsetof(struct sockaddr_un, sun_path) + 1 + len);
+}
+
+/**
+ * Reads the credentials of the peer of `fd`, which must be a process of the
+ * same user.
+ */
+static bool
+peer_credentials(int fd, struct ucred *cred)
+{
+    socklen_t len = sizeof(*cred);
+    return getsockopt(fd, SOL_SOCKET, SO_PEERCRED, cred, &len) == 0
+        && cred->uid == getuid();
+}
+
+int
+sentry__crash_ipc_listen(const char *name)
+{
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        SENTRY_WARNF("daemon: failed to create socket: %s", strerror(errno));
+        return -1;
+    }
+    struct sockaddr_un addr;
+    socklen_t addr_len = shared_address(&addr, name);
+    if (bind(fd, (struct sockaddr *)&addr, addr_len) < 0
+        || listen(fd, SOMAXCONN) < 0) {
+        SENTRY_DEBUGF(
+            "daemon: failed to listen on %s: %s", name, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+pid_t
+sentry__crash_ipc_register(
+    sentry_crash_ipc_t *ipc, const char *name, uint64_t app_tid)
+{
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_un addr;
+    socklen_t addr_len = shared_address(&addr, name);
+    struct ucred cred;
+    if (connect(fd, (struct sockaddr *)&addr, addr_len) < 0
+        || !peer_credentials(fd, &cred)) {
+        close(fd);
+        return -1;
+    }
+
+    shared_registration_t registration = { .magic = SHARED_REGISTRATION_MAGIC,
+        .version = SENTRY_CRASH_VERSION,
+        .app_tid = app_tid };
+    struct iovec iov = { &registration, sizeof(registration) };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &ipc->notify_fd, sizeof(int));
+
+    // The daemon acknowledges once it attached to the crash context. A daemon
+    // that is about to exit closes the connection instead.
+    uint8_t ack = 0;
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    if (sendmsg(fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(registration)
+        || poll(&pfd, 1, SENTRY_CRASH_DAEMON_READY_TIMEOUT_MS) <= 0
+        || recv(fd, &ack, sizeof(ack), 0) != (ssize_t)sizeof(ack)
+        || ack != 1) {
+        SENTRY_DEBUGF("shared crash daemon %s did not accept the app", name);
+        close(fd);
+        return -1;
+    }
+
+    // The connection stays open, the daemon drops the app when it closes
+    ipc->daemon_fd = fd;
+    SENTRY_DEBUGF("registered with shared crash daemon %s (PID %d)", name,
+        (int)cred.pid);
+    return cred.pid;
+}
+
+sentry_crash_ipc_t *
+sentry__crash_ipc_accept(int listen_fd)
+{
+    int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct ucred cred;
+    if (!peer_credentials(fd, &cred)) {
+        SENTRY_WARN("daemon: rejecting app of another user");
+        close(fd);
+        return NULL;
+    }
+
+    // The app sends its registration right after connecting
+    shared_registration_t registration;
+    struct iovec iov = { &registration, sizeof(registration) };
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    } control;
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    ssize_t received = poll(&pfd, 1, SHARED_REGISTRATION_TIMEOUT_MS) > 0
+        ? recvmsg(fd, &msg, MSG_CMSG_CLOEXEC)
+        : -1;
+
+    int notify_fd = -1;
+    struct cmsghdr *cmsg = received > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET
+        && cmsg->cmsg_type == SCM_RIGHTS
+        && cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+        memcpy(&notify_fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    if (received != (ssize_t)sizeof(registration) || notify_fd < 0
+        || registration.magic != SHARED_REGISTRATION_MAGIC
+        || registration.version != SENTRY_CRASH_VERSION) {
+        SENTRY_WARNF("daemon: invalid registration from PID %d", (int)cred.pid);
+        if (notify_fd >= 0) {
+            close(notify_fd);
+        }
+        close(fd);
+        return NULL;
+    }
+
+    sentry_crash_ipc_t *ipc = sentry__crash_ipc_init_daemon(
+        cred.pid, registration.app_tid, notify_fd, -1);
+    if (!ipc) {
+        close(notify_fd);
+        close(fd);
+        return NULL;
+    }
+    ipc->daemon_fd = fd;
+    ipc->parent_handle = cred.pid;
+
+    uint8_t ack = 1;
+    if (send(fd, &ack, sizeof(ack), MSG_NOSIGNAL) != (ssize_t)sizeof(ack)) {
+        sentry__crash_ipc_free(ipc);
+        return NULL;
+    }
+    return ipc;
+}
+
 #elif defined(SENTRY_PLATFORM_MACOS)
 
 #    include <errno.h>
@@ -360,49 +711,10 @@ sentry__crash_ipc_init_app(sentry_mutex_t *init_mutex)
         return NULL;
     }
 
-    // Verify and resize shared memory (both new and existing)
-    if (shm_exists) {
-        struct stat st;
-        if (fstat(ipc->shm_fd, &st) < 0) {
-            SENTRY_WARNF(
-                "failed to stat shared memory file: %s", strerror(errno));
-            close(ipc->shm_fd);
-            if (ipc->init_mutex) {
-                sentry__mutex_unlock(ipc->init_mutex);
-            }
-            sentry_free(ipc);
-            return NULL;
-        }
-        if (st.st_size != SENTRY_CRASH_SHM_SIZE) {
-            if (ftruncate(ipc->shm_fd, SENTRY_CRASH_SHM_SIZE) < 0) {
-                SENTRY_WARNF(
-                    "failed to resize shared memory file: %s", strerror(errno));
-                close(ipc->shm_fd);
-                if (ipc->init_mutex) {
-                    sentry__mutex_unlock(ipc->init_mutex);
-                }
-                sentry_free(ipc);
-                return NULL;
-            }
-        }
-    } else {
-        if (ftruncate(ipc->shm_fd, SENTRY_CRASH_SHM_SIZE) < 0) {
-            SENTRY_WARNF(
-                "failed to resize shared memory file: %s", strerror(errno));
-            close(ipc->shm_fd);
-            unlink(ipc->shm_path);
-            if (ipc->init_mutex) {
-                sentry__mutex_unlock(ipc->init_mutex);
-            }
-            sentry_free(ipc);
-            return NULL;
-        }
-    }
-
-    ipc->shmem = mmap(NULL, SENTRY_CRASH_SHM_SIZE, PROT_READ | PROT_WRITE,
-        MAP_SHARED, ipc->shm_fd, 0);
+    // Map shared memory, sized for the threads and modules of the process
+    // (an existing context is kept if it is valid)
+    ipc->shmem = map_app_context(ipc->shm_fd, shm_exists, &ipc->shm_size);
     if (ipc->shmem == MAP_FAILED) {
-        SENTRY_WARNF("failed to map shared memory: %s", strerror(errno));
         close(ipc->shm_fd);
         if (!shm_exists) {
             unlink(ipc->shm_path);
@@ -417,7 +729,7 @@ sentry__crash_ipc_init_app(sentry_mutex_t *init_mutex)
     // Create pipe for crash notifications (works across fork/posix_spawn)
     if (pipe(ipc->notify_pipe) < 0) {
         SENTRY_WARNF("failed to create notification pipe: %s", strerror(errno));
-        munmap(ipc->shmem, SENTRY_CRASH_SHM_SIZE);
+        munmap(ipc->shmem, ipc->shm_size);
         close(ipc->shm_fd);
         if (!shm_exists) {
             unlink(ipc->shm_path);
@@ -437,7 +749,7 @@ sentry__crash_ipc_init_app(sentry_mutex_t *init_mutex)
         SENTRY_WARNF("failed to create ready pipe: %s", strerror(errno));
         close(ipc->notify_pipe[0]);
         close(ipc->notify_pipe[1]);
-        munmap(ipc->shmem, SENTRY_CRASH_SHM_SIZE);
+        munmap(ipc->shmem, ipc->shm_size);
         close(ipc->shm_fd);
         if (!shm_exists) {
             unlink(ipc->shm_path);
@@ -449,14 +761,6 @@ sentry__crash_ipc_init_app(sentry_mutex_t *init_mutex)
         return NULL;
     }
 
-    if (!shm_exists) {
-        memset(ipc->shmem, 0, SENTRY_CRASH_SHM_SIZE);
-        ipc->shmem->magic = SENTRY_CRASH_MAGIC;
-        ipc->shmem->version = SENTRY_CRASH_VERSION;
-        sentry__atomic_store(&ipc->shmem->state, SENTRY_CRASH_STATE_READY);
-        sentry__atomic_store(&ipc->shmem->sequence, 0);
-    }
-
     if (ipc->init_mutex) {
         sentry__mutex_unlock(ipc->init_mutex);
     }
@@ -482,19 +786,8 @@ sentry__crash_ipc_init_daemon(pid_t app_pid, uint64_t app_tid,
 
     // Use the inherited shm_fd directly (no shm_open needed, sandbox-safe)
     ipc->shm_fd = shm_fd;
-    ipc->shmem = mmap(NULL, SENTRY_CRASH_SHM_SIZE, PROT_READ | PROT_WRITE,
-        MAP_SHARED, ipc->shm_fd, 0);
+    ipc->shmem = map_daemon_context(ipc->shm_fd, &ipc->shm_size);
     if (ipc->shmem == MAP_FAILED) {
-        SENTRY_WARNF(
-            "daemon: failed to map shared memory: %s", strerror(errno));
-        close(ipc->shm_fd);
-        sentry_free(ipc);
-        return NULL;
-    }
-
-    if (ipc->shmem->magic != SENTRY_CRASH_MAGIC) {
-        SENTRY_WARN("daemon: invalid shared memory magic");
-        munmap(ipc->shmem, SENTRY_CRASH_SHM_SIZE);
         close(ipc->shm_fd);
         sentry_free(ipc);
         return NULL;
@@ -569,7 +862,7 @@ sentry__crash_ipc_free(sentry_crash_ipc_t *ipc)
     }
 
     if (ipc->shmem && ipc->shmem != MAP_FAILED) {
-        munmap(ipc->shmem, SENTRY_CRASH_SHM_SIZE);
+        munmap(ipc->shmem, ipc->shm_size);
     }
 
     if (ipc->shm_fd >= 0) {
@@ -601,6 +894,19 @@ sentry__crash_ipc_free(sentry_crash_ipc_t *ipc)
 
 #elif defined(SENTRY_PLATFORM_WINDOWS)
 
+/**
+ * Returns the size of a view of a file mapping that was mapped in full.
+ */
+static size_t
+view_size(const void *view)
+{
+    MEMORY_BASIC_INFORMATION info;
+    if (!VirtualQuery(view, &info, sizeof(info))) {
+        return 0;
+    }
+    return info.RegionSize;
+}
+
 sentry_crash_ipc_t *
 sentry__crash_ipc_init_app(HANDLE init_mutex)
 {
@@ -634,10 +940,13 @@ sentry__crash_ipc_init_app(HANDLE init_mutex)
         }
     }
 
-    // Try to create or open shared memory
+    // Try to create or open shared memory, sized for the threads and modules
+    // of the process
+    size_t threads, modules, strings;
+    size_t shm_size = app_context_capacity(&threads, &modules, &strings);
     bool shm_exists = false;
     ipc->shm_handle = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL,
-        PAGE_READWRITE, 0, SENTRY_CRASH_SHM_SIZE, ipc->shm_name);
+        PAGE_READWRITE, 0, (DWORD)shm_size, ipc->shm_name);
     if (!ipc->shm_handle) {
         SENTRY_WARNF("failed to create shared memory: %lu", GetLastError());
         if (ipc->init_mutex) {
@@ -652,8 +961,8 @@ sentry__crash_ipc_init_app(HANDLE init_mutex)
         shm_exists = true;
     }
 
-    ipc->shmem = MapViewOfFile(
-        ipc->shm_handle, FILE_MAP_ALL_ACCESS, 0, 0, SENTRY_CRASH_SHM_SIZE);
+    ipc->shmem
+        = MapViewOfFile(ipc->shm_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
     if (!ipc->shmem) {
         SENTRY_WARNF("failed to map shared memory: %lu", GetLastError());
         CloseHandle(ipc->shm_handle);
@@ -664,6 +973,24 @@ sentry__crash_ipc_init_app(HANDLE init_mutex)
         return NULL;
     }
 
+    // An existing mapping keeps the size it was created with, and its context
+    // is kept if it is valid
+    ipc->shm_size = shm_exists ? view_size(ipc->shmem) : shm_size;
+    if (!shm_exists
+        || !sentry__crash_context_validate(ipc->shmem, ipc->shm_size)) {
+        if (ipc->shm_size < shm_size) {
+            SENTRY_WARN("existing shared memory is too small");
+            UnmapViewOfFile(ipc->shmem);
+            CloseHandle(ipc->shm_handle);
+            if (ipc->init_mutex) {
+                ReleaseMutex(ipc->init_mutex);
+            }
+            sentry_free(ipc);
+            return NULL;
+        }
+        sentry__crash_context_init(ipc->shmem, threads, modules, strings);
+    }
+
     // Create named event for notifications (using PID and thread ID)
     swprintf(ipc->event_name, SENTRY_CRASH_IPC_NAME_SIZE,
         L"Local\\SentryCrashEvent-%lu-%llx", GetCurrentProcessId(), tid);
@@ -705,15 +1032,6 @@ sentry__crash_ipc_init_app(HANDLE init_mutex)
         return NULL;
     }
 
-    // Initialize shared memory only if newly created
-    if (!shm_exists) {
-        memset(ipc->shmem, 0, SENTRY_CRASH_SHM_SIZE);
-        ipc->shmem->magic = SENTRY_CRASH_MAGIC;
-        ipc->shmem->version = SENTRY_CRASH_VERSION;
-        sentry__atomic_store(&ipc->shmem->state, SENTRY_CRASH_STATE_READY);
-        sentry__atomic_store(&ipc->shmem->sequence, 0);
-    }
-
     // Release mutex after initialization
     if (ipc->init_mutex) {
         ReleaseMutex(ipc->init_mutex);
@@ -752,8 +1070,9 @@ sentry__crash_ipc_init_daemon(pid_t app_pid, uint64_t app_tid,
         return NULL;
     }
 
-    ipc->shmem = MapViewOfFile(
-        ipc->shm_handle, FILE_MAP_ALL_ACCESS, 0, 0, SENTRY_CRASH_SHM_SIZE);
+    // Map the whole context, with the size the app chose for it
+    ipc->shmem
+        = MapViewOfFile(ipc->shm_handle, FILE_MAP_ALL_ACCESS, 0, 0, 0);
     if (!ipc->shmem) {
         SENTRY_WARNF(
             "daemon: failed to map shared memory: %lu", GetLastError());
@@ -762,8 +1081,9 @@ sentry__crash_ipc_init_daemon(pid_t app_pid, uint64_t app_tid,
         return NULL;
     }
 
-    if (ipc->shmem->magic != SENTRY_CRASH_MAGIC) {
-        SENTRY_WARN("daemon: invalid shared memory magic");
+    ipc->shm_size = view_size(ipc->shmem);
+    if (!sentry__crash_context_validate(ipc->shmem, ipc->shm_size)) {
+        SENTRY_WARN("daemon: invalid shared memory context");
         UnmapViewOfFile(ipc->shmem);
         CloseHandle(ipc->shm_handle);
         sentry_free(ipc);
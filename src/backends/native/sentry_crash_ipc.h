@@ -27,6 +27,7 @@ typedef pid_t sentry_process_handle_t;
  */
 typedef struct {
     sentry_crash_context_t *shmem;
+    size_t shm_size; // Mapped size of the crash context
 
 #if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
     int shm_fd;
@@ -35,6 +36,7 @@ typedef struct {
     char shm_name[SENTRY_CRASH_IPC_NAME_SIZE];
     sem_t *init_sem; // Named semaphore for initialization synchronization
     char sem_name[SENTRY_CRASH_IPC_NAME_SIZE];
+    int daemon_fd; // Connection to a shared daemon, -1 for a dedicated one
 #elif defined(SENTRY_PLATFORM_MACOS)
     int shm_fd;
     int notify_pipe[2]; // Pipe for crash notifications (fork-safe)
@@ -119,6 +121,38 @@ void sentry__crash_ipc_notify(sentry_crash_ipc_t *ipc);
  */
 bool sentry__crash_ipc_wait(sentry_crash_ipc_t *ipc, int timeout_ms);
 
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+/**
+ * Builds the socket name of the shared crash daemon for the apps of the
+ * current user whose crash context `ctx` has the same database path, DSN and
+ * daemon settings, such as user consent, external reporter and transport.
+ */
+void sentry__crash_ipc_shared_name(
+    char *name, size_t name_size, const sentry_crash_context_t *ctx);
+
+/**
+ * Creates the listening socket of a shared crash daemon.
+ * Returns -1 on failure, or if another daemon already listens on `name`.
+ */
+int sentry__crash_ipc_listen(const char *name);
+
+/**
+ * Registers the app with the shared crash daemon listening on `name`, which
+ * attaches to the crash context of `ipc` and receives its crash
+ * notifications from then on (called by app).
+ * Returns the PID of the daemon, or -1 if no daemon accepted the app.
+ */
+pid_t sentry__crash_ipc_register(
+    sentry_crash_ipc_t *ipc, const char *name, uint64_t app_tid);
+
+/**
+ * Accepts the registration of an app on the listening socket of a shared
+ * crash daemon (called by daemon).
+ * Returns NULL if the registration is invalid, or from another user.
+ */
+sentry_crash_ipc_t *sentry__crash_ipc_accept(int listen_fd);
+#endif
+
 /**
  * Unlink the shared memory.
  */
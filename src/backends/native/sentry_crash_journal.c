@@ -0,0 +1,170 @@
+#include "sentry_crash_journal.h"
+
+#include "sentry_alloc.h"
+#include "sentry_json.h"
+#include "sentry_sync.h"
+#include "sentry_utils.h"
+#include "sentry_value.h"
+
+#include <string.h>
+
+// How often the daemon retries reading a scope snapshot that is being
+// replaced concurrently
+#define SCOPE_READ_ATTEMPTS 8
+
+#define RING_MASK (SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE - 1)
+
+#if SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE & RING_MASK
+#    error "the breadcrumb ring buffer size must be a power of two"
+#endif
+
+/**
+ * A full barrier around reads of the counters the app publishes, so that
+ * the daemon re-reads them only after it has copied the data they guard.
+ */
+static long
+fetch_fenced(const volatile long *val)
+{
+    return sentry__atomic_fetch_and_add((volatile long *)val, 0);
+}
+
+void
+sentry__crash_journal_init(
+    sentry_crash_journal_t *journal, size_t max_breadcrumbs)
+{
+    memset(journal, 0, sizeof(*journal));
+    // the index entry after the newest breadcrumb is overwritten next, so
+    // one entry needs to stay out of the daemon's reading window
+    journal->max_breadcrumbs = (uint32_t)MIN(
+        max_breadcrumbs, SENTRY_CRASH_JOURNAL_MAX_BREADCRUMBS - 1);
+}
+
+bool
+sentry__crash_journal_write_scope(
+    sentry_crash_journal_t *journal, const char *buf, size_t len)
+{
+    if (len > SENTRY_CRASH_JOURNAL_SCOPE_SIZE) {
+        return false;
+    }
+    long seq = journal->scope_seq + 1;
+    size_t slot = (unsigned long)seq % 2;
+    memcpy(journal->scope[slot], buf, len);
+    journal->scope_len[slot] = (uint32_t)len;
+    sentry__atomic_store(&journal->scope_seq, seq);
+    return true;
+}
+
+bool
+sentry__crash_journal_add_breadcrumb(
+    sentry_crash_journal_t *journal, const char *buf, size_t len)
+{
+    if (len > SENTRY_CRASH_JOURNAL_MAX_BREADCRUMB_SIZE) {
+        return false;
+    }
+    long count = journal->breadcrumb_count;
+    uint32_t offset = (uint32_t)journal->breadcrumb_head;
+
+    // reserve the bytes first, so the daemon knows that the breadcrumbs they
+    // belonged to are being overwritten
+    sentry__atomic_store(&journal->breadcrumb_head, (long)(offset + len));
+
+    size_t pos = offset & RING_MASK;
+    size_t first = MIN(len, SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE - pos);
+    memcpy(journal->breadcrumbs + pos, buf, first);
+    memcpy(journal->breadcrumbs, buf + first, len - first);
+
+    sentry_crash_journal_entry_t *entry
+        = &journal->breadcrumb_index[(unsigned long)count
+            % SENTRY_CRASH_JOURNAL_MAX_BREADCRUMBS];
+    entry->offset = offset;
+    entry->len = (uint32_t)len;
+    sentry__atomic_store(&journal->breadcrumb_count, count + 1);
+    return true;
+}
+
+static sentry_value_t
+read_scope(const sentry_crash_journal_t *journal)
+{
+    char *buf = sentry_malloc(SENTRY_CRASH_JOURNAL_SCOPE_SIZE);
+    if (!buf) {
+        return sentry_value_new_null();
+    }
+    sentry_value_t event = sentry_value_new_null();
+    for (int i = 0; i < SCOPE_READ_ATTEMPTS; i++) {
+        long seq = fetch_fenced(&journal->scope_seq);
+        if (!seq) {
+            break;
+        }
+        size_t slot = (unsigned long)seq % 2;
+        size_t len = MIN(
+            journal->scope_len[slot], SENTRY_CRASH_JOURNAL_SCOPE_SIZE);
+        memcpy(buf, journal->scope[slot], len);
+        // the next snapshot only goes into this slot once it is published
+        if (fetch_fenced(&journal->scope_seq) == seq) {
+            event = sentry__value_from_json(buf, len);
+            break;
+        }
+    }
+    sentry_free(buf);
+    return event;
+}
+
+static sentry_value_t
+read_breadcrumbs(const sentry_crash_journal_t *journal)
+{
+    sentry_value_t breadcrumbs = sentry_value_new_list();
+    char *buf = sentry_malloc(SENTRY_CRASH_JOURNAL_MAX_BREADCRUMB_SIZE);
+    if (!buf) {
+        return breadcrumbs;
+    }
+    unsigned long count
+        = (unsigned long)fetch_fenced(&journal->breadcrumb_count);
+    unsigned long max_breadcrumbs = MIN(
+        journal->max_breadcrumbs, SENTRY_CRASH_JOURNAL_MAX_BREADCRUMBS - 1);
+    unsigned long first
+        = count > max_breadcrumbs ? count - max_breadcrumbs : 0;
+
+    for (unsigned long i = first; i < count; i++) {
+        sentry_crash_journal_entry_t entry = journal->breadcrumb_index[i
+            % SENTRY_CRASH_JOURNAL_MAX_BREADCRUMBS];
+        size_t len = MIN(entry.len, SENTRY_CRASH_JOURNAL_MAX_BREADCRUMB_SIZE);
+        size_t pos = entry.offset & RING_MASK;
+        size_t part = MIN(len, SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE - pos);
+        memcpy(buf, journal->breadcrumbs + pos, part);
+        memcpy(buf + part, journal->breadcrumbs, len - part);
+
+        // skip breadcrumbs whose index entry or bytes have been overwritten
+        // in the meantime
+        unsigned long new_count
+            = (unsigned long)fetch_fenced(&journal->breadcrumb_count);
+        uint32_t head = (uint32_t)fetch_fenced(&journal->breadcrumb_head);
+        if (new_count - i >= SENTRY_CRASH_JOURNAL_MAX_BREADCRUMBS
+            || (uint32_t)(head - entry.offset)
+                > SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE) {
+            continue;
+        }
+
+        sentry_value_t breadcrumb = sentry__value_from_json(buf, len);
+        if (!sentry_value_is_null(breadcrumb)) {
+            sentry_value_append(breadcrumbs, breadcrumb);
+        }
+    }
+    sentry_free(buf);
+    return breadcrumbs;
+}
+
+sentry_value_t
+sentry__crash_journal_read_event(const sentry_crash_journal_t *journal)
+{
+    sentry_value_t event = read_scope(journal);
+    sentry_value_t breadcrumbs = read_breadcrumbs(journal);
+    if (sentry_value_get_length(breadcrumbs) > 0) {
+        if (sentry_value_is_null(event)) {
+            event = sentry_value_new_object();
+        }
+        sentry_value_set_by_key(event, "breadcrumbs", breadcrumbs);
+    } else {
+        sentry_value_decref(breadcrumbs);
+    }
+    return event;
+}
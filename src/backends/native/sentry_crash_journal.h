@@ -0,0 +1,46 @@
+#ifndef SENTRY_CRASH_JOURNAL_H_INCLUDED
+#define SENTRY_CRASH_JOURNAL_H_INCLUDED
+
+#include "sentry_boot.h"
+#include "sentry_crash_context.h"
+
+/**
+ * The crash journal keeps the latest scope snapshot and the most recent
+ * breadcrumbs as serialized JSON in the shared crash context, so the app can
+ * update them in place without any file I/O, and the daemon can read them
+ * directly at crash time.
+ *
+ * The app side functions need to be serialized by the caller. The daemon side
+ * may run concurrently with them, and skips any data that was overwritten
+ * while it was being read.
+ */
+
+/**
+ * Resets the journal. The daemon will attach at most `max_breadcrumbs`
+ * breadcrumbs to the scope event.
+ */
+void sentry__crash_journal_init(
+    sentry_crash_journal_t *journal, size_t max_breadcrumbs);
+
+/**
+ * Replaces the scope snapshot with the serialized event in `buf`.
+ * Returns false if it does not fit into the journal.
+ */
+bool sentry__crash_journal_write_scope(
+    sentry_crash_journal_t *journal, const char *buf, size_t len);
+
+/**
+ * Appends the serialized breadcrumb in `buf`, evicting the oldest breadcrumbs
+ * as needed. Returns false if the breadcrumb is too large for the journal.
+ */
+bool sentry__crash_journal_add_breadcrumb(
+    sentry_crash_journal_t *journal, const char *buf, size_t len);
+
+/**
+ * Reads the scope snapshot as an event, with the most recent breadcrumbs
+ * attached. Returns a null value if the journal is empty.
+ */
+sentry_value_t sentry__crash_journal_read_event(
+    const sentry_crash_journal_t *journal);
+
+#endif
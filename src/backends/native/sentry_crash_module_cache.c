@@ -0,0 +1,612 @@
+#include "sentry_crash_module_cache.h"
+
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+
+#    include "sentry_alloc.h"
+#    include "sentry_crash_context.h"
+#    include "sentry_logger.h"
+#    include "sentry_sync.h"
+#    include "sentry_utils.h"
+
+#    include <elf.h>
+#    include <fcntl.h>
+#    include <stdio.h>
+#    include <string.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+
+#    if defined(__x86_64__) || defined(__aarch64__)
+typedef Elf64_Ehdr ehdr_t;
+typedef Elf64_Phdr phdr_t;
+typedef Elf64_Shdr shdr_t;
+typedef Elf64_Nhdr nhdr_t;
+typedef Elf64_Dyn dyn_t;
+#    else
+typedef Elf32_Ehdr ehdr_t;
+typedef Elf32_Phdr phdr_t;
+typedef Elf32_Shdr shdr_t;
+typedef Elf32_Nhdr nhdr_t;
+typedef Elf32_Dyn dyn_t;
+#    endif
+
+#    define MODULE_CACHE_MAGIC 0x434d4e53 // "SNMC" in little-endian
+#    define MODULE_CACHE_VERSION 1
+
+/**
+ * Upper bound for the entries of a persisted cache.
+ */
+#    define MODULE_CACHE_MAX_ENTRIES SENTRY_CRASH_MAX_MAPPINGS
+
+/**
+ * Number of mapping sets that are remembered as warmed. Apps of a shared
+ * daemon that run the same program usually map the same set of files.
+ */
+#    define MODULE_CACHE_WARMED_SETS 64
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_size;
+    uint32_t count;
+} module_cache_header_t;
+
+typedef struct {
+    sentry_crash_module_identity_t identity;
+    // looked up since the cache was loaded, persisted on the next save
+    bool used;
+} module_cache_entry_t;
+
+static struct {
+    module_cache_entry_t *entries;
+    size_t count;
+    size_t capacity;
+    bool dirty;
+    // signatures of the mapping sets that were warmed, oldest replaced first
+    uint64_t warmed[MODULE_CACHE_WARMED_SETS];
+    size_t warmed_count;
+} g_cache;
+
+// Recursive, since the public functions call each other
+static sentry_mutex_t g_cache_lock = SENTRY__MUTEX_INIT;
+
+static void *
+read_at(int fd, uint64_t offset, size_t size)
+{
+    if (size == 0) {
+        return NULL;
+    }
+    void *buf = sentry_malloc(size);
+    if (buf && pread(fd, buf, size, (off_t)offset) != (ssize_t)size) {
+        sentry_free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+/**
+ * Computes the virtual memory size of an ELF file from its PT_LOAD segments.
+ * This matches Crashpad's behavior: size = max(p_vaddr + p_memsz) -
+ * min(p_vaddr) across all PT_LOAD segments, rather than using page-aligned
+ * /proc/maps sizes.
+ */
+static uint64_t
+elf_size_from_phdrs(int fd, const ehdr_t *ehdr)
+{
+    phdr_t *phdrs = read_at(
+        fd, ehdr->e_phoff, (size_t)ehdr->e_phentsize * ehdr->e_phnum);
+    if (!phdrs) {
+        return 0;
+    }
+
+    uint64_t min_vaddr = UINT64_MAX;
+    uint64_t max_vaddr = 0;
+    bool found_load = false;
+    for (int i = 0; i < ehdr->e_phnum; i++) {
+        if (phdrs[i].p_type == PT_LOAD) {
+            found_load = true;
+            if (phdrs[i].p_vaddr < min_vaddr) {
+                min_vaddr = phdrs[i].p_vaddr;
+            }
+            uint64_t end = phdrs[i].p_vaddr + phdrs[i].p_memsz;
+            if (end > max_vaddr) {
+                max_vaddr = end;
+            }
+        }
+    }
+    sentry_free(phdrs);
+
+    if (!found_load || max_vaddr <= min_vaddr) {
+        return 0;
+    }
+    return max_vaddr - min_vaddr;
+}
+
+/**
+ * Finds the GNU Build ID in the note sections.
+ * Returns the Build ID length, or 0 if not found.
+ */
+static size_t
+build_id_from_notes(int fd, const shdr_t *sections, size_t section_count,
+    uint8_t *build_id, size_t max_len)
+{
+    for (size_t i = 0; i < section_count; i++) {
+        if (sections[i].sh_type != SHT_NOTE || sections[i].sh_size > 4096) {
+            continue;
+        }
+        size_t note_size = sections[i].sh_size;
+        uint8_t *note_buf = read_at(fd, sections[i].sh_offset, note_size);
+        if (!note_buf) {
+            continue;
+        }
+
+        uint8_t *ptr = note_buf;
+        uint8_t *end = ptr + note_size;
+        while (ptr + sizeof(nhdr_t) <= end) {
+            nhdr_t *nhdr = (nhdr_t *)ptr;
+            ptr += sizeof(*nhdr);
+
+            // Use aligned sizes in bounds check since pointer advances by
+            // aligned amounts. Also check for zero advancement to prevent an
+            // infinite loop on malformed notes.
+            size_t aligned_namesz = ((nhdr->n_namesz + 3) & ~3);
+            size_t aligned_descsz = ((nhdr->n_descsz + 3) & ~3);
+            if ((aligned_namesz == 0 && aligned_descsz == 0)
+                || ptr + aligned_namesz + aligned_descsz > end) {
+                break;
+            }
+
+            // GNU Build ID (type 3, name "GNU\0")
+            if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4
+                && memcmp(ptr, "GNU", 4) == 0) {
+                size_t len = MIN(nhdr->n_descsz, max_len);
+                memcpy(build_id, ptr + aligned_namesz, len);
+                sentry_free(note_buf);
+                return len;
+            }
+            ptr += aligned_namesz + aligned_descsz;
+        }
+        sentry_free(note_buf);
+    }
+    return 0;
+}
+
+/**
+ * Reads the DT_SONAME from the dynamic section, resolved through the string
+ * table that the dynamic section links to.
+ */
+static bool
+soname_from_dynamic(int fd, const shdr_t *sections, size_t section_count,
+    char *soname_buf, size_t soname_buf_size)
+{
+    const shdr_t *dynamic_shdr = NULL;
+    for (size_t i = 0; i < section_count; i++) {
+        if (sections[i].sh_type == SHT_DYNAMIC) {
+            dynamic_shdr = &sections[i];
+            break;
+        }
+    }
+    if (!dynamic_shdr || dynamic_shdr->sh_link >= section_count) {
+        return false;
+    }
+    const shdr_t *dynstr_shdr = &sections[dynamic_shdr->sh_link];
+    size_t dynstr_size = dynstr_shdr->sh_size;
+    if (dynstr_size > 1024 * 1024) { // Sanity: max 1MB
+        return false;
+    }
+
+    dyn_t *dyn_entries
+        = read_at(fd, dynamic_shdr->sh_offset, dynamic_shdr->sh_size);
+    char *dynstr = read_at(fd, dynstr_shdr->sh_offset, dynstr_size);
+    bool result = false;
+    size_t dyn_count = dyn_entries ? dynamic_shdr->sh_size / sizeof(dyn_t) : 0;
+    for (size_t i = 0; dynstr && i < dyn_count; i++) {
+        if (dyn_entries[i].d_tag == DT_SONAME) {
+            size_t name_offset = dyn_entries[i].d_un.d_val;
+            if (name_offset < dynstr_size) {
+                const char *soname = dynstr + name_offset;
+                size_t len = strnlen(soname, dynstr_size - name_offset);
+                if (len > 0 && len < soname_buf_size) {
+                    memcpy(soname_buf, soname, len);
+                    soname_buf[len] = '\0';
+                    result = true;
+                }
+            }
+            break;
+        }
+        if (dyn_entries[i].d_tag == DT_NULL) {
+            break;
+        }
+    }
+    sentry_free(dynstr);
+    sentry_free(dyn_entries);
+    return result;
+}
+
+/**
+ * Parses the identity of an ELF file, reading its headers only once.
+ * Returns false if it is not an ELF file.
+ */
+static bool
+read_elf_identity(int fd, sentry_crash_module_identity_t *identity)
+{
+    ehdr_t ehdr;
+    if (pread(fd, &ehdr, sizeof(ehdr), 0) != sizeof(ehdr)
+        || memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0) {
+        return false;
+    }
+
+    identity->elf_size = elf_size_from_phdrs(fd, &ehdr);
+
+    // Cast to size_t to prevent integer overflow (uint16_t * uint16_t promotes
+    // to int, which can overflow)
+    shdr_t *sections = read_at(
+        fd, ehdr.e_shoff, (size_t)ehdr.e_shentsize * ehdr.e_shnum);
+    if (sections) {
+        identity->build_id_len = (uint32_t)build_id_from_notes(fd, sections,
+            ehdr.e_shnum, identity->build_id, sizeof(identity->build_id));
+        soname_from_dynamic(fd, sections, ehdr.e_shnum, identity->soname,
+            sizeof(identity->soname));
+        sentry_free(sections);
+    }
+    return true;
+}
+
+/**
+ * Sets the fields of `key` that identify the file of `st` in the cache.
+ */
+static void
+key_from_stat(sentry_crash_module_identity_t *key, const struct stat *st)
+{
+    key->dev = (uint64_t)st->st_dev;
+    key->ino = (uint64_t)st->st_ino;
+    key->mtime_sec = (int64_t)st->st_mtim.tv_sec;
+    key->mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+}
+
+static module_cache_entry_t *
+find_entry(const sentry_crash_module_identity_t *key)
+{
+    for (size_t i = 0; i < g_cache.count; i++) {
+        const sentry_crash_module_identity_t *identity
+            = &g_cache.entries[i].identity;
+        if (identity->ino == key->ino && identity->dev == key->dev
+            && identity->mtime_sec == key->mtime_sec
+            && identity->mtime_nsec == key->mtime_nsec) {
+            return &g_cache.entries[i];
+        }
+    }
+    return NULL;
+}
+
+static module_cache_entry_t *
+add_entry(void)
+{
+    if (g_cache.count == g_cache.capacity) {
+        size_t capacity = g_cache.capacity ? g_cache.capacity * 2 : 64;
+        module_cache_entry_t *entries
+            = sentry_malloc(sizeof(module_cache_entry_t) * capacity);
+        if (!entries) {
+            return NULL;
+        }
+        if (g_cache.count) {
+            memcpy(entries, g_cache.entries,
+                sizeof(module_cache_entry_t) * g_cache.count);
+        }
+        sentry_free(g_cache.entries);
+        g_cache.entries = entries;
+        g_cache.capacity = capacity;
+    }
+    module_cache_entry_t *entry = &g_cache.entries[g_cache.count++];
+    memset(entry, 0, sizeof(*entry));
+    g_cache.dirty = true;
+    return entry;
+}
+
+/**
+ * Parses the identity of the file at `path`, keyed by the file that was
+ * actually opened. Returns false if the file cannot be opened.
+ */
+static bool
+parse_identity(const char *path, sentry_crash_module_identity_t *identity)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    memset(identity, 0, sizeof(*identity));
+    key_from_stat(identity, &st);
+    if (read_elf_identity(fd, identity)) {
+        identity->flags |= SENTRY_CRASH_MODULE_ELF;
+    }
+    SENTRY_DEBUGF("cached module identity of %s: build_id_len=%u", path,
+        identity->build_id_len);
+    close(fd);
+    return true;
+}
+
+/**
+ * Looks up the identity of the file at `path`, and parses the file into a new
+ * entry if it is not cached yet. The lock is only held to access the entries,
+ * not while the file is parsed. Returns false if the file cannot be read, and
+ * sets `added` if a new entry was added.
+ */
+static bool
+lookup(const char *path, sentry_crash_module_identity_t *identity, bool *added)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return false;
+    }
+    sentry_crash_module_identity_t key;
+    memset(&key, 0, sizeof(key));
+    key_from_stat(&key, &st);
+
+    sentry__mutex_lock(&g_cache_lock);
+    module_cache_entry_t *entry = find_entry(&key);
+    if (entry) {
+        entry->used = true;
+        *identity = entry->identity;
+    }
+    sentry__mutex_unlock(&g_cache_lock);
+    if (entry) {
+        return true;
+    }
+
+    if (!parse_identity(path, identity)) {
+        return false;
+    }
+    sentry__mutex_lock(&g_cache_lock);
+    // another thread may have parsed the same file meanwhile
+    entry = find_entry(identity);
+    if (!entry) {
+        entry = add_entry();
+        if (entry) {
+            entry->identity = *identity;
+            *added = true;
+        }
+    }
+    if (entry) {
+        entry->used = true;
+    }
+    sentry__mutex_unlock(&g_cache_lock);
+    return true;
+}
+
+bool
+sentry__crash_module_cache_get(
+    const char *path, sentry_crash_module_identity_t *identity)
+{
+    sentry_crash_module_identity_t found;
+    bool added = false;
+    if (!lookup(path, &found, &added)
+        || !(found.flags & SENTRY_CRASH_MODULE_ELF)) {
+        return false;
+    }
+    *identity = found;
+    return true;
+}
+
+/**
+ * Goes through the files mapped in the maps file `f`, and returns the
+ * signature of the code they map. Other mappings, like the crash context of
+ * each app, are left out so that processes of the same program share it. Each
+ * file is looked up as well if `parsed` is given, which counts the files that
+ * had to be parsed.
+ */
+static uint64_t
+scan_mapped_files(FILE *f, size_t *parsed)
+{
+    // FNV-1a of the device, inode and path of the executable mappings
+    uint64_t signature = 0xcbf29ce484222325ULL;
+    char line[SENTRY_CRASH_MAX_PATH + 128];
+    char prev_path[SENTRY_CRASH_MAX_PATH] = { 0 };
+    while (fgets(line, sizeof(line), f)) {
+        // "start-end perms offset dev inode pathname"
+        char perms[5] = { 0 };
+        int file_offset = 0;
+        int pathname_offset = 0;
+        sscanf(line, "%*s %4s %*s %n%*s %*s %n", perms, &file_offset,
+            &pathname_offset);
+        if (pathname_offset <= 0 || line[pathname_offset] != '/') {
+            continue;
+        }
+        char *path = line + pathname_offset;
+        path[strcspn(path, "\n")] = '\0';
+
+        if (perms[2] == 'x') {
+            for (const char *c = line + file_offset; *c; c++) {
+                signature = (signature ^ (uint8_t)*c) * 0x100000001b3ULL;
+            }
+        }
+
+        // consecutive mappings usually belong to the same file
+        if (strcmp(path, prev_path) == 0) {
+            continue;
+        }
+        snprintf(prev_path, sizeof(prev_path), "%s", path);
+
+        if (parsed) {
+            sentry_crash_module_identity_t identity;
+            bool added = false;
+            lookup(path, &identity, &added);
+            *parsed += added ? 1 : 0;
+        }
+    }
+    return signature;
+}
+
+/**
+ * Remembers that the mapping set with `signature` is warmed. Returns false if
+ * it was already.
+ */
+static bool
+mark_warmed(uint64_t signature)
+{
+    sentry__mutex_lock(&g_cache_lock);
+    size_t count = MIN(g_cache.warmed_count, MODULE_CACHE_WARMED_SETS);
+    bool warmed = false;
+    for (size_t i = 0; i < count && !warmed; i++) {
+        warmed = g_cache.warmed[i] == signature;
+    }
+    if (!warmed) {
+        g_cache.warmed[g_cache.warmed_count++ % MODULE_CACHE_WARMED_SETS]
+            = signature;
+    }
+    sentry__mutex_unlock(&g_cache_lock);
+    return !warmed;
+}
+
+size_t
+sentry__crash_module_cache_warm(pid_t pid)
+{
+    char maps_path[64];
+    snprintf(maps_path, sizeof(maps_path), "/proc/%d/maps", (int)pid);
+    FILE *f = fopen(maps_path, "r");
+    if (!f) {
+        return 0;
+    }
+
+    size_t parsed = 0;
+    if (mark_warmed(scan_mapped_files(f, NULL))) {
+        rewind(f);
+        scan_mapped_files(f, &parsed);
+    }
+    fclose(f);
+    return parsed;
+}
+
+static bool
+load_locked(const char *path)
+{
+    sentry__crash_module_cache_clear();
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    module_cache_header_t header;
+    bool ok = read(fd, &header, sizeof(header)) == sizeof(header)
+        && header.magic == MODULE_CACHE_MAGIC
+        && header.version == MODULE_CACHE_VERSION
+        && header.entry_size == sizeof(sentry_crash_module_identity_t)
+        && header.count <= MODULE_CACHE_MAX_ENTRIES;
+
+    sentry_crash_module_identity_t *identities = NULL;
+    if (ok && header.count > 0) {
+        identities = read_at(fd, sizeof(header),
+            sizeof(sentry_crash_module_identity_t) * header.count);
+        ok = identities != NULL;
+    }
+    close(fd);
+
+    for (size_t i = 0; ok && i < header.count; i++) {
+        module_cache_entry_t *entry = add_entry();
+        if (!entry) {
+            ok = false;
+            break;
+        }
+        entry->identity = identities[i];
+        entry->identity.soname[SENTRY_CRASH_MODULE_SONAME_SIZE - 1] = '\0';
+        entry->identity.build_id_len = MIN(
+            entry->identity.build_id_len, SENTRY_CRASH_MODULE_BUILD_ID_SIZE);
+    }
+    sentry_free(identities);
+
+    if (!ok) {
+        SENTRY_DEBUGF("discarding module cache %s", path);
+        sentry__crash_module_cache_clear();
+        return false;
+    }
+    g_cache.dirty = false;
+    SENTRY_DEBUGF("loaded %zu module identities", g_cache.count);
+    return true;
+}
+
+bool
+sentry__crash_module_cache_load(const char *path)
+{
+    sentry__mutex_lock(&g_cache_lock);
+    bool loaded = load_locked(path);
+    sentry__mutex_unlock(&g_cache_lock);
+    return loaded;
+}
+
+static bool
+save_locked(const char *path)
+{
+    if (!g_cache.dirty) {
+        return true;
+    }
+
+    size_t count = 0;
+    sentry_crash_module_identity_t *identities = sentry_malloc(
+        sizeof(sentry_crash_module_identity_t) * (g_cache.count + 1));
+    if (!identities) {
+        return false;
+    }
+    for (size_t i = 0; i < g_cache.count && count < MODULE_CACHE_MAX_ENTRIES;
+        i++) {
+        if (g_cache.entries[i].used) {
+            identities[count++] = g_cache.entries[i].identity;
+        }
+    }
+
+    module_cache_header_t header = {
+        .magic = MODULE_CACHE_MAGIC,
+        .version = MODULE_CACHE_VERSION,
+        .entry_size = sizeof(sentry_crash_module_identity_t),
+        .count = (uint32_t)count,
+    };
+    size_t size = sizeof(sentry_crash_module_identity_t) * count;
+
+    // write a temporary file first, so that a concurrent load never sees a
+    // partially written cache
+    char tmp_path[SENTRY_CRASH_MAX_PATH];
+    bool ok = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path)
+        < (int)sizeof(tmp_path);
+    int fd = ok ? open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600)
+                : -1;
+    ok = fd >= 0;
+    if (ok) {
+        ok = write(fd, &header, sizeof(header)) == sizeof(header)
+            && (size == 0 || write(fd, identities, size) == (ssize_t)size);
+        ok = close(fd) == 0 && ok;
+        ok = ok && rename(tmp_path, path) == 0;
+        if (!ok) {
+            unlink(tmp_path);
+        }
+    }
+    sentry_free(identities);
+
+    if (!ok) {
+        SENTRY_DEBUGF("failed to save module cache %s", path);
+        return false;
+    }
+    g_cache.dirty = false;
+    return true;
+}
+
+bool
+sentry__crash_module_cache_save(const char *path)
+{
+    sentry__mutex_lock(&g_cache_lock);
+    bool saved = save_locked(path);
+    sentry__mutex_unlock(&g_cache_lock);
+    return saved;
+}
+
+void
+sentry__crash_module_cache_clear(void)
+{
+    sentry__mutex_lock(&g_cache_lock);
+    sentry_free(g_cache.entries);
+    memset(&g_cache, 0, sizeof(g_cache));
+    sentry__mutex_unlock(&g_cache_lock);
+}
+
+#endif
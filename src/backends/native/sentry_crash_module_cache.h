@@ -0,0 +1,80 @@
+#ifndef SENTRY_CRASH_MODULE_CACHE_H_INCLUDED
+#define SENTRY_CRASH_MODULE_CACHE_H_INCLUDED
+
+#include "sentry_boot.h"
+
+#if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+
+#    include <sys/types.h>
+
+/**
+ * The module cache keeps the identity of every ELF file mapped into the app,
+ * keyed by the device, inode and modification time of the file. The daemon
+ * fills it while it waits for a crash, and persists it in the database
+ * directory for the next run, so that resolving the modules of a crash only
+ * needs a `stat` per module instead of parsing every ELF file again.
+ *
+ * The cache belongs to the daemon process. It is guarded by a lock, since a
+ * shared daemon resolves the modules of several crashes concurrently. Files
+ * are parsed without holding it.
+ */
+
+#    define SENTRY_CRASH_MODULE_BUILD_ID_SIZE 32
+#    define SENTRY_CRASH_MODULE_SONAME_SIZE 256
+
+/**
+ * The file is an ELF file. Entries without this flag are cached negative
+ * results for other mapped files, like fonts or locale archives.
+ */
+#    define SENTRY_CRASH_MODULE_ELF 0x1
+
+typedef struct {
+    uint64_t dev;
+    uint64_t ino;
+    int64_t mtime_sec;
+    int64_t mtime_nsec;
+    uint32_t flags;
+    uint32_t build_id_len;
+    uint8_t build_id[SENTRY_CRASH_MODULE_BUILD_ID_SIZE];
+    // size from the PT_LOAD segments, 0 if unknown
+    uint64_t elf_size;
+    // DT_SONAME, empty if the module has none
+    char soname[SENTRY_CRASH_MODULE_SONAME_SIZE];
+} sentry_crash_module_identity_t;
+
+/**
+ * Looks up the identity of the ELF file at `path`, which is only parsed if it
+ * is not cached yet, or changed since it was. Returns false if the file cannot
+ * be read or is not an ELF file.
+ */
+bool sentry__crash_module_cache_get(
+    const char *path, sentry_crash_module_identity_t *identity);
+
+/**
+ * Adds every file that is mapped into the process `pid` to the cache, unless
+ * the same code was mapped when the cache was warmed before, like for another
+ * process of the same program. Returns the number of files that had to be
+ * parsed.
+ */
+size_t sentry__crash_module_cache_warm(pid_t pid);
+
+/**
+ * Loads the cache persisted at `path`, replacing the current entries.
+ */
+bool sentry__crash_module_cache_load(const char *path);
+
+/**
+ * Persists the entries that were used since the cache was loaded to `path`.
+ * Entries of files that are no longer mapped are dropped that way.
+ * Does nothing if no entry was added since the last save.
+ */
+bool sentry__crash_module_cache_save(const char *path);
+
+/**
+ * Removes all entries and frees the cache.
+ */
+void sentry__crash_module_cache_clear(void);
+
+#endif
+
+#endif
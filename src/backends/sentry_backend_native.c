@@ -22,6 +22,7 @@
 #include "sentry_crash_daemon.h"
 #include "sentry_crash_handler.h"
 #include "sentry_crash_ipc.h"
+#include "sentry_crash_journal.h"
 #include "sentry_database.h"
 #include "sentry_envelope.h"
 #include "sentry_json.h"
@@ -33,6 +34,7 @@
 
 #include "sentry_scope.h"
 #include "sentry_session.h"
+#include "sentry_string.h"
 #include "sentry_sync.h"
 #include "sentry_transport.h"
 #include "transports/sentry_disk_transport.h"
@@ -68,11 +70,16 @@ static sentry_mutex_t g_ipc_init_mutex = SENTRY__MUTEX_INIT;
 typedef struct {
     sentry_crash_ipc_t *ipc;
     pid_t daemon_pid;
+    // The daemon is shared with other processes, which keeps it running
+    bool shared_daemon;
     sentry_path_t *event_path;
-    sentry_path_t *breadcrumb1_path;
-    sentry_path_t *breadcrumb2_path;
     sentry_path_t *envelope_path;
-    size_t num_breadcrumbs;
+    // Serializes updates of the crash journal in shared memory
+    sentry_mutex_t journal_lock;
+    // Scope that didn't fit into the journal was written to `event_path`
+    bool scope_in_event_file;
+    // Last attachment list written to `__sentry-attachments`
+    char *attachments_json;
     volatile long crashed;
 } native_backend_state_t;
 
@@ -134,6 +141,8 @@ native_backend_startup(
     if (!state) {
         return 1;
     }
+    memset(state, 0, sizeof(*state));
+    sentry__mutex_init(&state->journal_lock);
     backend->data = state;
 
     // Initialize IPC (protected by global synchronization for concurrent
@@ -199,7 +208,10 @@ native_backend_startup(
     sentry__atomic_store(
         &ctx->user_consent, sentry__atomic_fetch(&options->run->user_consent));
 
-    // Set up event and breadcrumb paths
+    // Scope and breadcrumbs are journaled in place in shared memory
+    sentry__crash_journal_init(&ctx->journal, options->max_breadcrumbs);
+
+    // Set up event path
     sentry_path_t *run_path = options->run->run_path;
     sentry_path_t *db_path = options->database_path;
 
@@ -256,34 +268,19 @@ native_backend_startup(
 #endif
     }
 
+    // The crash handler writes the final event here, which takes precedence
+    // over the journaled scope
     state->event_path = sentry__path_join_str(run_path, "__sentry-event");
-    state->breadcrumb1_path
-        = sentry__path_join_str(run_path, "__sentry-breadcrumb1");
-    state->breadcrumb2_path
-        = sentry__path_join_str(run_path, "__sentry-breadcrumb2");
-
     sentry__path_touch(state->event_path);
-    sentry__path_touch(state->breadcrumb1_path);
-    sentry__path_touch(state->breadcrumb2_path);
 
     // Copy paths to crash context
 #ifdef _WIN32
     strncpy_s(ctx->event_path, sizeof(ctx->event_path), state->event_path->path,
         _TRUNCATE);
-    strncpy_s(ctx->breadcrumb1_path, sizeof(ctx->breadcrumb1_path),
-        state->breadcrumb1_path->path, _TRUNCATE);
-    strncpy_s(ctx->breadcrumb2_path, sizeof(ctx->breadcrumb2_path),
-        state->breadcrumb2_path->path, _TRUNCATE);
 #else
     strncpy(
         ctx->event_path, state->event_path->path, sizeof(ctx->event_path) - 1);
     ctx->event_path[sizeof(ctx->event_path) - 1] = '\0';
-    strncpy(ctx->breadcrumb1_path, state->breadcrumb1_path->path,
-        sizeof(ctx->breadcrumb1_path) - 1);
-    ctx->breadcrumb1_path[sizeof(ctx->breadcrumb1_path) - 1] = '\0';
-    strncpy(ctx->breadcrumb2_path, state->breadcrumb2_path->path,
-        sizeof(ctx->breadcrumb2_path) - 1);
-    ctx->breadcrumb2_path[sizeof(ctx->breadcrumb2_path) - 1] = '\0';
 #endif
 
     // Set up crash envelope path
@@ -346,8 +343,21 @@ native_backend_startup(
         = options->handler_path ? options->handler_path->path : NULL;
 #    if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
     uint64_t tid = (uint64_t)pthread_self();
-    state->daemon_pid = sentry__crash_daemon_start(getpid(), tid,
-        state->ipc->notify_fd, state->ipc->ready_fd, daemon_handler_path);
+    if (options->crash_daemon_shared) {
+        char daemon_name[SENTRY_CRASH_IPC_NAME_SIZE];
+        sentry__crash_ipc_shared_name(daemon_name, sizeof(daemon_name), ctx);
+        state->daemon_pid = sentry__crash_daemon_register(
+            state->ipc, daemon_name, tid, daemon_handler_path);
+        state->shared_daemon = state->daemon_pid > 0;
+        if (!state->shared_daemon) {
+            SENTRY_WARN("failed to register with shared crash daemon, "
+                        "starting a dedicated one");
+        }
+    }
+    if (!state->shared_daemon) {
+        state->daemon_pid = sentry__crash_daemon_start(getpid(), tid,
+            state->ipc->notify_fd, state->ipc->ready_fd, daemon_handler_path);
+    }
 #    elif defined(SENTRY_PLATFORM_MACOS)
     uint64_t tid = (uint64_t)pthread_self();
     state->daemon_pid
@@ -404,9 +414,12 @@ native_backend_startup(
     }
 #    endif
 
-    // Wait for daemon to signal it's ready
-    if (!sentry__crash_ipc_wait_for_ready(
-            state->ipc, SENTRY_CRASH_DAEMON_READY_TIMEOUT_MS)) {
+    // Wait for daemon to signal it's ready (a shared daemon is ready once it
+    // accepted the registration)
+    if (state->shared_daemon) {
+        SENTRY_DEBUG("Registered with shared daemon");
+    } else if (!sentry__crash_ipc_wait_for_ready(
+                   state->ipc, SENTRY_CRASH_DAEMON_READY_TIMEOUT_MS)) {
         SENTRY_WARN("Daemon did not signal ready in time, proceeding anyway");
     } else {
         SENTRY_DEBUG("Daemon signaled ready");
@@ -415,7 +428,9 @@ native_backend_startup(
     if (sentry__crash_handler_init(state->ipc) < 0) {
         SENTRY_WARN("failed to initialize crash handler");
 #    if defined(SENTRY_PLATFORM_UNIX)
-        kill(state->daemon_pid, SIGTERM);
+        if (!state->shared_daemon) {
+            kill(state->daemon_pid, SIGTERM);
+        }
 #    elif defined(SENTRY_PLATFORM_WINDOWS)
         // On Windows, terminate the daemon process
         HANDLE hDaemon
@@ -451,8 +466,9 @@ native_backend_shutdown(sentry_backend_t *backend)
     sentry__crash_handler_shutdown();
 
 #if defined(SENTRY_PLATFORM_UNIX) && !defined(SENTRY_PLATFORM_IOS)
-    // Terminate daemon (Unix)
-    if (state->daemon_pid > 0) {
+    // Terminate daemon (Unix), a shared daemon drops the app once the IPC is
+    // closed below
+    if (state->daemon_pid > 0 && !state->shared_daemon) {
         kill(state->daemon_pid, SIGTERM);
         // Wait for daemon to exit
         waitpid(state->daemon_pid, NULL, 0);
@@ -579,9 +595,9 @@ native_backend_free(sentry_backend_t *backend)
     }
 
     sentry__path_free(state->event_path);
-    sentry__path_free(state->breadcrumb1_path);
-    sentry__path_free(state->breadcrumb2_path);
     sentry__path_free(state->envelope_path);
+    sentry_free(state->attachments_json);
+    sentry__mutex_free(&state->journal_lock);
 
     sentry_free(state);
 }
@@ -589,8 +605,9 @@ native_backend_free(sentry_backend_t *backend)
 // Writes the scope's attachment list to <run>/__sentry-attachments so the
 // crash daemon can locate and append them to the crash envelope.
 static void
-native_backend_write_attachments(const sentry_path_t *event_path)
+native_backend_write_attachments(native_backend_state_t *state)
 {
+    const sentry_path_t *event_path = state->event_path;
     if (!event_path) {
         return;
     }
@@ -626,11 +643,22 @@ native_backend_write_attachments(const sentry_path_t *event_path)
             }
             char *attach_json = sentry_value_to_json(attach_list);
             sentry_value_decref(attach_list);
-            if (attach_json) {
-                sentry__path_write_buffer(
-                    attach_list_path, attach_json, strlen(attach_json));
-                sentry_free(attach_json);
+            // most scope changes leave the attachments alone
+            sentry__mutex_lock(&state->journal_lock);
+            if (attach_json
+                && (!state->attachments_json
+                    || !sentry__string_eq(
+                        attach_json, state->attachments_json))) {
+                if (sentry__path_write_buffer(attach_list_path, attach_json,
+                        strlen(attach_json))
+                    == 0) {
+                    sentry_free(state->attachments_json);
+                    state->attachments_json = attach_json;
+                    attach_json = NULL;
+                }
             }
+            sentry__mutex_unlock(&state->journal_lock);
+            sentry_free(attach_json);
             sentry__path_free(attach_list_path);
         }
         sentry__path_free(run_path);
@@ -648,7 +676,7 @@ native_backend_flush_scope(
 
     // Manifest writes must continue post-crash so attachments registered
     // from on_crash/before_send reach the daemon
-    native_backend_write_attachments(state->event_path);
+    native_backend_write_attachments(state);
 
     if (sentry__atomic_fetch(&state->crashed)) {
         return;
@@ -712,15 +740,31 @@ native_backend_flush_scope(
         }
     }
 
-    // Serialize to JSON (so it can be deserialized on next start)
+    // Serialize to JSON, which the daemon reads from the journal at crash time
     char *json_str = sentry_value_to_json(event);
     sentry_value_decref(event);
-
-    if (json_str) {
-        size_t json_len = strlen(json_str);
-        sentry__path_write_buffer(state->event_path, json_str, json_len);
+    if (!json_str || !state->ipc || !state->ipc->shmem) {
         sentry_free(json_str);
+        return;
     }
+
+    size_t json_len = strlen(json_str);
+    sentry__mutex_lock(&state->journal_lock);
+    if (sentry__crash_journal_write_scope(
+            &state->ipc->shmem->journal, json_str, json_len)) {
+        if (state->scope_in_event_file) {
+            sentry__path_write_buffer(state->event_path, "", 0);
+            state->scope_in_event_file = false;
+        }
+    } else {
+        // the event file takes precedence over the journal for the daemon
+        SENTRY_DEBUG("scope is too large for the crash journal");
+        state->scope_in_event_file
+            = sentry__path_write_buffer(state->event_path, json_str, json_len)
+            == 0;
+    }
+    sentry__mutex_unlock(&state->journal_lock);
+    sentry_free(json_str);
 }
 
 static void
@@ -728,43 +772,25 @@ native_backend_add_breadcrumb(sentry_backend_t *backend,
     sentry_value_t breadcrumb, const sentry_options_t *options)
 {
     native_backend_state_t *state = (native_backend_state_t *)backend->data;
-    if (!state) {
-        return;
-    }
-
-    size_t max_breadcrumbs = options->max_breadcrumbs;
-    if (!max_breadcrumbs) {
-        return;
-    }
-
-    bool first_breadcrumb = state->num_breadcrumbs % max_breadcrumbs == 0;
-
-    const sentry_path_t *breadcrumb_file
-        = state->num_breadcrumbs % (max_breadcrumbs * 2) < max_breadcrumbs
-        ? state->breadcrumb1_path
-        : state->breadcrumb2_path;
-
-    state->num_breadcrumbs++;
-
-    if (!breadcrumb_file) {
+    if (!state || !state->ipc || !state->ipc->shmem
+        || !options->max_breadcrumbs) {
         return;
     }
 
-    // Serialize to JSON (so it can be deserialized on next start)
+    // Serialize to JSON, which the daemon reads from the journal at crash time
     char *json_str = sentry_value_to_json(breadcrumb);
     if (!json_str) {
         return;
     }
 
-    size_t json_len = strlen(json_str);
-    int rv = first_breadcrumb
-        ? sentry__path_write_buffer(breadcrumb_file, json_str, json_len)
-        : sentry__path_append_buffer(breadcrumb_file, json_str, json_len);
-
+    sentry__mutex_lock(&state->journal_lock);
+    bool added = sentry__crash_journal_add_breadcrumb(
+        &state->ipc->shmem->journal, json_str, strlen(json_str));
+    sentry__mutex_unlock(&state->journal_lock);
     sentry_free(json_str);
 
-    if (rv != 0) {
-        SENTRY_WARN("failed to write breadcrumb");
+    if (!added) {
+        SENTRY_WARN("breadcrumb is too large for the crash journal");
     }
 }
 
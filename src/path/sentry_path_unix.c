@@ -2,6 +2,7 @@
 #include "sentry_core.h"
 #include "sentry_path.h"
 #include "sentry_string.h"
+#include "sentry_sync.h"
 #include "sentry_utils.h"
 
 #ifdef SENTRY_PLATFORM_PS
@@ -20,6 +21,10 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#if !defined(SENTRY_PLATFORM_NX) && !defined(SENTRY_PLATFORM_PS)
+#    include <sys/mman.h>
+#endif
+
 #ifdef SENTRY_PLATFORM_DARWIN
 #    include <copyfile.h>
 #    include <mach-o/dyld.h>
@@ -97,6 +102,46 @@ sentry__filelock_try_lock(sentry_filelock_t *lock)
     return true;
 }
 
+bool
+sentry__filelock_lock(sentry_filelock_t *lock)
+{
+#ifdef SENTRY_PLATFORM_NX
+    // Nothing to do, see sentry__filelock_try_lock.
+    return true;
+#endif
+    lock->is_locked = false;
+
+    while (true) {
+        int fd = open(lock->path->path, O_RDWR | O_CREAT,
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH | S_IWOTH);
+        if (fd < 0) {
+            return false;
+        }
+
+        int rv;
+        do {
+            rv = flock(fd, LOCK_EX);
+        } while (rv != 0 && errno == EINTR);
+        if (rv != 0) {
+            close(fd);
+            return false;
+        }
+
+        // The previous owner removes the file before unlocking it, so the
+        // lock might be held on a file that is not on disk anymore, see
+        // `sentry__filelock_try_lock`. Start over with the current file then.
+        struct stat st0;
+        struct stat st1;
+        if (fstat(fd, &st0) == 0 && stat(lock->path->path, &st1) == 0
+            && st0.st_ino == st1.st_ino) {
+            lock->fd = fd;
+            lock->is_locked = true;
+            return true;
+        }
+        close(fd);
+    }
+}
+
 void
 sentry__filelock_unlock(sentry_filelock_t *lock)
 {
@@ -649,3 +694,79 @@ sentry__filewriter_byte_count(const sentry_filewriter_t *filewriter)
 {
     return filewriter->byte_count;
 }
+
+struct sentry_filemap_s {
+    const char *data;
+    size_t len;
+    long refcount;
+};
+
+sentry_filemap_t *
+sentry__filemap_new(const sentry_path_t *path)
+{
+#if defined(SENTRY_PLATFORM_NX) || defined(SENTRY_PLATFORM_PS)
+    (void)path;
+    return NULL;
+#else
+    int fd = open(path->path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0
+        || (uint64_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        return NULL;
+    }
+    size_t len = (size_t)st.st_size;
+    void *data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+
+    sentry_filemap_t *map = SENTRY_MAKE(sentry_filemap_t);
+    if (!map) {
+        munmap(data, len);
+        return NULL;
+    }
+    map->data = data;
+    map->len = len;
+    map->refcount = 1;
+    return map;
+#endif
+}
+
+const char *
+sentry__filemap_data(const sentry_filemap_t *map)
+{
+    return map->data;
+}
+
+size_t
+sentry__filemap_len(const sentry_filemap_t *map)
+{
+    return map->len;
+}
+
+sentry_filemap_t *
+sentry__filemap_incref(sentry_filemap_t *map)
+{
+    if (map) {
+        sentry__atomic_fetch_and_add(&map->refcount, 1);
+    }
+    return map;
+}
+
+void
+sentry__filemap_decref(sentry_filemap_t *map)
+{
+    if (!map || sentry__atomic_fetch_and_add(&map->refcount, -1) != 1) {
+        return;
+    }
+#if !defined(SENTRY_PLATFORM_NX) && !defined(SENTRY_PLATFORM_PS)
+    munmap((void *)map->data, map->len);
+#endif
+    sentry_free(map);
+}
@@ -73,6 +73,28 @@ sentry__filelock_try_lock(sentry_filelock_t *lock)
     return true;
 }
 
+bool
+sentry__filelock_lock(sentry_filelock_t *lock)
+{
+    lock->is_locked = false;
+
+    int fd = _wopen(
+        lock->path->path_w, _O_RDWR | _O_CREAT, _S_IREAD | _S_IWRITE);
+    if (fd < 0) {
+        return false;
+    }
+
+    // `_LK_LOCK` retries once per second, for up to 10 seconds
+    if (_locking(fd, _LK_LOCK, 1) != 0) {
+        _close(fd);
+        return false;
+    }
+
+    lock->fd = fd;
+    lock->is_locked = true;
+    return true;
+}
+
 void
 sentry__filelock_unlock(sentry_filelock_t *lock)
 {
@@ -814,3 +836,43 @@ sentry__filewriter_byte_count(const sentry_filewriter_t *filewriter)
 {
     return filewriter->byte_count;
 }
+
+// Files are never mapped on Windows: while a view is mapped, the file can
+// neither be truncated nor reliably renamed or deleted, which the database and
+// the retry logic do with envelopes that are still in flight. Callers fall back
+// to `sentry__path_read_to_buffer`.
+struct sentry_filemap_s {
+    const char *data;
+    size_t len;
+};
+
+sentry_filemap_t *
+sentry__filemap_new(const sentry_path_t *path)
+{
+    (void)path;
+    return NULL;
+}
+
+const char *
+sentry__filemap_data(const sentry_filemap_t *map)
+{
+    return map->data;
+}
+
+size_t
+sentry__filemap_len(const sentry_filemap_t *map)
+{
+    return map->len;
+}
+
+sentry_filemap_t *
+sentry__filemap_incref(sentry_filemap_t *map)
+{
+    return map;
+}
+
+void
+sentry__filemap_decref(sentry_filemap_t *map)
+{
+    (void)map;
+}
@@ -4,10 +4,7 @@
 #include "sentry_options.h"
 #include "sentry_utils.h"
 
-// The batcher thread sleeps for this interval between flush cycles.
-// When the timer fires and there are items in the buffer, they are flushed
-// regardless of how recently they were enqueued.
-#define SENTRY_BATCHER_FLUSH_INTERVAL_MS 5000
+#include <limits.h>
 
 #ifdef SENTRY_UNITTEST
 #    ifdef SENTRY_PLATFORM_WINDOWS
@@ -20,13 +17,41 @@
 #endif
 
 sentry_batcher_t *
-sentry__batcher_new(
-    sentry_batch_func_t batch_func, sentry_data_category_t data_category)
+sentry__batcher_new(sentry_batch_func_t batch_func,
+    sentry_data_category_t data_category, size_t capacity)
 {
+    if (!capacity) {
+        capacity = SENTRY_BATCHER_QUEUE_LENGTH;
+    }
+    if (capacity > LONG_MAX / (2 * SENTRY_BATCHER_SHARD_COUNT + 1)) {
+        return NULL;
+    }
     sentry_batcher_t *batcher = SENTRY_MAKE(sentry_batcher_t);
     if (!batcher) {
         return NULL;
     }
+
+    // all shard buffers share one allocation
+    const size_t slots = 2 * SENTRY_BATCHER_SHARD_COUNT * capacity;
+    sentry_batcher_item_t *items
+        = sentry_malloc(slots * sizeof(sentry_batcher_item_t));
+    batcher->scratch = sentry_malloc(capacity * sizeof(sentry_value_t));
+    if (!items || !batcher->scratch) {
+        sentry_free(items);
+        sentry_free(batcher->scratch);
+        sentry_free(batcher);
+        return NULL;
+    }
+    for (size_t i = 0; i < SENTRY_BATCHER_SHARD_COUNT; i++) {
+        batcher->shards[i].buffers[0].items = items;
+        items += capacity;
+        batcher->shards[i].buffers[1].items = items;
+        items += capacity;
+    }
+    batcher->capacity = capacity;
+    batcher->batch_size = (long)capacity;
+    batcher->max_bytes = SENTRY_BATCHER_MAX_BYTES;
+    batcher->flush_interval_ms = SENTRY_BATCHER_FLUSH_INTERVAL_MS;
     batcher->refcount = 1;
     batcher->batch_func = batch_func;
     batcher->data_category = data_category;
@@ -41,11 +66,15 @@ sentry__batcher_new(
  * flush (e.g. by a producer that acquired a ref before shutdown).
  */
 static void
-buffer_drain(sentry_batcher_buffer_t *buf)
+buffer_drain(sentry_batcher_t *batcher, sentry_batcher_buffer_t *buf)
 {
-    const long n = MIN(buf->index, SENTRY_BATCHER_QUEUE_LENGTH);
+    const long n = MIN(buf->index, (long)batcher->capacity);
     for (long i = 0; i < n; i++) {
-        sentry_value_decref(buf->items[i]);
+        if (buf->items[i].record) {
+            batcher->free_record_func(buf->items[i].record);
+        } else {
+            sentry_value_decref(buf->items[i].value);
+        }
     }
     buf->index = 0;
 }
@@ -56,8 +85,13 @@ sentry__batcher_release(sentry_batcher_t *batcher)
     if (!batcher || sentry__atomic_fetch_and_add(&batcher->refcount, -1) != 1) {
         return;
     }
-    buffer_drain(&batcher->buffers[0]);
-    buffer_drain(&batcher->buffers[1]);
+    for (size_t i = 0; i < SENTRY_BATCHER_SHARD_COUNT; i++) {
+        buffer_drain(batcher, &batcher->shards[i].buffers[0]);
+        buffer_drain(batcher, &batcher->shards[i].buffers[1]);
+    }
+    // the first shard buffer owns the allocation of all item slots
+    sentry_free(batcher->shards[0].buffers[0].items);
+    sentry_free(batcher->scratch);
     sentry__dsn_decref(batcher->dsn);
     sentry__thread_free(&batcher->batching_thread);
     sentry_free(batcher);
@@ -127,10 +161,10 @@ crash_safe_sleep_ms(uint64_t delay_ms)
     }
 }
 
-// checks whether the currently active buffer should be flushed.
+// checks whether any of the currently active shard buffers should be flushed.
 // otherwise we could miss the trigger of adding the last log if we're actively
-// flushing the other buffer already.
-// we can safely check the state of the active buffer, as the only thread that
+// flushing the other buffers already.
+// we can safely check the state of the active buffers, as the only thread that
 // can change which buffer is active is the one calling this check function
 // inside sentry__batcher_flush() below
 static bool
@@ -138,12 +172,82 @@ check_for_flush_condition(sentry_batcher_t *batcher)
 {
     // In sentry__batcher_flush, after finishing a flush:
     long current_active = sentry__atomic_fetch(&batcher->active_idx);
-    sentry_batcher_buffer_t *current_buf = &batcher->buffers[current_active];
+    const long batch_size = sentry__atomic_fetch(&batcher->batch_size);
+    for (size_t i = 0; i < SENTRY_BATCHER_SHARD_COUNT; i++) {
+        sentry_batcher_buffer_t *current_buf
+            = &batcher->shards[i].buffers[current_active];
+        if (sentry__atomic_fetch(&current_buf->index) >= batch_size) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns the number of items in the active buffers of all shards.
+ */
+static long
+count_active_items(sentry_batcher_t *batcher)
+{
+    const long active_idx = sentry__atomic_fetch(&batcher->active_idx);
+    long count = 0;
+    for (size_t i = 0; i < SENTRY_BATCHER_SHARD_COUNT; i++) {
+        count += MIN(
+            sentry__atomic_fetch(&batcher->shards[i].buffers[active_idx].index),
+            (long)batcher->capacity);
+    }
+    return count;
+}
+
+/**
+ * Sends a batch of items. If the serialized batch exceeds `max_bytes`, it is
+ * split in half until it either fits or consists of a single item. Takes
+ * ownership of the items.
+ */
+static void
+send_batch(sentry_batcher_t *batcher, sentry_value_t *items, long n,
+    bool crash_safe)
+{
+    sentry_value_t logs = sentry_value_new_object();
+    sentry_value_t log_items = sentry_value_new_list();
+    for (long i = 0; i < n; i++) {
+        // keep our own reference in case we need to split the batch
+        sentry_value_incref(items[i]);
+        sentry_value_append(log_items, items[i]);
+    }
+    sentry_value_set_by_key(logs, "items", log_items);
+
+    sentry_envelope_t *envelope = sentry__envelope_new_with_dsn(batcher->dsn);
+    sentry_envelope_item_t *item = batcher->batch_func(envelope, logs);
 
-    // Check if current active buffer is also full
-    // We could even lower the threshold for high-contention scenarios
-    return sentry__atomic_fetch(&current_buf->index)
-        >= SENTRY_BATCHER_QUEUE_LENGTH;
+    size_t payload_len = 0;
+    if (item) {
+        sentry__envelope_item_get_payload(item, &payload_len);
+    }
+    if (batcher->max_bytes && payload_len > batcher->max_bytes && n > 1) {
+        sentry_envelope_free(envelope);
+        sentry_value_decref(logs);
+        const long half = n / 2;
+        send_batch(batcher, items, half, crash_safe);
+        send_batch(batcher, items + half, n - half, crash_safe);
+        return;
+    }
+    for (long i = 0; i < n; i++) {
+        sentry_value_decref(items[i]);
+    }
+
+    if (crash_safe) {
+        // Write directly to disk to avoid transport queuing during
+        // crash
+        sentry__run_write_envelope(batcher->run, envelope);
+        sentry_envelope_free(envelope);
+    } else if (!sentry__run_should_skip_upload(batcher->run)) {
+        // Normal operation: use transport for HTTP transmission
+        sentry__transport_send_envelope(batcher->transport, envelope);
+    } else {
+        sentry_envelope_free(envelope);
+    }
+    sentry_value_decref(logs);
 }
 
 bool
@@ -177,61 +281,79 @@ sentry__batcher_flush(sentry_batcher_t *batcher, bool crash_safe)
         }
     }
     do {
-        // prep both buffers
+        // prep both buffers of every shard
         long old_buf_idx = sentry__atomic_fetch(&batcher->active_idx);
         long new_buf_idx = 1 - old_buf_idx;
-        sentry_batcher_buffer_t *old_buf = &batcher->buffers[old_buf_idx];
-        sentry_batcher_buffer_t *new_buf = &batcher->buffers[new_buf_idx];
 
-        // reset new buffer...
-        sentry__atomic_store(&new_buf->index, 0);
-        sentry__atomic_store(&new_buf->adding, 0);
-        sentry__atomic_store(&new_buf->sealed, 0);
+        // reset new buffers...
+        for (size_t i = 0; i < SENTRY_BATCHER_SHARD_COUNT; i++) {
+            sentry_batcher_buffer_t *new_buf
+                = &batcher->shards[i].buffers[new_buf_idx];
+            sentry__atomic_store(&new_buf->index, 0);
+            sentry__atomic_store(&new_buf->adding, 0);
+            sentry__atomic_store(&new_buf->sealed, 0);
+        }
 
-        // ...and make it active (after this we're good to go producer side)
+        // ...and make them active (after this we're good to go producer side)
         sentry__atomic_store(&batcher->active_idx, new_buf_idx);
 
-        // seal old buffer
-        sentry__atomic_store(&old_buf->sealed, 1);
-
-        // Wait for all in-flight producers of the old buffer
-        while (sentry__atomic_fetch(&old_buf->adding) > 0) {
-            sentry__cpu_relax();
+        // seal old buffers
+        for (size_t i = 0; i < SENTRY_BATCHER_SHARD_COUNT; i++) {
+            sentry__atomic_store(
+                &batcher->shards[i].buffers[old_buf_idx].sealed, 1);
         }
 
-        long n = sentry__atomic_store(&old_buf->index, 0);
-        if (n > SENTRY_BATCHER_QUEUE_LENGTH) {
-            n = SENTRY_BATCHER_QUEUE_LENGTH;
-        }
-
-        if (n > 0) {
-            // now we can do the actual batching of the old buffer
+        // Drain all shards in one pass, packing the items into batches of at
+        // most `batch_size` items.
+        const long capacity = (long)batcher->capacity;
+        const long batch_size = sentry__atomic_fetch(&batcher->batch_size);
+        sentry_value_t *batch = batcher->scratch;
+        long batch_len = 0;
+        sentry_value_arena_t *arena = NULL;
+        for (size_t i = 0; i < SENTRY_BATCHER_SHARD_COUNT; i++) {
+            sentry_batcher_buffer_t *old_buf
+                = &batcher->shards[i].buffers[old_buf_idx];
+
+            // Wait for all in-flight producers of the old buffer
+            while (sentry__atomic_fetch(&old_buf->adding) > 0) {
+                sentry__cpu_relax();
+            }
 
-            sentry_value_t logs = sentry_value_new_object();
-            sentry_value_t log_items = sentry_value_new_list();
-            int i;
-            for (i = 0; i < n; i++) {
-                sentry_value_append(log_items, old_buf->items[i]);
+            long n = sentry__atomic_store(&old_buf->index, 0);
+            if (n > capacity) {
+                n = capacity;
             }
-            sentry_value_set_by_key(logs, "items", log_items);
-
-            sentry_envelope_t *envelope
-                = sentry__envelope_new_with_dsn(batcher->dsn);
-            batcher->batch_func(envelope, logs);
-
-            if (crash_safe) {
-                // Write directly to disk to avoid transport queuing during
-                // crash
-                sentry__run_write_envelope(batcher->run, envelope);
-                sentry_envelope_free(envelope);
-            } else if (!sentry__run_should_skip_upload(batcher->run)) {
-                // Normal operation: use transport for HTTP transmission
-                sentry__transport_send_envelope(batcher->transport, envelope);
-            } else {
-                sentry_envelope_free(envelope);
+            for (long j = 0; j < n; j++) {
+                if (!arena && !crash_safe) {
+                    // the values of a batch are created and freed together,
+                    // but arenas are not used from within a signal handler
+                    arena = sentry__value_arena_begin();
+                }
+                const sentry_batcher_item_t *slot = &old_buf->items[j];
+                if (slot->record) {
+                    // deferred records are only turned into items here, off
+                    // the producer threads
+                    sentry_value_t item
+                        = batcher->materialize_func(slot->record);
+                    if (sentry_value_is_null(item)) {
+                        continue;
+                    }
+                    batch[batch_len++] = item;
+                } else {
+                    batch[batch_len++] = slot->value;
+                }
+                if (batch_len == batch_size) {
+                    send_batch(batcher, batch, batch_len, crash_safe);
+                    batch_len = 0;
+                    sentry__value_arena_end(arena);
+                    arena = NULL;
+                }
             }
-            sentry_value_decref(logs);
         }
+        if (batch_len > 0) {
+            send_batch(batcher, batch, batch_len, crash_safe);
+        }
+        sentry__value_arena_end(arena);
     } while (check_for_flush_condition(batcher));
 
     sentry__atomic_store(&batcher->flushing, 0);
@@ -240,73 +362,165 @@ sentry__batcher_flush(sentry_batcher_t *batcher, bool crash_safe)
 
 #define ENQUEUE_MAX_RETRIES 2
 
-bool
-sentry__batcher_enqueue(sentry_batcher_t *batcher, sentry_value_t item)
+/**
+ * Returns a per-thread hint used to select the home shard of a producer.
+ */
+static size_t
+current_shard_hint(void)
 {
-    for (int attempt = 0; attempt <= ENQUEUE_MAX_RETRIES; attempt++) {
-        // retrieve the active buffer
-        const long active_idx = sentry__atomic_fetch(&batcher->active_idx);
-        sentry_batcher_buffer_t *active = &batcher->buffers[active_idx];
+#ifdef SENTRY_PLATFORM_WINDOWS
+    uint64_t id = (uint64_t)GetCurrentThreadId();
+#else
+    uint64_t id = (uint64_t)(uintptr_t)pthread_self();
+#endif
+    // Fibonacci hashing, so that sequential ids and aligned thread control
+    // block addresses spread evenly across the shards.
+    return (size_t)((id * 0x9E3779B97F4A7C15ULL) >> 32);
+}
 
-        // if the buffer is already sealed we retry or drop and exit early.
-        if (sentry__atomic_fetch(&active->sealed) != 0) {
-            if (attempt == ENQUEUE_MAX_RETRIES) {
-                return false;
-            }
-            continue;
-        }
+typedef enum {
+    ENQUEUE_OK,
+    ENQUEUE_FULL,
+    ENQUEUE_RETRY,
+} enqueue_result_t;
 
-        // `adding` is our boundary for this buffer since it keeps the flusher
-        // blocked. We have to recheck that the flusher hasn't already switched
-        // the active buffer or sealed the one this thread is on. If either is
-        // true we have to unblock the flusher and retry or drop the item.
-        sentry__atomic_fetch_and_add(&active->adding, 1);
-        const long active_idx_check
-            = sentry__atomic_fetch(&batcher->active_idx);
-        const long sealed_check = sentry__atomic_fetch(&active->sealed);
-        if (active_idx != active_idx_check) {
-            sentry__atomic_fetch_and_add(&active->adding, -1);
-            if (attempt == ENQUEUE_MAX_RETRIES) {
-                return false;
-            }
-            continue;
-        }
-        if (sealed_check) {
-            sentry__atomic_fetch_and_add(&active->adding, -1);
-            if (attempt == ENQUEUE_MAX_RETRIES) {
-                return false;
-            }
-            continue;
+static enqueue_result_t
+shard_enqueue(sentry_batcher_t *batcher, sentry_batcher_shard_t *shard,
+    long active_idx, sentry_batcher_item_t item)
+{
+    sentry_batcher_buffer_t *active = &shard->buffers[active_idx];
+
+    // if the buffer is already sealed we retry or drop and exit early.
+    if (sentry__atomic_fetch(&active->sealed) != 0) {
+        return ENQUEUE_RETRY;
+    }
+
+    // `adding` is our boundary for this buffer since it keeps the flusher
+    // blocked. We have to recheck that the flusher hasn't already switched
+    // the active buffer or sealed the one this thread is on. If either is
+    // true we have to unblock the flusher and retry or drop the item.
+    sentry__atomic_fetch_and_add(&active->adding, 1);
+    const long active_idx_check = sentry__atomic_fetch(&batcher->active_idx);
+    const long sealed_check = sentry__atomic_fetch(&active->sealed);
+    if (active_idx != active_idx_check || sealed_check) {
+        sentry__atomic_fetch_and_add(&active->adding, -1);
+        return ENQUEUE_RETRY;
+    }
+
+    // Now we can finally request a slot and check if the item fits in this
+    // buffer.
+    const long item_idx = sentry__atomic_fetch_and_add(&active->index, 1);
+    if (item_idx < (long)batcher->capacity) {
+        // got a slot, write item to the buffer and unblock flusher
+        active->items[item_idx] = item;
+        sentry__atomic_fetch_and_add(&active->adding, -1);
+
+        // Check if active buffer reached the batch size and trigger flush.
+        if (item_idx == sentry__atomic_fetch(&batcher->batch_size) - 1) {
+            sentry__waitable_flag_set(&batcher->request_flush);
         }
+        return ENQUEUE_OK;
+    }
+    // ping the batching thread to flush, since we could miss the flag set
+    // on adding the last item
+    sentry__waitable_flag_set(&batcher->request_flush);
+    // Buffer is already full, roll back our increment.
+    sentry__atomic_fetch_and_add(&active->adding, -1);
+    return ENQUEUE_FULL;
+}
+
+static bool
+batcher_enqueue(sentry_batcher_t *batcher, sentry_batcher_item_t item)
+{
+    const size_t home = current_shard_hint();
+    for (int attempt = 0; attempt <= ENQUEUE_MAX_RETRIES; attempt++) {
+        // retrieve the active buffer index shared by all shards
+        const long active_idx = sentry__atomic_fetch(&batcher->active_idx);
 
-        // Now we can finally request a slot and check if the item fits in this
-        // buffer.
-        const long item_idx = sentry__atomic_fetch_and_add(&active->index, 1);
-        if (item_idx < SENTRY_BATCHER_QUEUE_LENGTH) {
-            // got a slot, write item to the buffer and unblock flusher
-            active->items[item_idx] = item;
-            sentry__atomic_fetch_and_add(&active->adding, -1);
-
-            // Check if active buffer is now full and trigger flush.
-            if (item_idx == SENTRY_BATCHER_QUEUE_LENGTH - 1) {
-                sentry__waitable_flag_set(&batcher->request_flush);
+        // Start at the home shard of this thread and only spill over into
+        // the other shards once it is full.
+        bool retry = false;
+        for (size_t i = 0; i < SENTRY_BATCHER_SHARD_COUNT; i++) {
+            sentry_batcher_shard_t *shard
+                = &batcher->shards[(home + i) % SENTRY_BATCHER_SHARD_COUNT];
+            const enqueue_result_t rv
+                = shard_enqueue(batcher, shard, active_idx, item);
+            if (rv == ENQUEUE_OK) {
+                return true;
+            }
+            if (rv == ENQUEUE_RETRY) {
+                // the flusher switched buffers, start over with fresh ones
+                retry = true;
+                break;
             }
-            return true;
         }
-        // ping the batching thread to flush, since we could miss the flag set
-        // on adding the last item
-        sentry__waitable_flag_set(&batcher->request_flush);
-        // Buffer is already full, roll back our increments and retry or drop.
-        sentry__atomic_fetch_and_add(&active->adding, -1);
         if (attempt == ENQUEUE_MAX_RETRIES) {
-            sentry__client_report_discard(SENTRY_DISCARD_REASON_QUEUE_OVERFLOW,
-                batcher->data_category, 1);
+            if (!retry) {
+                sentry__client_report_discard(
+                    SENTRY_DISCARD_REASON_QUEUE_OVERFLOW,
+                    batcher->data_category, 1);
+            }
             return false;
         }
     }
     return false;
 }
 
+bool
+sentry__batcher_enqueue(sentry_batcher_t *batcher, sentry_value_t item)
+{
+    sentry_batcher_item_t slot = { item, NULL };
+    return batcher_enqueue(batcher, slot);
+}
+
+void
+sentry__batcher_set_record_funcs(sentry_batcher_t *batcher,
+    sentry_batch_materialize_func_t materialize_func,
+    sentry_batch_free_record_func_t free_record_func)
+{
+    batcher->materialize_func = materialize_func;
+    batcher->free_record_func = free_record_func;
+}
+
+bool
+sentry__batcher_enqueue_record(sentry_batcher_t *batcher, void *record)
+{
+    sentry_batcher_item_t slot = { sentry_value_new_null(), record };
+    return batcher_enqueue(batcher, slot);
+}
+
+size_t
+sentry__batcher_get_batch_size(sentry_batcher_t *batcher)
+{
+    return (size_t)sentry__atomic_fetch(&batcher->batch_size);
+}
+
+/**
+ * Adaptive batching: doubles the batch size whenever a flush was triggered by
+ * a filled buffer, so that sustained load results in fewer, larger envelopes.
+ * Once a timeout flush finds less than half a batch, the batch size is halved
+ * again, but never below its initial size. Only called from the batching
+ * thread.
+ */
+static void
+adapt_batch_size(sentry_batcher_t *batcher, bool filled, long count)
+{
+    const long capacity = (long)batcher->capacity;
+    const long min_size = MIN(SENTRY_BATCHER_QUEUE_LENGTH, capacity);
+    const long batch_size = sentry__atomic_fetch(&batcher->batch_size);
+    long new_size = batch_size;
+    if (filled) {
+        new_size = batch_size > capacity / 2 ? capacity : batch_size * 2;
+    } else if (count < batch_size / 2) {
+        new_size = MAX(batch_size / 2, min_size);
+    }
+    if (new_size != batch_size) {
+        SENTRY_DEBUGF("adapting batch size from %ld to %ld items", batch_size,
+            new_size);
+        sentry__atomic_store(&batcher->batch_size, new_size);
+    }
+}
+
 SENTRY_THREAD_FN
 batcher_thread_func(void *data)
 {
@@ -330,14 +544,13 @@ batcher_thread_func(void *data)
     //
     // Flush triggers:
     //  1. Buffer full → enqueue wakes us via request_flush (immediate flush)
-    //  2. Timeout → partial buffer flushed after
-    //  SENTRY_BATCHER_FLUSH_INTERVAL_MS
+    //  2. Timeout → partial buffer flushed after `flush_interval_ms`
     //  3. Shutdown / force-flush → thread state change or cond_wake
     while (sentry__atomic_fetch(&batcher->thread_state)
         == SENTRY_BATCHER_THREAD_RUNNING) {
-        // Sleep for 5 seconds or until request_flush is set
+        // Sleep for the flush interval or until request_flush is set
         sentry__waitable_flag_wait(
-            &batcher->request_flush, SENTRY_BATCHER_FLUSH_INTERVAL_MS);
+            &batcher->request_flush, batcher->flush_interval_ms);
 
         if (sentry__atomic_fetch(&batcher->thread_state)
             != SENTRY_BATCHER_THREAD_RUNNING) {
@@ -346,18 +559,20 @@ batcher_thread_func(void *data)
 
         // Use the buffer state as the source of truth rather than the
         // wake trigger: flush if there's data, skip otherwise.
-        const long active_idx = sentry__atomic_fetch(&batcher->active_idx);
-        sentry_batcher_buffer_t *buf = &batcher->buffers[active_idx];
-        const long count = sentry__atomic_fetch(&buf->index);
+        const long count = count_active_items(batcher);
         if (count <= 0) {
             continue;
         }
 
-        if (count >= SENTRY_BATCHER_QUEUE_LENGTH) {
+        const bool filled = check_for_flush_condition(batcher);
+        if (filled) {
             SENTRY_TRACE("Batcher flushed by filled buffer");
         } else {
             SENTRY_TRACE("Batcher flushed by timeout");
         }
+        if (batcher->adaptive) {
+            adapt_batch_size(batcher, filled, count);
+        }
 
         sentry__batcher_flush(batcher, false);
     }
@@ -376,6 +591,16 @@ sentry__batcher_startup(
     // are only accessed in flush() which is bound by the options lifetime.
     batcher->transport = options->transport;
     batcher->run = options->run;
+    batcher->max_bytes = options->batch_max_bytes;
+    if (options->batch_flush_interval_ms) {
+        batcher->flush_interval_ms = options->batch_flush_interval_ms;
+    }
+    batcher->adaptive = options->batch_adaptive;
+    if (batcher->adaptive) {
+        // start small and let the load grow the batches up to the capacity
+        sentry__atomic_store(&batcher->batch_size,
+            MIN(SENTRY_BATCHER_QUEUE_LENGTH, (long)batcher->capacity));
+    }
 
     // Mark thread as starting before actually spawning so thread can transition
     // to RUNNING. This prevents shutdown from thinking the thread was never
@@ -8,12 +8,28 @@
 #include "sentry_sync.h"
 #include "sentry_transport.h"
 
+// `SENTRY_BATCHER_QUEUE_LENGTH` is the default capacity of each shard buffer
+// and the initial batch size of adaptive batching.
 #ifdef SENTRY_UNITTEST
 #    define SENTRY_BATCHER_QUEUE_LENGTH 5
+#    define SENTRY_BATCHER_SHARD_COUNT 4
 #else
 #    define SENTRY_BATCHER_QUEUE_LENGTH 100
+#    define SENTRY_BATCHER_SHARD_COUNT 16
 #endif
 
+// The batcher thread sleeps for this interval between flush cycles by default.
+// When the timer fires and there are items in the buffer, they are flushed
+// regardless of how recently they were enqueued.
+#define SENTRY_BATCHER_FLUSH_INTERVAL_MS 5000
+
+// Default upper bound for the serialized payload of a single batch.
+#define SENTRY_BATCHER_MAX_BYTES (1024 * 1024)
+
+// Producer-side counters are padded to this size so that shards don't share
+// cache lines with each other.
+#define SENTRY_BATCHER_CACHE_LINE 64
+
 /**
  * Thread lifecycle states for the batching thread.
  */
@@ -26,29 +42,69 @@ typedef enum {
     SENTRY_BATCHER_THREAD_RUNNING = 2,
 } sentry_batcher_thread_state_t;
 
+/**
+ * A buffer slot holds either a finished item, or a deferred record that is
+ * turned into an item by the batcher's `materialize_func` while flushing.
+ */
+typedef struct {
+    sentry_value_t value;
+    void *record;
+} sentry_batcher_item_t;
+
 typedef struct {
-    sentry_value_t items[SENTRY_BATCHER_QUEUE_LENGTH];
     long index; // (atomic) index for producer threads to get a unique slot
     long adding; // (atomic) count of in-flight writers on this buffer
     long sealed; // (atomic) 0=writeable, 1=sealed (meaning we drop)
+    char _pad[SENTRY_BATCHER_CACHE_LINE - 3 * sizeof(long)];
+    sentry_batcher_item_t *items; // `capacity` slots owned by the batcher
 } sentry_batcher_buffer_t;
 
+/**
+ * A shard is a double buffer that is preferably written to by a subset of
+ * threads. Producers pick their home shard by hashing their thread id and
+ * only spill into neighboring shards once their home shard is full. All
+ * shards switch their active buffer together, so the flusher drains every
+ * shard in a single pass.
+ */
+typedef struct {
+    sentry_batcher_buffer_t buffers[2];
+} sentry_batcher_shard_t;
+
 typedef sentry_envelope_item_t *(*sentry_batch_func_t)(
     sentry_envelope_t *envelope, sentry_value_t items);
 
+/**
+ * Turns a deferred record into an item, taking ownership of the record.
+ * Returning a null value drops the record.
+ */
+typedef sentry_value_t (*sentry_batch_materialize_func_t)(void *record);
+typedef void (*sentry_batch_free_record_func_t)(void *record);
+
 typedef struct {
     long refcount; // (atomic) reference count
-    sentry_batcher_buffer_t buffers[2]; // double buffer
-    long active_idx; // (atomic) index to the active buffer
     long flushing; // (atomic) reentrancy guard to the flusher
     long thread_state; // (atomic) sentry_batcher_thread_state_t
     sentry_waitable_flag_t request_flush; // level-triggered flush flag
     sentry_threadid_t batching_thread; // the batching thread
     sentry_batch_func_t batch_func; // function to add items to envelope
+    sentry_batch_materialize_func_t materialize_func; // for deferred records
+    sentry_batch_free_record_func_t free_record_func; // for deferred records
     sentry_data_category_t data_category; // for client report discard tracking
     sentry_dsn_t *dsn;
     sentry_transport_t *transport;
     sentry_run_t *run;
+    size_t capacity; // number of slots in each shard buffer
+    size_t max_bytes; // split batches whose payload exceeds this (0 = off)
+    uint64_t flush_interval_ms; // timeout between flush cycles
+    bool adaptive; // grow `batch_size` while buffers keep filling up
+    sentry_value_t *scratch; // flusher-only staging area of `capacity` slots
+    // `active_idx` and `batch_size` are read by every producer but only
+    // written by the flusher, so they get a cache line of their own.
+    char _pad0[SENTRY_BATCHER_CACHE_LINE];
+    long active_idx; // (atomic) index to the active buffer of every shard
+    long batch_size; // (atomic) items per shard that trigger a flush
+    char _pad1[SENTRY_BATCHER_CACHE_LINE - 2 * sizeof(long)];
+    sentry_batcher_shard_t shards[SENTRY_BATCHER_SHARD_COUNT];
 } sentry_batcher_t;
 
 typedef struct {
@@ -58,8 +114,12 @@ typedef struct {
 
 #define SENTRY_BATCHER_REF_INIT { NULL, 0 }
 
-sentry_batcher_t *sentry__batcher_new(
-    sentry_batch_func_t batch_func, sentry_data_category_t data_category);
+/**
+ * Creates a new batcher whose shard buffers hold `capacity` items each.
+ * A `capacity` of 0 selects `SENTRY_BATCHER_QUEUE_LENGTH`.
+ */
+sentry_batcher_t *sentry__batcher_new(sentry_batch_func_t batch_func,
+    sentry_data_category_t data_category, size_t capacity);
 
 /**
  * Acquires a reference to the batcher behind `ref`, atomically incrementing
@@ -87,7 +147,28 @@ sentry_batcher_t *sentry__batcher_swap(
     sentry_batcher_ref_t *ref, sentry_batcher_t *batcher);
 
 bool sentry__batcher_flush(sentry_batcher_t *batcher, bool crash_safe);
+
+/**
+ * Returns the current number of items per shard that trigger a flush. This is
+ * the capacity of the batcher unless adaptive batching is enabled.
+ */
+size_t sentry__batcher_get_batch_size(sentry_batcher_t *batcher);
+
 bool sentry__batcher_enqueue(sentry_batcher_t *batcher, sentry_value_t item);
+
+/**
+ * Sets the functions used to materialize and free deferred records. Must be
+ * called before the batcher is started.
+ */
+void sentry__batcher_set_record_funcs(sentry_batcher_t *batcher,
+    sentry_batch_materialize_func_t materialize_func,
+    sentry_batch_free_record_func_t free_record_func);
+
+/**
+ * Enqueues a deferred record, which is only materialized into an item on the
+ * flushing thread. On failure, the caller retains ownership of the record.
+ */
+bool sentry__batcher_enqueue_record(sentry_batcher_t *batcher, void *record);
 void sentry__batcher_startup(
     sentry_batcher_t *batcher, const sentry_options_t *options);
 void sentry__batcher_shutdown(sentry_batcher_t *batcher, uint64_t timeout);
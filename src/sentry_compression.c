@@ -0,0 +1,297 @@
+#include "sentry_compression.h"
+#include "sentry_alloc.h"
+#include "sentry_core.h"
+#include "sentry_string.h"
+#include "sentry_sync.h"
+#include "sentry_utils.h"
+
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef SENTRY_TRANSPORT_COMPRESSION
+#    include <zlib.h>
+#endif
+#ifdef SENTRY_TRANSPORT_ZSTD
+#    include <zstd.h>
+#endif
+
+/**
+ * The size of the chunks that `sentry__compressor_compress_buffer` grows its
+ * output by, instead of reserving the worst case size upfront.
+ */
+#define COMPRESS_BUFFER_CHUNK_SIZE 16384
+
+struct sentry_compressor_s {
+    sentry_http_compression_t codec;
+    int level;
+    size_t threshold;
+#ifdef SENTRY_TRANSPORT_COMPRESSION
+    z_stream stream;
+    bool stream_initialized;
+#endif
+#ifdef SENTRY_TRANSPORT_ZSTD
+    ZSTD_CCtx *cctx;
+#endif
+    sentry_mutex_t stats_lock;
+    sentry_compression_stats_t stats;
+};
+
+static uint64_t
+thread_cpu_time_us(void)
+{
+#if defined(SENTRY_PLATFORM_WINDOWS)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(
+            GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+        return 0;
+    }
+    uint64_t ticks = ((uint64_t)kernel.dwHighDateTime << 32)
+        + kernel.dwLowDateTime + ((uint64_t)user.dwHighDateTime << 32)
+        + user.dwLowDateTime;
+    return ticks / 10;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#else
+    return 0;
+#endif
+}
+
+static sentry_http_compression_t
+available_codec(sentry_http_compression_t codec)
+{
+#ifndef SENTRY_TRANSPORT_ZSTD
+    if (codec == SENTRY_HTTP_COMPRESSION_ZSTD) {
+        codec = SENTRY_HTTP_COMPRESSION_GZIP;
+    }
+#endif
+#ifndef SENTRY_TRANSPORT_COMPRESSION
+    if (codec == SENTRY_HTTP_COMPRESSION_GZIP) {
+        codec = SENTRY_HTTP_COMPRESSION_NONE;
+    }
+#endif
+    if (codec != SENTRY_HTTP_COMPRESSION_GZIP
+        && codec != SENTRY_HTTP_COMPRESSION_ZSTD) {
+        codec = SENTRY_HTTP_COMPRESSION_NONE;
+    }
+    return codec;
+}
+
+sentry_compressor_t *
+sentry__compressor_new(
+    sentry_http_compression_t codec, int level, size_t threshold)
+{
+    codec = available_codec(codec);
+    if (codec == SENTRY_HTTP_COMPRESSION_NONE) {
+        return NULL;
+    }
+    sentry_compressor_t *compressor = SENTRY_MAKE(sentry_compressor_t);
+    if (!compressor) {
+        return NULL;
+    }
+    compressor->codec = codec;
+    compressor->level = level;
+    compressor->threshold = threshold;
+    sentry__mutex_init(&compressor->stats_lock);
+
+#ifdef SENTRY_TRANSPORT_ZSTD
+    if (codec == SENTRY_HTTP_COMPRESSION_ZSTD) {
+        compressor->cctx = ZSTD_createCCtx();
+        if (!compressor->cctx) {
+            sentry__compressor_free(compressor);
+            return NULL;
+        }
+        if (level) {
+            ZSTD_CCtx_setParameter(
+                compressor->cctx, ZSTD_c_compressionLevel, level);
+        }
+    }
+#endif
+    return compressor;
+}
+
+void
+sentry__compressor_free(sentry_compressor_t *compressor)
+{
+    if (!compressor) {
+        return;
+    }
+#ifdef SENTRY_TRANSPORT_COMPRESSION
+    if (compressor->stream_initialized) {
+        deflateEnd(&compressor->stream);
+    }
+#endif
+#ifdef SENTRY_TRANSPORT_ZSTD
+    ZSTD_freeCCtx(compressor->cctx);
+#endif
+    sentry__mutex_free(&compressor->stats_lock);
+    sentry_free(compressor);
+}
+
+const char *
+sentry__compressor_encoding(const sentry_compressor_t *compressor)
+{
+    return compressor->codec == SENTRY_HTTP_COMPRESSION_ZSTD ? "zstd" : "gzip";
+}
+
+bool
+sentry__compressor_begin(sentry_compressor_t *compressor, size_t body_len)
+{
+    if (!compressor || body_len == 0 || body_len < compressor->threshold) {
+        return false;
+    }
+    uint64_t started = thread_cpu_time_us();
+    bool ok = false;
+#ifdef SENTRY_TRANSPORT_COMPRESSION
+    if (compressor->codec == SENTRY_HTTP_COMPRESSION_GZIP) {
+        if (compressor->stream_initialized) {
+            ok = deflateReset(&compressor->stream) == Z_OK;
+        } else {
+            int level = compressor->level ? compressor->level
+                                          : Z_DEFAULT_COMPRESSION;
+            int err = deflateInit2(&compressor->stream, level, Z_DEFLATED,
+                MAX_WBITS + 16, 9, Z_DEFAULT_STRATEGY);
+            if (err != Z_OK) {
+                SENTRY_WARNF("deflateInit2 failed: %d", err);
+            }
+            ok = compressor->stream_initialized = err == Z_OK;
+        }
+    }
+#endif
+#ifdef SENTRY_TRANSPORT_ZSTD
+    if (compressor->codec == SENTRY_HTTP_COMPRESSION_ZSTD) {
+        ok = !ZSTD_isError(
+                 ZSTD_CCtx_reset(compressor->cctx, ZSTD_reset_session_only))
+            && !ZSTD_isError(ZSTD_CCtx_setPledgedSrcSize(
+                compressor->cctx, (unsigned long long)body_len));
+    }
+#endif
+    uint64_t elapsed = thread_cpu_time_us() - started;
+
+    sentry__mutex_lock(&compressor->stats_lock);
+    compressor->stats.bodies += ok ? 1 : 0;
+    compressor->stats.cpu_time_us += elapsed;
+    sentry__mutex_unlock(&compressor->stats_lock);
+    return ok;
+}
+
+size_t
+sentry__compressor_compress(sentry_compressor_t *compressor, const char **in,
+    size_t *in_len, bool finish, char *out, size_t out_len, bool *finished)
+{
+    uint64_t started = thread_cpu_time_us();
+    size_t consumed = 0;
+    size_t produced = SIZE_MAX;
+#if !defined(SENTRY_TRANSPORT_COMPRESSION) && !defined(SENTRY_TRANSPORT_ZSTD)
+    (void)finish;
+    (void)out;
+    (void)out_len;
+    (void)finished;
+#endif
+#ifdef SENTRY_TRANSPORT_COMPRESSION
+    if (compressor->codec == SENTRY_HTTP_COMPRESSION_GZIP) {
+        z_stream *stream = &compressor->stream;
+        unsigned int avail_in = (unsigned int)MIN(*in_len, UINT_MAX);
+        unsigned int avail_out = (unsigned int)MIN(out_len, UINT_MAX);
+        stream->next_in = (unsigned char *)*in;
+        stream->avail_in = avail_in;
+        stream->next_out = (unsigned char *)out;
+        stream->avail_out = avail_out;
+        int err = deflate(
+            stream, finish && avail_in == *in_len ? Z_FINISH : Z_NO_FLUSH);
+        if (err == Z_OK || err == Z_BUF_ERROR || err == Z_STREAM_END) {
+            consumed = avail_in - stream->avail_in;
+            produced = avail_out - stream->avail_out;
+            *finished = err == Z_STREAM_END;
+        } else {
+            SENTRY_WARNF("deflate failed: %d", err);
+        }
+    }
+#endif
+#ifdef SENTRY_TRANSPORT_ZSTD
+    if (compressor->codec == SENTRY_HTTP_COMPRESSION_ZSTD) {
+        ZSTD_inBuffer input = { *in, *in_len, 0 };
+        ZSTD_outBuffer output = { out, out_len, 0 };
+        size_t remaining = ZSTD_compressStream2(compressor->cctx, &output,
+            &input, finish ? ZSTD_e_end : ZSTD_e_continue);
+        if (!ZSTD_isError(remaining)) {
+            consumed = input.pos;
+            produced = output.pos;
+            *finished = finish && remaining == 0;
+        } else {
+            SENTRY_WARNF("ZSTD_compressStream2 failed: %s",
+                ZSTD_getErrorName(remaining));
+        }
+    }
+#endif
+    uint64_t elapsed = thread_cpu_time_us() - started;
+    *in += consumed;
+    *in_len -= consumed;
+
+    sentry__mutex_lock(&compressor->stats_lock);
+    compressor->stats.bytes_in += consumed;
+    compressor->stats.bytes_out += produced != SIZE_MAX ? produced : 0;
+    compressor->stats.cpu_time_us += elapsed;
+    sentry__mutex_unlock(&compressor->stats_lock);
+    return produced;
+}
+
+char *
+sentry__compressor_compress_buffer(sentry_compressor_t *compressor,
+    const char *buf, size_t buf_len, size_t *out_len)
+{
+    if (!buf || !sentry__compressor_begin(compressor, buf_len)) {
+        return NULL;
+    }
+
+    sentry_stringbuilder_t sb;
+    sentry__stringbuilder_init(&sb);
+    size_t body_len = buf_len;
+    bool finished = false;
+    while (!finished) {
+        size_t len = sentry__stringbuilder_len(&sb);
+        // a body that does not get smaller is sent as it is
+        if (len >= body_len) {
+            sentry__stringbuilder_cleanup(&sb);
+            return NULL;
+        }
+        char *out
+            = sentry__stringbuilder_reserve(&sb, COMPRESS_BUFFER_CHUNK_SIZE);
+        if (!out) {
+            sentry__stringbuilder_cleanup(&sb);
+            return NULL;
+        }
+        size_t produced = sentry__compressor_compress(compressor, &buf,
+            &buf_len, true, out, COMPRESS_BUFFER_CHUNK_SIZE, &finished);
+        if (produced == SIZE_MAX) {
+            sentry__stringbuilder_cleanup(&sb);
+            return NULL;
+        }
+        sentry__stringbuilder_set_len(&sb, len + produced);
+    }
+    *out_len = sentry__stringbuilder_len(&sb);
+    if (*out_len >= body_len) {
+        sentry__stringbuilder_cleanup(&sb);
+        return NULL;
+    }
+    return sentry__stringbuilder_into_string(&sb);
+}
+
+void
+sentry__compressor_get_stats(
+    sentry_compressor_t *compressor, sentry_compression_stats_t *stats)
+{
+    if (!compressor) {
+        return;
+    }
+    sentry__mutex_lock(&compressor->stats_lock);
+    stats->bodies += compressor->stats.bodies;
+    stats->bytes_in += compressor->stats.bytes_in;
+    stats->bytes_out += compressor->stats.bytes_out;
+    stats->cpu_time_us += compressor->stats.cpu_time_us;
+    sentry__mutex_unlock(&compressor->stats_lock);
+}
@@ -0,0 +1,68 @@
+#ifndef SENTRY_COMPRESSION_H_INCLUDED
+#define SENTRY_COMPRESSION_H_INCLUDED
+
+#include "sentry_boot.h"
+
+/**
+ * A compression context for one codec, which compresses one request body at a
+ * time and is reused for all of them, so that its state only needs to be
+ * allocated once.
+ */
+typedef struct sentry_compressor_s sentry_compressor_t;
+
+typedef struct {
+    uint64_t bodies;
+    uint64_t bytes_in;
+    uint64_t bytes_out;
+    uint64_t cpu_time_us;
+} sentry_compression_stats_t;
+
+/**
+ * Creates a compressor for `codec` at `level`, where 0 is the default level of
+ * the codec. Bodies smaller than `threshold` bytes are not compressed.
+ * Codecs that the SDK was built without fall back to the next best one.
+ * Returns NULL if no codec is available, or for `SENTRY_HTTP_COMPRESSION_NONE`.
+ */
+sentry_compressor_t *sentry__compressor_new(
+    sentry_http_compression_t codec, int level, size_t threshold);
+
+void sentry__compressor_free(sentry_compressor_t *compressor);
+
+/**
+ * Returns the `content-encoding` of the compressed bodies.
+ */
+const char *sentry__compressor_encoding(const sentry_compressor_t *compressor);
+
+/**
+ * Starts compressing a new body of `body_len` bytes. Returns false if the body
+ * should be sent uncompressed instead.
+ */
+bool sentry__compressor_begin(
+    sentry_compressor_t *compressor, size_t body_len);
+
+/**
+ * Compresses input from `*in` into `out`, advancing `*in` and `*in_len` over
+ * the consumed input. Pass `finish` once `*in` holds the rest of the body, and
+ * call again until `*finished` is set.
+ * Returns the number of bytes written to `out`, or `SIZE_MAX` on error.
+ */
+size_t sentry__compressor_compress(sentry_compressor_t *compressor,
+    const char **in, size_t *in_len, bool finish, char *out, size_t out_len,
+    bool *finished);
+
+/**
+ * Compresses the whole `buf` into a newly allocated buffer. Returns NULL if
+ * the body should be sent uncompressed, because it is below the threshold, did
+ * not get any smaller, or failed to compress.
+ */
+char *sentry__compressor_compress_buffer(sentry_compressor_t *compressor,
+    const char *buf, size_t buf_len, size_t *out_len);
+
+/**
+ * Adds the number of compressed bodies, the bytes that went in and came out,
+ * and the CPU time spent compressing them to `stats`.
+ */
+void sentry__compressor_get_stats(
+    sentry_compressor_t *compressor, sentry_compression_stats_t *stats);
+
+#endif
@@ -86,14 +86,14 @@ generate_propagation_context(sentry_value_t propagation_context)
 {
     sentry_value_set_by_key(
         propagation_context, "trace", sentry_value_new_object());
-    sentry_uuid_t trace_id = sentry_uuid_new_v4();
-    sentry_uuid_t span_id = sentry_uuid_new_v4();
+    sentry_uuid_t ids[2];
+    sentry__uuids_new_v4(ids, 2);
     sentry_value_set_by_key(
         sentry_value_get_by_key(propagation_context, "trace"), "trace_id",
-        sentry__value_new_internal_uuid(&trace_id));
+        sentry__value_new_internal_uuid(&ids[0]));
     sentry_value_set_by_key(
         sentry_value_get_by_key(propagation_context, "trace"), "span_id",
-        sentry__value_new_span_uuid(&span_id));
+        sentry__value_new_span_uuid(&ids[1]));
     sentry__generate_sample_rand(
         sentry_value_get_by_key(propagation_context, "trace"));
 }
@@ -1097,27 +1097,9 @@ sentry__set_propagation_context(const char *key, sentry_value_t value)
 void
 sentry__apply_attributes(sentry_value_t telemetry, sentry_value_t attributes)
 {
-    SENTRY_WITH_SCOPE (scope) {
-        sentry__scope_apply_attributes(scope, telemetry, attributes);
-        if (scope->environment) {
-            sentry__value_add_attribute(attributes,
-                sentry_value_new_string(scope->environment), "string",
-                "sentry.environment");
-        }
-        if (scope->release) {
-            sentry__value_add_attribute(attributes,
-                sentry_value_new_string(scope->release), "string",
-                "sentry.release");
-        }
-    }
-    SENTRY_WITH_OPTIONS (options) {
-        sentry__value_add_attribute(attributes,
-            sentry_value_new_string(sentry_options_get_sdk_name(options)),
-            "string", "sentry.sdk.name");
-    }
-    sentry__value_add_attribute(attributes,
-        sentry_value_new_string(sentry_sdk_version()), "string",
-        "sentry.sdk.version");
+    sentry_scope_attributes_t *snapshot = sentry__scope_get_attributes();
+    sentry__scope_attributes_apply(snapshot, telemetry, attributes);
+    sentry__scope_attributes_decref(snapshot);
 }
 
 void
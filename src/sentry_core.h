@@ -7,6 +7,7 @@
 
 #define SENTRY_BREADCRUMBS_MAX 100
 #define SENTRY_SPANS_MAX 1000
+#define SENTRY_HTTP_COMPRESSION_THRESHOLD 128
 
 #if (defined(__GNUC__) && (__GNUC__ >= 4))                                     \
     || (defined(_MSC_VER) && defined(__clang__))
@@ -67,6 +67,18 @@ sentry__run_new(const sentry_path_t *database_path)
         return NULL;
     }
 
+    // `<db>/cache/retry.journal`
+    sentry_path_t *retry_journal_path
+        = sentry__path_join_str(cache_path, "retry.journal");
+    if (!retry_journal_path) {
+        sentry__path_free(run_path);
+        sentry__path_free(lock_path);
+        sentry__path_free(session_path);
+        sentry__path_free(external_path);
+        sentry__path_free(cache_path);
+        return NULL;
+    }
+
     sentry_run_t *run = SENTRY_MAKE(sentry_run_t);
     if (!run) {
         sentry__path_free(run_path);
@@ -74,6 +86,7 @@ sentry__run_new(const sentry_path_t *database_path)
         sentry__path_free(lock_path);
         sentry__path_free(external_path);
         sentry__path_free(cache_path);
+        sentry__path_free(retry_journal_path);
         return NULL;
     }
 
@@ -85,6 +98,14 @@ sentry__run_new(const sentry_path_t *database_path)
     run->session_path = session_path;
     run->external_path = external_path;
     run->cache_path = cache_path;
+    run->retry_journal_path = retry_journal_path;
+    sentry__mutex_init(&run->retry_journal_lock);
+    sentry_path_t *retry_journal_lock_path
+        = sentry__path_append_str(retry_journal_path, ".lock");
+    if (retry_journal_lock_path) {
+        run->retry_journal_filelock
+            = sentry__filelock_new(retry_journal_lock_path);
+    }
     run->lock = sentry__filelock_new(lock_path);
     if (!run->lock) {
         goto error;
@@ -215,6 +236,11 @@ sentry__run_free(sentry_run_t *run)
     sentry__path_free(run->session_path);
     sentry__path_free(run->external_path);
     sentry__path_free(run->cache_path);
+    sentry__path_free(run->retry_journal_path);
+    sentry__mutex_free(&run->retry_journal_lock);
+    if (run->retry_journal_filelock) {
+        sentry__filelock_free(run->retry_journal_filelock);
+    }
     sentry__filelock_free(run->lock);
     sentry_free(run->installation_id);
     sentry_free(run);
@@ -435,7 +461,7 @@ sentry__run_write_external(
 
 bool
 sentry__run_write_cache(
-    const sentry_run_t *run, const sentry_envelope_t *envelope, int retry_count)
+    sentry_run_t *run, const sentry_envelope_t *envelope, int retry_count)
 {
     if (sentry__path_create_dir_all(run->cache_path) != 0) {
         SENTRY_ERRORF("mkdir failed: \"%s\"", run->cache_path->path);
@@ -461,10 +487,91 @@ sentry__run_write_cache(
     }
 
     int rv = sentry_envelope_write_to_path(envelope, path);
-    sentry__path_free(path);
     if (rv) {
         SENTRY_WARN("writing envelope to file failed");
+    } else {
+        sentry__run_journal_retry(run, path);
+    }
+    sentry__path_free(path);
+    return rv == 0;
+}
+
+/**
+ * Locks the retry journal against other threads, and against other processes
+ * that use the same database, like a second SDK instance or the crash daemon.
+ */
+static void
+lock_retry_journal(sentry_run_t *run)
+{
+    sentry__mutex_lock(&run->retry_journal_lock);
+    if (run->retry_journal_filelock
+        && !sentry__filelock_lock(run->retry_journal_filelock)) {
+        SENTRY_WARN("failed to lock the retry journal");
+    }
+}
+
+static void
+unlock_retry_journal(sentry_run_t *run)
+{
+    if (run->retry_journal_filelock) {
+        sentry__filelock_unlock(run->retry_journal_filelock);
+    }
+    sentry__mutex_unlock(&run->retry_journal_lock);
+}
+
+bool
+sentry__run_journal_retry(sentry_run_t *run, const sentry_path_t *path)
+{
+    char record[128];
+    int len = snprintf(
+        record, sizeof(record), "%s\n", sentry__path_filename(path));
+    if (len <= 0 || (size_t)len >= sizeof(record)) {
+        return false;
     }
+
+    // a single append of a whole record, so that readers never observe a
+    // record that is interleaved with another one
+    lock_retry_journal(run);
+    int rv = sentry__path_append_buffer(
+        run->retry_journal_path, record, (size_t)len);
+    unlock_retry_journal(run);
+    if (rv != 0) {
+        SENTRY_WARN("appending to the retry journal failed");
+    }
+    return rv == 0;
+}
+
+bool
+sentry__run_rewrite_retry_journal(
+    sentry_run_t *run, const char *buf, size_t buf_len, size_t consumed)
+{
+    sentry_path_t *tmp_path
+        = sentry__path_append_str(run->retry_journal_path, ".tmp");
+    if (!tmp_path) {
+        return false;
+    }
+
+    // records appended by others after `consumed` must survive the rename
+    lock_retry_journal(run);
+    size_t size = 0;
+    char *contents
+        = sentry__path_read_to_buffer(run->retry_journal_path, &size);
+    int rv = sentry__path_write_buffer(tmp_path, buf, buf_len);
+    if (rv == 0 && contents && size > consumed) {
+        rv = sentry__path_append_buffer(
+            tmp_path, contents + consumed, size - consumed);
+    }
+    if (rv == 0) {
+        rv = sentry__path_rename(tmp_path, run->retry_journal_path);
+    }
+    unlock_retry_journal(run);
+
+    if (rv != 0) {
+        SENTRY_WARN("rewriting the retry journal failed");
+        sentry__path_remove(tmp_path);
+    }
+    sentry_free(contents);
+    sentry__path_free(tmp_path);
     return rv == 0;
 }
 
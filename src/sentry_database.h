@@ -6,6 +6,7 @@
 #include "sentry_attachment.h"
 #include "sentry_path.h"
 #include "sentry_session.h"
+#include "sentry_sync.h"
 
 typedef struct sentry_run_s {
     sentry_uuid_t uuid;
@@ -13,6 +14,10 @@ typedef struct sentry_run_s {
     sentry_path_t *session_path;
     sentry_path_t *external_path;
     sentry_path_t *cache_path;
+    sentry_path_t *retry_journal_path;
+    sentry_mutex_t retry_journal_lock;
+    // serializes journal writes with other processes on the same database
+    sentry_filelock_t *retry_journal_filelock;
     sentry_filelock_t *lock;
     long refcount;
     long retain; // (atomic) bool
@@ -126,8 +131,8 @@ bool sentry__run_clear_session(const sentry_run_t *run);
  * directory. When retry_count >= 0 the filename uses retry format
  * `<ts>-<count>-<uuid>.envelope`, otherwise `<uuid>.envelope`.
  */
-bool sentry__run_write_cache(const sentry_run_t *run,
-    const sentry_envelope_t *envelope, int retry_count);
+bool sentry__run_write_cache(
+    sentry_run_t *run, const sentry_envelope_t *envelope, int retry_count);
 
 /**
  * Moves a file into the cache directory. When retry_count >= 0 the
@@ -137,6 +142,22 @@ bool sentry__run_write_cache(const sentry_run_t *run,
 bool sentry__run_move_cache(
     const sentry_run_t *run, const sentry_path_t *src, int retry_count);
 
+/**
+ * Appends the filename of a retry-format cache file to the retry journal
+ * `<database>/cache/retry.journal`. The retry index replays the journal
+ * instead of rescanning the cache directory. `sentry__run_write_cache`
+ * records the files it writes in retry format on its own.
+ */
+bool sentry__run_journal_retry(sentry_run_t *run, const sentry_path_t *path);
+
+/**
+ * Replaces the retry journal with `buf`. Records that were appended after the
+ * first `consumed` bytes of the current journal are carried over to the end
+ * of the new journal, so that concurrent appends are not lost.
+ */
+bool sentry__run_rewrite_retry_journal(
+    sentry_run_t *run, const char *buf, size_t buf_len, size_t consumed);
+
 /**
  * Builds a cache path. When count >= 0 the result is
  * `<db>/cache/<ts>-<count>-<uuid>.envelope`, otherwise
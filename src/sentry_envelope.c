@@ -15,11 +15,21 @@
 #include <limits.h>
 #include <string.h>
 
+/**
+ * Envelope files of at least this size are mapped into memory instead of being
+ * read into a heap buffer, and item payloads of at least this size reference
+ * the mapping instead of being copied. Smaller payloads are still copied, so
+ * that they stay NUL-terminated.
+ */
+#define SENTRY_ENVELOPE_MAP_THRESHOLD (64 * 1024)
+
 struct sentry_envelope_item_s {
     sentry_value_t headers;
     sentry_value_t event;
     char *payload;
     size_t payload_len;
+    // if set, `payload` points into this mapping and is not owned by the item
+    sentry_filemap_t *map;
     sentry_envelope_item_t *next;
 };
 
@@ -35,6 +45,7 @@ struct sentry_envelope_s {
         struct {
             char *payload;
             size_t payload_len;
+            sentry_filemap_t *map;
         } raw;
     } contents;
 };
@@ -61,6 +72,7 @@ envelope_add_item(sentry_envelope_t *envelope)
     item->event = sentry_value_new_null();
     item->payload = NULL;
     item->payload_len = 0;
+    item->map = NULL;
     item->next = NULL;
 
     // Append to linked list
@@ -75,12 +87,62 @@ envelope_add_item(sentry_envelope_t *envelope)
     return item;
 }
 
+static void
+envelope_item_free_payload(sentry_envelope_item_t *item)
+{
+    if (item->map) {
+        sentry__filemap_decref(item->map);
+        item->map = NULL;
+    } else {
+        sentry_free(item->payload);
+    }
+    item->payload = NULL;
+}
+
 static void
 envelope_item_cleanup(sentry_envelope_item_t *item)
 {
     sentry_value_decref(item->headers);
     sentry_value_decref(item->event);
-    sentry_free(item->payload);
+    envelope_item_free_payload(item);
+}
+
+/**
+ * Reads the envelope file at `path`. Large files are mapped if `map_out` is
+ * given, in which case the mapping is returned in it, and the returned buffer
+ * is borrowed from it. Otherwise the returned buffer is owned by the caller.
+ *
+ * Only files in the database are mapped, since the SDK controls their
+ * lifetime. A mapped file that is truncated while it is in use makes reading
+ * from the mapping fault.
+ */
+static char *
+envelope_read_file(
+    const sentry_path_t *path, size_t *buf_len, sentry_filemap_t **map_out)
+{
+    if (!map_out) {
+        return sentry__path_read_to_buffer(path, buf_len);
+    }
+    *map_out = NULL;
+    if (sentry__path_get_size(path) >= SENTRY_ENVELOPE_MAP_THRESHOLD) {
+        sentry_filemap_t *map = sentry__filemap_new(path);
+        if (map) {
+            *map_out = map;
+            *buf_len = sentry__filemap_len(map);
+            return (char *)sentry__filemap_data(map);
+        }
+    }
+    return sentry__path_read_to_buffer(path, buf_len);
+}
+
+static void
+envelope_free_buffer(char *buf, sentry_filemap_t *map)
+{
+    if (map) {
+        sentry__filemap_decref(map);
+    } else {
+        sentry_free(buf);
+    }
 }
 
 sentry_value_t
@@ -196,7 +258,8 @@ sentry_envelope_free(sentry_envelope_t *envelope)
         return;
     }
     if (envelope->is_raw) {
-        sentry_free(envelope->contents.raw.payload);
+        envelope_free_buffer(
+            envelope->contents.raw.payload, envelope->contents.raw.map);
         sentry_free(envelope);
         return;
     }
@@ -261,8 +324,9 @@ sentry__envelope_new_with_dsn(const sentry_dsn_t *dsn)
 sentry_envelope_t *
 sentry__envelope_from_path(const sentry_path_t *path)
 {
-    size_t buf_len;
-    char *buf = sentry__path_read_to_buffer(path, &buf_len);
+    size_t buf_len = 0;
+    sentry_filemap_t *map = NULL;
+    char *buf = envelope_read_file(path, &buf_len, &map);
     if (!buf) {
         SENTRY_WARNF("failed to read raw envelope from \"%s\"", path->path);
         return NULL;
@@ -270,13 +334,14 @@ sentry__envelope_from_path(const sentry_path_t *path)
 
     sentry_envelope_t *envelope = SENTRY_MAKE(sentry_envelope_t);
     if (!envelope) {
-        sentry_free(buf);
+        envelope_free_buffer(buf, map);
         return NULL;
     }
 
     envelope->is_raw = true;
     envelope->contents.raw.payload = buf;
     envelope->contents.raw.payload_len = buf_len;
+    envelope->contents.raw.map = map;
 
     return envelope;
 }
@@ -343,8 +408,8 @@ sentry_envelope_get_transaction(const sentry_envelope_t *envelope)
     return sentry_value_new_null();
 }
 
-sentry_envelope_item_t *
-sentry__envelope_add_event(sentry_envelope_t *envelope, sentry_value_t event)
+static sentry_envelope_item_t *
+add_event(sentry_envelope_t *envelope, sentry_value_t event)
 {
     sentry_envelope_item_t *item = envelope_add_item(envelope);
     if (!item) {
@@ -427,6 +492,16 @@ sentry__envelope_add_event(sentry_envelope_t *envelope, sentry_value_t event)
     return item;
 }
 
+sentry_envelope_item_t *
+sentry__envelope_add_event(sentry_envelope_t *envelope, sentry_value_t event)
+{
+    // the headers and sampling context are freed along with the envelope
+    sentry_value_arena_t *arena = sentry__value_arena_begin();
+    sentry_envelope_item_t *item = add_event(envelope, event);
+    sentry__value_arena_end(arena);
+    return item;
+}
+
 sentry_envelope_item_t *
 sentry__envelope_add_transaction(
     sentry_envelope_t *envelope, sentry_value_t transaction)
@@ -855,50 +930,206 @@ sentry__envelope_serialize_into_stringbuilder(
     }
 }
 
-char *
-sentry_envelope_serialize_ratelimited(const sentry_envelope_t *envelope,
-    const sentry_rate_limiter_t *rl, size_t *size_out, bool *owned_out)
+static bool
+item_is_ratelimited(
+    const sentry_envelope_item_t *item, const sentry_rate_limiter_t *rl)
 {
+    if (!rl) {
+        return false;
+    }
+    int category = envelope_item_get_ratelimiter_category(item);
+    // category < 0 means the item should bypass rate limiting
+    if (category < 0 || !sentry__rate_limiter_is_disabled(rl, category)) {
+        return false;
+    }
+    const char *ty = sentry_value_as_string(
+        sentry_value_get_by_key(item->headers, "type"));
+    sentry__client_report_discard(SENTRY_DISCARD_REASON_RATELIMIT_BACKOFF,
+        item_type_to_data_category(ty), 1);
+    return true;
+}
+
+/**
+ * A contiguous part of the serialized envelope. Envelope and item headers are
+ * serialized upfront into the reader's `framing` buffer, item payloads are
+ * borrowed from the envelope.
+ */
+typedef struct {
+    const char *buf;
+    size_t offset;
+    size_t len;
+} envelope_chunk_t;
+
+struct sentry_envelope_reader_s {
+    sentry_stringbuilder_t framing;
+    envelope_chunk_t *chunks;
+    size_t chunks_len;
+    size_t chunk_idx;
+    size_t chunk_pos;
+    size_t len;
+};
+
+static void
+reader_push_chunk(sentry_envelope_reader_t *reader, const char *buf,
+    size_t offset, size_t len)
+{
+    if (!len) {
+        return;
+    }
+    envelope_chunk_t *chunk = &reader->chunks[reader->chunks_len++];
+    chunk->buf = buf;
+    chunk->offset = offset;
+    chunk->len = len;
+    reader->len += len;
+}
+
+static void
+reader_push_framing(sentry_envelope_reader_t *reader, size_t start)
+{
+    reader_push_chunk(reader, NULL, start,
+        sentry__stringbuilder_len(&reader->framing) - start);
+}
+
+sentry_envelope_reader_t *
+sentry__envelope_reader_new(
+    const sentry_envelope_t *envelope, const sentry_rate_limiter_t *rl)
+{
+    sentry_envelope_reader_t *reader = SENTRY_MAKE(sentry_envelope_reader_t);
+    if (!reader) {
+        return NULL;
+    }
+    memset(reader, 0, sizeof(*reader));
+    sentry__stringbuilder_init(&reader->framing);
+
     if (envelope->is_raw) {
-        *size_out = envelope->contents.raw.payload_len;
-        *owned_out = false;
-        return envelope->contents.raw.payload;
+        reader->chunks = SENTRY_MAKE(envelope_chunk_t);
+        if (!reader->chunks) {
+            sentry__envelope_reader_free(reader);
+            return NULL;
+        }
+        reader_push_chunk(reader, envelope->contents.raw.payload, 0,
+            envelope->contents.raw.payload_len);
+        return reader;
     }
-    *owned_out = true;
 
-    sentry_stringbuilder_t sb;
-    sentry__stringbuilder_init(&sb);
-    sentry__envelope_serialize_headers_into_stringbuilder(envelope, &sb);
+    // the envelope headers, plus item headers and payload for each item
+    reader->chunks = sentry_malloc(sizeof(envelope_chunk_t)
+        * (1 + 2 * envelope->contents.items.item_count));
+    sentry_jsonwriter_t *jw = sentry__jsonwriter_new_sb(&reader->framing);
+    if (!reader->chunks || !jw) {
+        if (jw) {
+            sentry__jsonwriter_free(jw);
+        }
+        sentry__envelope_reader_free(reader);
+        return NULL;
+    }
+
+    sentry__jsonwriter_write_value(jw, envelope->contents.items.headers);
+    sentry__jsonwriter_reset(jw);
+    reader_push_framing(reader, 0);
 
     size_t serialized_items = 0;
     for (const sentry_envelope_item_t *item
         = envelope->contents.items.first_item;
         item; item = item->next) {
-        if (rl) {
-            int category = envelope_item_get_ratelimiter_category(item);
-            // category < 0 means the item should bypass rate limiting
-            if (category >= 0
-                && sentry__rate_limiter_is_disabled(rl, category)) {
-                const char *ty = sentry_value_as_string(
-                    sentry_value_get_by_key(item->headers, "type"));
-                sentry__client_report_discard(
-                    SENTRY_DISCARD_REASON_RATELIMIT_BACKOFF,
-                    item_type_to_data_category(ty), 1);
-                continue;
-            }
+        if (item_is_ratelimited(item, rl)) {
+            continue;
         }
-        sentry__envelope_serialize_item_into_stringbuilder(item, &sb);
+        size_t start = sentry__stringbuilder_len(&reader->framing);
+        sentry__stringbuilder_append_char(&reader->framing, '\n');
+        sentry__jsonwriter_write_value(jw, item->headers);
+        sentry__jsonwriter_reset(jw);
+        sentry__stringbuilder_append_char(&reader->framing, '\n');
+        reader_push_framing(reader, start);
+        reader_push_chunk(reader, item->payload, 0, item->payload_len);
         serialized_items += 1;
     }
+    sentry__jsonwriter_free(jw);
 
     if (!serialized_items) {
-        sentry__stringbuilder_cleanup(&sb);
-        *size_out = 0;
+        sentry__envelope_reader_free(reader);
         return NULL;
     }
 
-    *size_out = sentry__stringbuilder_len(&sb);
-    return sentry__stringbuilder_into_string(&sb);
+    // the framing buffer is complete, so it is safe to point into it now
+    for (size_t i = 0; i < reader->chunks_len; i++) {
+        if (!reader->chunks[i].buf) {
+            reader->chunks[i].buf = reader->framing.buf;
+        }
+    }
+    return reader;
+}
+
+size_t
+sentry__envelope_reader_len(const sentry_envelope_reader_t *reader)
+{
+    return reader->len;
+}
+
+size_t
+sentry__envelope_reader_read(
+    sentry_envelope_reader_t *reader, char *buf, size_t buf_len)
+{
+    size_t written = 0;
+    while (written < buf_len && reader->chunk_idx < reader->chunks_len) {
+        const envelope_chunk_t *chunk = &reader->chunks[reader->chunk_idx];
+        size_t len = MIN(chunk->len - reader->chunk_pos, buf_len - written);
+        memcpy(buf + written, chunk->buf + chunk->offset + reader->chunk_pos,
+            len);
+        written += len;
+        reader->chunk_pos += len;
+        if (reader->chunk_pos == chunk->len) {
+            reader->chunk_idx++;
+            reader->chunk_pos = 0;
+        }
+    }
+    return written;
+}
+
+void
+sentry__envelope_reader_rewind(sentry_envelope_reader_t *reader)
+{
+    reader->chunk_idx = 0;
+    reader->chunk_pos = 0;
+}
+
+void
+sentry__envelope_reader_free(sentry_envelope_reader_t *reader)
+{
+    if (!reader) {
+        return;
+    }
+    sentry__stringbuilder_cleanup(&reader->framing);
+    sentry_free(reader->chunks);
+    sentry_free(reader);
+}
+
+char *
+sentry_envelope_serialize_ratelimited(const sentry_envelope_t *envelope,
+    const sentry_rate_limiter_t *rl, size_t *size_out, bool *owned_out)
+{
+    if (envelope->is_raw) {
+        *size_out = envelope->contents.raw.payload_len;
+        *owned_out = false;
+        return envelope->contents.raw.payload;
+    }
+    *owned_out = true;
+    *size_out = 0;
+
+    sentry_envelope_reader_t *reader
+        = sentry__envelope_reader_new(envelope, rl);
+    if (!reader) {
+        return NULL;
+    }
+    size_t len = sentry__envelope_reader_len(reader);
+    char *buf = sentry_malloc(len + 1);
+    if (buf) {
+        sentry__envelope_reader_read(reader, buf, len);
+        buf[len] = '\0';
+        *size_out = len;
+    }
+    sentry__envelope_reader_free(reader);
+    return buf;
 }
 
 char *
@@ -1002,11 +1233,11 @@ sentry_envelope_write_to_file(
     return sentry_envelope_write_to_file_n(envelope, path, strlen(path));
 }
 
-static bool deserialize_into(
-    sentry_envelope_t *envelope, const char *buf, size_t buf_len);
+static bool deserialize_into(sentry_envelope_t *envelope, const char *buf,
+    size_t buf_len, sentry_filemap_t *map);
 
-sentry_envelope_t *
-sentry_envelope_deserialize(const char *buf, size_t buf_len)
+static sentry_envelope_t *
+envelope_deserialize(const char *buf, size_t buf_len, sentry_filemap_t *map)
 {
     // Use sentry__envelope_new_with_dsn(NULL) instead of sentry__envelope_new()
     // because the DSN is part of the serialized headers and will be restored by
@@ -1016,16 +1247,24 @@ sentry_envelope_deserialize(const char *buf, size_t buf_len)
     if (!envelope) {
         return NULL;
     }
-    if (!deserialize_into(envelope, buf, buf_len)) {
+    if (!deserialize_into(envelope, buf, buf_len, map)) {
         sentry_envelope_free(envelope);
         return NULL;
     }
     return envelope;
 }
 
+sentry_envelope_t *
+sentry_envelope_deserialize(const char *buf, size_t buf_len)
+{
+    return envelope_deserialize(buf, buf_len, NULL);
+}
+
 // https://develop.sentry.dev/sdk/data-model/envelopes/
+// If `buf` lies within `map`, large item payloads reference the mapping.
 static bool
-deserialize_into(sentry_envelope_t *envelope, const char *buf, size_t buf_len)
+deserialize_into(sentry_envelope_t *envelope, const char *buf, size_t buf_len,
+    sentry_filemap_t *map)
 {
     if (!buf || buf_len == 0) {
         return false;
@@ -1105,12 +1344,17 @@ deserialize_into(sentry_envelope_t *envelope, const char *buf, size_t buf_len)
                 || item->payload_len >= SIZE_MAX) {
                 return false;
             }
-            item->payload = sentry_malloc(item->payload_len + 1);
-            if (!item->payload) {
-                return false;
+            if (map && item->payload_len >= SENTRY_ENVELOPE_MAP_THRESHOLD) {
+                item->payload = (char *)ptr;
+                item->map = sentry__filemap_incref(map);
+            } else {
+                item->payload = sentry_malloc(item->payload_len + 1);
+                if (!item->payload) {
+                    return false;
+                }
+                memcpy(item->payload, ptr, item->payload_len);
+                item->payload[item->payload_len] = '\0';
             }
-            memcpy(item->payload, ptr, item->payload_len);
-            item->payload[item->payload_len] = '\0';
 
             // item event/transaction
             const char *type = sentry_value_as_string(
@@ -1140,9 +1384,10 @@ parse_envelope_from_file(sentry_path_t *path)
         return NULL;
     }
 
+    // the file belongs to the caller, who might modify it at any time
     size_t buf_len = 0;
-    char *buf = sentry__path_read_to_buffer(path, &buf_len);
-    sentry_envelope_t *envelope = sentry_envelope_deserialize(buf, buf_len);
+    char *buf = envelope_read_file(path, &buf_len, NULL);
+    sentry_envelope_t *envelope = envelope_deserialize(buf, buf_len, NULL);
     sentry_free(buf);
     sentry__path_free(path);
     return envelope;
@@ -1192,8 +1437,8 @@ envelope_materialize(const sentry_envelope_t *envelope)
     if (!envelope || !envelope->is_raw) {
         return (sentry_envelope_t *)envelope;
     }
-    return sentry_envelope_deserialize(
-        envelope->contents.raw.payload, envelope->contents.raw.payload_len);
+    return envelope_deserialize(envelope->contents.raw.payload,
+        envelope->contents.raw.payload_len, envelope->contents.raw.map);
 }
 
 typedef struct {
@@ -1415,6 +1660,88 @@ sentry__envelope_is_raw(const sentry_envelope_t *envelope)
     return envelope && envelope->is_raw;
 }
 
+sentry_data_category_t
+sentry__envelope_get_data_category(const sentry_envelope_t *envelope)
+{
+    if (envelope->is_raw || !envelope->contents.items.first_item) {
+        return SENTRY_DATA_CATEGORY_ERROR;
+    }
+    const sentry_envelope_item_t *item = envelope->contents.items.first_item;
+    return item_type_to_data_category(sentry_value_as_string(
+        sentry_value_get_by_key(item->headers, "type")));
+}
+
+bool
+sentry__envelope_is_coalescable(const sentry_envelope_t *envelope)
+{
+    if (!envelope || envelope->is_raw
+        || !envelope->contents.items.first_item) {
+        return false;
+    }
+    // envelopes with an `event_id` or a `trace` belong together with their
+    // items, only the `dsn` header can be shared
+    sentry_value_t headers = envelope->contents.items.headers;
+    size_t num_headers = sentry_value_get_length(headers);
+    if (num_headers > 1
+        || (num_headers == 1
+            && sentry_value_is_null(sentry_value_get_by_key(headers, "dsn")))) {
+        return false;
+    }
+    for (const sentry_envelope_item_t *item
+        = envelope->contents.items.first_item;
+        item; item = item->next) {
+        const char *ty = sentry_value_as_string(
+            sentry_value_get_by_key(item->headers, "type"));
+        if (!item->payload
+            || !(sentry__string_eq(ty, "log")
+                || sentry__string_eq(ty, "trace_metric")
+                || sentry__string_eq(ty, "session")
+                || sentry__string_eq(ty, "sessions")
+                || sentry__string_eq(ty, "client_report"))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t
+envelope_payload_size(const sentry_envelope_t *envelope)
+{
+    size_t size = 0;
+    for (const sentry_envelope_item_t *item
+        = envelope->contents.items.first_item;
+        item; item = item->next) {
+        size += item->payload_len;
+    }
+    return size;
+}
+
+bool
+sentry__envelope_coalesce(
+    sentry_envelope_t *dst, sentry_envelope_t *src, size_t max_size)
+{
+    if (dst == src || !sentry__envelope_is_coalescable(dst)
+        || !sentry__envelope_is_coalescable(src)
+        || !sentry__string_eq(
+            sentry_value_as_string(sentry_envelope_get_header(dst, "dsn")),
+            sentry_value_as_string(sentry_envelope_get_header(src, "dsn")))) {
+        return false;
+    }
+    size_t dst_size = envelope_payload_size(dst);
+    size_t src_size = envelope_payload_size(src);
+    if (dst_size > max_size || src_size > max_size - dst_size) {
+        return false;
+    }
+
+    dst->contents.items.last_item->next = src->contents.items.first_item;
+    dst->contents.items.last_item = src->contents.items.last_item;
+    dst->contents.items.item_count += src->contents.items.item_count;
+    src->contents.items.first_item = NULL;
+    src->contents.items.last_item = NULL;
+    src->contents.items.item_count = 0;
+    return true;
+}
+
 size_t
 sentry__envelope_get_item_count(const sentry_envelope_t *envelope)
 {
@@ -1473,15 +1800,6 @@ sentry__envelope_remove_item(
     return false;
 }
 
-// these for now are only needed for tests
-#ifdef SENTRY_UNITTEST
-sentry_value_t
-sentry__envelope_item_get_header(
-    const sentry_envelope_item_t *item, const char *key)
-{
-    return sentry_value_get_by_key(item->headers, key);
-}
-
 const char *
 sentry__envelope_item_get_payload(
     const sentry_envelope_item_t *item, size_t *payload_len_out)
@@ -1491,6 +1809,16 @@ sentry__envelope_item_get_payload(
     }
     return item->payload;
 }
+
+// these for now are only needed for tests
+#ifdef SENTRY_UNITTEST
+sentry_value_t
+sentry__envelope_item_get_header(
+    const sentry_envelope_item_t *item, const char *key)
+{
+    return sentry_value_get_by_key(item->headers, key);
+}
+
 #endif
 
 bool
@@ -1504,13 +1832,14 @@ sentry__envelope_materialize(sentry_envelope_t *envelope)
     }
     char *payload = envelope->contents.raw.payload;
     size_t payload_len = envelope->contents.raw.payload_len;
+    sentry_filemap_t *map = envelope->contents.raw.map;
     envelope->is_raw = false;
     envelope->contents.items.headers = sentry_value_new_object();
     envelope->contents.items.first_item = NULL;
     envelope->contents.items.last_item = NULL;
     envelope->contents.items.item_count = 0;
-    bool ok = deserialize_into(envelope, payload, payload_len);
-    sentry_free(payload);
+    bool ok = deserialize_into(envelope, payload, payload_len, map);
+    envelope_free_buffer(payload, map);
     return ok;
 }
 
@@ -1572,7 +1901,7 @@ set_attachment_ref_payload(
     if (!payload) {
         return false;
     }
-    sentry_free(item->payload);
+    envelope_item_free_payload(item);
     item->payload = payload;
     item->payload_len = payload_len;
     sentry__envelope_item_set_header(
@@ -36,7 +36,9 @@ sentry_envelope_t *sentry__envelope_new(void);
 sentry_envelope_t *sentry__envelope_new_with_dsn(const sentry_dsn_t *dsn);
 
 /**
- * This loads a previously serialized envelope from disk.
+ * This loads a previously serialized envelope from disk. Large files are
+ * mapped instead of read, so this must only be used for files in the
+ * database, which are not modified while the envelope is alive.
  */
 sentry_envelope_t *sentry__envelope_from_path(const sentry_path_t *path);
 
@@ -170,6 +172,37 @@ void sentry__envelope_item_set_header(
 char *sentry_envelope_serialize_ratelimited(const sentry_envelope_t *envelope,
     const sentry_rate_limiter_t *rl, size_t *size_out, bool *owned_out);
 
+/**
+ * A pull-based serializer for envelopes.
+ *
+ * The reader serializes the envelope and item headers upfront, but borrows the
+ * item payloads from the envelope, which needs to outlive the reader. Items
+ * that are rate-limited by `rl` are skipped and recorded as discarded.
+ * Returns `NULL` when all items have been rate-limited.
+ */
+typedef struct sentry_envelope_reader_s sentry_envelope_reader_t;
+sentry_envelope_reader_t *sentry__envelope_reader_new(
+    const sentry_envelope_t *envelope, const sentry_rate_limiter_t *rl);
+
+/**
+ * Returns the total size of the serialized envelope.
+ */
+size_t sentry__envelope_reader_len(const sentry_envelope_reader_t *reader);
+
+/**
+ * Copies up to `buf_len` bytes of the serialized envelope into `buf`, and
+ * returns the number of bytes written, which is 0 once the reader is drained.
+ */
+size_t sentry__envelope_reader_read(
+    sentry_envelope_reader_t *reader, char *buf, size_t buf_len);
+
+/**
+ * Restarts the reader at the beginning of the envelope.
+ */
+void sentry__envelope_reader_rewind(sentry_envelope_reader_t *reader);
+
+void sentry__envelope_reader_free(sentry_envelope_reader_t *reader);
+
 /**
  * Serialize a complete envelope with all its items into the given string
  * builder.
@@ -194,18 +227,45 @@ int sentry__envelope_write_to_cache(
 
 bool sentry__envelope_is_raw(const sentry_envelope_t *envelope);
 
+/**
+ * Returns the data category of the first item in the envelope. Raw envelopes
+ * are assumed to contain errors.
+ */
+sentry_data_category_t sentry__envelope_get_data_category(
+    const sentry_envelope_t *envelope);
+
+/**
+ * Returns true if the envelope only contains standalone items, such as logs,
+ * metrics, sessions or client reports, which can be sent in one envelope
+ * together with those of other envelopes.
+ */
+bool sentry__envelope_is_coalescable(const sentry_envelope_t *envelope);
+
+/**
+ * Moves all items of `src` to the end of `dst`, if both are coalescable, are
+ * meant for the same DSN, and the item payloads of `dst` do not grow beyond
+ * `max_size` bytes. Returns true if the items were moved, leaving `src` empty.
+ */
+bool sentry__envelope_coalesce(
+    sentry_envelope_t *dst, sentry_envelope_t *src, size_t max_size);
+
 size_t sentry__envelope_get_item_count(const sentry_envelope_t *envelope);
 sentry_envelope_item_t *sentry__envelope_get_item(
     const sentry_envelope_t *envelope, size_t idx);
 bool sentry__envelope_remove_item(
     sentry_envelope_t *envelope, sentry_envelope_item_t *item);
 
+/**
+ * Returns the payload of `item` and optionally writes its length to
+ * `payload_len_out`.
+ */
+const char *sentry__envelope_item_get_payload(
+    const sentry_envelope_item_t *item, size_t *payload_len_out);
+
 // these for now are only needed for tests
 #ifdef SENTRY_UNITTEST
 sentry_value_t sentry__envelope_item_get_header(
     const sentry_envelope_item_t *item, const char *key);
-const char *sentry__envelope_item_get_payload(
-    const sentry_envelope_item_t *item, size_t *payload_len_out);
 #endif
 
 /**
@@ -5,8 +5,12 @@
 #include "sentry_options.h"
 #include "sentry_os.h"
 #include "sentry_scope.h"
+#include "sentry_string.h"
+#include "sentry_sync.h"
 #include "sentry_value.h"
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
 static sentry_batcher_ref_t g_batcher = SENTRY_BATCHER_REF_INIT;
@@ -32,20 +36,30 @@ level_as_string(sentry_level_t level)
     }
 }
 
-// TODO to be portable, pass in the length format specifier
-#ifndef SENTRY_UNITTEST
-static
-#endif
-    sentry_value_t
-    construct_param_from_conversion(const char conversion, va_list *args_copy)
+/**
+ * A single argument of a log message, read from the `va_list` with the type
+ * that its conversion specification implies.
+ */
+typedef struct {
+    char conversion;
+    union {
+        long long i;
+        unsigned long long u;
+        double d;
+        const void *p;
+        const char *s;
+    } value;
+} log_param_t;
+
+static sentry_value_t
+construct_param(const log_param_t *param)
 {
     sentry_value_t param_obj = sentry_value_new_object();
-    switch (conversion) {
+    switch (param->conversion) {
     case 'd':
     case 'i': {
-        long long val = va_arg(*args_copy, long long);
         sentry_value_set_by_key(
-            param_obj, "value", sentry_value_new_int64(val));
+            param_obj, "value", sentry_value_new_int64(param->value.i));
         sentry_value_set_by_key(
             param_obj, "type", sentry_value_new_string("integer"));
         break;
@@ -54,12 +68,11 @@ static
     case 'x':
     case 'X':
     case 'o': {
-        unsigned long long int val = va_arg(*args_copy, unsigned long long int);
         // TODO update once unsigned 64-bit can be sent as non-string
         char buf[26];
         char format[8];
-        snprintf(format, sizeof(format), "%%ll%c", conversion);
-        snprintf(buf, sizeof(buf), format, val);
+        snprintf(format, sizeof(format), "%%ll%c", param->conversion);
+        snprintf(buf, sizeof(buf), format, param->value.u);
         sentry_value_set_by_key(
             param_obj, "value", sentry_value_new_string(buf));
         sentry_value_set_by_key(
@@ -72,16 +85,14 @@ static
     case 'E':
     case 'g':
     case 'G': {
-        double val = va_arg(*args_copy, double);
         sentry_value_set_by_key(
-            param_obj, "value", sentry_value_new_double(val));
+            param_obj, "value", sentry_value_new_double(param->value.d));
         sentry_value_set_by_key(
             param_obj, "type", sentry_value_new_string("double"));
         break;
     }
     case 'c': {
-        int val = va_arg(*args_copy, int);
-        char str[2] = { (char)val, '\0' };
+        char str[2] = { (char)param->value.i, '\0' };
         sentry_value_set_by_key(
             param_obj, "value", sentry_value_new_string(str));
         sentry_value_set_by_key(
@@ -89,10 +100,9 @@ static
         break;
     }
     case 's': {
-        const char *val = va_arg(*args_copy, const char *);
-        if (val) {
+        if (param->value.s) {
             sentry_value_set_by_key(
-                param_obj, "value", sentry_value_new_string(val));
+                param_obj, "value", sentry_value_new_string(param->value.s));
         } else {
             sentry_value_set_by_key(
                 param_obj, "value", sentry_value_new_string("(null)"));
@@ -102,9 +112,8 @@ static
         break;
     }
     case 'p': {
-        void *val = va_arg(*args_copy, void *);
         char ptr_str[32];
-        snprintf(ptr_str, sizeof(ptr_str), "%p", val);
+        snprintf(ptr_str, sizeof(ptr_str), "%p", param->value.p);
         sentry_value_set_by_key(
             param_obj, "value", sentry_value_new_string(ptr_str));
         sentry_value_set_by_key(
@@ -112,8 +121,6 @@ static
         break;
     }
     default:
-        // Unknown format specifier, skip the argument
-        (void)va_arg(*args_copy, void *);
         sentry_value_set_by_key(
             param_obj, "value", sentry_value_new_string("(unknown)"));
         sentry_value_set_by_key(
@@ -124,6 +131,52 @@ static
     return param_obj;
 }
 
+// TODO to be portable, pass in the length format specifier
+#ifndef SENTRY_UNITTEST
+static
+#endif
+    sentry_value_t
+    construct_param_from_conversion(const char conversion, va_list *args_copy)
+{
+    log_param_t param;
+    memset(&param, 0, sizeof(param));
+    param.conversion = conversion;
+    switch (conversion) {
+    case 'd':
+    case 'i':
+        param.value.i = va_arg(*args_copy, long long);
+        break;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        param.value.u = va_arg(*args_copy, unsigned long long int);
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+        param.value.d = va_arg(*args_copy, double);
+        break;
+    case 'c':
+        param.value.i = va_arg(*args_copy, int);
+        break;
+    case 's':
+        param.value.s = va_arg(*args_copy, const char *);
+        break;
+    case 'p':
+        param.value.p = va_arg(*args_copy, void *);
+        break;
+    default:
+        // Unknown format specifier, skip the argument
+        (void)va_arg(*args_copy, void *);
+        break;
+    }
+    return construct_param(&param);
+}
+
 static const char *
 skip_flags(const char *fmt_ptr)
 {
@@ -242,16 +295,22 @@ clone_attributes(sentry_value_t custom_attributes)
 }
 
 static void
-apply_attributes(
-    sentry_value_t log, sentry_value_t attributes, sentry_level_t level)
+apply_level_and_timestamp(
+    sentry_value_t log, sentry_level_t level, uint64_t usec_time)
 {
     sentry_value_set_by_key(
         log, "level", sentry_value_new_string(level_as_string(level)));
 
     // timestamp in seconds
-    uint64_t usec_time = sentry__usec_time();
     sentry_value_set_by_key(log, "timestamp",
         sentry_value_new_double((double)usec_time / 1000000.0));
+}
+
+static void
+apply_attributes(
+    sentry_value_t log, sentry_value_t attributes, sentry_level_t level)
+{
+    apply_level_and_timestamp(log, level, sentry__usec_time());
 
     // adds data from the scope & options to the attributes, and adds `trace_id`
     // to the log
@@ -323,6 +382,435 @@ construct_log(sentry_level_t level, const char *message, va_list args)
     return log;
 }
 
+/**
+ * A parsed printf conversion specification.
+ */
+typedef struct {
+    const char *start; // the `%` introducing the specification
+    const char *length_start; // the (optional) length modifier
+    const char *end; // one past the conversion specifier
+    char conversion; // `%` for an escaped percent sign, `\0` if truncated
+    char length; // 0, `H` (hh), `h`, `l`, `q` (ll), `L`, `z`, `j` or `t`
+    bool has_star; // width or precision are passed as arguments
+} format_spec_t;
+
+/**
+ * Finds the next conversion specification in `*fmt_ptr` and advances
+ * `*fmt_ptr` past it. Returns false if there is none left.
+ */
+static bool
+next_format_spec(const char **fmt_ptr, format_spec_t *spec)
+{
+    const char *p = strchr(*fmt_ptr, '%');
+    if (!p) {
+        return false;
+    }
+    memset(spec, 0, sizeof(*spec));
+    spec->start = p++;
+
+    if (*p != '%') {
+        p = skip_flags(p);
+        if (*p == '*') {
+            spec->has_star = true;
+            p++;
+        } else {
+            p = skip_width(p);
+        }
+        if (*p == '.') {
+            p++;
+            if (*p == '*') {
+                spec->has_star = true;
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') {
+                    p++;
+                }
+            }
+        }
+        spec->length_start = p;
+        switch (*p) {
+        case 'h':
+            spec->length = p[1] == 'h' ? 'H' : 'h';
+            p += p[1] == 'h' ? 2 : 1;
+            break;
+        case 'l':
+            spec->length = p[1] == 'l' ? 'q' : 'l';
+            p += p[1] == 'l' ? 2 : 1;
+            break;
+        case 'L':
+        case 'z':
+        case 'j':
+        case 't':
+            spec->length = *p++;
+            break;
+        default:
+            break;
+        }
+    } else {
+        spec->length_start = p;
+    }
+
+    spec->conversion = *p;
+    spec->end = *p ? p + 1 : p;
+    *fmt_ptr = spec->end;
+    return true;
+}
+
+static long long
+read_signed_arg(char length, va_list *args)
+{
+    switch (length) {
+    case 'H':
+        return (signed char)va_arg(*args, int);
+    case 'h':
+        return (short)va_arg(*args, int);
+    case 'l':
+        return va_arg(*args, long);
+    case 'q':
+        return va_arg(*args, long long);
+    case 'z':
+    case 't':
+        return va_arg(*args, ptrdiff_t);
+    case 'j':
+        return va_arg(*args, intmax_t);
+    default:
+        return va_arg(*args, int);
+    }
+}
+
+static unsigned long long
+read_unsigned_arg(char length, va_list *args)
+{
+    switch (length) {
+    case 'H':
+        return (unsigned char)va_arg(*args, unsigned int);
+    case 'h':
+        return (unsigned short)va_arg(*args, unsigned int);
+    case 'l':
+        return va_arg(*args, unsigned long);
+    case 'q':
+        return va_arg(*args, unsigned long long);
+    case 'z':
+    case 't':
+        return va_arg(*args, size_t);
+    case 'j':
+        return va_arg(*args, uintmax_t);
+    default:
+        return va_arg(*args, unsigned int);
+    }
+}
+
+// Longer specifications (e.g. excessive zero padding) are formatted eagerly.
+#define MAX_DEFERRED_SPEC_LEN 32
+
+/**
+ * Reads the argument of `spec` into `param`. Returns false for conversions
+ * that can't be deferred, in which case the log is formatted eagerly.
+ */
+static bool
+capture_param(const format_spec_t *spec, log_param_t *param, va_list *args)
+{
+    if (spec->has_star
+        || (size_t)(spec->end - spec->start) > MAX_DEFERRED_SPEC_LEN) {
+        return false;
+    }
+    param->conversion = spec->conversion;
+    switch (spec->conversion) {
+    case 'd':
+    case 'i':
+        param->value.i = read_signed_arg(spec->length, args);
+        return true;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        param->value.u = read_unsigned_arg(spec->length, args);
+        return true;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+        if (spec->length == 'L') {
+            return false;
+        }
+        param->value.d = va_arg(*args, double);
+        return true;
+    case 'c':
+        if (spec->length) {
+            return false;
+        }
+        param->value.i = va_arg(*args, int);
+        return true;
+    case 's':
+        if (spec->length) {
+            return false;
+        }
+        param->value.s = va_arg(*args, const char *);
+        return true;
+    case 'p':
+        param->value.p = va_arg(*args, void *);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Logs with more parameters are formatted eagerly.
+#define MAX_DEFERRED_PARAMS 32
+
+/**
+ * A log captured by `sentry_log_X()` that is formatted on the batching thread.
+ * The record is a single allocation, in which the parameters are followed by
+ * copies of the format string and of all string arguments.
+ */
+typedef struct {
+    sentry_level_t level;
+    uint64_t timestamp;
+    sentry_scope_attributes_t *scope_attributes; // as of the log call
+    sentry_value_t attributes; // custom attributes, owned
+    const char *format;
+    size_t param_count;
+    log_param_t *params;
+} log_record_t;
+
+static void
+free_log_record(void *data)
+{
+    log_record_t *record = data;
+    sentry_value_decref(record->attributes);
+    sentry__scope_attributes_decref(record->scope_attributes);
+    sentry_free(record);
+}
+
+/**
+ * Captures a log without formatting it. Returns NULL if the log needs to be
+ * formatted eagerly, in which case `args` and the custom attributes are left
+ * untouched.
+ */
+static log_record_t *
+capture_log_record(sentry_level_t level, const char *message, va_list args,
+    const sentry_options_t *options)
+{
+    if (!message) {
+        return NULL;
+    }
+
+    log_param_t params[MAX_DEFERRED_PARAMS];
+    size_t string_lens[MAX_DEFERRED_PARAMS];
+    size_t param_count = 0;
+    const size_t message_size = strlen(message) + 1;
+    size_t strings_size = message_size;
+    bool deferrable = true;
+
+    va_list args_copy;
+    va_copy(args_copy, args);
+    sentry_value_t custom_attributes = sentry_value_new_null();
+    if (options->logs_with_attributes) {
+        custom_attributes = va_arg(args_copy, sentry_value_t);
+    }
+    const char *fmt_ptr = message;
+    format_spec_t spec;
+    while (next_format_spec(&fmt_ptr, &spec)) {
+        if (spec.conversion == '%') {
+            continue;
+        }
+        if (param_count == MAX_DEFERRED_PARAMS
+            || !capture_param(&spec, &params[param_count], &args_copy)) {
+            deferrable = false;
+            break;
+        }
+        size_t len = 0;
+        const char *str = params[param_count].value.s;
+        if (spec.conversion == 's' && str) {
+            // the parameter attribute keeps the whole string, the precision
+            // only applies to the body
+            len = strlen(str);
+            strings_size += len + 1;
+        }
+        string_lens[param_count++] = len;
+    }
+    va_end(args_copy);
+    if (!deferrable) {
+        return NULL;
+    }
+
+    log_record_t *record = sentry_malloc(sizeof(log_record_t)
+        + param_count * sizeof(log_param_t) + strings_size);
+    if (!record) {
+        return NULL;
+    }
+    record->level = level;
+    record->timestamp = sentry__usec_time();
+    record->scope_attributes = sentry__scope_get_attributes();
+    record->attributes = custom_attributes;
+    record->param_count = param_count;
+    record->params = (log_param_t *)(record + 1);
+
+    char *strings = (char *)&record->params[param_count];
+    memcpy(strings, message, message_size);
+    record->format = strings;
+    strings += message_size;
+    for (size_t i = 0; i < param_count; i++) {
+        record->params[i] = params[i];
+        if (params[i].conversion == 's' && params[i].value.s) {
+            memcpy(strings, params[i].value.s, string_lens[i]);
+            strings[string_lens[i]] = '\0';
+            record->params[i].value.s = strings;
+            strings += string_lens[i] + 1;
+        }
+    }
+    return record;
+}
+
+static void
+append_formatted(sentry_stringbuilder_t *sb, const char *format, ...)
+{
+    va_list args, args_copy;
+    va_start(args, format);
+    va_copy(args_copy, args);
+    char buf[64];
+    const int len = vsnprintf(buf, sizeof(buf), format, args);
+    if (len >= 0 && (size_t)len < sizeof(buf)) {
+        sentry__stringbuilder_append_buf(sb, buf, (size_t)len);
+    } else if (len > 0) {
+        char *dst = sentry__stringbuilder_reserve(sb, (size_t)len + 1);
+        if (dst) {
+            vsnprintf(dst, (size_t)len + 1, format, args_copy);
+            sentry__stringbuilder_set_len(
+                sb, sentry__stringbuilder_len(sb) + (size_t)len);
+        }
+    }
+    va_end(args_copy);
+    va_end(args);
+}
+
+/**
+ * Formats a captured parameter according to its specification. The length
+ * modifier is replaced by the one matching the type the argument was
+ * captured as.
+ */
+static void
+append_param(sentry_stringbuilder_t *sb, const format_spec_t *spec,
+    const log_param_t *param)
+{
+    char format[MAX_DEFERRED_SPEC_LEN + 4];
+    const size_t prefix_len = (size_t)(spec->length_start - spec->start);
+    memcpy(format, spec->start, prefix_len);
+    char *p = format + prefix_len;
+
+    switch (param->conversion) {
+    case 'd':
+    case 'i':
+        *p++ = 'l';
+        *p++ = 'l';
+        *p++ = param->conversion;
+        *p = '\0';
+        append_formatted(sb, format, param->value.i);
+        break;
+    case 'u':
+    case 'x':
+    case 'X':
+    case 'o':
+        *p++ = 'l';
+        *p++ = 'l';
+        *p++ = param->conversion;
+        *p = '\0';
+        append_formatted(sb, format, param->value.u);
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+        *p++ = param->conversion;
+        *p = '\0';
+        append_formatted(sb, format, param->value.d);
+        break;
+    case 'c':
+        *p++ = 'c';
+        *p = '\0';
+        append_formatted(sb, format, (int)param->value.i);
+        break;
+    case 's':
+        *p++ = 's';
+        *p = '\0';
+        append_formatted(
+            sb, format, param->value.s ? param->value.s : "(null)");
+        break;
+    case 'p':
+        *p++ = 'p';
+        *p = '\0';
+        append_formatted(sb, format, param->value.p);
+        break;
+    default:
+        break;
+    }
+}
+
+static sentry_value_t
+format_log_record(const log_record_t *record)
+{
+    sentry_stringbuilder_t sb;
+    sentry__stringbuilder_init(&sb);
+
+    const char *fmt_ptr = record->format;
+    const char *literal = fmt_ptr;
+    size_t param_index = 0;
+    format_spec_t spec;
+    while (next_format_spec(&fmt_ptr, &spec)) {
+        sentry__stringbuilder_append_buf(
+            &sb, literal, (size_t)(spec.start - literal));
+        literal = spec.end;
+        if (spec.conversion == '%') {
+            sentry__stringbuilder_append_char(&sb, '%');
+        } else {
+            append_param(&sb, &spec, &record->params[param_index++]);
+        }
+    }
+    sentry__stringbuilder_append(&sb, literal);
+
+    char *body = sentry__stringbuilder_into_string(&sb);
+    return body ? sentry__value_new_string_owned(body)
+                : sentry_value_new_string("");
+}
+
+/**
+ * Turns a captured log record into a log on the batching thread. This must
+ * neither acquire the options nor the scope lock, since `sentry_init` holds
+ * them while shutting down a previous batcher.
+ */
+static sentry_value_t
+materialize_log_record(void *data)
+{
+    log_record_t *record = data;
+    sentry_value_t log = sentry_value_new_object();
+    sentry_value_t attributes = clone_attributes(record->attributes);
+    record->attributes = sentry_value_new_null();
+
+    sentry_value_set_by_key(log, "body", format_log_record(record));
+    for (size_t i = 0; i < record->param_count; i++) {
+        char key[64];
+        snprintf(key, sizeof(key), "sentry.message.parameter.%zu", i);
+        sentry_value_set_by_key(
+            attributes, key, construct_param(&record->params[i]));
+    }
+    if (record->param_count) {
+        sentry__value_add_attribute(attributes,
+            sentry_value_new_string(record->format), "string",
+            "sentry.message.template");
+    }
+
+    apply_level_and_timestamp(log, record->level, record->timestamp);
+    sentry__scope_attributes_apply(record->scope_attributes, log, attributes);
+    sentry_value_set_by_key(log, "attributes", attributes);
+
+    free_log_record(record);
+    return log;
+}
+
 static void
 debug_print_log(sentry_level_t level, const char *log_body)
 {
@@ -383,18 +871,62 @@ send_log(sentry_level_t level, sentry_value_t log)
     return SENTRY_LOG_RETURN_SUCCESS;
 }
 
+#ifdef SENTRY_UNITTEST
+static volatile long g_deferred_count = 0;
+
+size_t
+sentry__logs_deferred_count(void)
+{
+    return (size_t)sentry__atomic_fetch(&g_deferred_count);
+}
+#endif
+
+static log_return_value_t
+send_log_record(log_record_t *record)
+{
+#ifdef SENTRY_UNITTEST
+    sentry__atomic_fetch_and_add(&g_deferred_count, 1);
+#endif
+    sentry_batcher_t *batcher = sentry__batcher_acquire(&g_batcher);
+    if (!batcher || !sentry__batcher_enqueue_record(batcher, record)) {
+        sentry__batcher_release(batcher);
+        free_log_record(record);
+        return SENTRY_LOG_RETURN_FAILED;
+    }
+    sentry__batcher_release(batcher);
+    return SENTRY_LOG_RETURN_SUCCESS;
+}
+
 log_return_value_t
 sentry__logs_log(sentry_level_t level, const char *message, va_list args)
 {
     bool enable_logs = false;
+    bool has_hook = false;
+    log_record_t *record = NULL;
     SENTRY_WITH_OPTIONS (options) {
         if (options->enable_logs)
             enable_logs = true;
+        has_hook = options->before_send_log_func != NULL;
+        // hooks and debug output need the formatted log right away
+        if (enable_logs && options->logs_deferred
+            && !options->before_send_log_func && !options->debug) {
+            record = capture_log_record(level, message, args, options);
+        }
     }
     if (!enable_logs) {
         return SENTRY_LOG_RETURN_DISABLED;
     }
-    return send_log(level, construct_log(level, message, args));
+    if (record) {
+        return send_log_record(record);
+    }
+    // The log tree is created in one go and freed along with its batch. A hook
+    // may keep parts of it, which would keep the whole arena alive, so the log
+    // is allocated as usual then.
+    sentry_value_arena_t *arena
+        = has_hook ? NULL : sentry__value_arena_begin();
+    sentry_value_t log = construct_log(level, message, args);
+    sentry__value_arena_end(arena);
+    return send_log(level, log);
 }
 
 log_return_value_t
@@ -489,13 +1021,15 @@ sentry_log(
 void
 sentry__logs_startup(const sentry_options_t *options)
 {
-    sentry_batcher_t *batcher = sentry__batcher_new(
-        sentry__envelope_add_logs, SENTRY_DATA_CATEGORY_LOG_ITEM);
+    sentry_batcher_t *batcher = sentry__batcher_new(sentry__envelope_add_logs,
+        SENTRY_DATA_CATEGORY_LOG_ITEM, options->batch_capacity);
     if (!batcher) {
         SENTRY_WARN("failed to allocate logs batcher");
         return;
     }
 
+    sentry__batcher_set_record_funcs(
+        batcher, materialize_log_record, free_log_record);
     sentry__batcher_startup(batcher, options);
     sentry_batcher_t *old = sentry__batcher_swap(&g_batcher, batcher);
 
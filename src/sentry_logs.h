@@ -44,6 +44,11 @@ int populate_message_parameters(
  * This is a test-only helper to avoid race conditions in tests.
  */
 void sentry__logs_wait_for_thread_startup(void);
+
+/**
+ * Returns how many logs were captured for formatting on the batching thread.
+ */
+size_t sentry__logs_deferred_count(void);
 #endif
 
 #endif
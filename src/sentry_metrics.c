@@ -134,8 +134,9 @@ sentry_metrics_distribution(
 void
 sentry__metrics_startup(const sentry_options_t *options)
 {
-    sentry_batcher_t *batcher = sentry__batcher_new(
-        sentry__envelope_add_metrics, SENTRY_DATA_CATEGORY_TRACE_METRIC);
+    sentry_batcher_t *batcher
+        = sentry__batcher_new(sentry__envelope_add_metrics,
+            SENTRY_DATA_CATEGORY_TRACE_METRIC, options->batch_capacity);
     if (!batcher) {
         SENTRY_WARN("failed to allocate metrics batcher");
         return;
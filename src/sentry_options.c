@@ -2,6 +2,7 @@
 #include "sentry_alloc.h"
 #include "sentry_attachment.h"
 #include "sentry_backend.h"
+#include "sentry_batcher.h"
 #include "sentry_database.h"
 #include "sentry_logger.h"
 #include "sentry_path.h"
@@ -95,8 +96,15 @@ sentry_options_new(void)
         = SENTRY_CRASH_REPORTING_MODE_NATIVE_WITH_MINIDUMP; // Default: best of
                                                             // both worlds
     opts->http_retry = false;
+    opts->http_concurrency = 1;
+    opts->http_compression = SENTRY_HTTP_COMPRESSION_GZIP;
+    opts->http_compression_threshold = SENTRY_HTTP_COMPRESSION_THRESHOLD;
     opts->send_client_reports = true;
     opts->enable_large_attachments = false;
+    opts->batch_capacity = SENTRY_BATCHER_QUEUE_LENGTH;
+    opts->batch_max_bytes = SENTRY_BATCHER_MAX_BYTES;
+    opts->batch_flush_interval_ms = SENTRY_BATCHER_FLUSH_INTERVAL_MS;
+    opts->batch_adaptive = false;
 
     return opts;
 }
@@ -579,6 +587,18 @@ sentry_options_get_crash_reporting_mode(const sentry_options_t *opts)
     return (sentry_crash_reporting_mode_t)opts->crash_reporting_mode;
 }
 
+void
+sentry_options_set_crash_daemon_shared(sentry_options_t *opts, int enabled)
+{
+    opts->crash_daemon_shared = !!enabled;
+}
+
+int
+sentry_options_get_crash_daemon_shared(const sentry_options_t *opts)
+{
+    return opts->crash_daemon_shared;
+}
+
 void
 sentry_options_set_crashpad_wait_for_upload(
     sentry_options_t *opts, int wait_for_upload)
@@ -862,6 +882,18 @@ sentry_options_get_logs_with_attributes(const sentry_options_t *opts)
     return opts->logs_with_attributes;
 }
 
+void
+sentry_options_set_logs_deferred(sentry_options_t *opts, int logs_deferred)
+{
+    opts->logs_deferred = !!logs_deferred;
+}
+
+int
+sentry_options_get_logs_deferred(const sentry_options_t *opts)
+{
+    return opts->logs_deferred;
+}
+
 void
 sentry_options_set_enable_metrics(sentry_options_t *opts, int enable_metrics)
 {
@@ -887,6 +919,56 @@ sentry_options_get_enable_large_attachments(const sentry_options_t *opts)
     return opts->enable_large_attachments;
 }
 
+void
+sentry_options_set_batch_capacity(sentry_options_t *opts, size_t capacity)
+{
+    opts->batch_capacity = capacity ? capacity : SENTRY_BATCHER_QUEUE_LENGTH;
+}
+
+size_t
+sentry_options_get_batch_capacity(const sentry_options_t *opts)
+{
+    return opts->batch_capacity;
+}
+
+void
+sentry_options_set_batch_max_bytes(sentry_options_t *opts, size_t max_bytes)
+{
+    opts->batch_max_bytes = max_bytes;
+}
+
+size_t
+sentry_options_get_batch_max_bytes(const sentry_options_t *opts)
+{
+    return opts->batch_max_bytes;
+}
+
+void
+sentry_options_set_batch_flush_interval(
+    sentry_options_t *opts, uint64_t interval_ms)
+{
+    opts->batch_flush_interval_ms
+        = interval_ms ? interval_ms : SENTRY_BATCHER_FLUSH_INTERVAL_MS;
+}
+
+uint64_t
+sentry_options_get_batch_flush_interval(const sentry_options_t *opts)
+{
+    return opts->batch_flush_interval_ms;
+}
+
+void
+sentry_options_set_batch_adaptive(sentry_options_t *opts, int adaptive)
+{
+    opts->batch_adaptive = !!adaptive;
+}
+
+int
+sentry_options_get_batch_adaptive(const sentry_options_t *opts)
+{
+    return opts->batch_adaptive;
+}
+
 void
 sentry_options_set_before_send_metric(sentry_options_t *opts,
     sentry_before_send_metric_function_t func, void *user_data)
@@ -924,6 +1006,84 @@ sentry_options_get_http_retry(const sentry_options_t *opts)
     return opts->http_retry;
 }
 
+void
+sentry_options_set_http_concurrency(
+    sentry_options_t *opts, size_t concurrency)
+{
+    opts->http_concurrency = concurrency ? concurrency : 1;
+}
+
+size_t
+sentry_options_get_http_concurrency(const sentry_options_t *opts)
+{
+    return opts->http_concurrency;
+}
+
+void
+sentry_options_set_http_queue_capacity(
+    sentry_options_t *opts, size_t capacity)
+{
+    opts->http_queue_capacity = capacity;
+}
+
+size_t
+sentry_options_get_http_queue_capacity(const sentry_options_t *opts)
+{
+    return opts->http_queue_capacity;
+}
+
+void
+sentry_options_set_http_coalesce_size(sentry_options_t *opts, size_t size)
+{
+    opts->http_coalesce_size = size;
+}
+
+size_t
+sentry_options_get_http_coalesce_size(const sentry_options_t *opts)
+{
+    return opts->http_coalesce_size;
+}
+
+void
+sentry_options_set_http_coalesce_delay(
+    sentry_options_t *opts, uint64_t delay_ms)
+{
+    opts->http_coalesce_delay = delay_ms;
+}
+
+uint64_t
+sentry_options_get_http_coalesce_delay(const sentry_options_t *opts)
+{
+    return opts->http_coalesce_delay;
+}
+
+void
+sentry_options_set_http_compression(
+    sentry_options_t *opts, sentry_http_compression_t codec, int level)
+{
+    opts->http_compression = codec;
+    opts->http_compression_level = level;
+}
+
+sentry_http_compression_t
+sentry_options_get_http_compression(const sentry_options_t *opts)
+{
+    return opts->http_compression;
+}
+
+void
+sentry_options_set_http_compression_threshold(
+    sentry_options_t *opts, size_t threshold)
+{
+    opts->http_compression_threshold = threshold;
+}
+
+size_t
+sentry_options_get_http_compression_threshold(const sentry_options_t *opts)
+{
+    return opts->http_compression_threshold;
+}
+
 void
 sentry_options_set_propagate_traceparent(
     sentry_options_t *opts, int propagate_traceparent)
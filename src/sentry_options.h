@@ -77,12 +77,25 @@ struct sentry_options_s {
     // takes the first varg as a `sentry_value_t` object containing attributes
     // if no custom attributes are to be passed, use `sentry_value_new_object()`
     bool logs_with_attributes;
+    // capture log arguments on the calling thread and format on the batcher
+    bool logs_deferred;
     bool enable_metrics;
     sentry_before_send_metric_function_t before_send_metric_func;
     void *before_send_metric_data;
     bool http_retry;
+    size_t http_concurrency;
+    size_t http_queue_capacity;
+    size_t http_coalesce_size;
+    uint64_t http_coalesce_delay;
+    sentry_http_compression_t http_compression;
+    int http_compression_level;
+    size_t http_compression_threshold;
     bool send_client_reports;
     bool enable_large_attachments;
+    size_t batch_capacity;
+    size_t batch_max_bytes;
+    uint64_t batch_flush_interval_ms;
+    bool batch_adaptive;
 
     /* everything from here on down are options which are stored here but
        not exposed through the options API */
@@ -96,6 +109,7 @@ struct sentry_options_s {
                        // sentry_crash_context.h)
     int crash_reporting_mode; // 0=minidump, 1=native, 2=native_with_minidump
                               // (see sentry_crash_reporting_mode_t)
+    bool crash_daemon_shared;
 
 #ifdef SENTRY_PLATFORM_NX
     void (*network_connect_func)(void);
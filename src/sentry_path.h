@@ -20,11 +20,13 @@ struct sentry_filelock_s {
 };
 
 struct sentry_filewriter_s;
+struct sentry_filemap_s;
 
 typedef struct sentry_path_s sentry_path_t;
 typedef struct sentry_pathiter_s sentry_pathiter_t;
 typedef struct sentry_filelock_s sentry_filelock_t;
 typedef struct sentry_filewriter_s sentry_filewriter_t;
+typedef struct sentry_filemap_s sentry_filemap_t;
 
 /**
  * NOTE on encodings:
@@ -253,6 +255,13 @@ sentry_filelock_t *sentry__filelock_new(sentry_path_t *path);
  */
 bool sentry__filelock_try_lock(sentry_filelock_t *lock);
 
+/**
+ * This will wait until a lock on the given file is acquired, which makes it
+ * usable to serialize short operations between processes.
+ * The function will return `false` when the lock file can not be opened.
+ */
+bool sentry__filelock_lock(sentry_filelock_t *lock);
+
 /**
  * This will release the lock on the given file.
  */
@@ -285,6 +294,38 @@ size_t sentry__filewriter_byte_count(const sentry_filewriter_t *filewriter);
  */
 void sentry__filewriter_free(sentry_filewriter_t *filewriter);
 
+/**
+ * Maps the whole file at `path` read-only into memory.
+ * The mapping is reference counted and starts out with one reference.
+ * Returns NULL if the file is empty or cannot be mapped, or if the platform
+ * does not support mappings, in which case callers should fall back to
+ * `sentry__path_read_to_buffer`.
+ * The file must not be truncated while it is mapped.
+ */
+sentry_filemap_t *sentry__filemap_new(const sentry_path_t *path);
+
+/**
+ * Returns the start of the mapped file contents. These are not terminated by a
+ * NUL byte.
+ */
+const char *sentry__filemap_data(const sentry_filemap_t *map);
+
+/**
+ * Returns the number of mapped bytes.
+ */
+size_t sentry__filemap_len(const sentry_filemap_t *map);
+
+/**
+ * Increments the reference count of the mapping.
+ */
+sentry_filemap_t *sentry__filemap_incref(sentry_filemap_t *map);
+
+/**
+ * Decrements the reference count of the mapping, and unmaps it once the last
+ * reference is gone.
+ */
+void sentry__filemap_decref(sentry_filemap_t *map);
+
 /* windows-specific API additions */
 #ifdef SENTRY_PLATFORM_WINDOWS
 /**
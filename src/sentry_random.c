@@ -47,6 +47,167 @@ getrandom_devurandom(void *dst, size_t bytes)
 
 #    define HAVE_URANDOM
 #endif
+#ifdef SENTRY_PLATFORM_LINUX
+#    include "sentry_sync.h"
+
+#    include <pthread.h>
+#    include <string.h>
+#    ifdef SENTRY_HAVE_GETRANDOM
+#        include <sys/random.h>
+#    endif
+
+/**
+ * The number of bytes a thread generates before it reseeds its generator from
+ * the kernel.
+ */
+#    define CHACHA_RESEED_INTERVAL (1024 * 1024)
+
+static int
+getrandom_syscall(void *dst, size_t bytes)
+{
+#    ifdef SENTRY_HAVE_GETRANDOM
+    size_t to_read = bytes;
+    char *d = dst;
+    while (to_read > 0) {
+        ssize_t n = getrandom(d, to_read, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n <= 0) {
+            break;
+        }
+        d += n;
+        to_read -= n;
+    }
+    return to_read > 0;
+#    else
+    (void)dst;
+    (void)bytes;
+    return 1;
+#    endif
+}
+
+typedef struct {
+    uint32_t input[16];
+    uint8_t keystream[64];
+    size_t available;
+    size_t generated;
+    long generation;
+    bool seeded;
+} chacha_rng_t;
+
+static SENTRY_THREAD_LOCAL chacha_rng_t g_rng;
+static volatile long g_fork_generation = 0;
+static volatile long g_atfork_registered = 0;
+
+static void
+chacha_atfork_child(void)
+{
+    // a forked child starts with a copy of its parent's generator, which
+    // would repeat the parent's IDs unless it is reseeded
+    sentry__atomic_fetch_and_add(&g_fork_generation, 1);
+}
+
+#    define CHACHA_ROTL(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#    define CHACHA_QUARTERROUND(x, a, b, c, d)                                 \
+        x[a] += x[b];                                                          \
+        x[d] = CHACHA_ROTL(x[d] ^ x[a], 16);                                   \
+        x[c] += x[d];                                                          \
+        x[b] = CHACHA_ROTL(x[b] ^ x[c], 12);                                   \
+        x[a] += x[b];                                                          \
+        x[d] = CHACHA_ROTL(x[d] ^ x[a], 8);                                    \
+        x[c] += x[d];                                                          \
+        x[b] = CHACHA_ROTL(x[b] ^ x[c], 7)
+
+/**
+ * Produces the next ChaCha20 keystream block and rekeys the generator from it.
+ */
+static void
+chacha_block(chacha_rng_t *rng)
+{
+    uint32_t x[16];
+    memcpy(x, rng->input, sizeof(x));
+    for (int i = 0; i < 10; i++) {
+        CHACHA_QUARTERROUND(x, 0, 4, 8, 12);
+        CHACHA_QUARTERROUND(x, 1, 5, 9, 13);
+        CHACHA_QUARTERROUND(x, 2, 6, 10, 14);
+        CHACHA_QUARTERROUND(x, 3, 7, 11, 15);
+        CHACHA_QUARTERROUND(x, 0, 5, 10, 15);
+        CHACHA_QUARTERROUND(x, 1, 6, 11, 12);
+        CHACHA_QUARTERROUND(x, 2, 7, 8, 13);
+        CHACHA_QUARTERROUND(x, 3, 4, 9, 14);
+    }
+    for (int i = 0; i < 16; i++) {
+        uint32_t v = x[i] + rng->input[i];
+        rng->keystream[i * 4] = (uint8_t)v;
+        rng->keystream[i * 4 + 1] = (uint8_t)(v >> 8);
+        rng->keystream[i * 4 + 2] = (uint8_t)(v >> 16);
+        rng->keystream[i * 4 + 3] = (uint8_t)(v >> 24);
+    }
+    // the first half of every block replaces the key, so that bytes that have
+    // been handed out cannot be reconstructed from the generator's state
+    memcpy(&rng->input[4], rng->keystream, 32);
+    memset(rng->keystream, 0, 32);
+    rng->available = sizeof(rng->keystream) - 32;
+}
+
+static int
+chacha_seed(chacha_rng_t *rng)
+{
+    if (sentry__atomic_compare_swap(&g_atfork_registered, 0, 1)) {
+        pthread_atfork(NULL, NULL, chacha_atfork_child);
+    }
+    long generation = sentry__atomic_fetch(&g_fork_generation);
+
+    // "expand 32-byte k", followed by a random key, counter and nonce
+    uint32_t input[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+    if (getrandom_syscall(&input[4], sizeof(input) - 16) != 0
+        && getrandom_devurandom(&input[4], sizeof(input) - 16) != 0) {
+        return 1;
+    }
+    memcpy(rng->input, input, sizeof(input));
+    memset(input, 0, sizeof(input));
+    rng->available = 0;
+    rng->generated = 0;
+    rng->generation = generation;
+    rng->seeded = true;
+    return 0;
+}
+
+/**
+ * Fills `dst` from a per-thread ChaCha20 generator, which is seeded once from
+ * the kernel instead of reading from it for every ID, and reseeded after a
+ * fork and every `CHACHA_RESEED_INTERVAL` bytes.
+ */
+static int
+getrandom_chacha(void *dst, size_t bytes)
+{
+    chacha_rng_t *rng = &g_rng;
+    if (!rng->seeded || rng->generated >= CHACHA_RESEED_INTERVAL
+        || rng->generation != sentry__atomic_fetch(&g_fork_generation)) {
+        if (chacha_seed(rng) != 0) {
+            return 1;
+        }
+    }
+
+    char *d = dst;
+    while (bytes > 0) {
+        if (rng->available == 0) {
+            chacha_block(rng);
+        }
+        size_t offset = sizeof(rng->keystream) - rng->available;
+        size_t n = MIN(bytes, rng->available);
+        memcpy(d, rng->keystream + offset, n);
+        memset(rng->keystream + offset, 0, n);
+        rng->available -= n;
+        rng->generated += n;
+        d += n;
+        bytes -= n;
+    }
+    return 0;
+}
+
+#    define HAVE_CHACHA
+#endif
 #ifdef SENTRY_PLATFORM_WINDOWS
 typedef BOOLEAN(WINAPI *sRtlGenRandom)(PVOID Buffer, ULONG BufferLength);
 
@@ -84,6 +245,11 @@ sentry__getrandom(void *dst, size_t len)
         return 0;
     }
 #endif
+#ifdef HAVE_CHACHA
+    if (getrandom_chacha(dst, len) == 0) {
+        return 0;
+    }
+#endif
 #ifdef HAVE_URANDOM
     if (getrandom_devurandom(dst, len) == 0) {
         return 0;
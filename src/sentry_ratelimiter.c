@@ -1,11 +1,14 @@
 #include "sentry_ratelimiter.h"
 #include "sentry_alloc.h"
 #include "sentry_slice.h"
+#include "sentry_sync.h"
 #include "sentry_utils.h"
 
 #define MAX_RATE_LIMITS 4
 
 struct sentry_rate_limiter_s {
+    // the HTTP transport can update the limits from concurrent requests
+    sentry_mutex_t lock;
     uint64_t disabled_until[MAX_RATE_LIMITS];
 };
 
@@ -14,6 +17,7 @@ sentry__rate_limiter_new(void)
 {
     sentry_rate_limiter_t *rl = SENTRY_MAKE(sentry_rate_limiter_t);
     if (rl) {
+        sentry__mutex_init(&rl->lock);
         rl->disabled_until[SENTRY_RL_CATEGORY_ANY] = 0;
         rl->disabled_until[SENTRY_RL_CATEGORY_ERROR] = 0;
         rl->disabled_until[SENTRY_RL_CATEGORY_SESSION] = 0;
@@ -22,9 +26,8 @@ sentry__rate_limiter_new(void)
     return rl;
 }
 
-bool
-sentry__rate_limiter_update_from_header(
-    sentry_rate_limiter_t *rl, const char *sentry_header)
+static bool
+update_from_header(sentry_rate_limiter_t *rl, const char *sentry_header)
 {
     sentry_slice_t slice = sentry__slice_from_str(sentry_header);
 
@@ -72,6 +75,16 @@ sentry__rate_limiter_update_from_header(
     return true;
 }
 
+bool
+sentry__rate_limiter_update_from_header(
+    sentry_rate_limiter_t *rl, const char *sentry_header)
+{
+    sentry__mutex_lock(&rl->lock);
+    bool rv = update_from_header(rl, sentry_header);
+    sentry__mutex_unlock(&rl->lock);
+    return rv;
+}
+
 bool
 sentry__rate_limiter_update_from_http_retry_after(
     sentry_rate_limiter_t *rl, const char *retry_after)
@@ -79,16 +92,20 @@ sentry__rate_limiter_update_from_http_retry_after(
     sentry_slice_t slice = sentry__slice_from_str(retry_after);
     uint64_t eta = 60;
     sentry__slice_consume_uint64(&slice, &eta);
+    sentry__mutex_lock(&rl->lock);
     rl->disabled_until[SENTRY_RL_CATEGORY_ANY]
         = sentry__monotonic_time() + eta * 1000;
+    sentry__mutex_unlock(&rl->lock);
     return true;
 }
 
 bool
 sentry__rate_limiter_update_from_429(sentry_rate_limiter_t *rl)
 {
+    sentry__mutex_lock(&rl->lock);
     rl->disabled_until[SENTRY_RL_CATEGORY_ANY]
         = sentry__monotonic_time() + 60 * 1000;
+    sentry__mutex_unlock(&rl->lock);
     return true;
 }
 
@@ -96,8 +113,12 @@ bool
 sentry__rate_limiter_is_disabled(const sentry_rate_limiter_t *rl, int category)
 {
     uint64_t now = sentry__monotonic_time();
-    return rl->disabled_until[SENTRY_RL_CATEGORY_ANY] > now
+    sentry_mutex_t *lock = (sentry_mutex_t *)&rl->lock;
+    sentry__mutex_lock(lock);
+    bool disabled = rl->disabled_until[SENTRY_RL_CATEGORY_ANY] > now
         || rl->disabled_until[category] > now;
+    sentry__mutex_unlock(lock);
+    return disabled;
 }
 
 void
@@ -106,6 +127,7 @@ sentry__rate_limiter_free(sentry_rate_limiter_t *rl)
     if (!rl) {
         return;
     }
+    sentry__mutex_free(&rl->lock);
     sentry_free(rl);
 }
 
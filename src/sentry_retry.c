@@ -4,14 +4,19 @@
 #include "sentry_envelope.h"
 #include "sentry_logger.h"
 #include "sentry_options.h"
+#include "sentry_string.h"
 #include "sentry_utils.h"
+#include "sentry_uuid.h"
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define SENTRY_RETRY_ATTEMPTS 6
 #define SENTRY_RETRY_INTERVAL (15 * 60 * 1000)
 #define SENTRY_RETRY_THROTTLE 100
+#define SENTRY_RETRY_BATCH_SIZE (256 * 1024)
+#define SENTRY_RETRY_MAX_CONCURRENCY 8
 
 typedef enum {
     SENTRY_RETRY_STARTUP = 0,
@@ -25,6 +30,23 @@ typedef enum {
     SENTRY_POLL_SHUTDOWN = 2
 } sentry_poll_state_t;
 
+// The retry index is a min-heap of retry files ordered by the time their next
+// attempt is due. It is persisted as an append-only journal of retry
+// filenames in the cache directory, so that polls only need to pop the due
+// entries instead of rescanning the directory, and a new index is restored by
+// replaying the journal.
+#define SENTRY_RETRY_JOURNAL_MAGIC "sentry-retry-journal "
+#define SENTRY_RETRY_JOURNAL_HEADER_LEN                                        \
+    (sizeof(SENTRY_RETRY_JOURNAL_MAGIC) - 1 + 36 + 1)
+#define SENTRY_RETRY_JOURNAL_SLACK 64
+
+typedef struct {
+    uint64_t due;
+    uint64_t ts;
+    int count;
+    char uuid[37];
+} retry_item_t;
+
 struct sentry_retry_s {
     sentry_run_t *run;
     bool cache_keep;
@@ -33,8 +55,17 @@ struct sentry_retry_s {
     volatile long scheduled;
     sentry_bgworker_t *bgworker;
     sentry_retry_send_func_t send_cb;
+    sentry_retry_send_batch_func_t send_batch_cb;
+    size_t concurrency;
     void *send_data;
     sentry_mutex_t sealed_lock;
+    sentry_mutex_t index_lock;
+    retry_item_t *items;
+    size_t num_items;
+    size_t items_capacity;
+    size_t journal_size;
+    size_t journal_records;
+    char journal_header[SENTRY_RETRY_JOURNAL_HEADER_LEN + 1];
 };
 
 sentry_retry_t *
@@ -45,6 +76,7 @@ sentry__retry_new(const sentry_options_t *options)
         return NULL;
     }
     sentry__mutex_init(&retry->sealed_lock);
+    sentry__mutex_init(&retry->index_lock);
     retry->run = sentry__run_incref(options->run);
     retry->cache_keep = options->cache_keep;
     retry->startup_time = sentry__usec_time() / 1000;
@@ -58,7 +90,9 @@ sentry__retry_free(sentry_retry_t *retry)
         return;
     }
     sentry__mutex_free(&retry->sealed_lock);
+    sentry__mutex_free(&retry->index_lock);
     sentry__run_free(retry->run);
+    sentry_free(retry->items);
     sentry_free(retry);
 }
 
@@ -70,13 +104,6 @@ sentry__retry_backoff(int count)
     return (uint64_t)SENTRY_RETRY_INTERVAL << MIN(MAX(count, 0), 5);
 }
 
-typedef struct {
-    sentry_path_t *path;
-    uint64_t ts;
-    int count;
-    char uuid[37];
-} retry_item_t;
-
 static int
 compare_retry_items(const void *a, const void *b)
 {
@@ -91,24 +118,295 @@ compare_retry_items(const void *a, const void *b)
     return strcmp(ia->uuid, ib->uuid);
 }
 
+static bool
+item_before(const retry_item_t *a, const retry_item_t *b)
+{
+    if (a->due != b->due) {
+        return a->due < b->due;
+    }
+    return compare_retry_items(a, b) < 0;
+}
+
+static void
+index_sift_down(sentry_retry_t *retry, size_t i)
+{
+    retry_item_t *items = retry->items;
+    while (true) {
+        size_t smallest = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < retry->num_items
+            && item_before(&items[left], &items[smallest])) {
+            smallest = left;
+        }
+        if (right < retry->num_items
+            && item_before(&items[right], &items[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        retry_item_t tmp = items[i];
+        items[i] = items[smallest];
+        items[smallest] = tmp;
+        i = smallest;
+    }
+}
+
+static bool
+index_push(sentry_retry_t *retry, const retry_item_t *item)
+{
+    if (retry->num_items == retry->items_capacity) {
+        size_t capacity
+            = retry->items_capacity ? retry->items_capacity * 2 : 16;
+        retry_item_t *items = sentry_malloc(capacity * sizeof(retry_item_t));
+        if (!items) {
+            return false;
+        }
+        if (retry->num_items) {
+            memcpy(
+                items, retry->items, retry->num_items * sizeof(retry_item_t));
+        }
+        sentry_free(retry->items);
+        retry->items = items;
+        retry->items_capacity = capacity;
+    }
+
+    retry_item_t *items = retry->items;
+    size_t i = retry->num_items++;
+    items[i] = *item;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!item_before(&items[i], &items[parent])) {
+            break;
+        }
+        retry_item_t tmp = items[i];
+        items[i] = items[parent];
+        items[parent] = tmp;
+        i = parent;
+    }
+    return true;
+}
+
+static void
+index_pop(sentry_retry_t *retry, retry_item_t *item_out)
+{
+    *item_out = retry->items[0];
+    retry->items[0] = retry->items[--retry->num_items];
+    index_sift_down(retry, 0);
+}
+
+static void
+index_heapify(sentry_retry_t *retry)
+{
+    for (size_t i = retry->num_items / 2; i > 0; i--) {
+        index_sift_down(retry, i - 1);
+    }
+}
+
+/**
+ * Drops duplicate items and restores the heap order.
+ */
+static void
+index_unique(sentry_retry_t *retry)
+{
+    if (retry->num_items < 2) {
+        return;
+    }
+    qsort(retry->items, retry->num_items, sizeof(retry_item_t),
+        compare_retry_items);
+    retry_item_t *items = retry->items;
+    size_t n = 1;
+    for (size_t i = 1; i < retry->num_items; i++) {
+        if (compare_retry_items(&items[n - 1], &items[i]) != 0) {
+            items[n++] = items[i];
+        }
+    }
+    retry->num_items = n;
+    index_heapify(retry);
+}
+
+static bool
+index_add_filename(sentry_retry_t *retry, const char *filename)
+{
+    uint64_t ts;
+    int count;
+    const char *uuid;
+    if (!sentry__parse_cache_filename(filename, &ts, &count, &uuid)
+        || count < 0) {
+        return false;
+    }
+    retry_item_t item;
+    item.due = ts + sentry__retry_backoff(count);
+    item.ts = ts;
+    item.count = count;
+    memcpy(item.uuid, uuid, 36);
+    item.uuid[36] = '\0';
+    return index_push(retry, &item);
+}
+
+/**
+ * Adds the records of a journal chunk to the index and returns the number of
+ * bytes consumed. A trailing partial record is left for the next replay.
+ *
+ * A file can be listed twice: a rebuild carries over the records that were
+ * appended while it scanned the cache directory, and may have indexed their
+ * files already. Such duplicates are dropped, so that no file is sent twice.
+ */
+static size_t
+replay_journal(sentry_retry_t *retry, char *buf, size_t len)
+{
+    size_t records = retry->journal_records;
+    size_t consumed = 0;
+    while (consumed < len) {
+        char *record = buf + consumed;
+        char *end = memchr(record, '\n', len - consumed);
+        if (!end) {
+            break;
+        }
+        *end = '\0';
+        if (index_add_filename(retry, record)) {
+            retry->journal_records++;
+        }
+        consumed = (size_t)(end - buf) + 1;
+    }
+    if (retry->journal_records != records) {
+        index_unique(retry);
+    }
+    return consumed;
+}
+
+static void
+write_journal(sentry_retry_t *retry, size_t consumed)
+{
+    sentry_stringbuilder_t sb;
+    sentry__stringbuilder_init(&sb);
+    sentry__stringbuilder_append(&sb, retry->journal_header);
+    for (size_t i = 0; i < retry->num_items; i++) {
+        const retry_item_t *item = &retry->items[i];
+        sentry_path_t *path = sentry__run_make_cache_path(
+            retry->run, item->ts, item->count, item->uuid);
+        if (path) {
+            sentry__stringbuilder_append(&sb, sentry__path_filename(path));
+            sentry__stringbuilder_append_char(&sb, '\n');
+            sentry__path_free(path);
+        }
+    }
+
+    size_t len = sentry__stringbuilder_len(&sb);
+    char *buf = sentry__stringbuilder_into_string(&sb);
+    if (buf
+        && sentry__run_rewrite_retry_journal(retry->run, buf, len, consumed)) {
+        retry->journal_size = len;
+    } else {
+        // the next sync starts over with a directory scan
+        retry->journal_header[0] = '\0';
+        retry->journal_size = 0;
+    }
+    retry->journal_records = retry->num_items;
+    sentry_free(buf);
+}
+
+/**
+ * Rebuilds the index from a scan of the cache directory and starts a new
+ * journal. Used when the journal is missing or belongs to someone else.
+ */
+static void
+rebuild_index(sentry_retry_t *retry)
+{
+    size_t consumed = sentry__path_get_size(retry->run->retry_journal_path);
+    retry->num_items = 0;
+
+    sentry_pathiter_t *piter
+        = sentry__path_iter_directory(retry->run->cache_path);
+    const sentry_path_t *p;
+    while (piter && (p = sentry__pathiter_next(piter)) != NULL) {
+        index_add_filename(retry, sentry__path_filename(p));
+    }
+    sentry__pathiter_free(piter);
+
+    sentry_uuid_t generation = sentry_uuid_new_v4();
+    char uuid[37];
+    sentry_uuid_as_string(&generation, uuid);
+    snprintf(retry->journal_header, sizeof(retry->journal_header), "%s%s\n",
+        SENTRY_RETRY_JOURNAL_MAGIC, uuid);
+    write_journal(retry, consumed);
+}
+
+/**
+ * Brings the index up to date with the journal. Only the records appended
+ * since the last sync are replayed; an unchanged journal costs a single stat.
+ */
+static void
+sync_index(sentry_retry_t *retry)
+{
+    const sentry_path_t *journal_path = retry->run->retry_journal_path;
+    bool loaded = retry->journal_header[0] != '\0';
+    if (loaded && sentry__path_get_size(journal_path) == retry->journal_size) {
+        return;
+    }
+
+    size_t size = 0;
+    char *buf = sentry__path_read_to_buffer(journal_path, &size);
+    if (!buf || size < SENTRY_RETRY_JOURNAL_HEADER_LEN) {
+        rebuild_index(retry);
+    } else if (loaded && size >= retry->journal_size
+        && memcmp(buf, retry->journal_header, SENTRY_RETRY_JOURNAL_HEADER_LEN)
+            == 0) {
+        retry->journal_size += replay_journal(
+            retry, buf + retry->journal_size, size - retry->journal_size);
+    } else if (!loaded
+        && strncmp(buf, SENTRY_RETRY_JOURNAL_MAGIC,
+               sizeof(SENTRY_RETRY_JOURNAL_MAGIC) - 1)
+            == 0
+        && buf[SENTRY_RETRY_JOURNAL_HEADER_LEN - 1] == '\n') {
+        // a journal left by a previous run: restore the index from it
+        memcpy(retry->journal_header, buf, SENTRY_RETRY_JOURNAL_HEADER_LEN);
+        retry->journal_header[SENTRY_RETRY_JOURNAL_HEADER_LEN] = '\0';
+        retry->num_items = 0;
+        retry->journal_records = 0;
+        retry->journal_size = SENTRY_RETRY_JOURNAL_HEADER_LEN
+            + replay_journal(retry, buf + SENTRY_RETRY_JOURNAL_HEADER_LEN,
+                size - SENTRY_RETRY_JOURNAL_HEADER_LEN);
+    } else {
+        rebuild_index(retry);
+    }
+    sentry_free(buf);
+
+    // drop the records of files that were retried meanwhile
+    if (retry->journal_header[0]
+        && retry->journal_records
+            > 2 * retry->num_items + SENTRY_RETRY_JOURNAL_SLACK) {
+        write_journal(retry, retry->journal_size);
+    }
+}
+
 static bool
 handle_result(sentry_retry_t *retry, const retry_item_t *item, int status_code)
 {
     // Only network failures (status_code < 0) trigger retries. HTTP responses
     // including 5xx (500, 502, 503, 504) are discarded:
     // https://develop.sentry.dev/sdk/foundations/transport/offline-caching/#dealing-with-network-failures
+    sentry_path_t *path = sentry__run_make_cache_path(
+        retry->run, item->ts, item->count, item->uuid);
+    if (!path) {
+        return false;
+    }
 
     // network failure with retries remaining: bump count & re-enqueue
     if (item->count + 1 < SENTRY_RETRY_ATTEMPTS && status_code < 0) {
         sentry_path_t *new_path = sentry__run_make_cache_path(retry->run,
             sentry__usec_time() / 1000, item->count + 1, item->uuid);
         if (new_path) {
-            if (sentry__path_rename(item->path, new_path) != 0) {
+            if (sentry__path_rename(path, new_path) != 0) {
                 SENTRY_WARNF(
-                    "failed to rename retry envelope \"%s\"", item->path->path);
+                    "failed to rename retry envelope \"%s\"", path->path);
+            } else {
+                sentry__run_journal_retry(retry->run, new_path);
             }
             sentry__path_free(new_path);
         }
+        sentry__path_free(path);
         return true;
     }
 
@@ -127,114 +425,257 @@ handle_result(sentry_retry_t *retry, const retry_item_t *item, int status_code)
 
     // cache on last attempt
     if (exhausted && retry->cache_keep && status_code < 0) {
-        if (!sentry__run_move_cache(retry->run, item->path, -1)) {
-            sentry__cache_remove_envelope(item->path);
+        if (!sentry__run_move_cache(retry->run, path, -1)) {
+            sentry__cache_remove_envelope(path);
         }
-        return false;
+    } else {
+        sentry__cache_remove_envelope(path);
     }
-
-    sentry__cache_remove_envelope(item->path);
+    sentry__path_free(path);
     return false;
 }
 
-size_t
-sentry__retry_send(sentry_retry_t *retry, uint64_t before,
-    sentry_retry_send_func_t send_cb, void *data)
+/**
+ * Takes the entries to send out of the index: everything older than `before`,
+ * or with `before == 0` the entries whose backoff has elapsed. Returns the
+ * number of entries still pending, including the taken ones.
+ */
+static size_t
+take_eligible_items(sentry_retry_t *retry, uint64_t before,
+    retry_item_t **items_out, size_t *eligible_out)
 {
-    if (sentry__run_should_skip_upload(retry->run)) {
-        return 1; // keep the poll alive until consent is given
+    sentry__mutex_lock(&retry->index_lock);
+    sync_index(retry);
+
+    size_t eligible = 0;
+    size_t total = 0;
+    retry_item_t *items = NULL;
+    if (before > 0) {
+        items = retry->num_items
+            ? sentry_malloc(retry->num_items * sizeof(retry_item_t))
+            : NULL;
+        if (items) {
+            size_t kept = 0;
+            for (size_t i = 0; i < retry->num_items; i++) {
+                if (retry->items[i].ts < before) {
+                    items[eligible++] = retry->items[i];
+                } else {
+                    retry->items[kept++] = retry->items[i];
+                }
+            }
+            retry->num_items = kept;
+            index_heapify(retry);
+        }
+        total = eligible;
+    } else {
+        uint64_t now = sentry__usec_time() / 1000;
+        size_t item_cap = 0;
+        while (retry->num_items && retry->items[0].due <= now) {
+            if (eligible == item_cap) {
+                item_cap = item_cap ? item_cap * 2 : 16;
+                retry_item_t *tmp
+                    = sentry_malloc(item_cap * sizeof(retry_item_t));
+                if (!tmp) {
+                    break;
+                }
+                if (eligible) {
+                    memcpy(tmp, items, eligible * sizeof(retry_item_t));
+                }
+                sentry_free(items);
+                items = tmp;
+            }
+            index_pop(retry, &items[eligible++]);
+        }
+        total = eligible + retry->num_items;
     }
+    sentry__mutex_unlock(&retry->index_lock);
 
-    sentry_pathiter_t *piter
-        = sentry__path_iter_directory(retry->run->cache_path);
-    if (!piter) {
-        return 0;
+    *items_out = items;
+    *eligible_out = eligible;
+    return total;
+}
+
+/**
+ * Loads the envelope of a retry item. Small envelopes are materialized, so
+ * that the ones with standalone items can be combined with others.
+ */
+static sentry_envelope_t *
+load_item(sentry_retry_t *retry, const retry_item_t *item)
+{
+    sentry_path_t *path = sentry__run_make_cache_path(
+        retry->run, item->ts, item->count, item->uuid);
+    if (!path) {
+        return NULL;
     }
+    sentry_envelope_t *envelope = sentry__envelope_from_path(path);
+    if (!envelope) {
+        // journal records outlive files that were retried or removed by the
+        // cache cleanup meanwhile; only discard unreadable files
+        if (sentry__path_is_file(path)) {
+            sentry__cache_remove_envelope(path);
+        }
+    } else if (sentry__path_get_size(path) <= SENTRY_RETRY_BATCH_SIZE
+        && !sentry__envelope_materialize(envelope)) {
+        // send malformed envelopes as they are
+        sentry_envelope_free(envelope);
+        envelope = sentry__envelope_from_path(path);
+    }
+    sentry__path_free(path);
+    if (envelope) {
+        SENTRY_DEBUGF("retrying envelope (%d/%d)", item->count + 1,
+            SENTRY_RETRY_ATTEMPTS);
+    }
+    return envelope;
+}
+
+typedef struct {
+    sentry_envelope_t *envelope;
+    size_t first;
+    size_t last;
+} retry_group_t;
 
-    size_t item_cap = 16;
-    retry_item_t *items = sentry_malloc(item_cap * sizeof(retry_item_t));
-    if (!items) {
-        sentry__pathiter_free(piter);
-        return 0;
+size_t
+sentry__retry_send_batch(sentry_retry_t *retry, uint64_t before,
+    sentry_retry_send_batch_func_t send_batch_cb, size_t concurrency,
+    void *data)
+{
+    if (sentry__run_should_skip_upload(retry->run)) {
+        return 1; // keep the poll alive until consent is given
     }
 
-    size_t total = 0;
-    size_t eligible = 0;
-    uint64_t now = before > 0 ? 0 : sentry__usec_time() / 1000;
+    retry_item_t *items;
+    size_t eligible;
+    size_t total = take_eligible_items(retry, before, &items, &eligible);
 
-    const sentry_path_t *p;
-    while ((p = sentry__pathiter_next(piter)) != NULL) {
-        const char *fname = sentry__path_filename(p);
-        uint64_t ts;
-        int count;
-        const char *uuid;
-        if (!sentry__parse_cache_filename(fname, &ts, &count, &uuid)
-            || count < 0) {
-            continue;
-        }
-        if (before > 0 && ts >= before) {
-            continue;
-        }
-        total++;
-        if (!before
-            && (now < ts || (now - ts) < sentry__retry_backoff(count))) {
-            continue;
-        }
-        if (eligible == item_cap) {
-            item_cap *= 2;
-            retry_item_t *tmp = sentry_malloc(item_cap * sizeof(retry_item_t));
-            if (!tmp) {
+    if (eligible > 1) {
+        qsort(items, eligible, sizeof(retry_item_t), compare_retry_items);
+    }
+    concurrency = MIN(MAX(concurrency, 1), SENTRY_RETRY_MAX_CONCURRENCY);
+
+    // Items are loaded in order and combined into up to `concurrency` groups
+    // per round. The items that were loaded are compacted to the front of
+    // `items`, so that every group covers the range [first, last).
+    retry_group_t groups[SENTRY_RETRY_MAX_CONCURRENCY];
+    sentry_envelope_t *envelopes[SENTRY_RETRY_MAX_CONCURRENCY];
+    int status_codes[SENTRY_RETRY_MAX_CONCURRENCY];
+    sentry_envelope_t *held = NULL;
+    size_t loaded = 0;
+    size_t next = 0;
+    bool failed = false;
+    while (!failed && (held || next < eligible)) {
+        size_t num_groups = 0;
+        while (true) {
+            sentry_envelope_t *envelope = held;
+            held = NULL;
+            if (!envelope) {
+                if (next == eligible) {
+                    break;
+                }
+                items[loaded] = items[next++];
+                envelope = load_item(retry, &items[loaded]);
+                if (!envelope) {
+                    total--;
+                    continue;
+                }
+                loaded++;
+            }
+            retry_group_t *group = num_groups ? &groups[num_groups - 1] : NULL;
+            if (group
+                && sentry__envelope_coalesce(
+                    group->envelope, envelope, SENTRY_RETRY_BATCH_SIZE)) {
+                group->last = loaded;
+                sentry_envelope_free(envelope);
+                continue;
+            }
+            if (num_groups == concurrency) {
+                held = envelope;
                 break;
             }
-            memcpy(tmp, items, eligible * sizeof(retry_item_t));
-            sentry_free(items);
-            items = tmp;
+            group = &groups[num_groups++];
+            group->envelope = envelope;
+            group->first = loaded - 1;
+            group->last = loaded;
         }
-        retry_item_t *item = &items[eligible];
-        item->path = sentry__path_clone(p);
-        if (!item->path) {
+        if (!num_groups) {
             break;
         }
-        item->ts = ts;
-        item->count = count;
-        memcpy(item->uuid, uuid, 36);
-        item->uuid[36] = '\0';
-        eligible++;
-    }
-    sentry__pathiter_free(piter);
-
-    if (eligible > 1) {
-        qsort(items, eligible, sizeof(retry_item_t), compare_retry_items);
-    }
 
-    for (size_t i = 0; i < eligible; i++) {
-        sentry_envelope_t *envelope = sentry__envelope_from_path(items[i].path);
-        if (!envelope) {
-            sentry__cache_remove_envelope(items[i].path);
-            total--;
-        } else {
-            SENTRY_DEBUGF("retrying envelope (%d/%d)", items[i].count + 1,
-                SENTRY_RETRY_ATTEMPTS);
-            int status_code = send_cb(envelope, data);
-            sentry_envelope_free(envelope);
-            if (!handle_result(retry, &items[i], status_code)) {
-                total--;
+        for (size_t g = 0; g < num_groups; g++) {
+            envelopes[g] = groups[g].envelope;
+            status_codes[g] = 0;
+            if (groups[g].last - groups[g].first > 1) {
+                SENTRY_DEBUGF("retrying %zu envelopes in one request",
+                    groups[g].last - groups[g].first);
+            }
+        }
+        send_batch_cb(envelopes, status_codes, num_groups, data);
+
+        // every envelope of a group shares the result of its request
+        for (size_t g = 0; g < num_groups; g++) {
+            int status_code = status_codes[g];
+            for (size_t j = groups[g].first; j < groups[g].last; j++) {
+                if (!handle_result(retry, &items[j], status_code)) {
+                    total--;
+                }
             }
+            sentry_envelope_free(groups[g].envelope);
             // stop on network failure to avoid wasting time on a dead
             // connection; remaining envelopes stay untouched for later
             if (status_code < 0) {
-                break;
+                failed = true;
             }
         }
     }
 
-    for (size_t i = 0; i < eligible; i++) {
-        sentry__path_free(items[i].path);
+    sentry__mutex_lock(&retry->index_lock);
+    if (held) {
+        sentry_envelope_free(held);
+        index_push(retry, &items[loaded - 1]);
+    }
+    for (; next < eligible; next++) {
+        index_push(retry, &items[next]);
     }
+    sentry__mutex_unlock(&retry->index_lock);
     sentry_free(items);
     return total;
 }
 
+typedef struct {
+    sentry_retry_send_func_t send_cb;
+    void *data;
+} retry_send_each_t;
+
+static void
+send_each(sentry_envelope_t **envelopes, int *status_codes, size_t count,
+    void *_each)
+{
+    retry_send_each_t *each = _each;
+    for (size_t i = 0; i < count; i++) {
+        status_codes[i] = each->send_cb(envelopes[i], each->data);
+    }
+}
+
+size_t
+sentry__retry_send(sentry_retry_t *retry, uint64_t before,
+    sentry_retry_send_func_t send_cb, void *data)
+{
+    retry_send_each_t each = { send_cb, data };
+    return sentry__retry_send_batch(retry, before, send_each, 1, &each);
+}
+
+/**
+ * Sends the eligible retry files with the callbacks of `sentry__retry_start`.
+ */
+static size_t
+retry_drain(sentry_retry_t *retry, uint64_t before)
+{
+    if (retry->send_batch_cb) {
+        return sentry__retry_send_batch(retry, before, retry->send_batch_cb,
+            retry->concurrency, retry->send_data);
+    }
+    return sentry__retry_send(retry, before, retry->send_cb, retry->send_data);
+}
+
 static void
 retry_poll_task(void *_retry, void *_state)
 {
@@ -247,7 +688,7 @@ retry_poll_task(void *_retry, void *_state)
     // CAS instead of unconditional store to preserve SENTRY_POLL_SHUTDOWN
     sentry__atomic_compare_swap(
         &retry->scheduled, SENTRY_POLL_SCHEDULED, SENTRY_POLL_IDLE);
-    if (sentry__retry_send(retry, before, retry->send_cb, retry->send_data)
+    if (retry_drain(retry, before)
         && sentry__atomic_compare_swap(
             &retry->scheduled, SENTRY_POLL_IDLE, SENTRY_POLL_SCHEDULED)) {
         sentry__bgworker_submit_delayed(retry->bgworker, retry_poll_task, NULL,
@@ -270,13 +711,20 @@ sentry__retry_start(sentry_retry_t *retry, sentry_bgworker_t *bgworker,
         bgworker, retry_poll_task, NULL, retry, SENTRY_RETRY_THROTTLE);
 }
 
+void
+sentry__retry_set_send_batch(sentry_retry_t *retry,
+    sentry_retry_send_batch_func_t send_batch_cb, size_t concurrency)
+{
+    retry->send_batch_cb = send_batch_cb;
+    retry->concurrency = concurrency;
+}
+
 static void
 retry_flush_task(void *_retry, void *_state)
 {
     (void)_state;
     sentry_retry_t *retry = _retry;
-    sentry__retry_send(
-        retry, retry->startup_time, retry->send_cb, retry->send_data);
+    retry_drain(retry, retry->startup_time);
 }
 
 static bool
@@ -315,7 +763,7 @@ retry_trigger_task(void *_retry, void *_state)
 {
     (void)_state;
     sentry_retry_t *retry = _retry;
-    sentry__retry_send(retry, UINT64_MAX, retry->send_cb, retry->send_data);
+    retry_drain(retry, UINT64_MAX);
 }
 
 void
@@ -10,6 +10,13 @@ typedef struct sentry_retry_s sentry_retry_t;
 typedef int (*sentry_retry_send_func_t)(
     sentry_envelope_t *envelope, void *data);
 
+/**
+ * Sends `count` envelopes, possibly concurrently, and stores the result of
+ * each one in `status_codes`. Returns once all of them have been sent.
+ */
+typedef void (*sentry_retry_send_batch_func_t)(sentry_envelope_t **envelopes,
+    int *status_codes, size_t count, void *data);
+
 sentry_retry_t *sentry__retry_new(const sentry_options_t *options);
 void sentry__retry_free(sentry_retry_t *retry);
 
@@ -19,6 +26,14 @@ void sentry__retry_free(sentry_retry_t *retry);
 void sentry__retry_start(sentry_retry_t *retry, sentry_bgworker_t *bgworker,
     sentry_retry_send_func_t send_cb, void *send_data);
 
+/**
+ * Drains the retry backlog with `send_batch_cb`, which sends up to
+ * `concurrency` envelopes at once, instead of the `send_cb` of
+ * `sentry__retry_start`. Must be called before the first poll is due.
+ */
+void sentry__retry_set_send_batch(sentry_retry_t *retry,
+    sentry_retry_send_batch_func_t send_batch_cb, size_t concurrency);
+
 /**
  * Prepares retry for shutdown: drops pending polls and submits a flush task.
  */
@@ -38,11 +53,22 @@ bool sentry__retry_enqueue(
 /**
  * Sends eligible retry files via `send_cb`. `before > 0`: send files with
  * ts < before (startup). `before == 0`: use backoff. Returns remaining file
- * count for controlling polling.
+ * count for controlling polling. The files are looked up in the retry index,
+ * which replays the retry journal instead of rescanning the cache directory.
  */
 size_t sentry__retry_send(sentry_retry_t *retry, uint64_t before,
     sentry_retry_send_func_t send_cb, void *data);
 
+/**
+ * Like `sentry__retry_send`, but combines envelopes that only contain
+ * standalone items, such as logs or sessions, into size-capped envelopes,
+ * and sends up to `concurrency` of those per `send_batch_cb` call. The result
+ * of a combined request applies to each of the envelopes it contains.
+ */
+size_t sentry__retry_send_batch(sentry_retry_t *retry, uint64_t before,
+    sentry_retry_send_batch_func_t send_batch_cb, size_t concurrency,
+    void *data);
+
 /**
  * Exponential backoff: 15m, 30m, 1h, 2h, 4h, 8h, 8h, ... (capped at 8h).
  */
@@ -3,6 +3,7 @@
 #include "sentry_attachment.h"
 #include "sentry_backend.h"
 #include "sentry_core.h"
+#include "sentry_cpu_relax.h"
 #include "sentry_database.h"
 #include "sentry_options.h"
 #include "sentry_os.h"
@@ -31,6 +32,14 @@ SENTRY__MUTEX_INIT_DYN(g_lock)
 static sentry_mutex_t g_lock = SENTRY__MUTEX_INIT;
 #endif
 
+// (atomic) incremented whenever the global scope is locked for modification
+static long g_scope_version = 0;
+// The published attribute snapshot, guarded by `g_attributes_lock`. This is a
+// spinlock rather than a mutex, since it is only ever held to swap the pointer
+// or to increment the refcount of the snapshot it points to.
+static sentry_scope_attributes_t *g_attributes = NULL;
+static long g_attributes_lock = 0; // (atomic) spinlock
+
 static sentry_value_t
 get_client_sdk(void)
 {
@@ -126,6 +135,8 @@ cleanup_scope(sentry_scope_t *scope)
     sentry__span_decref(scope->span);
 }
 
+static void publish_attributes(sentry_scope_attributes_t *snapshot);
+
 void
 sentry__scope_cleanup(void)
 {
@@ -135,6 +146,8 @@ sentry__scope_cleanup(void)
         g_scope_initialized = false;
         cleanup_scope(&g_scope);
     }
+    sentry__atomic_fetch_and_add(&g_scope_version, 1);
+    publish_attributes(NULL);
     sentry__mutex_unlock(&g_lock);
 }
 
@@ -146,6 +159,16 @@ sentry__scope_lock(void)
     return get_scope();
 }
 
+sentry_scope_t *
+sentry__scope_lock_mut(void)
+{
+    sentry_scope_t *scope = sentry__scope_lock();
+    // Snapshots are only built while holding the lock, so bumping the version
+    // up front is enough to keep modifications from being missed.
+    sentry__atomic_fetch_and_add(&g_scope_version, 1);
+    return scope;
+}
+
 void
 sentry__scope_unlock(void)
 {
@@ -768,3 +791,138 @@ sentry__scope_apply_attributes(const sentry_scope_t *scope,
         }
     }
 }
+
+static inline void
+lock_attributes(void)
+{
+    while (!sentry__atomic_compare_swap(&g_attributes_lock, 0, 1)) {
+        sentry__cpu_relax();
+    }
+}
+
+static inline void
+unlock_attributes(void)
+{
+    sentry__atomic_store(&g_attributes_lock, 0);
+}
+
+static sentry_scope_attributes_t *
+acquire_attributes(void)
+{
+    lock_attributes();
+    sentry_scope_attributes_t *snapshot = g_attributes;
+    if (snapshot) {
+        sentry__atomic_fetch_and_add(&snapshot->refcount, 1);
+    }
+    unlock_attributes();
+    return snapshot;
+}
+
+/**
+ * Replaces the published snapshot, taking ownership of `snapshot`.
+ */
+static void
+publish_attributes(sentry_scope_attributes_t *snapshot)
+{
+    lock_attributes();
+    sentry_scope_attributes_t *old = g_attributes;
+    g_attributes = snapshot;
+    unlock_attributes();
+    sentry__scope_attributes_decref(old);
+}
+
+static sentry_scope_attributes_t *
+build_attributes(const sentry_scope_t *scope, const sentry_options_t *options,
+    long version)
+{
+    sentry_scope_attributes_t *snapshot
+        = SENTRY_MAKE(sentry_scope_attributes_t);
+    if (!snapshot) {
+        return NULL;
+    }
+    snapshot->refcount = 1;
+    snapshot->version = version;
+
+    sentry_value_t telemetry = sentry_value_new_object();
+    sentry_value_t attributes = sentry_value_new_object();
+    sentry__scope_apply_attributes(scope, telemetry, attributes);
+    if (scope->environment) {
+        sentry__value_add_attribute(attributes,
+            sentry_value_new_string(scope->environment), "string",
+            "sentry.environment");
+    }
+    if (scope->release) {
+        sentry__value_add_attribute(attributes,
+            sentry_value_new_string(scope->release), "string",
+            "sentry.release");
+    }
+    if (options) {
+        sentry__value_add_attribute(attributes,
+            sentry_value_new_string(sentry_options_get_sdk_name(options)),
+            "string", "sentry.sdk.name");
+    }
+    sentry__value_add_attribute(attributes,
+        sentry_value_new_string(sentry_sdk_version()), "string",
+        "sentry.sdk.version");
+
+    snapshot->trace_id = sentry_value_get_by_key_owned(telemetry, "trace_id");
+    snapshot->attributes = attributes;
+    sentry_value_decref(telemetry);
+    return snapshot;
+}
+
+sentry_scope_attributes_t *
+sentry__scope_get_attributes(void)
+{
+    sentry_scope_attributes_t *snapshot = acquire_attributes();
+    if (snapshot
+        && snapshot->version == sentry__atomic_fetch(&g_scope_version)) {
+        return snapshot;
+    }
+    sentry__scope_attributes_decref(snapshot);
+
+    // The options must be acquired before the scope lock, since `sentry_init`
+    // locks the scope while holding the options lock.
+    const sentry_options_t *options = sentry__options_getref();
+    snapshot = NULL;
+    SENTRY_WITH_SCOPE (scope) {
+        // another producer might have rebuilt it while we waited for the lock
+        const long version = sentry__atomic_fetch(&g_scope_version);
+        snapshot = acquire_attributes();
+        if (!snapshot || snapshot->version != version) {
+            sentry__scope_attributes_decref(snapshot);
+            snapshot = build_attributes(scope, options, version);
+            if (snapshot) {
+                sentry__atomic_fetch_and_add(&snapshot->refcount, 1);
+                publish_attributes(snapshot);
+            }
+        }
+    }
+    sentry_options_free((sentry_options_t *)options);
+    return snapshot;
+}
+
+void
+sentry__scope_attributes_decref(sentry_scope_attributes_t *snapshot)
+{
+    if (!snapshot
+        || sentry__atomic_fetch_and_add(&snapshot->refcount, -1) != 1) {
+        return;
+    }
+    sentry_value_decref(snapshot->trace_id);
+    sentry_value_decref(snapshot->attributes);
+    sentry_free(snapshot);
+}
+
+void
+sentry__scope_attributes_apply(const sentry_scope_attributes_t *snapshot,
+    sentry_value_t telemetry, sentry_value_t attributes)
+{
+    if (!snapshot) {
+        return;
+    }
+    sentry_value_incref(snapshot->trace_id);
+    sentry_value_set_by_key(telemetry, "trace_id", snapshot->trace_id);
+    // the snapshot is shared, so every record gets attribute objects of its own
+    sentry__value_merge_objects_copy(attributes, snapshot->attributes);
+}
@@ -62,6 +62,12 @@ typedef enum {
  */
 sentry_scope_t *sentry__scope_lock(void);
 
+/**
+ * Same as `sentry__scope_lock`, but marks the global scope as modified, which
+ * invalidates the published telemetry attributes.
+ */
+sentry_scope_t *sentry__scope_lock_mut(void);
+
 /**
  * Release the lock on the global scope.
  */
@@ -122,10 +128,10 @@ void sentry__scope_remove_attribute_n(
     for (const sentry_scope_t *Scope = sentry__scope_lock(); Scope;            \
         sentry__scope_unlock(), Scope = NULL)
 #define SENTRY_WITH_SCOPE_MUT(Scope)                                           \
-    for (sentry_scope_t *Scope = sentry__scope_lock(); Scope;                  \
+    for (sentry_scope_t *Scope = sentry__scope_lock_mut(); Scope;              \
         sentry__scope_flush_unlock(), Scope = NULL)
 #define SENTRY_WITH_SCOPE_MUT_NO_FLUSH(Scope)                                  \
-    for (sentry_scope_t *Scope = sentry__scope_lock(); Scope;                  \
+    for (sentry_scope_t *Scope = sentry__scope_lock_mut(); Scope;              \
         sentry__scope_unlock(), Scope = NULL)
 
 /**
@@ -134,6 +140,41 @@ void sentry__scope_remove_attribute_n(
 void sentry__scope_apply_attributes(const sentry_scope_t *scope,
     sentry_value_t telemetry, sentry_value_t attributes);
 
+/**
+ * An immutable, refcounted snapshot of the attributes that the global scope
+ * and the SDK add to telemetry such as logs and metrics. A new snapshot is
+ * built lazily by the first producer that observes a scope modification and
+ * is then published for everyone else to share.
+ */
+typedef struct sentry_scope_attributes_s {
+    long refcount; // (atomic)
+    long version; // the scope version this snapshot was built from
+    sentry_value_t trace_id;
+    sentry_value_t attributes;
+} sentry_scope_attributes_t;
+
+/**
+ * Returns a new reference to the attribute snapshot of the current global
+ * scope. The scope lock is only taken if the scope was modified since the
+ * last snapshot was built; otherwise this takes a global spinlock for as long
+ * as it takes to load the published snapshot and increment its refcount.
+ * Returns NULL on allocation failure.
+ */
+sentry_scope_attributes_t *sentry__scope_get_attributes(void);
+
+/**
+ * Releases a reference to an attribute snapshot.
+ */
+void sentry__scope_attributes_decref(sentry_scope_attributes_t *snapshot);
+
+/**
+ * Adds copies of the attributes of the `snapshot` to the telemetry attributes
+ * object, and sets the `trace_id` on the `telemetry` object. The copies can be
+ * modified, e.g. by `before_send_log`, without affecting the snapshot.
+ */
+void sentry__scope_attributes_apply(const sentry_scope_attributes_t *snapshot,
+    sentry_value_t telemetry, sentry_value_t attributes);
+
 #endif
 
 // this is only used in unit tests
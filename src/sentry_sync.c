@@ -116,7 +116,16 @@ thread_setname(sentry_threadid_t thread_id, const char *thread_name)
  * removed from the queue (either after being executed, or when the task was
  * concurrently removed from the queue).
  *
- * Each access to the queue itself must be done using the `task_lock`.
+ * Tasks that are due on submission are pushed onto the lock-free `incoming`
+ * stack, which makes for a multi-producer single-consumer queue: producers
+ * only ever push using a compare-and-swap, and the consumer takes the whole
+ * stack at once and reverses it into submission order. Delayed tasks go into
+ * the `timers` min-heap instead. The worker moves both into the `ready` lists,
+ * one per priority and sorted by `execute_after`, as they become due.
+ *
+ * Everything but the `incoming` stack must be accessed using the `task_lock`,
+ * and whoever holds it can act as the consumer. Producers of due tasks only
+ * take the lock to wake up the worker when it announced that it is `sleeping`.
  * There are two signals, `submit` *to* the worker, signaling a new task, and
  * `done` *from* the worker signaling that it will close down and can be joined.
  */
@@ -135,6 +144,11 @@ typedef struct sentry_bgworker_task_s {
     struct sentry_bgworker_task_s *next_task;
     long refcount;
     uint64_t execute_after;
+    // breaks ties between delayed tasks, to keep their submission order
+    uint64_t seq;
+    sentry_task_priority_t priority;
+    // counts against the capacity of the queue, and can be shed
+    bool bounded;
     sentry_task_exec_func_t exec_func;
     void (*cleanup_func)(void *task_data);
     void *task_data;
@@ -157,22 +171,291 @@ sentry__task_decref(sentry_bgworker_task_t *task)
     }
 }
 
+typedef struct {
+    sentry_bgworker_task_t *first;
+    sentry_bgworker_task_t *last;
+} sentry_task_list_t;
+
 struct sentry_bgworker_s {
     sentry_threadid_t thread_id;
     char *thread_name;
     sentry_cond_t submit_signal;
     sentry_cond_t done_signal;
     sentry_mutex_t task_lock;
-    sentry_bgworker_task_t *first_task;
-    sentry_bgworker_task_t *last_task;
+    // newly submitted due tasks, the most recent first
+    void *volatile incoming;
+    sentry_task_list_t ready[SENTRY_TASK_PRIORITY_HIGH + 1];
+    sentry_bgworker_task_t **timers;
+    size_t num_timers;
+    size_t timers_capacity;
+    uint64_t timer_seq;
     sentry_bgworker_task_t *current_task;
     void *state;
     void (*free_state)(void *state);
+    volatile long num_bounded;
+    size_t capacity;
+    void (*shed_func)(void *task_data, void *state);
     long refcount;
     long running;
     long draining;
+    long sleeping;
 };
 
+static void
+list_append(sentry_task_list_t *list, sentry_bgworker_task_t *task)
+{
+    task->next_task = NULL;
+    if (list->last) {
+        list->last->next_task = task;
+    } else {
+        list->first = task;
+    }
+    list->last = task;
+}
+
+/**
+ * Inserts the task sorted by `execute_after`, after all tasks that are due at
+ * the same time. Tasks are mostly due in the order they arrive, in which case
+ * this is a simple append.
+ */
+static void
+list_insert(sentry_task_list_t *list, sentry_bgworker_task_t *task)
+{
+    if (!list->last || list->last->execute_after <= task->execute_after) {
+        list_append(list, task);
+        return;
+    }
+    sentry_bgworker_task_t *prev = NULL;
+    sentry_bgworker_task_t *cur = list->first;
+    while (cur->execute_after <= task->execute_after) {
+        prev = cur;
+        cur = cur->next_task;
+    }
+    task->next_task = cur;
+    if (prev) {
+        prev->next_task = task;
+    } else {
+        list->first = task;
+    }
+}
+
+static void
+list_remove(sentry_task_list_t *list, sentry_bgworker_task_t *prev,
+    sentry_bgworker_task_t *task)
+{
+    if (prev) {
+        prev->next_task = task->next_task;
+    } else {
+        list->first = task->next_task;
+    }
+    if (list->last == task) {
+        list->last = prev;
+    }
+    task->next_task = NULL;
+}
+
+static void
+list_free(sentry_task_list_t *list)
+{
+    sentry_bgworker_task_t *task = list->first;
+    while (task) {
+        sentry_bgworker_task_t *next_task = task->next_task;
+        sentry__task_decref(task);
+        task = next_task;
+    }
+    list->first = NULL;
+    list->last = NULL;
+}
+
+static bool
+timer_before(const sentry_bgworker_task_t *a, const sentry_bgworker_task_t *b)
+{
+    return a->execute_after < b->execute_after
+        || (a->execute_after == b->execute_after && a->seq < b->seq);
+}
+
+static void
+timers_sift_down(sentry_bgworker_t *bgw, size_t i)
+{
+    sentry_bgworker_task_t **timers = bgw->timers;
+    while (true) {
+        size_t min = i;
+        size_t left = 2 * i + 1;
+        size_t right = left + 1;
+        if (left < bgw->num_timers && timer_before(timers[left], timers[min])) {
+            min = left;
+        }
+        if (right < bgw->num_timers
+            && timer_before(timers[right], timers[min])) {
+            min = right;
+        }
+        if (min == i) {
+            return;
+        }
+        sentry_bgworker_task_t *tmp = timers[i];
+        timers[i] = timers[min];
+        timers[min] = tmp;
+        i = min;
+    }
+}
+
+static void
+timers_sift_up(sentry_bgworker_t *bgw, size_t i)
+{
+    sentry_bgworker_task_t *task = bgw->timers[i];
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!timer_before(task, bgw->timers[parent])) {
+            break;
+        }
+        bgw->timers[i] = bgw->timers[parent];
+        i = parent;
+    }
+    bgw->timers[i] = task;
+}
+
+/**
+ * Adds a delayed task to the timer heap. Expects the `task_lock` to be held.
+ */
+static bool
+timers_push(sentry_bgworker_t *bgw, sentry_bgworker_task_t *task)
+{
+    if (bgw->num_timers == bgw->timers_capacity) {
+        size_t capacity = bgw->timers_capacity ? bgw->timers_capacity * 2 : 16;
+        sentry_bgworker_task_t **timers
+            = sentry_malloc(capacity * sizeof(sentry_bgworker_task_t *));
+        if (!timers) {
+            return false;
+        }
+        if (bgw->num_timers) {
+            memcpy(timers, bgw->timers,
+                bgw->num_timers * sizeof(sentry_bgworker_task_t *));
+        }
+        sentry_free(bgw->timers);
+        bgw->timers = timers;
+        bgw->timers_capacity = capacity;
+    }
+
+    task->seq = bgw->timer_seq++;
+    bgw->timers[bgw->num_timers++] = task;
+    timers_sift_up(bgw, bgw->num_timers - 1);
+    return true;
+}
+
+static void
+timers_remove(sentry_bgworker_t *bgw, size_t i)
+{
+    bgw->num_timers--;
+    if (i < bgw->num_timers) {
+        bgw->timers[i] = bgw->timers[bgw->num_timers];
+        timers_sift_down(bgw, i);
+        timers_sift_up(bgw, i);
+    }
+}
+
+static sentry_bgworker_task_t *
+timers_pop(sentry_bgworker_t *bgw)
+{
+    sentry_bgworker_task_t *task = bgw->timers[0];
+    bgw->timers[0] = bgw->timers[--bgw->num_timers];
+    timers_sift_down(bgw, 0);
+    return task;
+}
+
+/**
+ * Pushes a due task onto the `incoming` stack, without taking any lock.
+ */
+static void
+push_incoming(sentry_bgworker_t *bgw, sentry_bgworker_task_t *task)
+{
+    void *head;
+    do {
+        head = sentry__atomic_fetch_ptr(&bgw->incoming);
+        task->next_task = head;
+    } while (!sentry__atomic_compare_swap_ptr(&bgw->incoming, head, task));
+}
+
+/**
+ * Moves the delayed tasks that are due, and all newly submitted tasks, into
+ * the ready lists. Expects the `task_lock` to be held.
+ */
+static void
+collect_tasks(sentry_bgworker_t *bgw)
+{
+    if (bgw->num_timers) {
+        uint64_t now = sentry__monotonic_time();
+        while (bgw->num_timers && bgw->timers[0]->execute_after <= now) {
+            sentry_bgworker_task_t *task = timers_pop(bgw);
+            list_insert(&bgw->ready[task->priority], task);
+        }
+    }
+    if (!sentry__atomic_fetch_ptr(&bgw->incoming)) {
+        return;
+    }
+
+    // the stack has the most recent task first, so reverse it
+    sentry_bgworker_task_t *task
+        = sentry__atomic_store_ptr(&bgw->incoming, NULL);
+    sentry_bgworker_task_t *ordered = NULL;
+    while (task) {
+        sentry_bgworker_task_t *next_task = task->next_task;
+        task->next_task = ordered;
+        ordered = task;
+        task = next_task;
+    }
+    while (ordered) {
+        sentry_bgworker_task_t *next_task = ordered->next_task;
+        list_insert(&bgw->ready[ordered->priority], ordered);
+        ordered = next_task;
+    }
+}
+
+/**
+ * Takes the next task to execute from the ready lists, which is the oldest
+ * one of the highest priority. Expects the `task_lock` to be held.
+ */
+static sentry_bgworker_task_t *
+pop_ready_task(sentry_bgworker_t *bgw)
+{
+    for (int p = SENTRY_TASK_PRIORITY_HIGH; p >= SENTRY_TASK_PRIORITY_LOW;
+        p--) {
+        sentry_task_list_t *list = &bgw->ready[p];
+        sentry_bgworker_task_t *task = list->first;
+        if (task) {
+            list_remove(list, NULL, task);
+            return task;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Updates the task counts for a task that was removed from the queue.
+ */
+static void
+task_removed(sentry_bgworker_t *bgw, const sentry_bgworker_task_t *task)
+{
+    if (task->bounded) {
+        sentry__atomic_fetch_and_add(&bgw->num_bounded, -1);
+    }
+}
+
+/**
+ * Wakes up the worker after a task was pushed onto the `incoming` stack. The
+ * worker announces that it is `sleeping` before it checks the stack one last
+ * time, so either it sees the new task, or we see the announcement.
+ */
+static void
+wake_worker(sentry_bgworker_t *bgw)
+{
+    if (sentry__atomic_fetch(&bgw->sleeping)
+        && sentry__atomic_compare_swap(&bgw->sleeping, 1, 0)) {
+        sentry__mutex_lock(&bgw->task_lock);
+        sentry__cond_wake(&bgw->submit_signal);
+        sentry__mutex_unlock(&bgw->task_lock);
+    }
+}
+
 sentry_bgworker_t *
 sentry__bgworker_new(void *state, void (*free_state)(void *state))
 {
@@ -207,12 +490,15 @@ sentry__bgworker_decref(sentry_bgworker_t *bgw)
     }
 
     // no need to lock here, as we do have the only reference
-    sentry_bgworker_task_t *task = bgw->first_task;
-    while (task) {
-        sentry_bgworker_task_t *next_task = task->next_task;
-        sentry__task_decref(task);
-        task = next_task;
+    collect_tasks(bgw);
+    for (size_t i = 0; i < bgw->num_timers; i++) {
+        sentry__task_decref(bgw->timers[i]);
     }
+    for (int p = SENTRY_TASK_PRIORITY_LOW; p <= SENTRY_TASK_PRIORITY_HIGH;
+        p++) {
+        list_free(&bgw->ready[p]);
+    }
+    sentry_free(bgw->timers);
     if (bgw->free_state) {
         bgw->free_state(bgw->state);
     }
@@ -228,6 +514,18 @@ sentry__bgworker_get_state(sentry_bgworker_t *bgw)
     return bgw->state;
 }
 
+static bool
+has_ready_tasks(sentry_bgworker_t *bgw)
+{
+    for (int p = SENTRY_TASK_PRIORITY_LOW; p <= SENTRY_TASK_PRIORITY_HIGH;
+        p++) {
+        if (bgw->ready[p].first) {
+            return true;
+        }
+    }
+    return sentry__atomic_fetch_ptr(&bgw->incoming) != NULL;
+}
+
 /**
  * Check if the bgworker is done running and can be shut down.
  * This function does *not* internally lock, and it should only be called when
@@ -239,9 +537,7 @@ sentry__bgworker_is_done(sentry_bgworker_t *bgw)
     if (sentry__atomic_fetch(&bgw->draining)) {
         return true;
     }
-    return (!bgw->first_task
-               || sentry__monotonic_time() < bgw->first_task->execute_after)
-        && !sentry__atomic_fetch(&bgw->running);
+    return !has_ready_tasks(bgw) && !sentry__atomic_fetch(&bgw->running);
 }
 
 SENTRY_THREAD_FN
@@ -262,30 +558,35 @@ worker_thread(void *data)
 
     sentry__mutex_lock(&bgw->task_lock);
     while (true) {
+        collect_tasks(bgw);
+
         if (sentry__bgworker_is_done(bgw)) {
             sentry__cond_wake(&bgw->done_signal);
             sentry__mutex_unlock(&bgw->task_lock);
             break;
         }
 
-        sentry_bgworker_task_t *task = bgw->first_task;
+        sentry_bgworker_task_t *task = pop_ready_task(bgw);
         if (!task) {
-            // this will implicitly release the lock, and re-acquire on wake
-            sentry__cond_wait_timeout(
-                &bgw->submit_signal, &bgw->task_lock, 1000);
-            continue;
-        }
-
-        // wait for a delayed task, wake up to new submissions
-        {
-            uint64_t now = sentry__monotonic_time();
-            if (now < task->execute_after) {
-                sentry__cond_wait_timeout(&bgw->submit_signal, &bgw->task_lock,
-                    (uint32_t)MIN(task->execute_after - now, UINT32_MAX));
-                continue;
+            // wait for the next delayed task, wake up to new submissions
+            uint32_t timeout = 1000;
+            if (bgw->num_timers) {
+                uint64_t now = sentry__monotonic_time();
+                uint64_t next = bgw->timers[0]->execute_after;
+                timeout = next > now ? (uint32_t)MIN(next - now, UINT32_MAX)
+                                     : 0;
+            }
+            sentry__atomic_store(&bgw->sleeping, 1);
+            if (!sentry__atomic_fetch_ptr(&bgw->incoming)) {
+                // this will implicitly release the lock, and re-acquire on wake
+                sentry__cond_wait_timeout(
+                    &bgw->submit_signal, &bgw->task_lock, timeout);
             }
+            sentry__atomic_store(&bgw->sleeping, 0);
+            continue;
         }
 
+        // the reference of the queue moves to `current_task`
         sentry__task_incref(task);
         bgw->current_task = task;
         sentry__mutex_unlock(&bgw->task_lock);
@@ -297,16 +598,12 @@ worker_thread(void *data)
         // processed_.
         sentry__task_decref(task);
 
-        // check if the queue has been modified concurrently.
-        // if not, we pop it and `decref` again, removing the _is inside
-        // list_ refcount.
+        // check if the task has been dropped concurrently.
+        // if not, we `decref` again, removing the _is inside queue_ refcount.
         sentry__mutex_lock(&bgw->task_lock);
-        bgw->current_task = NULL;
-        if (bgw->first_task == task) {
-            bgw->first_task = task->next_task;
-            if (task == bgw->last_task) {
-                bgw->last_task = NULL;
-            }
+        if (bgw->current_task == task) {
+            bgw->current_task = NULL;
+            task_removed(bgw, task);
             sentry__task_decref(task);
         }
     }
@@ -383,11 +680,10 @@ sentry__bgworker_flush(sentry_bgworker_t *bgw, uint64_t timeout)
     uint64_t deadline = add_saturate(before, timeout);
     uint64_t execute_after = before;
     sentry__mutex_lock(&bgw->task_lock);
-    for (sentry_bgworker_task_t *t
-        = bgw->current_task ? bgw->current_task->next_task : bgw->first_task;
-        t && t->execute_after <= deadline; t = t->next_task) {
-        if (t->execute_after > execute_after) {
-            execute_after = t->execute_after;
+    for (size_t i = 0; i < bgw->num_timers; i++) {
+        uint64_t t = bgw->timers[i]->execute_after;
+        if (t <= deadline && t > execute_after) {
+            execute_after = t;
         }
     }
     // NOTE: another thread could submit between unlock and submit_at, making
@@ -396,9 +692,11 @@ sentry__bgworker_flush(sentry_bgworker_t *bgw, uint64_t timeout)
 
     sentry__mutex_lock(&flush_task->lock);
 
-    /* submit the task that triggers our condvar once it runs */
-    sentry__bgworker_submit_at(bgw, sentry__flush_task,
-        (void (*)(void *))sentry__flush_task_decref, flush_task, execute_after);
+    /* submit the task that triggers our condvar once it runs, after all tasks
+     * of any priority that were submitted before */
+    sentry__bgworker_submit_prioritized(bgw, sentry__flush_task,
+        (void (*)(void *))sentry__flush_task_decref, flush_task, execute_after,
+        SENTRY_TASK_PRIORITY_LOW);
 
     uint64_t started = sentry__monotonic_time();
     bool was_flushed = false;
@@ -436,8 +734,9 @@ sentry__bgworker_shutdown_cb(sentry_bgworker_t *bgw, uint64_t timeout,
     }
     SENTRY_DEBUG("shutting down background worker thread");
 
-    /* submit a task to shut down the queue */
-    sentry__bgworker_submit(bgw, shutdown_task, NULL, bgw);
+    /* submit a task to shut down the queue, once all queued tasks ran */
+    sentry__bgworker_submit_prioritized(bgw, shutdown_task, NULL, bgw,
+        sentry__monotonic_time(), SENTRY_TASK_PRIORITY_LOW);
 
     uint64_t started = sentry__monotonic_time();
     sentry__mutex_lock(&bgw->task_lock);
@@ -475,14 +774,74 @@ sentry__bgworker_shutdown_cb(sentry_bgworker_t *bgw, uint64_t timeout,
     }
 }
 
+static sentry_bgworker_task_t *
+task_new(sentry_task_exec_func_t exec_func,
+    void (*cleanup_func)(void *task_data), void *task_data,
+    uint64_t execute_after, sentry_task_priority_t priority)
+{
+    sentry_bgworker_task_t *task = SENTRY_MAKE(sentry_bgworker_task_t);
+    if (!task) {
+        return NULL;
+    }
+    task->next_task = NULL;
+    task->refcount = 1;
+    task->execute_after = execute_after;
+    task->priority = priority;
+    task->bounded = false;
+    task->exec_func = exec_func;
+    task->cleanup_func = cleanup_func;
+    task->task_data = task_data;
+    return task;
+}
+
+/**
+ * Queues a new task, on the `incoming` stack if it is due at `now`, and on the
+ * timer heap otherwise.
+ */
+static int
+submit_task(sentry_bgworker_t *bgw, sentry_task_exec_func_t exec_func,
+    void (*cleanup_func)(void *task_data), void *task_data,
+    uint64_t execute_after, sentry_task_priority_t priority, uint64_t now)
+{
+    sentry_bgworker_task_t *task = task_new(
+        exec_func, cleanup_func, task_data, execute_after, priority);
+    if (!task) {
+        if (cleanup_func) {
+            cleanup_func(task_data);
+        }
+        return 1;
+    }
+
+    if (execute_after <= now) {
+        push_incoming(bgw, task);
+        wake_worker(bgw);
+        return 0;
+    }
+
+    sentry__mutex_lock(&bgw->task_lock);
+    bool pushed = timers_push(bgw, task);
+    if (pushed) {
+        // the worker might be waiting for a later timer
+        sentry__cond_wake(&bgw->submit_signal);
+    }
+    sentry__mutex_unlock(&bgw->task_lock);
+
+    if (!pushed) {
+        sentry__task_decref(task);
+        return 1;
+    }
+    return 0;
+}
+
 int
 sentry__bgworker_submit(sentry_bgworker_t *bgw,
     sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
     void *task_data)
 {
     SENTRY_DEBUG("submitting task to background worker thread");
-    return sentry__bgworker_submit_at(
-        bgw, exec_func, cleanup_func, task_data, sentry__monotonic_time());
+    uint64_t now = sentry__monotonic_time();
+    return submit_task(bgw, exec_func, cleanup_func, task_data, now,
+        SENTRY_TASK_PRIORITY_NORMAL, now);
 }
 
 int
@@ -503,55 +862,160 @@ sentry__bgworker_submit_at(sentry_bgworker_t *bgw,
     sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
     void *task_data, uint64_t execute_after)
 {
-    sentry_bgworker_task_t *task = SENTRY_MAKE(sentry_bgworker_task_t);
+    return sentry__bgworker_submit_prioritized(bgw, exec_func, cleanup_func,
+        task_data, execute_after, SENTRY_TASK_PRIORITY_NORMAL);
+}
+
+int
+sentry__bgworker_submit_prioritized(sentry_bgworker_t *bgw,
+    sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
+    void *task_data, uint64_t execute_after, sentry_task_priority_t priority)
+{
+    return submit_task(bgw, exec_func, cleanup_func, task_data, execute_after,
+        priority, sentry__monotonic_time());
+}
+
+/**
+ * Removes the most recently queued bounded task with a priority lower than
+ * `priority`, preferring tasks that are already due over delayed ones.
+ * Expects the `task_lock` to be held.
+ */
+static sentry_bgworker_task_t *
+remove_shed_candidate(sentry_bgworker_t *bgw, sentry_task_priority_t priority)
+{
+    for (int p = SENTRY_TASK_PRIORITY_LOW; p < (int)priority; p++) {
+        sentry_task_list_t *list = &bgw->ready[p];
+        sentry_bgworker_task_t *candidate = NULL;
+        sentry_bgworker_task_t *candidate_prev = NULL;
+        for (sentry_bgworker_task_t *prev = NULL, *t = list->first; t;
+            prev = t, t = t->next_task) {
+            if (t->bounded) {
+                candidate = t;
+                candidate_prev = prev;
+            }
+        }
+        if (candidate) {
+            list_remove(list, candidate_prev, candidate);
+            return candidate;
+        }
+
+        size_t index = bgw->num_timers;
+        for (size_t i = 0; i < bgw->num_timers; i++) {
+            const sentry_bgworker_task_t *t = bgw->timers[i];
+            if (t->bounded && (int)t->priority == p
+                && (index == bgw->num_timers
+                    || t->seq > bgw->timers[index]->seq)) {
+                index = i;
+            }
+        }
+        if (index < bgw->num_timers) {
+            candidate = bgw->timers[index];
+            timers_remove(bgw, index);
+            return candidate;
+        }
+    }
+    return NULL;
+}
+
+int
+sentry__bgworker_try_submit(sentry_bgworker_t *bgw,
+    sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
+    void *task_data, sentry_task_priority_t priority)
+{
+    return sentry__bgworker_try_submit_delayed(
+        bgw, exec_func, cleanup_func, task_data, priority, 0);
+}
+
+int
+sentry__bgworker_try_submit_delayed(sentry_bgworker_t *bgw,
+    sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
+    void *task_data, sentry_task_priority_t priority, uint64_t delay_ms)
+{
+    sentry_bgworker_task_t *task = task_new(exec_func, cleanup_func,
+        task_data, add_saturate(sentry__monotonic_time(), delay_ms), priority);
     if (!task) {
+        if (bgw->shed_func) {
+            bgw->shed_func(task_data, bgw->state);
+        }
         if (cleanup_func) {
             cleanup_func(task_data);
         }
         return 1;
     }
-    task->next_task = NULL;
-    task->refcount = 1;
-    task->execute_after = execute_after;
-    task->exec_func = exec_func;
-    task->cleanup_func = cleanup_func;
-    task->task_data = task_data;
+    task->bounded = true;
+
+    // reserve a slot first, so that the common case needs no lock
+    size_t capacity = bgw->capacity;
+    long queued = sentry__atomic_fetch_and_add(&bgw->num_bounded, 1);
+    bool has_room = !capacity || (size_t)queued < capacity;
+    if (has_room && !delay_ms) {
+        push_incoming(bgw, task);
+        wake_worker(bgw);
+        return 0;
+    }
 
+    sentry_bgworker_task_t *shed = NULL;
     sentry__mutex_lock(&bgw->task_lock);
-
-    if (!bgw->first_task) {
-        // empty queue
-        bgw->first_task = task;
-        bgw->last_task = task;
-    } else if (bgw->last_task->execute_after <= task->execute_after) {
-        // append last (common fast path for FIFO immediates)
-        bgw->last_task->next_task = task;
-        bgw->last_task = task;
-    } else {
-        // insert sorted by execute_after; skip past current_task which
-        // may be executing without the lock held
-        sentry_bgworker_task_t *prev = bgw->current_task;
-        sentry_bgworker_task_t *cur = prev ? prev->next_task : bgw->first_task;
-        while (cur && cur->execute_after <= task->execute_after) {
-            prev = cur;
-            cur = cur->next_task;
-        }
-
-        task->next_task = cur;
-        if (prev) {
-            prev->next_task = task;
+    collect_tasks(bgw);
+    // a slot might have been freed in the meantime
+    if (!has_room
+        && (size_t)sentry__atomic_fetch(&bgw->num_bounded) > capacity) {
+        shed = remove_shed_candidate(bgw, priority);
+        if (shed) {
+            task_removed(bgw, shed);
         } else {
-            bgw->first_task = task;
+            // the new task has the lowest priority itself
+            shed = task;
         }
-        if (!task->next_task) {
-            bgw->last_task = task;
+    }
+    if (shed != task) {
+        if (!delay_ms) {
+            list_insert(&bgw->ready[priority], task);
+        } else if (!timers_push(bgw, task)) {
+            shed = task;
         }
+        sentry__cond_wake(&bgw->submit_signal);
     }
+    if (shed == task) {
+        sentry__atomic_fetch_and_add(&bgw->num_bounded, -1);
+    }
+    sentry__mutex_unlock(&bgw->task_lock);
 
-    sentry__cond_wake(&bgw->submit_signal);
+    if (shed) {
+        SENTRY_DEBUG("background worker queue is full, shedding a task");
+        if (bgw->shed_func) {
+            bgw->shed_func(shed->task_data, bgw->state);
+        }
+        sentry__task_decref(shed);
+    }
+    return shed == task ? 1 : 0;
+}
+
+void
+sentry__bgworker_set_capacity(sentry_bgworker_t *bgw, size_t capacity,
+    void (*shed_func)(void *task_data, void *state))
+{
+    sentry__mutex_lock(&bgw->task_lock);
+    bgw->capacity = capacity;
+    bgw->shed_func = shed_func;
     sentry__mutex_unlock(&bgw->task_lock);
+}
 
-    return 0;
+static bool
+should_drop_task(const sentry_bgworker_task_t *task,
+    sentry_task_exec_func_t exec_func,
+    bool (*callback)(void *task_data, void *data), void *data)
+{
+    // only consider tasks matching this exec_func
+    return task->exec_func == exec_func
+        && (!callback || callback(task->task_data, data));
+}
+
+static void
+drop_task(sentry_bgworker_t *bgw, sentry_bgworker_task_t *task)
+{
+    task_removed(bgw, task);
+    sentry__task_decref(task);
 }
 
 size_t
@@ -560,39 +1024,51 @@ sentry__bgworker_foreach_matching(sentry_bgworker_t *bgw,
     bool (*callback)(void *task_data, void *data), void *data)
 {
     sentry__mutex_lock(&bgw->task_lock);
-    sentry_bgworker_task_t *task = bgw->first_task;
-    sentry_bgworker_task_t *prev_task = NULL;
+    collect_tasks(bgw);
     size_t dropped = 0;
 
-    while (task) {
-        bool drop_task = false;
-        // only consider tasks matching this exec_func
-        if (task->exec_func == exec_func) {
-            drop_task = !callback || callback(task->task_data, data);
-        }
+    // the executing task is not part of the ready lists anymore
+    sentry_bgworker_task_t *current = bgw->current_task;
+    if (current && should_drop_task(current, exec_func, callback, data)) {
+        bgw->current_task = NULL;
+        drop_task(bgw, current);
+        dropped++;
+    }
 
-        sentry_bgworker_task_t *next_task = task->next_task;
-        if (drop_task) {
-            if (prev_task) {
-                prev_task->next_task = next_task;
+    for (int p = SENTRY_TASK_PRIORITY_HIGH; p >= SENTRY_TASK_PRIORITY_LOW;
+        p--) {
+        sentry_task_list_t *list = &bgw->ready[p];
+        sentry_bgworker_task_t *prev_task = NULL;
+        sentry_bgworker_task_t *task = list->first;
+        while (task) {
+            sentry_bgworker_task_t *next_task = task->next_task;
+            if (should_drop_task(task, exec_func, callback, data)) {
+                list_remove(list, prev_task, task);
+                drop_task(bgw, task);
+                dropped++;
             } else {
-                bgw->first_task = next_task;
+                prev_task = task;
             }
-            if (bgw->current_task == task) {
-                bgw->current_task = NULL;
-            } else if (bgw->current_task
-                && bgw->current_task->next_task == task) {
-                bgw->current_task->next_task = next_task;
-            }
-            sentry__task_decref(task);
+            task = next_task;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < bgw->num_timers; i++) {
+        sentry_bgworker_task_t *task = bgw->timers[i];
+        if (should_drop_task(task, exec_func, callback, data)) {
+            drop_task(bgw, task);
             dropped++;
         } else {
-            prev_task = task;
+            bgw->timers[kept++] = task;
+        }
+    }
+    if (kept != bgw->num_timers) {
+        bgw->num_timers = kept;
+        for (size_t i = kept / 2; i > 0; i--) {
+            timers_sift_down(bgw, i - 1);
         }
-
-        task = next_task;
     }
-    bgw->last_task = prev_task;
     sentry__mutex_unlock(&bgw->task_lock);
 
     return dropped;
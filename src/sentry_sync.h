@@ -22,6 +22,12 @@
 #    define UNSIGNED_MINGW
 #endif
 
+#ifdef _MSC_VER
+#    define SENTRY_THREAD_LOCAL __declspec(thread)
+#else
+#    define SENTRY_THREAD_LOCAL __thread
+#endif
+
 // pthreads use `void *` return types, whereas windows uses `DWORD`
 #ifdef SENTRY_PLATFORM_WINDOWS
 #    define SENTRY_THREAD_FN static UNSIGNED_MINGW DWORD THREAD_FUNCTION_API
@@ -206,6 +212,8 @@ typedef CONDITION_VARIABLE sentry_cond_t;
 #    endif
 #    define sentry__cond_wait(CondVar, Lock)                                   \
         sentry__cond_wait_timeout(CondVar, Lock, INFINITE)
+// condition variables hold no resources on Windows
+#    define sentry__cond_free(CondVar) (void)(CondVar)
 
 static inline sentry_threadid_t
 sentry__current_thread(void)
@@ -342,6 +350,7 @@ typedef pthread_cond_t sentry_cond_t;
             }                                                                  \
         } while (0)
 #    define sentry__cond_wake pthread_cond_signal
+#    define sentry__cond_free(CondVar) pthread_cond_destroy(CondVar)
 #    define sentry__thread_init(ThreadId)                                      \
         memset(ThreadId, 0, sizeof(sentry_threadid_t))
 #    define sentry__thread_spawn(ThreadId, Func, Data)                         \
@@ -364,6 +373,11 @@ sentry__cond_wait_timeout(
     gettimeofday(&now, NULL);
     lock_time.tv_sec = now.tv_sec + msecs / 1000ULL;
     lock_time.tv_nsec = (now.tv_usec + 1000ULL * (msecs % 1000)) * 1000ULL;
+    if (lock_time.tv_nsec >= 1000000000L) {
+        // an out of range `tv_nsec` makes the wait fail right away
+        lock_time.tv_sec += 1;
+        lock_time.tv_nsec -= 1000000000L;
+    }
     return pthread_cond_timedwait(cv, mutex, &lock_time);
 }
 #endif
@@ -399,7 +413,27 @@ sentry__atomic_store(volatile long *val, long value)
 static inline long
 sentry__atomic_fetch(volatile long *val)
 {
+#ifdef SENTRY_PLATFORM_WINDOWS
     return sentry__atomic_fetch_and_add(val, 0);
+#else
+    // A plain load keeps the cache line shared between readers, whereas an
+    // `add(0)` would require exclusive ownership on every read.
+    return __atomic_load_n(val, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/**
+ * Like `sentry__atomic_fetch`, but without ordering guarantees. Meant for
+ * frequently read flags, where a stale value is acceptable.
+ */
+static inline long
+sentry__atomic_fetch_relaxed(volatile long *val)
+{
+#ifdef SENTRY_PLATFORM_WINDOWS
+    return *val;
+#else
+    return __atomic_load_n(val, __ATOMIC_RELAXED);
+#endif
 }
 
 /**
@@ -430,11 +464,59 @@ sentry__atomic_compare_swap(volatile long *val, long expected, long desired)
 #endif
 }
 
+/**
+ * Pointer variants of the atomic operations above, with the same sequentially
+ * consistent ordering.
+ */
+static inline void *
+sentry__atomic_fetch_ptr(void *volatile *ptr)
+{
+#ifdef SENTRY_PLATFORM_WINDOWS
+    return InterlockedCompareExchangePointer((volatile PVOID *)ptr, NULL, NULL);
+#else
+    return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline void *
+sentry__atomic_store_ptr(void *volatile *ptr, void *value)
+{
+#ifdef SENTRY_PLATFORM_WINDOWS
+    return InterlockedExchangePointer((volatile PVOID *)ptr, value);
+#else
+    return __atomic_exchange_n(ptr, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline bool
+sentry__atomic_compare_swap_ptr(
+    void *volatile *ptr, void *expected, void *desired)
+{
+#ifdef SENTRY_PLATFORM_WINDOWS
+    return InterlockedCompareExchangePointer(
+               (volatile PVOID *)ptr, desired, expected)
+        == expected;
+#else
+    return __atomic_compare_exchange_n(
+        ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
 struct sentry_bgworker_s;
 typedef struct sentry_bgworker_s sentry_bgworker_t;
 
 typedef void (*sentry_task_exec_func_t)(void *task_data, void *state);
 
+/**
+ * Among the tasks that are due, the worker executes those with a higher
+ * priority first. Tasks of the same priority are executed in order.
+ */
+typedef enum {
+    SENTRY_TASK_PRIORITY_LOW,
+    SENTRY_TASK_PRIORITY_NORMAL,
+    SENTRY_TASK_PRIORITY_HIGH,
+} sentry_task_priority_t;
+
 /**
  * Creates a new background worker thread.
  *
@@ -519,6 +601,44 @@ int sentry__bgworker_submit_at(sentry_bgworker_t *bgw,
     sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
     void *task_data, uint64_t execute_after);
 
+/**
+ * Like `sentry__bgworker_submit_at`, but with an explicit `priority`. The other
+ * submit functions use `SENTRY_TASK_PRIORITY_NORMAL`.
+ */
+int sentry__bgworker_submit_prioritized(sentry_bgworker_t *bgw,
+    sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
+    void *task_data, uint64_t execute_after, sentry_task_priority_t priority);
+
+/**
+ * Submits a task to the bounded part of the queue, see
+ * `sentry__bgworker_set_capacity`. This never waits for the worker to make
+ * room, instead the task with the lowest priority is shed when the queue is
+ * full, which can be the submitted task itself.
+ *
+ * Takes ownership of `data`, freeing it using the provided `cleanup_func`.
+ * Returns 0 if the task was queued, and 1 if it was shed or on failure.
+ */
+int sentry__bgworker_try_submit(sentry_bgworker_t *bgw,
+    sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
+    void *task_data, sentry_task_priority_t priority);
+
+/**
+ * Like `sentry__bgworker_try_submit`, but delays execution by the specified
+ * delay in milliseconds. The task counts against the capacity while it waits.
+ */
+int sentry__bgworker_try_submit_delayed(sentry_bgworker_t *bgw,
+    sentry_task_exec_func_t exec_func, void (*cleanup_func)(void *task_data),
+    void *task_data, sentry_task_priority_t priority, uint64_t delay_ms);
+
+/**
+ * Limits the number of tasks submitted via `sentry__bgworker_try_submit` that
+ * can be queued at once. A `capacity` of 0 means no limit. Shed tasks are
+ * passed to `shed_func` together with the worker state before they are
+ * cleaned up, without being executed.
+ */
+void sentry__bgworker_set_capacity(sentry_bgworker_t *bgw, size_t capacity,
+    void (*shed_func)(void *task_data, void *state));
+
 /**
  * This function will iterate through all the current tasks of the worker
  * thread, and will call the `callback` function for each task with a matching
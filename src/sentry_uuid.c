@@ -14,15 +14,24 @@ sentry_uuid_nil(void)
     return rv;
 }
 
+void
+sentry__uuids_new_v4(sentry_uuid_t *uuids, size_t count)
+{
+    if (sentry__getrandom(uuids, sizeof(sentry_uuid_t) * count) != 0) {
+        memset(uuids, 0, sizeof(sentry_uuid_t) * count);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        uuids[i].bytes[6] = (uuids[i].bytes[6] & 0x0f) | 0x40;
+    }
+}
+
 sentry_uuid_t
 sentry_uuid_new_v4(void)
 {
-    char buf[16];
-    if (sentry__getrandom(buf, sizeof(buf)) != 0) {
-        return sentry_uuid_nil();
-    }
-    buf[6] = (buf[6] & 0x0f) | 0x40;
-    return sentry_uuid_from_bytes(buf);
+    sentry_uuid_t rv;
+    sentry__uuids_new_v4(&rv, 1);
+    return rv;
 }
 
 sentry_uuid_t
@@ -3,6 +3,12 @@
 
 #include "sentry_boot.h"
 
+/**
+ * Fills `uuids` with `count` new v4 UUIDs, drawing the random bytes for all of
+ * them at once. They are all nil if no random bytes are available.
+ */
+void sentry__uuids_new_v4(sentry_uuid_t *uuids, size_t count);
+
 /**
  * Converts a sentry UUID to a string representation used for internal
  * sentry UUIDs such as event IDs.
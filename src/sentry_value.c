@@ -1,8 +1,10 @@
 #include "sentry_boot.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -32,6 +34,7 @@
 
 #include "sentry_alloc.h"
 #include "sentry_core.h"
+#include "sentry_cpu_relax.h"
 #include "sentry_json.h"
 #include "sentry_slice.h"
 #include "sentry_string.h"
@@ -40,6 +43,10 @@
 #include "sentry_uuid.h"
 #include "sentry_value.h"
 
+#ifdef SENTRY_PLATFORM_UNIX
+#    include "sentry_unix_pageallocator.h"
+#endif
+
 /**
  * Pointer Tagging of `sentry_value_t`
  *
@@ -57,17 +64,42 @@
  *                                                            false - 0010
  *                                                             true - 0110
  *                                                             null - 1010
+ *                                                    INLINE as below - 11
+ *
+ * Inline values store a scalar in the remaining bits, so they don't need an
+ * allocation. They are told apart by their lowest five bits:
+ *
+ *                           A `double` in [2^-127, 2^129), see below - xx111
+ *             A `double` with five trailing zero bits, like 0 or 0.5 - 11011
+ *                        An `int64_t` in [-2^58, 2^58), shifted by 5 - 00011
+ *                             An `uint64_t` below 2^59, shifted by 5 - 10011
+ *             A string of `g_inline_strings`, its index shifted by 5 - 01011
+ *
+ * Doubles in range are rotated left by 5, so that the sign and the upper four
+ * exponent bits come last. Those exponent bits are either 0111 or 1000 for
+ * the range, so only the topmost is kept.
  */
 
 #define TAG_MASK 0x3
 #define TAG_INT32 0x1
 #define TAG_CONST 0x2
+#define TAG_INLINE 0x3
+
+#define INLINE_SHIFT 5
+#define INLINE_KIND_MASK 0x1f
+#define INLINE_DOUBLE_MASK 0x7
+#define INLINE_DOUBLE 0x7
+#define INLINE_DOUBLE_BITS 0x1b
+#define INLINE_INT64 0x3
+#define INLINE_UINT64 0x13
+#define INLINE_STRING 0xb
 
 #define CONST_FALSE 0x2
 #define CONST_TRUE 0x6
 #define CONST_NULL 0xa
 
-#define THING_TYPE_MASK 0x7f
+#define THING_TYPE_MASK 0x3f
+#define THING_TYPE_ARENA 0x40
 #define THING_TYPE_FROZEN 0x80
 #define THING_TYPE_LIST 0
 #define THING_TYPE_OBJECT 1
@@ -96,16 +128,392 @@ typedef struct {
 } list_t;
 
 typedef struct {
-    char *k;
+    const char *k; // either interned or owned, see `free_key`
     sentry_value_t v;
 } obj_pair_t;
 
+// Objects with more keys than this get a hash index for their keys. Smaller
+// objects are scanned linearly, which is cheaper for the common case.
+#define OBJ_INDEX_THRESHOLD 16
+
+typedef struct {
+    uint32_t hash;
+    uint32_t pos; // 1-based position in `pairs`, 0 marks an empty slot
+} obj_index_slot_t;
+
 typedef struct {
     obj_pair_t *pairs;
     size_t len;
     size_t allocated;
+    // open-addressing index into `pairs`, which keep the insertion order
+    obj_index_slot_t *index;
+    size_t index_size; // power of two, at least twice `len`
 } obj_t;
 
+/**
+ * Value Arenas
+ *
+ * While an arena is active on a thread, the values created on that thread are
+ * bump-allocated from it, along with all the memory they own later on (list
+ * items, object pairs and keys, string contents). Apart from that they are
+ * regular values: they are refcounted, can be mutated and shared with other
+ * threads, and may outlive the scope of their arena. The arena memory is
+ * released as a whole once its scope has ended and the last of its values is
+ * gone, so freeing a tree only walks it to drop references.
+ *
+ * Only the thread that owns the scope bumps the allocation pointer, so that
+ * doesn't need a lock. Values that grow on other threads, or after the scope
+ * ended, get a separate chunk per allocation.
+ *
+ * Buffers that are replaced when values grow are not leaked until the arena is
+ * freed: during the scope they are reused for later allocations of the same
+ * size, and separate chunks are freed right away.
+ */
+
+#define ARENA_ALIGN 8
+#define ARENA_ALIGN_UP(Size)                                                   \
+    (((Size) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define ARENA_FIRST_CHUNK_SIZE 2048
+#define ARENA_MAX_CHUNK_SIZE (64 * 1024)
+// While its scope is active, the refcount of an arena is biased by this, so
+// that values freed during the scope can't release the arena. The values
+// created during the scope are only accounted for at its end.
+#define ARENA_SCOPE_REFS (LONG_MAX / 2)
+
+// replaced buffers are reused for sizes from 16 bytes to 512 KiB
+#define ARENA_FREE_MIN_SHIFT 4
+#define ARENA_FREE_CLASSES 16
+
+typedef struct arena_chunk_s {
+    struct arena_chunk_s *next;
+} arena_chunk_t;
+
+typedef struct arena_free_s {
+    struct arena_free_s *next;
+} arena_free_t;
+
+struct sentry_value_arena_s {
+    long refcount;
+    long lock; // protects `foreign_chunks`
+    arena_chunk_t *foreign_chunks;
+    // the rest is only used by the owning thread during the scope
+    sentry_value_arena_t *prev; // the arena that was active before
+    arena_chunk_t *chunks; // the first chunk is part of this allocation
+    char *pos;
+    char *end;
+    size_t next_chunk_size;
+    long created; // the number of values created during the scope
+    // replaced power of two sized buffers, by size
+    arena_free_t *free_buffers[ARENA_FREE_CLASSES];
+};
+
+// things allocated from an arena are prefixed with the arena they belong to
+typedef struct {
+    sentry_value_arena_t *arena;
+    thing_t thing;
+} arena_thing_t;
+
+static SENTRY_THREAD_LOCAL sentry_value_arena_t *g_arena = NULL;
+// The number of arenas active on any thread, so that the thread-local is only
+// read while there are any.
+static volatile long g_active_arenas = 0;
+
+/**
+ * Arenas are not used while crashing, since the first access to the
+ * thread-local on a thread may allocate, which is not safe in a signal handler.
+ * All backends enable the page allocator in that case.
+ */
+static bool
+arenas_disabled(void)
+{
+#ifdef SENTRY_PLATFORM_UNIX
+    return sentry__page_allocator_enabled();
+#else
+    return false;
+#endif
+}
+
+sentry_value_arena_t *
+sentry__value_arena_begin(void)
+{
+    if (arenas_disabled()) {
+        return NULL;
+    }
+    const size_t header_size = ARENA_ALIGN_UP(sizeof(sentry_value_arena_t));
+    sentry_value_arena_t *arena
+        = sentry_malloc(header_size + ARENA_FIRST_CHUNK_SIZE);
+    if (!arena) {
+        return NULL;
+    }
+    arena->refcount = ARENA_SCOPE_REFS;
+    arena->lock = 0;
+    arena->foreign_chunks = NULL;
+    arena->prev = g_arena;
+    arena->chunks = NULL;
+    arena->pos = (char *)arena + header_size;
+    arena->end = arena->pos + ARENA_FIRST_CHUNK_SIZE;
+    arena->next_chunk_size = 2 * ARENA_FIRST_CHUNK_SIZE;
+    arena->created = 0;
+    memset(arena->free_buffers, 0, sizeof(arena->free_buffers));
+
+    sentry__atomic_fetch_and_add(&g_active_arenas, 1);
+    g_arena = arena;
+    return arena;
+}
+
+static void
+free_chunks(arena_chunk_t *chunk)
+{
+    while (chunk) {
+        arena_chunk_t *next = chunk->next;
+        sentry_free(chunk);
+        chunk = next;
+    }
+}
+
+static void
+arena_decref(sentry_value_arena_t *arena, long count)
+{
+    if (sentry__atomic_fetch_and_add(&arena->refcount, -count) != count) {
+        return;
+    }
+    free_chunks(arena->chunks);
+    free_chunks(arena->foreign_chunks);
+    sentry_free(arena);
+}
+
+void
+sentry__value_arena_end(sentry_value_arena_t *arena)
+{
+    if (!arena) {
+        return;
+    }
+    g_arena = arena->prev;
+    sentry__atomic_fetch_and_add(&g_active_arenas, -1);
+    arena_decref(arena, ARENA_SCOPE_REFS - arena->created);
+}
+
+static sentry_value_arena_t *
+current_arena(void)
+{
+    if (!sentry__atomic_fetch_relaxed(&g_active_arenas) || arenas_disabled()) {
+        return NULL;
+    }
+    return g_arena;
+}
+
+/**
+ * Returns the index into `free_buffers` for buffers of `size`, or -1 if
+ * buffers of that size are not reused.
+ */
+static int
+arena_free_class(size_t size)
+{
+    if (size & (size - 1)) {
+        return -1;
+    }
+    int shift = 0;
+    while (((size_t)1 << shift) < size) {
+        shift++;
+    }
+    shift -= ARENA_FREE_MIN_SHIFT;
+    return shift >= 0 && shift < ARENA_FREE_CLASSES ? shift : -1;
+}
+
+static void *
+arena_alloc(sentry_value_arena_t *arena, size_t size)
+{
+    if (size > ARENA_MAX_CHUNK_SIZE * (size_t)1024) {
+        return NULL;
+    }
+    size = ARENA_ALIGN_UP(size);
+    const size_t header_size = ARENA_ALIGN_UP(sizeof(arena_chunk_t));
+    arena_chunk_t *chunk;
+
+    if (arena != current_arena()) {
+        chunk = sentry_malloc(header_size + size);
+        if (!chunk) {
+            return NULL;
+        }
+        while (!sentry__atomic_compare_swap(&arena->lock, 0, 1)) {
+            sentry__cpu_relax();
+        }
+        chunk->next = arena->foreign_chunks;
+        arena->foreign_chunks = chunk;
+        sentry__atomic_store(&arena->lock, 0);
+        return (char *)chunk + header_size;
+    }
+
+    int free_class = arena_free_class(size);
+    if (free_class >= 0 && arena->free_buffers[free_class]) {
+        arena_free_t *buffer = arena->free_buffers[free_class];
+        arena->free_buffers[free_class] = buffer->next;
+        return buffer;
+    }
+    if (size > ARENA_MAX_CHUNK_SIZE / 4) {
+        // large allocations get a chunk of their own, so that the remainder
+        // of the current chunk isn't wasted
+        chunk = sentry_malloc(header_size + size);
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        return (char *)chunk + header_size;
+    }
+    if ((size_t)(arena->end - arena->pos) < size) {
+        const size_t chunk_size = arena->next_chunk_size;
+        chunk = sentry_malloc(header_size + chunk_size);
+        if (!chunk) {
+            return NULL;
+        }
+        chunk->next = arena->chunks;
+        arena->chunks = chunk;
+        arena->pos = (char *)chunk + header_size;
+        arena->end = arena->pos + chunk_size;
+        if (arena->next_chunk_size < ARENA_MAX_CHUNK_SIZE) {
+            arena->next_chunk_size *= 2;
+        }
+    }
+    char *rv = arena->pos;
+    arena->pos += size;
+    return rv;
+}
+
+/**
+ * Releases a buffer of `size` bytes that is no longer used. During the scope
+ * it is kept for reuse, otherwise it is freed if it has a chunk of its own.
+ */
+static void
+arena_release(sentry_value_arena_t *arena, void *ptr, size_t size)
+{
+    if (!ptr) {
+        return;
+    }
+    size = ARENA_ALIGN_UP(size);
+    if (arena == current_arena()) {
+        int free_class = arena_free_class(size);
+        if (free_class >= 0) {
+            arena_free_t *buffer = ptr;
+            buffer->next = arena->free_buffers[free_class];
+            arena->free_buffers[free_class] = buffer;
+            return;
+        }
+    }
+
+    const size_t header_size = ARENA_ALIGN_UP(sizeof(arena_chunk_t));
+    arena_chunk_t *chunk = (arena_chunk_t *)(void *)((char *)ptr - header_size);
+    bool found = false;
+    while (!sentry__atomic_compare_swap(&arena->lock, 0, 1)) {
+        sentry__cpu_relax();
+    }
+    for (arena_chunk_t **it = &arena->foreign_chunks; *it; it = &(*it)->next) {
+        if (*it == chunk) {
+            *it = chunk->next;
+            found = true;
+            break;
+        }
+    }
+    sentry__atomic_store(&arena->lock, 0);
+    if (found) {
+        sentry_free(chunk);
+    }
+}
+
+static sentry_value_arena_t *
+thing_arena(const thing_t *thing)
+{
+    if (!(thing->type & THING_TYPE_ARENA)) {
+        return NULL;
+    }
+    return ((const arena_thing_t *)(const void *)((const char *)thing
+                - offsetof(arena_thing_t, thing)))
+        ->arena;
+}
+
+/**
+ * Allocates memory owned by `thing`, which comes from its arena if it has one.
+ */
+static void *
+thing_alloc(const thing_t *thing, size_t size)
+{
+    sentry_value_arena_t *arena = thing_arena(thing);
+    return arena ? arena_alloc(arena, size) : sentry_malloc(size);
+}
+
+static void
+thing_dealloc(const thing_t *thing, void *ptr)
+{
+    if (!(thing->type & THING_TYPE_ARENA)) {
+        sentry_free(ptr);
+    }
+}
+
+/**
+ * Releases a buffer of `size` bytes that `thing` replaced with a new one.
+ */
+static void
+thing_dealloc_replaced(const thing_t *thing, void *ptr, size_t size)
+{
+    sentry_value_arena_t *arena = thing_arena(thing);
+    if (arena) {
+        arena_release(arena, ptr, size);
+    } else {
+        sentry_free(ptr);
+    }
+}
+
+/**
+ * Creates a new thing with a refcount of 1 and an unset payload, allocated
+ * from `arena` if given, which must be the current arena.
+ */
+static thing_t *
+thing_new(uint8_t thing_type, sentry_value_arena_t *arena)
+{
+    thing_t *thing;
+    if (arena) {
+        arena_thing_t *arena_thing = arena_alloc(arena, sizeof(arena_thing_t));
+        if (!arena_thing) {
+            return NULL;
+        }
+        arena->created++;
+        arena_thing->arena = arena;
+        thing = &arena_thing->thing;
+        thing_type |= THING_TYPE_ARENA;
+    } else {
+        thing = sentry_malloc(sizeof(thing_t));
+        if (!thing) {
+            return NULL;
+        }
+    }
+    thing->payload._ptr = NULL;
+    thing->refcount = 1;
+    thing->type = thing_type;
+    return thing;
+}
+
+/**
+ * Releases the memory of `thing` itself, but not of what it owns.
+ */
+static void
+thing_release(thing_t *thing)
+{
+    sentry_value_arena_t *arena = thing_arena(thing);
+    if (arena) {
+        arena_decref(arena, 1);
+    } else {
+        sentry_free(thing);
+    }
+}
+
+static sentry_value_t
+thing_as_value(const thing_t *thing)
+{
+    sentry_value_t rv;
+    rv._bits = (uint64_t)(size_t)thing;
+    return rv;
+}
+
 static const char *
 level_as_string(sentry_level_t level)
 {
@@ -127,7 +535,8 @@ level_as_string(sentry_level_t level)
 }
 
 static bool
-reserve(void **buf, size_t item_size, size_t *allocated, size_t min_len)
+reserve(const thing_t *thing, void **buf, size_t item_size, size_t *allocated,
+    size_t min_len)
 {
     if (*allocated >= min_len) {
         return true;
@@ -140,20 +549,448 @@ reserve(void **buf, size_t item_size, size_t *allocated, size_t min_len)
         new_allocated *= 2;
     }
 
-    void *new_buf = sentry_malloc(new_allocated * item_size);
+    void *new_buf = thing_alloc(thing, new_allocated * item_size);
     if (!new_buf) {
         return false;
     }
 
     if (*buf) {
         memcpy(new_buf, *buf, *allocated * item_size);
-        sentry_free(*buf);
+        thing_dealloc_replaced(thing, *buf, *allocated * item_size);
     }
     *buf = new_buf;
     *allocated = new_allocated;
     return true;
 }
 
+/**
+ * Keys that are used by the SDK itself, sorted by `strcmp`. Object keys that
+ * match one of these point into `g_keys` instead of owning a heap copy.
+ */
+#define INTERNED_KEYS(X)                                                       \
+    X(arch, "arch")                                                            \
+    X(attributes, "attributes")                                                \
+    X(body, "body")                                                            \
+    X(breadcrumbs, "breadcrumbs")                                              \
+    X(build, "build")                                                          \
+    X(category, "category")                                                    \
+    X(code_file, "code_file")                                                  \
+    X(code_id, "code_id")                                                      \
+    X(contexts, "contexts")                                                    \
+    X(crashed, "crashed")                                                      \
+    X(current, "current")                                                      \
+    X(data, "data")                                                            \
+    X(debug_file, "debug_file")                                                \
+    X(debug_id, "debug_id")                                                    \
+    X(debug_meta, "debug_meta")                                                \
+    X(description, "description")                                              \
+    X(device, "device")                                                        \
+    X(dist, "dist")                                                            \
+    X(email, "email")                                                          \
+    X(environment, "environment")                                              \
+    X(event_id, "event_id")                                                    \
+    X(exception, "exception")                                                  \
+    X(extra, "extra")                                                          \
+    X(filename, "filename")                                                    \
+    X(fingerprint, "fingerprint")                                              \
+    X(formatted, "formatted")                                                  \
+    X(fp, "fp")                                                                \
+    X(frames, "frames")                                                        \
+    X(function, "function")                                                    \
+    X(handled, "handled")                                                      \
+    X(id, "id")                                                                \
+    X(image_addr, "image_addr")                                                \
+    X(image_size, "image_size")                                                \
+    X(images, "images")                                                        \
+    X(instruction_addr, "instruction_addr")                                    \
+    X(integrations, "integrations")                                            \
+    X(ip_address, "ip_address")                                                \
+    X(items, "items")                                                          \
+    X(level, "level")                                                          \
+    X(lineno, "lineno")                                                        \
+    X(logger, "logger")                                                        \
+    X(lr, "lr")                                                                \
+    X(mechanism, "mechanism")                                                  \
+    X(message, "message")                                                      \
+    X(meta, "meta")                                                            \
+    X(module, "module")                                                        \
+    X(name, "name")                                                            \
+    X(op, "op")                                                                \
+    X(origin, "origin")                                                        \
+    X(os, "os")                                                                \
+    X(os_name, "os.name")                                                      \
+    X(os_version, "os.version")                                                \
+    X(package, "package")                                                      \
+    X(packages, "packages")                                                    \
+    X(params, "params")                                                        \
+    X(parent_span_id, "parent_span_id")                                        \
+    X(pc, "pc")                                                                \
+    X(platform, "platform")                                                    \
+    X(registers, "registers")                                                  \
+    X(release, "release")                                                      \
+    X(sample_rand, "sample_rand")                                              \
+    X(sampled, "sampled")                                                      \
+    X(sdk, "sdk")                                                              \
+    X(segment, "segment")                                                      \
+    X(sentry_environment, "sentry.environment")                                \
+    X(sentry_message_template, "sentry.message.template")                      \
+    X(sentry_origin, "sentry.origin")                                          \
+    X(sentry_release, "sentry.release")                                        \
+    X(sentry_sdk_name, "sentry.sdk.name")                                      \
+    X(sentry_sdk_version, "sentry.sdk.version")                                \
+    X(sentry_trace_parent_span_id, "sentry.trace.parent_span_id")              \
+    X(server_name, "server_name")                                              \
+    X(signal, "signal")                                                        \
+    X(sp, "sp")                                                                \
+    X(span_id, "span_id")                                                      \
+    X(stacktrace, "stacktrace")                                                \
+    X(start_timestamp, "start_timestamp")                                      \
+    X(status, "status")                                                        \
+    X(tags, "tags")                                                            \
+    X(threads, "threads")                                                      \
+    X(timestamp, "timestamp")                                                  \
+    X(trace, "trace")                                                          \
+    X(trace_id, "trace_id")                                                    \
+    X(transaction, "transaction")                                              \
+    X(trust, "trust")                                                          \
+    X(type, "type")                                                            \
+    X(unit, "unit")                                                            \
+    X(user, "user")                                                            \
+    X(user_email, "user.email")                                                \
+    X(user_id, "user.id")                                                      \
+    X(user_ip_address, "user.ip_address")                                      \
+    X(user_name, "user.name")                                                  \
+    X(username, "username")                                                    \
+    X(value, "value")                                                          \
+    X(values, "values")                                                        \
+    X(version, "version")
+
+#define INTERNED_KEY_FIELD(Id, Str) char Id[sizeof(Str)];
+#define INTERNED_KEY_STR(Id, Str) Str,
+#define INTERNED_KEY_PTR(Id, Str) g_keys.Id,
+#define INTERNED_KEY_LEN(Id, Str) | (1u << (sizeof(Str) - 1))
+
+// all interned strings live in a single block, so telling whether a key is
+// interned is a range check
+static const struct {
+    INTERNED_KEYS(INTERNED_KEY_FIELD)
+} g_keys = { INTERNED_KEYS(INTERNED_KEY_STR) };
+
+static const char *const g_sorted_keys[] = { INTERNED_KEYS(INTERNED_KEY_PTR) };
+
+// bit `n` is set if there is an interned key of length `n`
+static const uint32_t g_key_lengths = 0 INTERNED_KEYS(INTERNED_KEY_LEN);
+
+#undef INTERNED_KEY_FIELD
+#undef INTERNED_KEY_STR
+#undef INTERNED_KEY_PTR
+#undef INTERNED_KEY_LEN
+#undef INTERNED_KEYS
+
+static bool
+is_interned(const char *k)
+{
+    return (uintptr_t)k - (uintptr_t)&g_keys < sizeof(g_keys);
+}
+
+/**
+ * Returns `k` if it is the start of one of the interned keys, without
+ * searching. Suffixes of interned keys don't count.
+ */
+static const char *
+as_interned(const char *k, size_t k_len)
+{
+    if (!is_interned(k)) {
+        return NULL;
+    }
+    // index through `g_keys` so nothing is read outside of it
+    const char *base = (const char *)&g_keys;
+    size_t offset = (size_t)(k - base);
+    if ((offset == 0 || base[offset - 1] == '\0')
+        && k_len < sizeof(g_keys) - offset && base[offset + k_len] == '\0') {
+        return k;
+    }
+    return NULL;
+}
+
+static int
+compare_key(const char *key, const char *k, size_t k_len)
+{
+    for (size_t i = 0; i < k_len; i++) {
+        const int rv = (uint8_t)key[i] - (uint8_t)k[i];
+        if (rv != 0) {
+            return rv;
+        }
+        if (!key[i]) {
+            // `k` contains a NUL byte, which `key` ends with
+            return -1;
+        }
+    }
+    return key[k_len] ? 1 : 0;
+}
+
+/**
+ * Returns the index of `k` in the sorted `table`, or `count` if it isn't
+ * present. Bit `n` of `lengths` is set if the table has strings of length `n`.
+ */
+static size_t
+find_sorted(const char *const *table, size_t count, uint32_t lengths,
+    const char *k, size_t k_len)
+{
+    if (k_len >= 32 || !(lengths & (1u << k_len))) {
+        return count;
+    }
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const int rv = compare_key(table[mid], k, k_len);
+        if (rv == 0) {
+            return mid;
+        }
+        if (rv < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return count;
+}
+
+const char *
+sentry__value_intern_key(const char *k, size_t k_len)
+{
+    const char *interned = as_interned(k, k_len);
+    if (interned) {
+        return interned;
+    }
+    const size_t count = sizeof(g_sorted_keys) / sizeof(g_sorted_keys[0]);
+    const size_t i = find_sorted(g_sorted_keys, count, g_key_lengths, k, k_len);
+    return i < count ? g_sorted_keys[i] : NULL;
+}
+
+#ifdef SENTRY_UNITTEST
+const char *const *
+sentry__value_interned_keys(size_t *count)
+{
+    *count = sizeof(g_sorted_keys) / sizeof(g_sorted_keys[0]);
+    return g_sorted_keys;
+}
+#endif
+
+static const char *
+new_key(const thing_t *thing, sentry_slice_t k)
+{
+    char *rv = thing_alloc(thing, k.len + 1);
+    if (rv) {
+        memcpy(rv, k.ptr, k.len);
+        rv[k.len] = '\0';
+    }
+    return rv;
+}
+
+static void
+free_key(const thing_t *thing, const char *k)
+{
+    if (!is_interned(k)) {
+        thing_dealloc(thing, (char *)k);
+    }
+}
+
+/**
+ * String values that are common enough to be stored inline, sorted by
+ * `strcmp`. `sentry_value_as_string` returns pointers into this table.
+ */
+#define INLINE_STRINGS(X)                                                      \
+    X("")                                                                      \
+    X("abnormal")                                                              \
+    X("array")                                                                 \
+    X("auto")                                                                  \
+    X("boolean")                                                               \
+    X("c")                                                                     \
+    X("crashed")                                                               \
+    X("debug")                                                                 \
+    X("default")                                                               \
+    X("double")                                                                \
+    X("error")                                                                 \
+    X("event")                                                                 \
+    X("exited")                                                                \
+    X("false")                                                                 \
+    X("fatal")                                                                 \
+    X("generic")                                                               \
+    X("info")                                                                  \
+    X("integer")                                                               \
+    X("log")                                                                   \
+    X("manual")                                                                \
+    X("native")                                                                \
+    X("ok")                                                                    \
+    X("other")                                                                 \
+    X("signalhandler")                                                         \
+    X("string")                                                                \
+    X("trace")                                                                 \
+    X("true")                                                                  \
+    X("unknown")                                                               \
+    X("warning")
+
+#define INLINE_STRING_STR(Str) Str,
+#define INLINE_STRING_LEN(Str) | (1u << (sizeof(Str) - 1))
+
+static const char *const g_inline_strings[]
+    = { INLINE_STRINGS(INLINE_STRING_STR) };
+static const uint32_t g_inline_string_lengths
+    = 0 INLINE_STRINGS(INLINE_STRING_LEN);
+
+#undef INLINE_STRING_STR
+#undef INLINE_STRING_LEN
+#undef INLINE_STRINGS
+
+#define INLINE_STRING_COUNT                                                    \
+    (sizeof(g_inline_strings) / sizeof(g_inline_strings[0]))
+
+static int
+inline_kind(uint64_t bits)
+{
+    if ((bits & INLINE_DOUBLE_MASK) == INLINE_DOUBLE) {
+        return INLINE_DOUBLE;
+    }
+    return (int)(bits & INLINE_KIND_MASK);
+}
+
+static bool
+is_inline(sentry_value_t value, int kind)
+{
+    return (value._bits & TAG_MASK) == TAG_INLINE
+        && inline_kind(value._bits) == kind;
+}
+
+static bool
+inline_double(double value, sentry_value_t *rv)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    if (!(bits & INLINE_KIND_MASK)) {
+        rv->_bits = bits | INLINE_DOUBLE_BITS;
+        return true;
+    }
+    const uint64_t rotated = bits << INLINE_SHIFT | bits >> (64 - INLINE_SHIFT);
+    const uint64_t expected = (rotated & 0x8) ? 0 : 0x7;
+    if ((rotated & 0x7) != expected) {
+        return false;
+    }
+    rv->_bits = rotated | INLINE_DOUBLE;
+    return true;
+}
+
+static double
+inline_as_double(sentry_value_t value)
+{
+    uint64_t bits = value._bits;
+    if (inline_kind(bits) == INLINE_DOUBLE) {
+        bits = (bits & ~(uint64_t)0x7) | ((bits & 0x8) ? 0 : 0x7);
+        bits = bits >> INLINE_SHIFT | bits << (64 - INLINE_SHIFT);
+    } else {
+        bits &= ~(uint64_t)INLINE_KIND_MASK;
+    }
+    double rv;
+    memcpy(&rv, &bits, sizeof(rv));
+    return rv;
+}
+
+static uint32_t
+hash_key(const char *k, size_t k_len)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < k_len; i++) {
+        hash ^= (uint8_t)k[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void
+obj_index_insert(obj_t *o, uint32_t hash, size_t pos)
+{
+    const size_t mask = o->index_size - 1;
+    size_t i = hash & mask;
+    while (o->index[i].pos) {
+        i = (i + 1) & mask;
+    }
+    o->index[i].hash = hash;
+    o->index[i].pos = (uint32_t)pos + 1;
+}
+
+/**
+ * Drops the index of objects that shrank below the threshold, and (re)builds
+ * it for all others. If the index can't be allocated, the object falls back
+ * to linear scans.
+ */
+static void
+obj_index_rebuild(const thing_t *thing, obj_t *o)
+{
+    thing_dealloc_replaced(
+        thing, o->index, o->index_size * sizeof(obj_index_slot_t));
+    o->index = NULL;
+    o->index_size = 0;
+    if (o->len <= OBJ_INDEX_THRESHOLD || o->len >= UINT32_MAX) {
+        return;
+    }
+
+    size_t size = 4 * OBJ_INDEX_THRESHOLD;
+    while (size < 2 * o->len) {
+        size *= 2;
+    }
+    o->index = thing_alloc(thing, size * sizeof(obj_index_slot_t));
+    if (!o->index) {
+        return;
+    }
+    memset(o->index, 0, size * sizeof(obj_index_slot_t));
+    o->index_size = size;
+    for (size_t i = 0; i < o->len; i++) {
+        obj_index_insert(o, hash_key(o->pairs[i].k, strlen(o->pairs[i].k)), i);
+    }
+}
+
+/**
+ * Every key that has an interned version is stored as that, so lookups that
+ * resolve their key to the interned version compare by pointer. All other
+ * keys are compared by content.
+ */
+static bool
+key_eq(const char *pair_k, sentry_slice_t k, const char *interned)
+{
+    if (interned) {
+        return pair_k == interned;
+    }
+    return sentry__slice_eqs(k, pair_k);
+}
+
+/**
+ * Returns the position of `k` in `pairs`, or `len` if it isn't present.
+ * `interned` is the interned version of `k`, if known.
+ */
+static size_t
+obj_find(const obj_t *o, sentry_slice_t k, uint32_t hash, const char *interned)
+{
+    if (o->index) {
+        const size_t mask = o->index_size - 1;
+        for (size_t i = hash & mask; o->index[i].pos; i = (i + 1) & mask) {
+            const size_t pos = o->index[i].pos - 1;
+            if (o->index[i].hash == hash
+                && key_eq(o->pairs[pos].k, k, interned)) {
+                return pos;
+            }
+        }
+        return o->len;
+    }
+    for (size_t i = 0; i < o->len; i++) {
+        if (key_eq(o->pairs[i].k, k, interned)) {
+            return i;
+        }
+    }
+    return o->len;
+}
+
 static int
 thing_get_type(const thing_t *thing)
 {
@@ -169,26 +1006,27 @@ thing_free(thing_t *thing)
         for (size_t i = 0; i < list->len; i++) {
             sentry_value_decref(list->items[i]);
         }
-        sentry_free(list->items);
-        sentry_free(list);
+        thing_dealloc(thing, list->items);
+        thing_dealloc(thing, list);
         break;
     }
     case THING_TYPE_OBJECT: {
         obj_t *obj = thing->payload._ptr;
         for (size_t i = 0; i < obj->len; i++) {
-            sentry_free(obj->pairs[i].k);
+            free_key(thing, obj->pairs[i].k);
             sentry_value_decref(obj->pairs[i].v);
         }
-        sentry_free(obj->pairs);
-        sentry_free(obj);
+        thing_dealloc(thing, obj->pairs);
+        thing_dealloc(thing, obj->index);
+        thing_dealloc(thing, obj);
         break;
     }
     case THING_TYPE_STRING: {
-        sentry_free(thing->payload._ptr);
+        thing_dealloc(thing, thing->payload._ptr);
         break;
     }
     }
-    sentry_free(thing);
+    thing_release(thing);
 }
 
 static int
@@ -223,22 +1061,6 @@ thing_freeze(thing_t *thing)
     }
 }
 
-static sentry_value_t
-new_thing_value(void *ptr, uint8_t thing_type)
-{
-    thing_t *thing = sentry_malloc(sizeof(thing_t));
-    if (!thing) {
-        return sentry_value_new_null();
-    }
-    thing->payload._ptr = ptr;
-    thing->refcount = 1;
-    thing->type = thing_type;
-
-    sentry_value_t rv;
-    rv._bits = (uint64_t)(size_t)thing;
-    return rv;
-}
-
 static thing_t *
 value_as_thing(sentry_value_t value)
 {
@@ -255,6 +1077,28 @@ value_as_unfrozen_thing(sentry_value_t value)
     return thing && !thing_is_frozen(thing) ? thing : NULL;
 }
 
+#ifdef SENTRY_UNITTEST
+bool
+sentry__value_is_arena_allocated(sentry_value_t value)
+{
+    const thing_t *thing = value_as_thing(value);
+    return thing && thing_arena(thing);
+}
+
+size_t
+sentry__value_arena_foreign_chunks(sentry_value_t value)
+{
+    const thing_t *thing = value_as_thing(value);
+    sentry_value_arena_t *arena = thing ? thing_arena(thing) : NULL;
+    size_t count = 0;
+    for (arena_chunk_t *chunk = arena ? arena->foreign_chunks : NULL; chunk;
+        chunk = chunk->next) {
+        count++;
+    }
+    return count;
+}
+#endif
+
 /* public api implementations */
 
 void
@@ -317,49 +1161,52 @@ sentry_value_new_int32(int32_t value)
 sentry_value_t
 sentry_value_new_double(double value)
 {
-    thing_t *thing = SENTRY_MAKE(thing_t);
+    sentry_value_t rv;
+    if (inline_double(value, &rv)) {
+        return rv;
+    }
+    thing_t *thing = thing_new(
+        (uint8_t)(THING_TYPE_DOUBLE | THING_TYPE_FROZEN), current_arena());
     if (!thing) {
         return sentry_value_new_null();
     }
     thing->payload._double = value;
-    thing->refcount = 1;
-    thing->type = (uint8_t)(THING_TYPE_DOUBLE | THING_TYPE_FROZEN);
-
-    sentry_value_t rv;
-    rv._bits = (uint64_t)(size_t)thing;
-    return rv;
+    return thing_as_value(thing);
 }
 
 sentry_value_t
 sentry_value_new_int64(int64_t value)
 {
-    thing_t *thing = SENTRY_MAKE(thing_t);
+    const int64_t limit = (int64_t)1 << (63 - INLINE_SHIFT);
+    if (value >= -limit && value < limit) {
+        sentry_value_t rv;
+        rv._bits = (uint64_t)value << INLINE_SHIFT | INLINE_INT64;
+        return rv;
+    }
+    thing_t *thing = thing_new(
+        (uint8_t)(THING_TYPE_INT64 | THING_TYPE_FROZEN), current_arena());
     if (!thing) {
         return sentry_value_new_null();
     }
     thing->payload._i64 = value;
-    thing->refcount = 1;
-    thing->type = (uint8_t)(THING_TYPE_INT64 | THING_TYPE_FROZEN);
-
-    sentry_value_t rv;
-    rv._bits = (uint64_t)(size_t)thing;
-    return rv;
+    return thing_as_value(thing);
 }
 
 sentry_value_t
 sentry_value_new_uint64(uint64_t value)
 {
-    thing_t *thing = SENTRY_MAKE(thing_t);
+    if (value < (uint64_t)1 << (64 - INLINE_SHIFT)) {
+        sentry_value_t rv;
+        rv._bits = value << INLINE_SHIFT | INLINE_UINT64;
+        return rv;
+    }
+    thing_t *thing = thing_new(
+        (uint8_t)(THING_TYPE_UINT64 | THING_TYPE_FROZEN), current_arena());
     if (!thing) {
         return sentry_value_new_null();
     }
     thing->payload._u64 = value;
-    thing->refcount = 1;
-    thing->type = (uint8_t)(THING_TYPE_UINT64 | THING_TYPE_FROZEN);
-
-    sentry_value_t rv;
-    rv._bits = (uint64_t)(size_t)thing;
-    return rv;
+    return thing_as_value(thing);
 }
 
 sentry_value_t
@@ -373,6 +1220,35 @@ sentry_value_new_bool(int value)
 sentry_value_t
 sentry_value_new_string_n(const char *value, size_t value_len)
 {
+    if (!value) {
+        return sentry_value_new_null();
+    }
+    const size_t index = find_sorted(g_inline_strings, INLINE_STRING_COUNT,
+        g_inline_string_lengths, value, value_len);
+    if (index < INLINE_STRING_COUNT) {
+        sentry_value_t rv;
+        rv._bits = (uint64_t)index << INLINE_SHIFT | INLINE_STRING;
+        return rv;
+    }
+
+    sentry_value_arena_t *arena = current_arena();
+    if (arena) {
+        thing_t *thing
+            = thing_new(THING_TYPE_STRING | THING_TYPE_FROZEN, arena);
+        if (!thing) {
+            return sentry_value_new_null();
+        }
+        char *s = arena_alloc(arena, value_len + 1);
+        if (!s) {
+            thing_release(thing);
+            return sentry_value_new_null();
+        }
+        memcpy(s, value, value_len);
+        s[value_len] = '\0';
+        thing->payload._ptr = s;
+        return thing_as_value(thing);
+    }
+
     char *s = sentry__string_clone_n(value, value_len);
     if (!s) {
         return sentry_value_new_null();
@@ -390,79 +1266,69 @@ sentry_value_new_string(const char *value)
 sentry_value_t
 sentry_value_new_list(void)
 {
-    list_t *l = SENTRY_MAKE(list_t);
-    if (l) {
-        sentry_value_t rv = new_thing_value(l, THING_TYPE_LIST);
-        if (sentry_value_is_null(rv)) {
-            sentry_free(l);
-        }
-        return rv;
-    } else {
-        return sentry_value_new_null();
-    }
+    return sentry__value_new_list_with_size(0);
 }
 
 sentry_value_t
 sentry__value_new_list_with_size(size_t size)
 {
-    list_t *l = SENTRY_MAKE(list_t);
-    if (l) {
-        l->allocated = size;
-        if (size) {
-            l->items = sentry_malloc(sizeof(sentry_value_t) * size);
-            if (!l->items) {
-                sentry_free(l);
-                return sentry_value_new_null();
-            }
-        }
-        sentry_value_t rv = new_thing_value(l, THING_TYPE_LIST);
-        if (sentry_value_is_null(rv)) {
-            sentry_free(l->items);
-            sentry_free(l);
-        }
-        return rv;
-    } else {
+    thing_t *thing = thing_new(THING_TYPE_LIST, current_arena());
+    if (!thing) {
         return sentry_value_new_null();
     }
+    list_t *l = thing_alloc(thing, sizeof(list_t));
+    if (!l) {
+        goto fail;
+    }
+    memset(l, 0, sizeof(list_t));
+    l->allocated = size;
+    if (size) {
+        l->items = thing_alloc(thing, sizeof(sentry_value_t) * size);
+        if (!l->items) {
+            thing_dealloc(thing, l);
+            goto fail;
+        }
+    }
+    thing->payload._ptr = l;
+    return thing_as_value(thing);
+
+fail:
+    thing_release(thing);
+    return sentry_value_new_null();
 }
 
 sentry_value_t
 sentry_value_new_object(void)
 {
-    obj_t *o = SENTRY_MAKE(obj_t);
-    if (o) {
-        sentry_value_t rv = new_thing_value(o, THING_TYPE_OBJECT);
-        if (sentry_value_is_null(rv)) {
-            sentry_free(o);
-        }
-        return rv;
-    } else {
-        return sentry_value_new_null();
-    }
+    return sentry__value_new_object_with_size(0);
 }
 
 sentry_value_t
 sentry__value_new_object_with_size(size_t size)
 {
-    obj_t *o = SENTRY_MAKE(obj_t);
-    if (o) {
-        o->allocated = size;
-        if (size) {
-            o->pairs = sentry_malloc(sizeof(obj_pair_t) * size);
-            if (!o->pairs) {
-                sentry_free(o);
-                return sentry_value_new_null();
-            }
-        }
-        sentry_value_t rv = new_thing_value(o, THING_TYPE_OBJECT);
-        if (sentry_value_is_null(rv)) {
-            sentry_free(o->pairs);
-            sentry_free(o);
-        }
-        return rv;
-    } else {
+    thing_t *thing = thing_new(THING_TYPE_OBJECT, current_arena());
+    if (!thing) {
         return sentry_value_new_null();
     }
+    obj_t *o = thing_alloc(thing, sizeof(obj_t));
+    if (!o) {
+        goto fail;
+    }
+    memset(o, 0, sizeof(obj_t));
+    o->allocated = size;
+    if (size) {
+        o->pairs = thing_alloc(thing, sizeof(obj_pair_t) * size);
+        if (!o->pairs) {
+            thing_dealloc(thing, o);
+            goto fail;
+        }
+    }
+    thing->payload._ptr = o;
+    return thing_as_value(thing);
+
+fail:
+    thing_release(thing);
+    return sentry_value_new_null();
 }
 
 sentry_value_t
@@ -622,6 +1488,18 @@ sentry_value_get_type(sentry_value_t value)
         return SENTRY_VALUE_TYPE_BOOL;
     } else if ((value._bits & TAG_MASK) == TAG_INT32) {
         return SENTRY_VALUE_TYPE_INT32;
+    } else if ((value._bits & TAG_MASK) == TAG_INLINE) {
+        switch (inline_kind(value._bits)) {
+        case INLINE_DOUBLE:
+        case INLINE_DOUBLE_BITS:
+            return SENTRY_VALUE_TYPE_DOUBLE;
+        case INLINE_INT64:
+            return SENTRY_VALUE_TYPE_INT64;
+        case INLINE_UINT64:
+            return SENTRY_VALUE_TYPE_UINT64;
+        case INLINE_STRING:
+            return SENTRY_VALUE_TYPE_STRING;
+        }
     }
     UNREACHABLE("invalid value type");
     return SENTRY_VALUE_TYPE_NULL;
@@ -640,27 +1518,33 @@ sentry_value_set_by_key_n(
         goto fail;
     }
     obj_t *o = thing->payload._ptr;
-    for (size_t i = 0; i < o->len; i++) {
-        obj_pair_t *pair = &o->pairs[i];
-        if (sentry__slice_eqs(k_slice, pair->k)) {
-            sentry_value_decref(pair->v);
-            pair->v = v;
-            return 0;
-        }
+    const char *interned = sentry__value_intern_key(k, k_len);
+    const uint32_t hash = o->index ? hash_key(k, k_len) : 0;
+    const size_t pos = obj_find(o, k_slice, hash, interned);
+    if (pos < o->len) {
+        obj_pair_t *pair = &o->pairs[pos];
+        sentry_value_decref(pair->v);
+        pair->v = v;
+        return 0;
     }
 
-    if (!reserve((void **)&o->pairs, sizeof(o->pairs[0]), &o->allocated,
-            o->len + 1)) {
+    if (!reserve(thing, (void **)&o->pairs, sizeof(o->pairs[0]),
+            &o->allocated, o->len + 1)) {
         goto fail;
     }
 
     obj_pair_t pair;
-    pair.k = sentry__slice_to_owned(k_slice);
+    pair.k = interned ? interned : new_key(thing, k_slice);
     if (!pair.k) {
         goto fail;
     }
     pair.v = v;
     o->pairs[o->len++] = pair;
+    if (o->index && 2 * o->len <= o->index_size) {
+        obj_index_insert(o, hash, o->len - 1);
+    } else if (o->len > OBJ_INDEX_THRESHOLD) {
+        obj_index_rebuild(thing, o);
+    }
     return 0;
 
 fail:
@@ -691,18 +1575,22 @@ sentry_value_remove_by_key_n(sentry_value_t value, const char *k, size_t k_len)
         return 1;
     }
     obj_t *o = thing->payload._ptr;
-    for (size_t i = 0; i < o->len; i++) {
-        obj_pair_t *pair = &o->pairs[i];
-        if (sentry__slice_eqs(k_slice, pair->k)) {
-            sentry_free(pair->k);
-            sentry_value_decref(pair->v);
-            memmove(o->pairs + i, o->pairs + i + 1,
-                (o->len - i - 1) * sizeof(o->pairs[0]));
-            o->len--;
-            return 0;
-        }
+    const size_t i = obj_find(o, k_slice, o->index ? hash_key(k, k_len) : 0,
+        sentry__value_intern_key(k, k_len));
+    if (i == o->len) {
+        return 1;
     }
-    return 1;
+    obj_pair_t *pair = &o->pairs[i];
+    free_key(thing, pair->k);
+    sentry_value_decref(pair->v);
+    memmove(o->pairs + i, o->pairs + i + 1,
+        (o->len - i - 1) * sizeof(o->pairs[0]));
+    o->len--;
+    if (o->index) {
+        // the positions of all following keys have shifted
+        obj_index_rebuild(thing, o);
+    }
+    return 0;
 }
 
 int
@@ -725,8 +1613,8 @@ sentry_value_append(sentry_value_t value, sentry_value_t v)
 
     list_t *l = thing->payload._ptr;
 
-    if (!reserve((void **)&l->items, sizeof(l->items[0]), &l->allocated,
-            l->len + 1)) {
+    if (!reserve(thing, (void **)&l->items, sizeof(l->items[0]),
+            &l->allocated, l->len + 1)) {
         goto fail;
     }
 
@@ -834,8 +1722,8 @@ sentry_value_set_by_index(sentry_value_t value, size_t index, sentry_value_t v)
     }
 
     list_t *l = thing->payload._ptr;
-    if (!reserve(
-            (void *)&l->items, sizeof(l->items[0]), &l->allocated, index + 1)) {
+    if (!reserve(thing, (void *)&l->items, sizeof(l->items[0]),
+            &l->allocated, index + 1)) {
         goto fail;
     }
 
@@ -883,12 +1771,12 @@ sentry_value_get_by_key_n(sentry_value_t value, const char *k, size_t k_len)
     }
     const thing_t *thing = value_as_thing(value);
     if (thing && thing_get_type(thing) == THING_TYPE_OBJECT) {
-        obj_t *o = thing->payload._ptr;
-        for (size_t i = 0; i < o->len; i++) {
-            obj_pair_t *pair = &o->pairs[i];
-            if (sentry__slice_eqs((sentry_slice_t) { k, k_len }, pair->k)) {
-                return pair->v;
-            }
+        const obj_t *o = thing->payload._ptr;
+        const size_t pos = obj_find(o, (sentry_slice_t) { k, k_len },
+            o->index ? hash_key(k, k_len) : 0,
+            sentry__value_intern_key(k, k_len));
+        if (pos < o->len) {
+            return o->pairs[pos].v;
         }
     }
     return sentry_value_new_null();
@@ -945,6 +1833,9 @@ sentry_value_get_by_index_owned(sentry_value_t value, size_t index)
 size_t
 sentry_value_get_length(sentry_value_t value)
 {
+    if (is_inline(value, INLINE_STRING)) {
+        return strlen(sentry_value_as_string(value));
+    }
     const thing_t *thing = value_as_thing(value);
     if (thing) {
         switch (thing_get_type(thing)) {
@@ -965,15 +1856,18 @@ sentry_value_as_int32(sentry_value_t value)
     if ((value._bits & TAG_MASK) == TAG_INT32) {
         return (int32_t)((int64_t)value._bits >> 32);
     }
-    const thing_t *thing = value_as_thing(value);
-    if (thing && thing_get_type(thing) == THING_TYPE_INT64) {
+    switch (sentry_value_get_type(value)) {
+    case SENTRY_VALUE_TYPE_INT64:
         SENTRY_WARN("Cannot convert int64 into int32, returning 0");
-    }
-    if (thing && thing_get_type(thing) == THING_TYPE_UINT64) {
+        break;
+    case SENTRY_VALUE_TYPE_UINT64:
         SENTRY_WARN("Cannot convert uint64 into int32, returning 0");
-    }
-    if (thing && thing_get_type(thing) == THING_TYPE_DOUBLE) {
+        break;
+    case SENTRY_VALUE_TYPE_DOUBLE:
         SENTRY_WARN("Cannot convert double into int32, returning 0");
+        break;
+    default:
+        break;
     }
     return 0;
 }
@@ -984,15 +1878,20 @@ sentry_value_as_double(sentry_value_t value)
     if ((value._bits & TAG_MASK) == TAG_INT32) {
         return (double)(int64_t)sentry_value_as_int32(value);
     }
+    if (is_inline(value, INLINE_DOUBLE)
+        || is_inline(value, INLINE_DOUBLE_BITS)) {
+        return inline_as_double(value);
+    }
 
     const thing_t *thing = value_as_thing(value);
     if (thing && thing_get_type(thing) == THING_TYPE_DOUBLE) {
         return thing->payload._double;
     }
-    if (thing && thing_get_type(thing) == THING_TYPE_INT64) {
+    const sentry_value_type_t type = sentry_value_get_type(value);
+    if (type == SENTRY_VALUE_TYPE_INT64) {
         SENTRY_WARN("Cannot convert int64 into double, returning NAN");
     }
-    if (thing && thing_get_type(thing) == THING_TYPE_UINT64) {
+    if (type == SENTRY_VALUE_TYPE_UINT64) {
         SENTRY_WARN("Cannot convert uint64 into double, returning NAN");
     }
 
@@ -1005,15 +1904,19 @@ sentry_value_as_int64(sentry_value_t value)
     if ((value._bits & TAG_MASK) == TAG_INT32) {
         return (int64_t)sentry_value_as_int32(value);
     }
+    if (is_inline(value, INLINE_INT64)) {
+        return (int64_t)value._bits >> INLINE_SHIFT;
+    }
 
     const thing_t *thing = value_as_thing(value);
     if (thing && thing_get_type(thing) == THING_TYPE_INT64) {
         return thing->payload._i64;
     }
-    if (thing && thing_get_type(thing) == THING_TYPE_UINT64) {
+    const sentry_value_type_t type = sentry_value_get_type(value);
+    if (type == SENTRY_VALUE_TYPE_UINT64) {
         SENTRY_WARN("Cannot convert uint64 into int64, returning 0");
     }
-    if (thing && thing_get_type(thing) == THING_TYPE_DOUBLE) {
+    if (type == SENTRY_VALUE_TYPE_DOUBLE) {
         SENTRY_WARN("Cannot convert double into int64, returning 0");
     }
     return 0;
@@ -1027,14 +1930,19 @@ sentry_value_as_uint64(sentry_value_t value)
         return 0;
     }
 
+    if (is_inline(value, INLINE_UINT64)) {
+        return value._bits >> INLINE_SHIFT;
+    }
+
     const thing_t *thing = value_as_thing(value);
     if (thing && thing_get_type(thing) == THING_TYPE_UINT64) {
         return thing->payload._u64;
     }
-    if (thing && thing_get_type(thing) == THING_TYPE_INT64) {
+    const sentry_value_type_t type = sentry_value_get_type(value);
+    if (type == SENTRY_VALUE_TYPE_INT64) {
         SENTRY_WARN("Cannot convert int64 into uint64, returning 0");
     }
-    if (thing && thing_get_type(thing) == THING_TYPE_DOUBLE) {
+    if (type == SENTRY_VALUE_TYPE_DOUBLE) {
         SENTRY_WARN("Cannot convert double into uint64, returning 0");
     }
     return 0;
@@ -1043,6 +1951,9 @@ sentry_value_as_uint64(sentry_value_t value)
 const char *
 sentry_value_as_string(sentry_value_t value)
 {
+    if (is_inline(value, INLINE_STRING)) {
+        return g_inline_strings[value._bits >> INLINE_SHIFT];
+    }
     const thing_t *thing = value_as_thing(value);
     if (thing && thing_get_type(thing) == THING_TYPE_STRING) {
         return (const char *)thing->payload._ptr;
@@ -1082,8 +1993,8 @@ sentry_value_is_null(sentry_value_t value)
     return value._bits == CONST_NULL;
 }
 
-int
-sentry__value_merge_objects(sentry_value_t dst, sentry_value_t src)
+static int
+merge_objects(sentry_value_t dst, sentry_value_t src, bool copy)
 {
     if (sentry_value_is_null(src)) {
         return 0;
@@ -1099,16 +2010,20 @@ sentry__value_merge_objects(sentry_value_t dst, sentry_value_t src)
     }
     obj_t *obj = thing->payload._ptr;
     for (size_t i = 0; i < obj->len; i++) {
-        char *key = obj->pairs[i].k;
+        const char *key = obj->pairs[i].k;
         sentry_value_t src_val = obj->pairs[i].v;
         sentry_value_t dst_val = sentry_value_get_by_key(dst, key);
         if (sentry_value_get_type(dst_val) == SENTRY_VALUE_TYPE_OBJECT
             && sentry_value_get_type(src_val) == SENTRY_VALUE_TYPE_OBJECT) {
-            if (sentry__value_merge_objects(dst_val, src_val) != 0) {
+            if (merge_objects(dst_val, src_val, copy) != 0) {
                 return 1;
             }
         } else if (sentry_value_is_null(dst_val)) {
-            sentry_value_incref(src_val);
+            if (copy) {
+                src_val = sentry__value_clone(src_val);
+            } else {
+                sentry_value_incref(src_val);
+            }
             if (sentry_value_set_by_key(dst, key, src_val) != 0) {
                 return 1;
             }
@@ -1117,6 +2032,18 @@ sentry__value_merge_objects(sentry_value_t dst, sentry_value_t src)
     return 0;
 }
 
+int
+sentry__value_merge_objects(sentry_value_t dst, sentry_value_t src)
+{
+    return merge_objects(dst, src, false);
+}
+
+int
+sentry__value_merge_objects_copy(sentry_value_t dst, sentry_value_t src)
+{
+    return merge_objects(dst, src, true);
+}
+
 void
 sentry__jsonwriter_write_value(sentry_jsonwriter_t *jw, sentry_value_t value)
 {
@@ -1256,12 +2183,14 @@ sentry__value_new_string_owned(char *s)
     if (!s) {
         return sentry_value_new_null();
     }
-    sentry_value_t rv
-        = new_thing_value(s, THING_TYPE_STRING | THING_TYPE_FROZEN);
-    if (sentry_value_is_null(rv)) {
+    // `s` is heap-allocated, so this can't be part of an arena
+    thing_t *thing = thing_new(THING_TYPE_STRING | THING_TYPE_FROZEN, NULL);
+    if (!thing) {
         sentry_free(s);
+        return sentry_value_new_null();
     }
-    return rv;
+    thing->payload._ptr = s;
+    return thing_as_value(thing);
 }
 
 #ifdef SENTRY_PLATFORM_WINDOWS
@@ -1307,37 +2236,25 @@ sentry__value_new_hexstring(const uint8_t *bytes, size_t len)
 sentry_value_t
 sentry__value_new_span_uuid(const sentry_uuid_t *uuid)
 {
-    char *buf = sentry_malloc(17);
-    if (!buf) {
-        return sentry_value_new_null();
-    }
+    char buf[17];
     sentry__span_uuid_as_string(uuid, buf);
-    buf[16] = '\0';
-    return sentry__value_new_string_owned(buf);
+    return sentry_value_new_string_n(buf, 16);
 }
 
 sentry_value_t
 sentry__value_new_internal_uuid(const sentry_uuid_t *uuid)
 {
-    char *buf = sentry_malloc(33);
-    if (!buf) {
-        return sentry_value_new_null();
-    }
+    char buf[37];
     sentry__internal_uuid_as_string(uuid, buf);
-    buf[32] = '\0';
-    return sentry__value_new_string_owned(buf);
+    return sentry_value_new_string_n(buf, 32);
 }
 
 sentry_value_t
 sentry__value_new_uuid(const sentry_uuid_t *uuid)
 {
-    char *buf = sentry_malloc(37);
-    if (!buf) {
-        return sentry_value_new_null();
-    }
+    char buf[37];
     sentry_uuid_as_string(uuid, buf);
-    buf[36] = '\0';
-    return sentry__value_new_string_owned(buf);
+    return sentry_value_new_string_n(buf, 36);
 }
 
 sentry_value_t
@@ -101,6 +101,13 @@ sentry_value_t sentry__value_clone(sentry_value_t value);
  */
 int sentry__value_merge_objects(sentry_value_t dst, sentry_value_t src);
 
+/**
+ * Same as `sentry__value_merge_objects`, but the values that are added to dst
+ * are shallow copies of the ones in src, so that modifying them in dst does
+ * not modify src.
+ */
+int sentry__value_merge_objects_copy(sentry_value_t dst, sentry_value_t src);
+
 /**
  * Writes the given `value` into the `jsonwriter`.
  */
@@ -132,4 +139,38 @@ sentry_value_t sentry__value_from_msgpack(const char *buf, size_t buf_len);
 sentry_value_t sentry__value_merge_breadcrumbs(
     sentry_value_t list_a, sentry_value_t list_b, size_t max);
 
+typedef struct sentry_value_arena_s sentry_value_arena_t;
+
+/**
+ * Begins a scope in which the values created on the calling thread are
+ * allocated from a new arena, until the matching `sentry__value_arena_end`.
+ * Scopes nest, and must be ended in reverse order on the same thread.
+ *
+ * Values from an arena are otherwise regular values and may outlive its
+ * scope. The arena is freed as a whole once its scope has ended and all of
+ * its values are gone.
+ *
+ * Returns NULL if the arena can't be allocated, in which case values are
+ * allocated individually as usual.
+ */
+sentry_value_arena_t *sentry__value_arena_begin(void);
+
+/**
+ * Ends the scope of `arena`, which may be NULL.
+ */
+void sentry__value_arena_end(sentry_value_arena_t *arena);
+
+/**
+ * Returns the interned version of the object key `k`, or NULL if `k` isn't
+ * one of the well-known keys. Interned keys are static and never freed.
+ */
+const char *sentry__value_intern_key(const char *k, size_t k_len);
+
+// this is only used in unit tests
+#ifdef SENTRY_UNITTEST
+const char *const *sentry__value_interned_keys(size_t *count);
+bool sentry__value_is_arena_allocated(sentry_value_t value);
+size_t sentry__value_arena_foreign_chunks(sentry_value_t value);
+#endif
+
 #endif
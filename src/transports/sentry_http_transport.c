@@ -2,6 +2,7 @@
 #include "sentry_alloc.h"
 #include "sentry_attachment.h"
 #include "sentry_client_report.h"
+#include "sentry_compression.h"
 #include "sentry_database.h"
 #include "sentry_envelope.h"
 #include "sentry_options.h"
@@ -12,20 +13,13 @@
 #include "sentry_utils.h"
 #include "sentry_value.h"
 
-#ifdef SENTRY_TRANSPORT_COMPRESSION
-#    include "zlib.h"
-#endif
-
+#include <limits.h>
 #include <string.h>
 
 #define ENVELOPE_MIME "application/x-sentry-envelope"
 #define TUS_MIME "application/offset+octet-stream"
 #define TUS_MAX_HTTP_HEADERS 4
-#ifdef SENTRY_TRANSPORT_COMPRESSION
-#    define MAX_HTTP_HEADERS 4
-#else
-#    define MAX_HTTP_HEADERS 3
-#endif
+#define MAX_HTTP_HEADERS 4
 
 typedef struct {
     sentry_dsn_t *dsn;
@@ -40,62 +34,175 @@ typedef struct {
     bool cache_keep;
     sentry_run_t *run;
     bool send_client_reports;
+    bool stream_body;
+    size_t coalesce_size;
+    uint64_t coalesce_delay;
+    void *(*new_client)(void *client);
+    void (*warmup_client)(void *client, const char *url);
+    // `workers[0]` is the transport's own worker, the others send envelopes of
+    // other categories concurrently, each with its own client
+    sentry_bgworker_t *workers[SENTRY_HTTP_MAX_CONCURRENCY];
+    // every worker compresses its request bodies with a context of its own
+    sentry_compressor_t *compressors[SENTRY_HTTP_MAX_CONCURRENCY];
+    size_t num_workers;
+    volatile long queued;
+    volatile long in_flight;
+    // set once the shutdown of the transport's own worker timed out
+    volatile long cancelled;
+    long refcount;
 } http_transport_state_t;
 
-#ifdef SENTRY_TRANSPORT_COMPRESSION
-static bool
-gzipped_with_compression(const char *body, const size_t body_len,
-    char **compressed_body, size_t *compressed_body_len)
+typedef struct {
+    http_transport_state_t *state;
+    void *client;
+    size_t index;
+} http_worker_t;
+
+/**
+ * Size of the buffer that envelope data is pulled into before it is handed to
+ * the incremental compression stage.
+ */
+#define BODY_STREAM_CHUNK_SIZE 16384
+
+struct sentry_http_body_stream_s {
+    sentry_envelope_reader_t *reader;
+    sentry_compressor_t *compressor;
+    bool eof;
+    bool finished;
+    const char *in_pos;
+    size_t in_len;
+    char in[BODY_STREAM_CHUNK_SIZE];
+};
+
+static void
+body_stream_free(sentry_http_body_stream_t *body)
 {
-    if (!body || body_len == 0) {
-        return false;
+    if (!body) {
+        return;
     }
+    sentry__envelope_reader_free(body->reader);
+    sentry_free(body);
+}
 
-    z_stream stream;
-    memset(&stream, 0, sizeof(stream));
-    stream.next_in = (unsigned char *)body;
-    stream.avail_in = (unsigned int)body_len;
+static sentry_http_body_stream_t *
+body_stream_new(const sentry_envelope_t *envelope,
+    const sentry_rate_limiter_t *rl, sentry_compressor_t *compressor)
+{
+    sentry_http_body_stream_t *body = SENTRY_MAKE(sentry_http_body_stream_t);
+    if (!body) {
+        return NULL;
+    }
+    memset(body, 0, sizeof(*body));
+    body->reader = sentry__envelope_reader_new(envelope, rl);
+    if (!body->reader) {
+        body_stream_free(body);
+        return NULL;
+    }
 
-    int err = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
-        MAX_WBITS + 16, 9, Z_DEFAULT_STRATEGY);
-    if (err != Z_OK) {
-        SENTRY_WARNF("deflateInit2 failed: %d", err);
-        return false;
+    if (sentry__compressor_begin(
+            compressor, sentry__envelope_reader_len(body->reader))) {
+        body->compressor = compressor;
     }
+    return body;
+}
 
-    size_t len = compressBound((unsigned long)body_len);
-    char *buffer = sentry_malloc(len);
-    if (!buffer) {
-        deflateEnd(&stream);
-        return false;
+static size_t
+body_stream_compress(sentry_http_body_stream_t *body, char *buf, size_t buf_len)
+{
+    size_t written = 0;
+    while (written < buf_len && !body->finished) {
+        if (body->in_len == 0 && !body->eof) {
+            body->in_len = sentry__envelope_reader_read(
+                body->reader, body->in, sizeof(body->in));
+            body->in_pos = body->in;
+            body->eof = body->in_len == 0;
+        }
+        size_t produced = sentry__compressor_compress(body->compressor,
+            &body->in_pos, &body->in_len, body->eof, buf + written,
+            buf_len - written, &body->finished);
+        if (produced == SIZE_MAX) {
+            return SIZE_MAX;
+        }
+        written += produced;
     }
+    return written;
+}
 
-    while (err == Z_OK) {
-        stream.next_out = (unsigned char *)(buffer + stream.total_out);
-        stream.avail_out = (unsigned int)(len - stream.total_out);
-        err = deflate(&stream, Z_FINISH);
+size_t
+sentry__http_body_stream_read(
+    sentry_http_body_stream_t *body, char *buf, size_t buf_len)
+{
+    if (body->compressor) {
+        return body_stream_compress(body, buf, buf_len);
     }
+    return sentry__envelope_reader_read(body->reader, buf, buf_len);
+}
 
-    if (err != Z_STREAM_END) {
-        SENTRY_WARNF("deflate failed: %d", err);
-        sentry_free(buffer);
-        buffer = NULL;
-        deflateEnd(&stream);
-        return false;
+bool
+sentry__http_body_stream_rewind(sentry_http_body_stream_t *body)
+{
+    sentry__envelope_reader_rewind(body->reader);
+    if (!body->compressor) {
+        return true;
     }
+    body->eof = false;
+    body->finished = false;
+    body->in_pos = body->in;
+    body->in_len = 0;
+    return sentry__compressor_begin(
+        body->compressor, sentry__envelope_reader_len(body->reader));
+}
 
-    *compressed_body_len = stream.total_out;
-    *compressed_body = buffer;
+static sentry_prepared_http_request_t *
+prepare_envelope_request(const sentry_dsn_t *dsn, const char *user_agent,
+    const char *content_encoding, const size_t *content_length)
+{
+    sentry_prepared_http_request_t *req
+        = SENTRY_MAKE(sentry_prepared_http_request_t);
+    if (!req) {
+        return NULL;
+    }
+    memset(req, 0, sizeof(*req));
+    req->headers = sentry_malloc(
+        sizeof(sentry_prepared_http_header_t) * MAX_HTTP_HEADERS);
+    if (!req->headers) {
+        sentry_free(req);
+        return NULL;
+    }
+    req->headers_len = 0;
 
-    deflateEnd(&stream);
-    return true;
+    req->method = "POST";
+    req->url = sentry__dsn_get_envelope_url(dsn);
+
+    sentry_prepared_http_header_t *h;
+    h = &req->headers[req->headers_len++];
+    h->key = "x-sentry-auth";
+    h->value = sentry__dsn_get_auth_header(dsn, user_agent);
+
+    h = &req->headers[req->headers_len++];
+    h->key = "content-type";
+    h->value = sentry__string_clone(ENVELOPE_MIME);
+
+    if (content_encoding) {
+        h = &req->headers[req->headers_len++];
+        h->key = "content-encoding";
+        h->value = sentry__string_clone(content_encoding);
+    }
+
+    if (content_length) {
+        h = &req->headers[req->headers_len++];
+        h->key = "content-length";
+        h->value = sentry__int64_to_string((int64_t)*content_length);
+        req->body_len = *content_length;
+    }
+
+    return req;
 }
-#endif
 
 sentry_prepared_http_request_t *
 sentry__prepare_http_request(sentry_envelope_t *envelope,
     const sentry_dsn_t *dsn, const sentry_rate_limiter_t *rl,
-    const char *user_agent)
+    const char *user_agent, sentry_compressor_t *compressor)
 {
     if (!dsn || !dsn->is_valid) {
         return NULL;
@@ -109,70 +216,59 @@ sentry__prepare_http_request(sentry_envelope_t *envelope,
         return NULL;
     }
 
-#ifdef SENTRY_TRANSPORT_COMPRESSION
-    bool compressed = false;
-    char *compressed_body = NULL;
+    const char *content_encoding = NULL;
     size_t compressed_body_len = 0;
-    compressed = gzipped_with_compression(
-        body, body_len, &compressed_body, &compressed_body_len);
-    if (compressed) {
+    char *compressed_body = sentry__compressor_compress_buffer(
+        compressor, body, body_len, &compressed_body_len);
+    if (compressed_body) {
         if (body_owned) {
             sentry_free(body);
-            body_owned = false;
         }
         body = compressed_body;
         body_len = compressed_body_len;
         body_owned = true;
+        content_encoding = sentry__compressor_encoding(compressor);
     }
-#endif
 
-    sentry_prepared_http_request_t *req
-        = SENTRY_MAKE(sentry_prepared_http_request_t);
+    sentry_prepared_http_request_t *req = prepare_envelope_request(
+        dsn, user_agent, content_encoding, &body_len);
     if (!req) {
         if (body_owned) {
             sentry_free(body);
         }
         return NULL;
     }
-    req->headers = sentry_malloc(
-        sizeof(sentry_prepared_http_header_t) * MAX_HTTP_HEADERS);
-    if (!req->headers) {
-        sentry_free(req);
-        if (body_owned) {
-            sentry_free(body);
-        }
-        return NULL;
-    }
-    req->headers_len = 0;
-
-    req->method = "POST";
-    req->url = sentry__dsn_get_envelope_url(dsn);
-    req->body_path = NULL;
-
-    sentry_prepared_http_header_t *h;
-    h = &req->headers[req->headers_len++];
-    h->key = "x-sentry-auth";
-    h->value = sentry__dsn_get_auth_header(dsn, user_agent);
+    req->body = body;
+    req->body_owned = body_owned;
 
-    h = &req->headers[req->headers_len++];
-    h->key = "content-type";
-    h->value = sentry__string_clone(ENVELOPE_MIME);
+    return req;
+}
 
-#ifdef SENTRY_TRANSPORT_COMPRESSION
-    if (compressed) {
-        h = &req->headers[req->headers_len++];
-        h->key = "content-encoding";
-        h->value = sentry__string_clone("gzip");
+sentry_prepared_http_request_t *
+sentry__prepare_http_request_streamed(const sentry_envelope_t *envelope,
+    const sentry_dsn_t *dsn, const sentry_rate_limiter_t *rl,
+    const char *user_agent, sentry_compressor_t *compressor)
+{
+    if (!dsn || !dsn->is_valid) {
+        return NULL;
     }
-#endif
 
-    h = &req->headers[req->headers_len++];
-    h->key = "content-length";
-    h->value = sentry__int64_to_string((int64_t)body_len);
+    sentry_http_body_stream_t *body = body_stream_new(envelope, rl, compressor);
+    if (!body) {
+        return NULL;
+    }
 
-    req->body = body;
-    req->body_len = body_len;
-    req->body_owned = body_owned;
+    // the size of a compressed body is only known once it has been sent
+    size_t body_len = sentry__envelope_reader_len(body->reader);
+    sentry_prepared_http_request_t *req = body->compressor
+        ? prepare_envelope_request(
+              dsn, user_agent, sentry__compressor_encoding(compressor), NULL)
+        : prepare_envelope_request(dsn, user_agent, NULL, &body_len);
+    if (!req) {
+        body_stream_free(body);
+        return NULL;
+    }
+    req->body_stream = body;
 
     return req;
 }
@@ -192,6 +288,7 @@ sentry__prepared_http_request_free(sentry_prepared_http_request_t *req)
         sentry_free(req->body);
     }
     sentry__path_free(req->body_path);
+    body_stream_free(req->body_stream);
     sentry_free(req);
 }
 
@@ -300,11 +397,11 @@ enum {
 };
 
 static int
-http_send_request(http_transport_state_t *state,
+http_send_request(http_transport_state_t *state, void *client,
     sentry_prepared_http_request_t *req, sentry_http_response_t *resp)
 {
     memset(resp, 0, sizeof(*resp));
-    if (!state->send_func(state->client, req, resp)) {
+    if (!state->send_func(client, req, resp)) {
         int result = resp->shutdown ? RESULT_SHUTDOWN : RESULT_ERROR;
         http_response_cleanup(resp);
         return result;
@@ -345,8 +442,8 @@ http_update_ratelimiter(
 // Perform a TUS upload for the file at <cache>/<basename> and put the
 // resulting remote location URL (caller frees) in `location_out`.
 static int
-tus_upload_file(http_transport_state_t *state, const sentry_path_t *cache_path,
-    const char *basename, char **location_out)
+tus_upload_file(http_transport_state_t *state, void *client,
+    const sentry_path_t *cache_path, const char *basename, char **location_out)
 {
     if (!basename || *basename == '\0') {
         return RESULT_ERROR;
@@ -368,7 +465,7 @@ tus_upload_file(http_transport_state_t *state, const sentry_path_t *cache_path,
     }
 
     sentry_http_response_t resp;
-    int status_code = http_send_request(state, req, &resp);
+    int status_code = http_send_request(state, client, req, &resp);
     sentry__prepared_http_request_free(req);
 
     if (status_code < 0) {
@@ -402,7 +499,7 @@ tus_upload_file(http_transport_state_t *state, const sentry_path_t *cache_path,
         return RESULT_ERROR;
     }
 
-    status_code = http_send_request(state, req, &resp);
+    status_code = http_send_request(state, client, req, &resp);
     sentry__prepared_http_request_free(req);
     if (status_code < 0) {
         sentry_free(location);
@@ -508,8 +605,8 @@ prune_attachment_refs(const sentry_run_t *run, sentry_value_t paths,
 // TUS upload and set `location`. If TUS is unavailable or fails for a given
 // item, drop it and send the event without the large attachment.
 static int
-resolve_attachment_refs(
-    http_transport_state_t *state, sentry_envelope_t *envelope)
+resolve_attachment_refs(http_transport_state_t *state, void *client,
+    sentry_envelope_t *envelope)
 {
     if (!state->run || !envelope || sentry__envelope_is_raw(envelope)) {
         return RESULT_OK;
@@ -552,8 +649,8 @@ resolve_attachment_refs(
         }
 
         char *new_location = NULL;
-        int result
-            = tus_upload_file(state, cache_path, ref.path, &new_location);
+        int result = tus_upload_file(
+            state, client, cache_path, ref.path, &new_location);
         if (new_location) {
             bool resolved = sentry__envelope_item_resolve_attachment_ref(
                 item, new_location);
@@ -598,10 +695,10 @@ add_client_report(sentry_envelope_t *envelope, http_transport_state_t *state,
 }
 
 static int
-http_send_envelope(sentry_envelope_t *envelope, void *_state)
+http_send_envelope(sentry_envelope_t *envelope, http_transport_state_t *state,
+    void *client, size_t index)
 {
-    http_transport_state_t *state = _state;
-    int result = resolve_attachment_refs(state, envelope);
+    int result = resolve_attachment_refs(state, client, envelope);
     if (result < 0) {
         if (result != RESULT_SHUTDOWN) {
             SENTRY_WARN("failed to resolve attachment-ref items");
@@ -609,13 +706,19 @@ http_send_envelope(sentry_envelope_t *envelope, void *_state)
         return result;
     }
 
-    sentry_prepared_http_request_t *req = sentry__prepare_http_request(
-        envelope, state->dsn, state->ratelimiter, state->user_agent);
+    sentry_compressor_t *compressor = state->compressors[index];
+    sentry_prepared_http_request_t *req = state->stream_body
+        ? sentry__prepare_http_request_streamed(envelope, state->dsn,
+              state->ratelimiter, state->user_agent, compressor)
+        : sentry__prepare_http_request(envelope, state->dsn,
+              state->ratelimiter, state->user_agent, compressor);
     if (!req) {
         return RESULT_OK;
     }
     sentry_http_response_t resp;
-    int status_code = http_send_request(state, req, &resp);
+    sentry__atomic_fetch_and_add(&state->in_flight, 1);
+    int status_code = http_send_request(state, client, req, &resp);
+    sentry__atomic_fetch_and_add(&state->in_flight, -1);
     sentry__prepared_http_request_free(req);
     if (status_code >= 0) {
         http_update_ratelimiter(state, &resp);
@@ -624,16 +727,16 @@ http_send_envelope(sentry_envelope_t *envelope, void *_state)
 }
 
 static int
-retry_send_cb(sentry_envelope_t *envelope, void *_state)
+retry_send_envelope(sentry_envelope_t *envelope, http_transport_state_t *state,
+    void *client, size_t index)
 {
-    http_transport_state_t *state = _state;
     if (!materialize_attachment_refs(envelope)) {
         return 400;
     }
     sentry_client_report_t report = { 0 };
     bool reported = add_client_report(envelope, state, &report);
     sentry_value_t ref_paths = collect_attachment_refs(envelope);
-    int status_code = http_send_envelope(envelope, state);
+    int status_code = http_send_envelope(envelope, state, client, index);
     if (status_code < 0) {
         prune_attachment_refs(state->run, ref_paths, envelope);
     } else {
@@ -652,10 +755,20 @@ retry_send_cb(sentry_envelope_t *envelope, void *_state)
     return status_code;
 }
 
+static int
+retry_send_cb(sentry_envelope_t *envelope, void *_state)
+{
+    http_transport_state_t *state = _state;
+    return retry_send_envelope(envelope, state, state->client, 0);
+}
+
 static void
-http_transport_state_free(void *_state)
+http_transport_state_decref(void *_state)
 {
     http_transport_state_t *state = _state;
+    if (sentry__atomic_fetch_and_add(&state->refcount, -1) != 1) {
+        return;
+    }
     if (state->free_client) {
         state->free_client(state->client);
     }
@@ -664,14 +777,73 @@ http_transport_state_free(void *_state)
     sentry__rate_limiter_free(state->ratelimiter);
     sentry__retry_free(state->retry);
     sentry__run_free(state->run);
+    for (size_t i = 0; i < SENTRY_HTTP_MAX_CONCURRENCY; i++) {
+        sentry__compressor_free(state->compressors[i]);
+    }
     sentry_free(state);
 }
 
 static void
-http_send_task(void *_envelope, void *_state)
+http_worker_free(void *_worker)
 {
-    sentry_envelope_t *envelope = _envelope;
-    http_transport_state_t *state = _state;
+    http_worker_t *worker = _worker;
+    if (worker->client && worker->state->free_client) {
+        worker->state->free_client(worker->client);
+    }
+    http_transport_state_decref(worker->state);
+    sentry_free(worker);
+}
+
+static void http_send_task(void *envelope, void *_state);
+static void http_worker_send_task(void *envelope, void *_worker);
+
+typedef struct {
+    sentry_envelope_t *envelope;
+    size_t max_size;
+    size_t coalesced;
+} http_coalesce_t;
+
+static bool
+http_coalesce_cb(void *envelope, void *_coalesce)
+{
+    http_coalesce_t *coalesce = _coalesce;
+    if (!sentry__envelope_coalesce(
+            coalesce->envelope, envelope, coalesce->max_size)) {
+        return false;
+    }
+    // the emptied envelope is dropped from the queue
+    coalesce->coalesced++;
+    return true;
+}
+
+/**
+ * Moves the items of other envelopes queued on the same worker into
+ * `envelope`, so that they are all sent with a single request.
+ */
+static void
+coalesce_queued_envelopes(
+    sentry_envelope_t *envelope, http_transport_state_t *state, size_t index)
+{
+    if (!state->coalesce_size || !sentry__envelope_is_coalescable(envelope)) {
+        return;
+    }
+    http_coalesce_t coalesce = { envelope, state->coalesce_size, 0 };
+    sentry__bgworker_foreach_matching(state->workers[index],
+        index ? http_worker_send_task : http_send_task, http_coalesce_cb,
+        &coalesce);
+    if (coalesce.coalesced) {
+        SENTRY_DEBUGF("coalesced %zu queued envelopes", coalesce.coalesced);
+        sentry__atomic_fetch_and_add(
+            &state->queued, -(long)coalesce.coalesced);
+    }
+}
+
+static void
+send_envelope_task(sentry_envelope_t *envelope, http_transport_state_t *state,
+    void *client, size_t index)
+{
+    sentry__atomic_fetch_and_add(&state->queued, -1);
+    coalesce_queued_envelopes(envelope, state, index);
 
     sentry_uuid_t event_id = sentry__envelope_get_event_id(envelope);
     if (!materialize_attachment_refs(envelope)) {
@@ -685,7 +857,7 @@ http_send_task(void *_envelope, void *_state)
     // Capture cached sibling paths before resolving attachment-refs. Dropped
     // attachment-refs no longer carry local paths afterwards.
     sentry_value_t ref_paths = collect_attachment_refs(envelope);
-    int status_code = http_send_envelope(envelope, state);
+    int status_code = http_send_envelope(envelope, state, client, index);
 
     if (status_code < 0) {
         const sentry_envelope_t *ref_owner = NULL;
@@ -723,6 +895,162 @@ http_send_task(void *_envelope, void *_state)
     }
 }
 
+static void
+shed_envelope(sentry_envelope_t *envelope, http_transport_state_t *state)
+{
+    sentry__atomic_fetch_and_add(&state->queued, -1);
+    sentry__envelope_discard(
+        envelope, SENTRY_DISCARD_REASON_QUEUE_OVERFLOW, state->ratelimiter);
+}
+
+static void
+http_shed_task(void *envelope, void *state)
+{
+    shed_envelope(envelope, state);
+}
+
+static void
+http_worker_shed_task(void *envelope, void *_worker)
+{
+    http_worker_t *worker = _worker;
+    shed_envelope(envelope, worker->state);
+}
+
+static void
+http_send_task(void *envelope, void *_state)
+{
+    http_transport_state_t *state = _state;
+    send_envelope_task(envelope, state, state->client, 0);
+}
+
+static void
+http_worker_send_task(void *envelope, void *_worker)
+{
+    http_worker_t *worker = _worker;
+    send_envelope_task(envelope, worker->state, worker->client, worker->index);
+}
+
+typedef struct {
+    sentry_mutex_t lock;
+    sentry_cond_t done_signal;
+    size_t pending;
+} http_retry_batch_t;
+
+typedef struct {
+    http_retry_batch_t *batch;
+    sentry_envelope_t *envelope;
+    int *status_code;
+} http_retry_job_t;
+
+static void
+http_worker_retry_task(void *_job, void *_worker)
+{
+    http_retry_job_t *job = _job;
+    http_worker_t *worker = _worker;
+    *job->status_code = retry_send_envelope(
+        job->envelope, worker->state, worker->client, worker->index);
+}
+
+static void
+http_retry_job_done(void *_job)
+{
+    http_retry_job_t *job = _job;
+    http_retry_batch_t *batch = job->batch;
+    sentry_free(job);
+
+    sentry__mutex_lock(&batch->lock);
+    batch->pending--;
+    sentry__cond_wake(&batch->done_signal);
+    sentry__mutex_unlock(&batch->lock);
+}
+
+static bool
+http_retry_job_matches_cb(void *_job, void *batch)
+{
+    http_retry_job_t *job = _job;
+    return job->batch == batch;
+}
+
+/**
+ * Drops the jobs of `batch` that have not run yet, so that waiting for the
+ * batch does not depend on workers that might have stopped already.
+ */
+static void
+cancel_retry_batch(http_transport_state_t *state, http_retry_batch_t *batch)
+{
+    for (size_t i = 1; i < state->num_workers; i++) {
+        sentry__bgworker_foreach_matching(state->workers[i],
+            http_worker_retry_task, http_retry_job_matches_cb, batch);
+    }
+}
+
+/**
+ * Sends the first envelope of a retry batch on the calling transport worker,
+ * and the others on the additional workers, each with its own client.
+ */
+static void
+retry_send_batch_cb(sentry_envelope_t **envelopes, int *status_codes,
+    size_t count, void *_state)
+{
+    http_transport_state_t *state = _state;
+    http_retry_batch_t batch;
+    sentry__mutex_init(&batch.lock);
+    sentry__cond_init(&batch.done_signal);
+    batch.pending = 0;
+
+    for (size_t i = 1; i < count; i++) {
+        // jobs that are dropped on shutdown count as network failures
+        status_codes[i] = RESULT_SHUTDOWN;
+        http_retry_job_t *job = NULL;
+        if (state->num_workers > 1) {
+            job = SENTRY_MAKE(http_retry_job_t);
+        }
+        if (!job) {
+            status_codes[i]
+                = retry_send_envelope(envelopes[i], state, state->client, 0);
+            continue;
+        }
+        job->batch = &batch;
+        job->envelope = envelopes[i];
+        job->status_code = &status_codes[i];
+
+        sentry__mutex_lock(&batch.lock);
+        batch.pending++;
+        sentry__mutex_unlock(&batch.lock);
+        size_t index = 1 + (i - 1) % (state->num_workers - 1);
+        if (sentry__bgworker_submit(state->workers[index],
+                http_worker_retry_task, http_retry_job_done, job)
+            != 0) {
+            // the job has been cleaned up already
+            status_codes[i]
+                = retry_send_envelope(envelopes[i], state, state->client, 0);
+        }
+    }
+    if (count) {
+        status_codes[0]
+            = retry_send_envelope(envelopes[0], state, state->client, 0);
+    }
+
+    sentry__mutex_lock(&batch.lock);
+    bool cancelled = false;
+    while (batch.pending) {
+        sentry__cond_wait_timeout(&batch.done_signal, &batch.lock, 250);
+        if (batch.pending && !cancelled
+            && sentry__atomic_fetch(&state->cancelled)) {
+            // the dropped jobs keep their RESULT_SHUTDOWN status, and jobs
+            // that are running finish once the shutdown timeout cancelled
+            // the requests of their workers
+            cancelled = true;
+            sentry__mutex_unlock(&batch.lock);
+            cancel_retry_batch(state, &batch);
+            sentry__mutex_lock(&batch.lock);
+        }
+    }
+    sentry__mutex_unlock(&batch.lock);
+    sentry__cond_free(&batch.done_signal);
+    sentry__mutex_free(&batch.lock);
+}
+
 static void
 http_cleanup_cache_task(void *task_data, void *_state)
 {
@@ -731,15 +1059,138 @@ http_cleanup_cache_task(void *task_data, void *_state)
     sentry__cleanup_cache(options);
 }
 
+/**
+ * Cancels the requests of all workers once the transport's own worker timed
+ * out. The other workers share its deadline, so they would not get to send
+ * anything else either, and a retry batch that the transport's own worker
+ * waits for can have requests in flight on any of them.
+ */
 static void
 http_transport_shutdown_timeout(void *_state)
 {
     http_transport_state_t *state = _state;
-    if (state->shutdown_client) {
-        state->shutdown_client(state->client);
+    sentry__atomic_store(&state->cancelled, 1);
+    if (!state->shutdown_client) {
+        return;
+    }
+    state->shutdown_client(state->client);
+    for (size_t i = 1; i < state->num_workers; i++) {
+        http_worker_t *worker = sentry__bgworker_get_state(state->workers[i]);
+        state->shutdown_client(worker->client);
     }
 }
 
+static void
+http_worker_shutdown_timeout(void *_worker)
+{
+    http_worker_t *worker = _worker;
+    if (worker->state->shutdown_client) {
+        worker->state->shutdown_client(worker->client);
+    }
+}
+
+static sentry_compressor_t *
+http_compressor_new(const sentry_options_t *options)
+{
+    return sentry__compressor_new(options->http_compression,
+        options->http_compression_level, options->http_compression_threshold);
+}
+
+/**
+ * Starts an additional worker with a client and compressor of its own.
+ */
+static sentry_bgworker_t *
+http_worker_start(http_transport_state_t *state,
+    const sentry_options_t *options, size_t index)
+{
+    http_worker_t *worker = SENTRY_MAKE(http_worker_t);
+    if (!worker) {
+        return NULL;
+    }
+    sentry__atomic_fetch_and_add(&state->refcount, 1);
+    worker->state = state;
+    worker->client = state->new_client(state->client);
+    worker->index = index;
+    if (!state->compressors[index]) {
+        state->compressors[index] = http_compressor_new(options);
+    }
+    if (!worker->client
+        || (state->start_client
+            && state->start_client(worker->client, options) != 0)) {
+        http_worker_free(worker);
+        return NULL;
+    }
+
+    // the worker is freed along with the bgworker, or right away on failure
+    sentry_bgworker_t *bgworker
+        = sentry__bgworker_new(worker, http_worker_free);
+    if (!bgworker) {
+        return NULL;
+    }
+
+    sentry__bgworker_set_capacity(
+        bgworker, options->http_queue_capacity, http_worker_shed_task);
+
+    char thread_name[64];
+    snprintf(thread_name, sizeof(thread_name), "%s-%zu",
+        options->transport_thread_name ? options->transport_thread_name
+                                       : "sentry-http",
+        index);
+    sentry__bgworker_setname(bgworker, thread_name);
+    if (sentry__bgworker_start(bgworker) != 0) {
+        sentry__bgworker_decref(bgworker);
+        return NULL;
+    }
+    return bgworker;
+}
+
+/**
+ * Errors and sessions are sent first, and logs and metrics are sent last and
+ * shed first when the queue is full.
+ */
+static sentry_task_priority_t
+http_envelope_priority(sentry_data_category_t category)
+{
+    switch (category) {
+    case SENTRY_DATA_CATEGORY_LOG_ITEM:
+    case SENTRY_DATA_CATEGORY_TRACE_METRIC:
+        return SENTRY_TASK_PRIORITY_LOW;
+    case SENTRY_DATA_CATEGORY_TRANSACTION:
+        return SENTRY_TASK_PRIORITY_NORMAL;
+    default:
+        return SENTRY_TASK_PRIORITY_HIGH;
+    }
+}
+
+/**
+ * Picks the worker for envelopes of `category`, so that every category is
+ * sent in order. Errors, which carry attachments and minidumps, get the
+ * transport's own worker, the other categories are spread over the rest.
+ */
+static size_t
+http_worker_index(
+    const http_transport_state_t *state, sentry_data_category_t category)
+{
+    if (state->num_workers < 2 || category == SENTRY_DATA_CATEGORY_ERROR) {
+        return 0;
+    }
+    return 1 + (size_t)category % (state->num_workers - 1);
+}
+
+static void
+http_warmup_task(void *url, void *_state)
+{
+    http_transport_state_t *state = _state;
+    state->warmup_client(state->client, url);
+}
+
+static uint64_t
+remaining_timeout(uint64_t started, uint64_t timeout)
+{
+    uint64_t elapsed = sentry__monotonic_time() - started;
+    return elapsed < timeout ? timeout - elapsed : 0;
+}
+
 static int
 http_transport_start(const sentry_options_t *options, void *transport_state)
 {
@@ -753,6 +1204,9 @@ http_transport_start(const sentry_options_t *options, void *transport_state)
     state->cache_keep = options->cache_keep;
     state->run = sentry__run_incref(options->run);
     state->send_client_reports = options->send_client_reports;
+    state->coalesce_size = options->http_coalesce_size;
+    state->coalesce_delay = options->http_coalesce_delay;
+    state->compressors[0] = http_compressor_new(options);
 
     if (state->start_client) {
         int rv = state->start_client(state->client, options);
@@ -761,14 +1215,44 @@ http_transport_start(const sentry_options_t *options, void *transport_state)
         }
     }
 
+    sentry__bgworker_set_capacity(
+        bgworker, options->http_queue_capacity, http_shed_task);
     int rv = sentry__bgworker_start(bgworker);
     if (rv != 0) {
         return rv;
     }
 
+    // resolve the upstream and complete a TLS handshake ahead of the first
+    // envelope, which the clients of all workers can then resume
+    if (state->warmup_client && state->dsn && state->dsn->is_valid
+        && state->dsn->is_secure) {
+        char *url = sentry__dsn_get_envelope_url(state->dsn);
+        if (url) {
+            sentry__bgworker_submit(
+                bgworker, http_warmup_task, sentry_free, url);
+        }
+    }
+
+    size_t concurrency
+        = MIN(options->http_concurrency, SENTRY_HTTP_MAX_CONCURRENCY);
+    if (concurrency > 1 && !state->new_client) {
+        SENTRY_DEBUG("transport does not support concurrent requests");
+    }
+    while (state->new_client && state->num_workers < concurrency) {
+        sentry_bgworker_t *worker
+            = http_worker_start(state, options, state->num_workers);
+        if (!worker) {
+            SENTRY_WARN("failed to start additional transport worker");
+            break;
+        }
+        state->workers[state->num_workers++] = worker;
+    }
+
     if (options->http_retry) {
         state->retry = sentry__retry_new(options);
         if (state->retry) {
+            sentry__retry_set_send_batch(
+                state->retry, retry_send_batch_cb, state->num_workers);
             sentry__retry_start(state->retry, bgworker, retry_send_cb, state);
         }
     }
@@ -780,7 +1264,19 @@ static int
 http_transport_flush(uint64_t timeout, void *transport_state)
 {
     sentry_bgworker_t *bgworker = transport_state;
-    return sentry__bgworker_flush(bgworker, timeout);
+    http_transport_state_t *state = sentry__bgworker_get_state(bgworker);
+    SENTRY_DEBUGF("flushing transport with %ld queued and %ld in-flight "
+                  "envelopes",
+        sentry__atomic_fetch(&state->queued),
+        sentry__atomic_fetch(&state->in_flight));
+
+    uint64_t started = sentry__monotonic_time();
+    int rv = sentry__bgworker_flush(bgworker, timeout);
+    for (size_t i = 1; i < state->num_workers; i++) {
+        rv |= sentry__bgworker_flush(
+            state->workers[i], remaining_timeout(started, timeout));
+    }
+    return rv;
 }
 
 static bool
@@ -798,13 +1294,26 @@ http_transport_shutdown(uint64_t timeout, void *transport_state)
 
     sentry__retry_shutdown(state->retry);
 
-    int rv = sentry__bgworker_shutdown_cb(
-        bgworker, timeout, http_transport_shutdown_timeout, state);
+    // the other workers keep sending while the transport's own one shuts down
+    uint64_t started = sentry__monotonic_time();
+    if (state->coalesce_delay) {
+        // envelopes that are held back for coalescing are not due yet
+        http_transport_flush(timeout, transport_state);
+    }
+    int rv = sentry__bgworker_shutdown_cb(bgworker,
+        remaining_timeout(started, timeout), http_transport_shutdown_timeout,
+        state);
     if (rv != 0) {
         sentry__bgworker_foreach_matching(
             bgworker, http_cleanup_cache_task, http_flush_cleanup_cb, NULL);
         sentry__retry_seal(state->retry);
     }
+    for (size_t i = 1; i < state->num_workers; i++) {
+        sentry_bgworker_t *worker = state->workers[i];
+        rv |= sentry__bgworker_shutdown_cb(worker,
+            remaining_timeout(started, timeout), http_worker_shutdown_timeout,
+            sentry__bgworker_get_state(worker));
+    }
     return rv;
 }
 
@@ -812,8 +1321,23 @@ static void
 http_transport_send_envelope(sentry_envelope_t *envelope, void *transport_state)
 {
     sentry_bgworker_t *bgworker = transport_state;
-    sentry__bgworker_submit(bgworker, http_send_task,
-        (void (*)(void *))sentry_envelope_free, envelope);
+    http_transport_state_t *state = sentry__bgworker_get_state(bgworker);
+    sentry_data_category_t category
+        = sentry__envelope_get_data_category(envelope);
+    size_t index = http_worker_index(state, category);
+
+    // give envelopes that can be coalesced a chance to be joined by others
+    uint64_t delay = 0;
+    if (state->coalesce_size && sentry__envelope_is_coalescable(envelope)) {
+        delay = state->coalesce_delay;
+    }
+
+    // shed envelopes are accounted for by the shed task
+    sentry__atomic_fetch_and_add(&state->queued, 1);
+    sentry__bgworker_try_submit_delayed(state->workers[index],
+        index ? http_worker_send_task : http_send_task,
+        (void (*)(void *))sentry_envelope_free, envelope,
+        http_envelope_priority(category), delay);
 }
 
 static bool
@@ -828,8 +1352,39 @@ static size_t
 http_dump_queue(sentry_run_t *run, void *transport_state)
 {
     sentry_bgworker_t *bgworker = transport_state;
-    return sentry__bgworker_foreach_matching(
+    http_transport_state_t *state = sentry__bgworker_get_state(bgworker);
+    size_t dumped = sentry__bgworker_foreach_matching(
         bgworker, http_send_task, http_dump_task_cb, run);
+    for (size_t i = 1; i < state->num_workers; i++) {
+        dumped += sentry__bgworker_foreach_matching(state->workers[i],
+            http_worker_send_task, http_dump_task_cb, run);
+    }
+    sentry__atomic_fetch_and_add(&state->queued, -(long)dumped);
+    return dumped;
+}
+
+static bool
+http_drop_task_cb(void *UNUSED(envelope), void *UNUSED(data))
+{
+    return true;
+}
+
+static void
+http_transport_free(void *transport_state)
+{
+    sentry_bgworker_t *bgworker = transport_state;
+    http_transport_state_t *state = sentry__bgworker_get_state(bgworker);
+    // envelopes that were neither sent nor dumped at shutdown are dropped,
+    // and must not be counted as queued by workers that outlive the transport
+    size_t dropped = sentry__bgworker_foreach_matching(
+        bgworker, http_send_task, http_drop_task_cb, NULL);
+    for (size_t i = 1; i < state->num_workers; i++) {
+        dropped += sentry__bgworker_foreach_matching(state->workers[i],
+            http_worker_send_task, http_drop_task_cb, NULL);
+        sentry__bgworker_decref(state->workers[i]);
+    }
+    sentry__atomic_fetch_and_add(&state->queued, -(long)dropped);
+    sentry__bgworker_decref(bgworker);
 }
 
 static http_transport_state_t *
@@ -869,13 +1424,15 @@ sentry__http_transport_new(void *client, sentry_http_send_func_t send_func)
     state->ratelimiter = sentry__rate_limiter_new();
     state->client = client;
     state->send_func = send_func;
+    state->refcount = 1;
 
     sentry_bgworker_t *bgworker
-        = sentry__bgworker_new(state, http_transport_state_free);
+        = sentry__bgworker_new(state, http_transport_state_decref);
     if (!bgworker) {
-        http_transport_state_free(state);
         return NULL;
     }
+    state->workers[0] = bgworker;
+    state->num_workers = 1;
 
     sentry_transport_t *transport
         = sentry_transport_new(http_transport_send_envelope);
@@ -885,8 +1442,7 @@ sentry__http_transport_new(void *client, sentry_http_send_func_t send_func)
     }
 
     sentry_transport_set_state(transport, bgworker);
-    sentry_transport_set_free_func(
-        transport, (void (*)(void *))sentry__bgworker_decref);
+    sentry_transport_set_free_func(transport, http_transport_free);
     sentry_transport_set_startup_func(transport, http_transport_start);
     sentry_transport_set_flush_func(transport, http_transport_flush);
     sentry_transport_set_shutdown_func(transport, http_transport_shutdown);
@@ -905,6 +1461,42 @@ sentry__http_transport_set_free_client(
     http_transport_get_state(transport)->free_client = free_client;
 }
 
+void
+sentry__http_transport_set_stream_body(
+    sentry_transport_t *transport, bool stream_body)
+{
+    http_transport_get_state(transport)->stream_body = stream_body;
+}
+
+void
+sentry__http_transport_set_new_client(
+    sentry_transport_t *transport, void *(*new_client)(void *))
+{
+    http_transport_get_state(transport)->new_client = new_client;
+}
+
+void
+sentry__http_transport_set_warmup_client(sentry_transport_t *transport,
+    void (*warmup_client)(void *, const char *))
+{
+    http_transport_get_state(transport)->warmup_client = warmup_client;
+}
+
+void
+sentry__http_transport_get_stats(
+    sentry_transport_t *transport, sentry_http_transport_stats_t *stats)
+{
+    http_transport_state_t *state = http_transport_get_state(transport);
+    stats->workers = state->num_workers;
+    stats->queued = (size_t)MAX(sentry__atomic_fetch(&state->queued), 0);
+    stats->in_flight = (size_t)MAX(sentry__atomic_fetch(&state->in_flight), 0);
+    memset(&stats->compression, 0, sizeof(stats->compression));
+    for (size_t i = 0; i < state->num_workers; i++) {
+        sentry__compressor_get_stats(
+            state->compressors[i], &stats->compression);
+    }
+}
+
 void
 sentry__http_transport_set_start_client(sentry_transport_t *transport,
     int (*start_client)(void *, const sentry_options_t *))
@@ -2,16 +2,29 @@
 #define SENTRY_HTTP_TRANSPORT_H_INCLUDED
 
 #include "sentry_boot.h"
+#include "sentry_compression.h"
 #include "sentry_path.h"
 #include "sentry_ratelimiter.h"
 #include "sentry_sync.h"
 #include "sentry_transport.h"
 
+/**
+ * The maximum number of requests that an HTTP transport sends concurrently,
+ * see `sentry_options_set_http_concurrency`.
+ */
+#define SENTRY_HTTP_MAX_CONCURRENCY 8
+
 typedef struct sentry_prepared_http_header_s {
     const char *key;
     char *value;
 } sentry_prepared_http_header_t;
 
+/**
+ * The body of a streamed envelope request, see
+ * `sentry__prepare_http_request_streamed`.
+ */
+typedef struct sentry_http_body_stream_s sentry_http_body_stream_t;
+
 typedef struct sentry_prepared_http_request_s {
     const char *method;
     char *url;
@@ -21,11 +34,45 @@ typedef struct sentry_prepared_http_request_s {
     size_t body_len;
     bool body_owned;
     sentry_path_t *body_path;
+    sentry_http_body_stream_t *body_stream;
 } sentry_prepared_http_request_t;
 
+/**
+ * Prepares an envelope request with a serialized body, which is compressed by
+ * `compressor` unless that is NULL.
+ */
 sentry_prepared_http_request_t *sentry__prepare_http_request(
     sentry_envelope_t *envelope, const sentry_dsn_t *dsn,
-    const sentry_rate_limiter_t *rl, const char *user_agent);
+    const sentry_rate_limiter_t *rl, const char *user_agent,
+    sentry_compressor_t *compressor);
+
+/**
+ * Prepares an envelope request whose body is serialized (and compressed) on
+ * demand via `sentry__http_body_stream_read`, with memory usage independent of
+ * the envelope size. The envelope and `compressor` need to outlive the
+ * request, which uses the compressor until it has been sent. The
+ * `content-length` header and `body_len` are only set for uncompressed bodies,
+ * as the size of compressed bodies is unknown until they have been sent.
+ */
+sentry_prepared_http_request_t *sentry__prepare_http_request_streamed(
+    const sentry_envelope_t *envelope, const sentry_dsn_t *dsn,
+    const sentry_rate_limiter_t *rl, const char *user_agent,
+    sentry_compressor_t *compressor);
+
+/**
+ * Reads up to `buf_len` bytes of the request body into `buf`. Returns the
+ * number of bytes read, 0 at the end of the body, or `SIZE_MAX` on error.
+ */
+size_t sentry__http_body_stream_read(
+    sentry_http_body_stream_t *body, char *buf, size_t buf_len);
+
+/**
+ * Restarts the request body from its beginning, for clients that need to send
+ * it again, e.g. when a reused connection turned out to be closed. Returns
+ * false if the body cannot be restarted.
+ */
+bool sentry__http_body_stream_rewind(sentry_http_body_stream_t *body);
+
 sentry_prepared_http_request_t *sentry__prepare_tus_create_request(
     size_t file_size, const sentry_dsn_t *dsn, const char *user_agent);
 sentry_prepared_http_request_t *sentry__prepare_tus_upload_request(
@@ -56,8 +103,42 @@ void sentry__http_transport_set_free_client(
     sentry_transport_t *transport, void (*free_client)(void *));
 void sentry__http_transport_set_start_client(sentry_transport_t *transport,
     int (*start_client)(void *, const sentry_options_t *));
+/**
+ * Lets the transport send envelopes as `body_stream` instead of a serialized
+ * `body`, for clients that can pull the request body incrementally.
+ */
+void sentry__http_transport_set_stream_body(
+    sentry_transport_t *transport, bool stream_body);
 void sentry__http_transport_set_shutdown_client(
     sentry_transport_t *transport, void (*shutdown_client)(void *));
+/**
+ * Lets the transport create additional clients from its initial one, which are
+ * started, shut down and freed with the same functions as the initial one.
+ * Only transports with a `new_client` function send requests concurrently.
+ */
+void sentry__http_transport_set_new_client(
+    sentry_transport_t *transport, void *(*new_client)(void *));
+/**
+ * Lets the transport warm up its initial client on startup, by connecting it
+ * to the envelope `url` of a secure DSN before the first envelope is sent.
+ */
+void sentry__http_transport_set_warmup_client(sentry_transport_t *transport,
+    void (*warmup_client)(void *, const char *));
+
+typedef struct {
+    size_t workers;
+    size_t queued;
+    size_t in_flight;
+    sentry_compression_stats_t compression;
+} sentry_http_transport_stats_t;
+
+/**
+ * Returns the number of transport workers, the number of envelopes waiting to
+ * be sent, the number of requests currently in flight, and how much the
+ * request bodies have been compressed at which CPU cost.
+ */
+void sentry__http_transport_get_stats(
+    sentry_transport_t *transport, sentry_http_transport_stats_t *stats);
 
 #ifdef SENTRY_UNITTEST
 void *sentry__http_transport_get_bgworker(sentry_transport_t *transport);
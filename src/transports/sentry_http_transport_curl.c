@@ -11,6 +11,7 @@
 
 #include <curl/curl.h>
 #include <curl/easy.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -18,11 +19,24 @@
 #    include "sentry_transport_curl_nx.h"
 #endif
 
+/**
+ * A curl share handle, which lets the clients of all transport workers reuse
+ * resolved host names and TLS sessions, so that only the first connection to
+ * the upstream needs a full TLS handshake.
+ */
+typedef struct {
+    CURLSH *handle;
+    sentry_mutex_t locks[CURL_LOCK_DATA_LAST];
+    long refcount;
+} curl_share_t;
+
 typedef struct {
     CURL *curl_handle;
+    curl_share_t *share;
     char *proxy;
     char *ca_certs;
     bool debug;
+    bool http2;
     long shutdown;
 #ifdef SENTRY_PLATFORM_NX
     void *nx_state;
@@ -34,6 +48,69 @@ typedef struct {
     const sentry_path_t *path;
 } file_body_t;
 
+static void
+share_lock(CURL *UNUSED(handle), curl_lock_data data,
+    curl_lock_access UNUSED(access), void *userptr)
+{
+    curl_share_t *share = userptr;
+    sentry__mutex_lock(&share->locks[data]);
+}
+
+static void
+share_unlock(CURL *UNUSED(handle), curl_lock_data data, void *userptr)
+{
+    curl_share_t *share = userptr;
+    sentry__mutex_unlock(&share->locks[data]);
+}
+
+static curl_share_t *
+curl_share_new(void)
+{
+    curl_share_t *share = SENTRY_MAKE(curl_share_t);
+    if (!share) {
+        return NULL;
+    }
+    share->handle = curl_share_init();
+    if (!share->handle) {
+        sentry_free(share);
+        return NULL;
+    }
+    for (size_t i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        sentry__mutex_init(&share->locks[i]);
+    }
+    share->refcount = 1;
+
+    curl_share_setopt(share->handle, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(share->handle, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(share->handle, CURLSHOPT_USERDATA, share);
+    curl_share_setopt(share->handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(
+        share->handle, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    return share;
+}
+
+static curl_share_t *
+curl_share_incref(curl_share_t *share)
+{
+    if (share) {
+        sentry__atomic_fetch_and_add(&share->refcount, 1);
+    }
+    return share;
+}
+
+static void
+curl_share_decref(curl_share_t *share)
+{
+    if (!share || sentry__atomic_fetch_and_add(&share->refcount, -1) != 1) {
+        return;
+    }
+    curl_share_cleanup(share->handle);
+    for (size_t i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        sentry__mutex_free(&share->locks[i]);
+    }
+    sentry_free(share);
+}
+
 static curl_client_t *
 curl_client_new(void)
 {
@@ -48,13 +125,32 @@ curl_client_new(void)
     return client;
 }
 
+/**
+ * Creates the client of an additional transport worker, which shares its DNS
+ * and TLS session caches with the transport's own client.
+ */
+static void *
+curl_client_new_worker(void *_client)
+{
+    curl_client_t *parent = _client;
+    curl_client_t *client = curl_client_new();
+    if (client) {
+        client->share = curl_share_incref(parent->share);
+    }
+    return client;
+}
+
 static void
 curl_client_free(void *_client)
 {
     curl_client_t *client = _client;
     if (client->curl_handle) {
         curl_easy_cleanup(client->curl_handle);
+        // the share can only go away once no handle uses it anymore
+        curl_share_decref(client->share);
         curl_global_cleanup();
+    } else {
+        curl_share_decref(client->share);
     }
     sentry_free(client->ca_certs);
     sentry_free(client->proxy);
@@ -108,6 +204,17 @@ curl_client_start(void *_client, const sentry_options_t *options)
     client->ca_certs = sentry__string_clone(options->ca_certs);
     client->curl_handle = curl_easy_init();
     client->debug = options->debug;
+#if LIBCURL_VERSION_NUM >= 0x072f00
+    curl_version_info_data *version_data = curl_version_info(CURLVERSION_NOW);
+    client->http2
+        = version_data && (version_data->features & CURL_VERSION_HTTP2) != 0;
+#endif
+    if (!client->share) {
+        client->share = curl_share_new();
+        if (!client->share) {
+            SENTRY_WARN("`curl_share_init` failed");
+        }
+    }
 
     if (!client->curl_handle) {
         // In this case we don't start the worker at all, which means we can
@@ -197,6 +304,95 @@ fail:
     return CURL_READFUNC_ABORT;
 }
 
+static int
+file_seek_callback(void *userdata, curl_off_t offset, int origin)
+{
+    file_body_t *body = userdata;
+    if (origin != SEEK_SET || offset < 0 || offset > (curl_off_t)LONG_MAX
+        || fseek(body->file, (long)offset, SEEK_SET) != 0) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    return CURL_SEEKFUNC_OK;
+}
+
+static size_t
+stream_read_callback(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    if (size && nitems > SIZE_MAX / size) {
+        return CURL_READFUNC_ABORT;
+    }
+    size_t read
+        = sentry__http_body_stream_read(userdata, buffer, size * nitems);
+    if (read == SIZE_MAX) {
+        SENTRY_WARN("failed to stream request body");
+        return CURL_READFUNC_ABORT;
+    }
+    return read;
+}
+
+/**
+ * Restarts a streamed body, which curl asks for when it needs to send the
+ * request again, e.g. on a reused connection that turned out to be closed, or
+ * after a proxy or authentication round trip. Streamed bodies can only be
+ * restarted from their beginning.
+ */
+static int
+stream_seek_callback(void *userdata, curl_off_t offset, int origin)
+{
+    if (origin != SEEK_SET || offset != 0
+        || !sentry__http_body_stream_rewind(userdata)) {
+        return CURL_SEEKFUNC_CANTSEEK;
+    }
+    return CURL_SEEKFUNC_OK;
+}
+
+/**
+ * Resets the handle and applies the options that every request of the client
+ * uses. Resetting keeps the live connections of the handle, which are reused
+ * for subsequent requests to the same host.
+ */
+static void
+curl_client_reset(curl_client_t *client)
+{
+    CURL *curl = client->curl_handle;
+    curl_easy_reset(curl);
+    if (client->debug) {
+        curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, stderr);
+        // CURLOPT_WRITEFUNCTION will `fwrite` by default
+    } else {
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, swallow_data);
+    }
+    curl_easy_setopt(curl, CURLOPT_USERAGENT, SENTRY_SDK_USER_AGENT);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, 15000L);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, client);
+    if (client->share) {
+        curl_easy_setopt(curl, CURLOPT_SHARE, client->share->handle);
+    }
+#if LIBCURL_VERSION_NUM >= 0x071900
+    // keep idle connections alive between bursts of envelopes
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 15L);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072f00
+    if (client->http2) {
+        // HTTP/2 is negotiated via ALPN, plain HTTP stays on HTTP/1.1
+        curl_easy_setopt(
+            curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    }
+#endif
+    if (client->proxy) {
+        curl_easy_setopt(curl, CURLOPT_PROXY, client->proxy);
+    }
+    if (client->ca_certs) {
+        curl_easy_setopt(curl, CURLOPT_CAINFO, client->ca_certs);
+    }
+}
+
 static bool
 curl_send_task(void *_client, sentry_prepared_http_request_t *req,
     sentry_http_response_t *resp)
@@ -223,21 +419,9 @@ curl_send_task(void *_client, sentry_prepared_http_request_t *req,
     }
 
     CURL *curl = client->curl_handle;
-    curl_easy_reset(curl);
-    if (client->debug) {
-        curl_easy_setopt(curl, CURLOPT_VERBOSE, 1);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, stderr);
-        // CURLOPT_WRITEFUNCTION will `fwrite` by default
-    } else {
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, swallow_data);
-    }
+    curl_client_reset(client);
     curl_easy_setopt(curl, CURLOPT_URL, req->url);
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_USERAGENT, SENTRY_SDK_USER_AGENT);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, 15000L);
-    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
-    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback);
-    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, client);
 
     FILE *body_file = NULL;
     file_body_t file_body = { 0 };
@@ -259,8 +443,19 @@ curl_send_task(void *_client, sentry_prepared_http_request_t *req,
         curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, req->method);
         curl_easy_setopt(curl, CURLOPT_READFUNCTION, file_read_callback);
         curl_easy_setopt(curl, CURLOPT_READDATA, &file_body);
+        curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, file_seek_callback);
+        curl_easy_setopt(curl, CURLOPT_SEEKDATA, &file_body);
         curl_easy_setopt(
             curl, CURLOPT_INFILESIZE_LARGE, (curl_off_t)req->body_len);
+    } else if (req->body_stream) {
+        // without a known size, curl uses a chunked transfer encoding
+        curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, stream_read_callback);
+        curl_easy_setopt(curl, CURLOPT_READDATA, req->body_stream);
+        curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, stream_seek_callback);
+        curl_easy_setopt(curl, CURLOPT_SEEKDATA, req->body_stream);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE,
+            req->body_len ? (curl_off_t)req->body_len : (curl_off_t)-1);
     } else if (req->body) {
         curl_easy_setopt(curl, CURLOPT_POST, (long)1);
         curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req->body);
@@ -276,13 +471,6 @@ curl_send_task(void *_client, sentry_prepared_http_request_t *req,
     curl_easy_setopt(curl, CURLOPT_HEADERDATA, (void *)resp);
     curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
 
-    if (client->proxy) {
-        curl_easy_setopt(curl, CURLOPT_PROXY, client->proxy);
-    }
-    if (client->ca_certs) {
-        curl_easy_setopt(curl, CURLOPT_CAINFO, client->ca_certs);
-    }
-
 #ifdef SENTRY_PLATFORM_NX
     CURLcode rv = sentry_nx_curl_easy_setopt(client->nx_state, curl, req);
 #else
@@ -319,6 +507,28 @@ curl_send_task(void *_client, sentry_prepared_http_request_t *req,
     return rv == CURLE_OK;
 }
 
+#ifndef SENTRY_PLATFORM_NX
+/**
+ * Connects to `url` without sending a request. This caches the resolved host
+ * and the TLS session in the share, so that the connection of the first
+ * request, and those of the other workers, skip the full handshake.
+ */
+static void
+curl_client_warmup(void *_client, const char *url)
+{
+    curl_client_t *client = _client;
+    CURL *curl = client->curl_handle;
+    curl_client_reset(client);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+    CURLcode rv = curl_easy_perform(curl);
+    if (rv != CURLE_OK) {
+        SENTRY_DEBUGF("failed to warm up connection: %s",
+            curl_easy_strerror(rv));
+    }
+}
+#endif
+
 sentry_transport_t *
 sentry__transport_new_default(void)
 {
@@ -336,6 +546,11 @@ sentry__transport_new_default(void)
     }
     sentry__http_transport_set_free_client(transport, curl_client_free);
     sentry__http_transport_set_start_client(transport, curl_client_start);
+    sentry__http_transport_set_stream_body(transport, true);
     sentry__http_transport_set_shutdown_client(transport, curl_client_shutdown);
+    sentry__http_transport_set_new_client(transport, curl_client_new_worker);
+#ifndef SENTRY_PLATFORM_NX
+    sentry__http_transport_set_warmup_client(transport, curl_client_warmup);
+#endif
     return transport;
 }
@@ -52,3 +52,53 @@ def test_benchmark_backend(backend, cmake, httpserver, gbenchmark):
         gbenchmark,
         f"Backend startup ({backend})",
     )
+
+
+@pytest.mark.parametrize("threads", [1, 16])
+def test_benchmark_batcher_enqueue(threads, cmake, httpserver, gbenchmark):
+    run_benchmark(
+        f"batcher_enqueue/real_time/threads:{threads}$",
+        "inproc",
+        cmake,
+        httpserver,
+        gbenchmark,
+        f"Batcher enqueue ({threads} threads)",
+    )
+
+
+@pytest.mark.parametrize("queue", ["bgworker", "locked_queue"])
+@pytest.mark.parametrize("threads", [1, 16])
+def test_benchmark_bgworker_submit(queue, threads, cmake, httpserver, gbenchmark):
+    run_benchmark(
+        f"{queue}_submit/real_time/threads:{threads}$",
+        "inproc",
+        cmake,
+        httpserver,
+        gbenchmark,
+        f"Task submit ({queue}, {threads} threads)",
+    )
+
+
+@pytest.mark.parametrize("op", ["get", "set", "merge"])
+@pytest.mark.parametrize("keys", [10, 100, 1000])
+def test_benchmark_value_object(op, keys, cmake, httpserver, gbenchmark):
+    run_benchmark(
+        f"value_object_{op}/{keys}$",
+        "inproc",
+        cmake,
+        httpserver,
+        gbenchmark,
+        f"Object {op} ({keys} keys)",
+    )
+
+
+@pytest.mark.parametrize("arena", [0, 1])
+def test_benchmark_value_log_build(arena, cmake, httpserver, gbenchmark):
+    run_benchmark(
+        f"value_log_build/arena:{arena}$",
+        "inproc",
+        cmake,
+        httpserver,
+        gbenchmark,
+        f"Log object build (arena: {arena})",
+    )
@@ -0,0 +1,65 @@
+#include <benchmark/benchmark.h>
+
+extern "C" {
+#include "sentry_batcher.h"
+#include "sentry_database.h"
+#include "sentry_envelope.h"
+#include "sentry_options.h"
+#include "sentry_path.h"
+}
+
+static sentry_options_t *g_options;
+static sentry_batcher_t *g_batcher;
+
+static void
+discard_envelope(sentry_envelope_t *envelope, void *)
+{
+    sentry_envelope_free(envelope);
+}
+
+static void
+batcher_setup()
+{
+    g_options = sentry_options_new();
+    sentry_options_set_transport(
+        g_options, sentry_transport_new(discard_envelope));
+    sentry__path_create_dir_all(g_options->database_path);
+    g_options->run = sentry__run_new(g_options->database_path);
+
+    g_batcher = sentry__batcher_new(sentry__envelope_add_logs,
+        SENTRY_DATA_CATEGORY_LOG_ITEM, g_options->batch_capacity);
+    sentry__batcher_startup(g_batcher, g_options);
+}
+
+static void
+batcher_teardown()
+{
+    sentry__batcher_shutdown(g_batcher, 0);
+    sentry__batcher_release(g_batcher);
+    g_batcher = nullptr;
+    sentry_options_free(g_options);
+    g_options = nullptr;
+}
+
+static void
+benchmark_batcher_enqueue(benchmark::State &state)
+{
+    if (state.thread_index() == 0) {
+        batcher_setup();
+    }
+
+    int64_t dropped = 0;
+    for (auto s : state) {
+        if (!sentry__batcher_enqueue(g_batcher, sentry_value_new_null())) {
+            dropped++;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["dropped"] = benchmark::Counter((double)dropped);
+
+    if (state.thread_index() == 0) {
+        batcher_teardown();
+    }
+}
+
+BENCHMARK(benchmark_batcher_enqueue)->ThreadRange(1, 64)->UseRealTime();
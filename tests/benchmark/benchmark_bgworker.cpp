@@ -0,0 +1,184 @@
+#include <benchmark/benchmark.h>
+
+extern "C" {
+#include "sentry_alloc.h"
+#include "sentry_sync.h"
+#include "sentry_utils.h"
+}
+
+static void
+noop_task(void *, void *)
+{
+}
+
+static sentry_bgworker_t *g_bgworker;
+
+static void
+benchmark_bgworker_submit(benchmark::State &state)
+{
+    if (state.thread_index() == 0) {
+        g_bgworker = sentry__bgworker_new(nullptr, nullptr);
+        sentry__bgworker_start(g_bgworker);
+    }
+
+    for (auto s : state) {
+        sentry__bgworker_submit(g_bgworker, noop_task, nullptr, nullptr);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        sentry__bgworker_shutdown(g_bgworker, 60000);
+        sentry__bgworker_decref(g_bgworker);
+        g_bgworker = nullptr;
+    }
+}
+
+BENCHMARK(benchmark_bgworker_submit)->ThreadRange(1, 64)->UseRealTime();
+
+// The mutex protected task list that the background worker used before, as a
+// baseline. Submitting and popping a task works the same way it did: every
+// submission and both steps of every pop take the same lock.
+struct locked_task_t {
+    locked_task_t *next_task;
+    long refcount;
+    uint64_t execute_after;
+    sentry_task_exec_func_t exec_func;
+    void (*cleanup_func)(void *task_data);
+    void *task_data;
+};
+
+struct locked_queue_t {
+    sentry_threadid_t thread_id;
+    sentry_mutex_t task_lock;
+    sentry_cond_t submit_signal;
+    locked_task_t *first_task;
+    locked_task_t *last_task;
+    locked_task_t *current_task;
+    long running;
+};
+
+static locked_queue_t g_locked_queue;
+
+static void
+locked_task_decref(locked_task_t *task)
+{
+    if (sentry__atomic_fetch_and_add(&task->refcount, -1) == 1) {
+        if (task->cleanup_func) {
+            task->cleanup_func(task->task_data);
+        }
+        sentry_free(task);
+    }
+}
+
+SENTRY_THREAD_FN
+locked_queue_worker(void *data)
+{
+    auto *queue = static_cast<locked_queue_t *>(data);
+    sentry__mutex_lock(&queue->task_lock);
+    while (true) {
+        locked_task_t *task = queue->first_task;
+        if ((!task || sentry__monotonic_time() < task->execute_after)
+            && !sentry__atomic_fetch(&queue->running)) {
+            break;
+        }
+        if (!task) {
+            sentry__cond_wait_timeout(
+                &queue->submit_signal, &queue->task_lock, 1000);
+            continue;
+        }
+        uint64_t now = sentry__monotonic_time();
+        if (now < task->execute_after) {
+            sentry__cond_wait_timeout(&queue->submit_signal,
+                &queue->task_lock, (uint32_t)(task->execute_after - now));
+            continue;
+        }
+
+        sentry__atomic_fetch_and_add(&task->refcount, 1);
+        queue->current_task = task;
+        sentry__mutex_unlock(&queue->task_lock);
+
+        task->exec_func(task->task_data, nullptr);
+        locked_task_decref(task);
+
+        sentry__mutex_lock(&queue->task_lock);
+        queue->current_task = nullptr;
+        if (queue->first_task == task) {
+            queue->first_task = task->next_task;
+            if (task == queue->last_task) {
+                queue->last_task = nullptr;
+            }
+            locked_task_decref(task);
+        }
+    }
+    sentry__mutex_unlock(&queue->task_lock);
+    return 0;
+}
+
+static void
+locked_queue_submit(locked_queue_t *queue, sentry_task_exec_func_t exec_func)
+{
+    auto *task = SENTRY_MAKE(locked_task_t);
+    task->refcount = 1;
+    task->execute_after = sentry__monotonic_time();
+    task->exec_func = exec_func;
+
+    sentry__mutex_lock(&queue->task_lock);
+    if (!queue->first_task) {
+        queue->first_task = task;
+        queue->last_task = task;
+    } else if (queue->last_task->execute_after <= task->execute_after) {
+        queue->last_task->next_task = task;
+        queue->last_task = task;
+    } else {
+        locked_task_t *prev = queue->current_task;
+        locked_task_t *cur = prev ? prev->next_task : queue->first_task;
+        while (cur && cur->execute_after <= task->execute_after) {
+            prev = cur;
+            cur = cur->next_task;
+        }
+        task->next_task = cur;
+        if (prev) {
+            prev->next_task = task;
+        } else {
+            queue->first_task = task;
+        }
+        if (!task->next_task) {
+            queue->last_task = task;
+        }
+    }
+    sentry__cond_wake(&queue->submit_signal);
+    sentry__mutex_unlock(&queue->task_lock);
+}
+
+static void
+benchmark_locked_queue_submit(benchmark::State &state)
+{
+    locked_queue_t *queue = &g_locked_queue;
+    if (state.thread_index() == 0) {
+        sentry__thread_init(&queue->thread_id);
+        sentry__mutex_init(&queue->task_lock);
+        sentry__cond_init(&queue->submit_signal);
+        queue->first_task = nullptr;
+        queue->last_task = nullptr;
+        queue->current_task = nullptr;
+        queue->running = 1;
+        sentry__thread_spawn(&queue->thread_id, locked_queue_worker, queue);
+    }
+
+    for (auto s : state) {
+        locked_queue_submit(queue, noop_task);
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    if (state.thread_index() == 0) {
+        sentry__mutex_lock(&queue->task_lock);
+        sentry__atomic_store(&queue->running, 0);
+        sentry__cond_wake(&queue->submit_signal);
+        sentry__mutex_unlock(&queue->task_lock);
+        sentry__thread_join(queue->thread_id);
+        sentry__thread_free(&queue->thread_id);
+        sentry__mutex_free(&queue->task_lock);
+    }
+}
+
+BENCHMARK(benchmark_locked_queue_submit)->ThreadRange(1, 64)->UseRealTime();
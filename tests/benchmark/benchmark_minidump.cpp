@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+
+#if defined(SENTRY_WITH_NATIVE_BACKEND) && defined(__linux__)
+
+#    include <cstdio>
+#    include <cstdlib>
+#    include <cstring>
+#    include <fcntl.h>
+#    include <unistd.h>
+#    include <vector>
+
+extern "C" {
+#    include "backends/native/minidump/sentry_minidump_common.h"
+}
+
+static const size_t THREAD_COUNT = 500;
+static const size_t MODULE_COUNT = 100;
+static const size_t STACK_SIZE = 16 * 1024;
+
+// Writes a minidump with the same layout the Linux writer produces, from
+// synthetic threads and modules: a context and a stack per thread, the thread
+// list, the module names and list, and finally the header and directory.
+static bool
+write_synthetic_minidump(minidump_writer_base_t *writer,
+    const std::vector<uint8_t> &context, std::vector<uint8_t> &stack)
+{
+    std::vector<minidump_thread_t> threads(THREAD_COUNT);
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        minidump_thread_t *thread = &threads[i];
+        memset(thread, 0, sizeof(*thread));
+        thread->thread_id = (uint32_t)(1000 + i);
+        thread->thread_context.rva = sentry__minidump_write_data(
+            writer, context.data(), context.size());
+        thread->thread_context.size = (uint32_t)context.size();
+    }
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        struct iovec iov = { stack.data(), stack.size() };
+        threads[i].stack.start_address = 0x7f0000000000 + i * STACK_SIZE;
+        threads[i].stack.memory.rva = (minidump_rva_t)writer->current_offset;
+        threads[i].stack.memory.size = (uint32_t)stack.size();
+        if (sentry__minidump_write_iov(writer, &iov, 1) != 0) {
+            return false;
+        }
+    }
+
+    minidump_directory_t directories[2];
+    uint32_t thread_count = (uint32_t)THREAD_COUNT;
+    directories[0].stream_type = MINIDUMP_STREAM_THREAD_LIST;
+    directories[0].rva
+        = sentry__minidump_write_data(writer, &thread_count, sizeof(uint32_t));
+    for (size_t i = 0; i < THREAD_COUNT; i++) {
+        sentry__minidump_write_data(writer, &threads[i], sizeof(threads[i]));
+    }
+    directories[0].data_size = (uint32_t)(sizeof(uint32_t)
+        + THREAD_COUNT * sizeof(minidump_thread_t));
+
+    std::vector<minidump_module_t> modules(MODULE_COUNT);
+    for (size_t i = 0; i < MODULE_COUNT; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "libsynthetic-module-%zu.so", i);
+        memset(&modules[i], 0, sizeof(modules[i]));
+        modules[i].base_of_image = 0x7e0000000000 + i * 0x100000;
+        modules[i].size_of_image = 0x100000;
+        modules[i].module_name_rva
+            = sentry__minidump_write_string(writer, name);
+    }
+    uint32_t module_count = (uint32_t)MODULE_COUNT;
+    directories[1].stream_type = MINIDUMP_STREAM_MODULE_LIST;
+    directories[1].rva
+        = sentry__minidump_write_data(writer, &module_count, sizeof(uint32_t));
+    sentry__minidump_write_data(
+        writer, modules.data(), MODULE_COUNT * sizeof(minidump_module_t));
+    directories[1].data_size = (uint32_t)(sizeof(uint32_t)
+        + MODULE_COUNT * sizeof(minidump_module_t));
+
+    if (sentry__minidump_buffer_end(writer) != 0) {
+        return false;
+    }
+    return sentry__minidump_write_directory(writer, directories, 2) == 0;
+}
+
+// Writes the synthetic minidump unbuffered (0), or staged in the
+// write-combining buffer with the file preallocated (1).
+static void
+benchmark_minidump_write(benchmark::State &state)
+{
+    bool buffered = state.range(0) != 0;
+    std::vector<uint8_t> context(sentry__minidump_get_context_size(), 0x11);
+    std::vector<uint8_t> stack(STACK_SIZE, 0x22);
+    uint64_t header_size
+        = sizeof(minidump_header_t) + 2 * sizeof(minidump_directory_t);
+    uint64_t size_hint = header_size
+        + THREAD_COUNT
+            * (sizeof(minidump_thread_t) + context.size() + STACK_SIZE)
+        + MODULE_COUNT * (sizeof(minidump_module_t) + 64);
+
+    char path[] = "/tmp/sentry-benchmark-minidump-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        state.SkipWithMessage("failed to create minidump file");
+        return;
+    }
+
+    for (auto s : state) {
+        if (ftruncate(fd, 0) != 0
+            || lseek(fd, (off_t)header_size, SEEK_SET) < 0) {
+            state.SkipWithError("failed to reset minidump file");
+            break;
+        }
+        minidump_writer_base_t writer = { fd, header_size, nullptr };
+        if (buffered) {
+            sentry__minidump_buffer_begin(&writer, size_hint);
+        }
+        if (!write_synthetic_minidump(&writer, context, stack)) {
+            state.SkipWithError("failed to write minidump");
+            break;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+
+    close(fd);
+    unlink(path);
+}
+
+BENCHMARK(benchmark_minidump_write)->Arg(0)->Arg(1);
+
+#endif
@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "sentry_value.h"
+}
+
+static std::vector<std::string>
+make_keys(size_t count, const char *prefix)
+{
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "%s.%zu", prefix, i);
+        keys.emplace_back(key);
+    }
+    return keys;
+}
+
+static sentry_value_t
+make_object(const std::vector<std::string> &keys)
+{
+    sentry_value_t obj = sentry_value_new_object();
+    for (size_t i = 0; i < keys.size(); i++) {
+        sentry_value_set_by_key(
+            obj, keys[i].c_str(), sentry_value_new_int32((int32_t)i));
+    }
+    return obj;
+}
+
+static void
+benchmark_value_object_get(benchmark::State &state)
+{
+    const auto keys = make_keys((size_t)state.range(0), "tag");
+    sentry_value_t obj = make_object(keys);
+    for (auto _ : state) {
+        for (const auto &key : keys) {
+            benchmark::DoNotOptimize(
+                sentry_value_get_by_key(obj, key.c_str()));
+        }
+    }
+    state.SetItemsProcessed(
+        state.iterations() * static_cast<int64_t>(keys.size()));
+    sentry_value_decref(obj);
+}
+
+static void
+benchmark_value_object_set(benchmark::State &state)
+{
+    const auto keys = make_keys((size_t)state.range(0), "tag");
+    for (auto _ : state) {
+        sentry_value_t obj = make_object(keys);
+        state.PauseTiming();
+        sentry_value_decref(obj);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(
+        state.iterations() * static_cast<int64_t>(keys.size()));
+}
+
+static void
+benchmark_value_object_merge(benchmark::State &state)
+{
+    // half of the source keys already exist in the destination
+    const auto count = (size_t)state.range(0);
+    const auto dst_keys = make_keys(count, "tag");
+    auto src_keys = make_keys(count / 2, "tag");
+    const auto extra_keys = make_keys(count - count / 2, "extra");
+    src_keys.insert(src_keys.end(), extra_keys.begin(), extra_keys.end());
+    sentry_value_t src = make_object(src_keys);
+    for (auto _ : state) {
+        state.PauseTiming();
+        sentry_value_t dst = make_object(dst_keys);
+        state.ResumeTiming();
+        sentry__value_merge_objects(dst, src);
+        state.PauseTiming();
+        sentry_value_decref(dst);
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+    sentry_value_decref(src);
+}
+
+static sentry_value_t
+make_log(void)
+{
+    // the shape of a structured log, which only uses well-known keys
+    sentry_value_t log = sentry_value_new_object();
+    sentry_value_set_by_key(
+        log, "body", sentry_value_new_string("log message"));
+    sentry_value_set_by_key(log, "level", sentry_value_new_string("info"));
+    sentry_value_set_by_key(log, "timestamp", sentry_value_new_double(1));
+    sentry_value_set_by_key(log, "trace_id",
+        sentry_value_new_string("0123456789abcdef0123456789abcdef"));
+    sentry_value_t attributes = sentry_value_new_object();
+    const char *names[] = { "sentry.sdk.name", "sentry.sdk.version",
+        "sentry.environment", "sentry.release", "sentry.message.template" };
+    for (const char *name : names) {
+        sentry_value_t attribute = sentry_value_new_object();
+        sentry_value_set_by_key(
+            attribute, "type", sentry_value_new_string("string"));
+        sentry_value_set_by_key(
+            attribute, "value", sentry_value_new_string("value"));
+        sentry_value_set_by_key(attributes, name, attribute);
+    }
+    sentry_value_set_by_key(log, "attributes", attributes);
+    return log;
+}
+
+static void
+benchmark_value_log_build(benchmark::State &state)
+{
+    const bool use_arena = state.range(0) != 0;
+    for (auto _ : state) {
+        sentry_value_arena_t *arena
+            = use_arena ? sentry__value_arena_begin() : nullptr;
+        sentry_value_t log = make_log();
+        sentry__value_arena_end(arena);
+        sentry_value_decref(log);
+    }
+}
+
+BENCHMARK(benchmark_value_object_get)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(benchmark_value_object_set)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(benchmark_value_object_merge)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(benchmark_value_log_build)->ArgName("arena")->Arg(0)->Arg(1);
@@ -1,6 +1,8 @@
+import http.server
 import itertools
 import json
 import os
+import threading
 import time
 
 import pytest
@@ -1210,3 +1212,66 @@ def test_http_retry_session_on_network_error(cmake, httpserver, unreachable_dsn)
 
     cache_files = list(cache_dir.glob("*.envelope"))
     assert len(cache_files) == 0
+
+
+class _CountingHandler(http.server.BaseHTTPRequestHandler):
+    """Accepts envelopes over persistent HTTP/1.1 connections."""
+
+    protocol_version = "HTTP/1.1"
+
+    def setup(self):
+        super().setup()
+        self.server.connections.append(self.client_address)
+
+    def _read_body(self):
+        if self.headers.get("transfer-encoding", "").lower() != "chunked":
+            return self.rfile.read(int(self.headers.get("content-length", 0)))
+        body = b""
+        while True:
+            size = int(self.rfile.readline().split(b";")[0], 16)
+            chunk = self.rfile.read(size)
+            self.rfile.readline()
+            if size == 0:
+                return body
+            body += chunk
+
+    def do_POST(self):
+        self.server.requests.append(self._read_body())
+        self.send_response(200)
+        self.send_header("content-length", "2")
+        self.end_headers()
+        self.wfile.write(b"OK")
+
+    def log_message(self, format, *args):
+        pass
+
+
+def test_http_connection_reuse(cmake):
+    tmp_path = cmake(["sentry_example"], {"SENTRY_BACKEND": "none"})
+
+    server = http.server.ThreadingHTTPServer(("127.0.0.1", 0), _CountingHandler)
+    server.daemon_threads = True
+    server.connections = []
+    server.requests = []
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+    try:
+        dsn = "http://uiaeosnrtdy@127.0.0.1:{}/123456".format(server.server_port)
+        run(
+            tmp_path,
+            "sentry_example",
+            ["log", "capture-multiple"],
+            env=dict(os.environ, SENTRY_DSN=dsn),
+        )
+    finally:
+        server.shutdown()
+        server.server_close()
+
+    events = [
+        envelope
+        for envelope in map(Envelope.deserialize, server.requests)
+        if envelope.get_event() is not None
+    ]
+    assert len(events) == 10
+    # all envelopes were sent over the same connection
+    assert len(server.connections) == 1
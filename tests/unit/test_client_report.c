@@ -6,6 +6,7 @@
 #include "sentry_sync.h"
 #include "sentry_testsupport.h"
 #include "sentry_value.h"
+#include "transports/sentry_http_transport.h"
 
 SENTRY_TEST(client_report_discard)
 {
@@ -328,12 +329,14 @@ SENTRY_TEST(client_report_queue_overflow)
     SENTRY_TEST_OPTIONS_NEW(options);
     sentry_init(options);
 
-    sentry_batcher_t *batcher
-        = sentry__batcher_new(dummy_batch_func, SENTRY_DATA_CATEGORY_LOG_ITEM);
+    sentry_batcher_t *batcher = sentry__batcher_new(dummy_batch_func,
+        SENTRY_DATA_CATEGORY_LOG_ITEM, SENTRY_BATCHER_QUEUE_LENGTH);
     TEST_CHECK(!!batcher);
 
-    // Fill the buffer (SENTRY_BATCHER_QUEUE_LENGTH is 5 in unit tests)
-    for (int i = 0; i < SENTRY_BATCHER_QUEUE_LENGTH; i++) {
+    // Fill every shard (SENTRY_BATCHER_QUEUE_LENGTH is 5 in unit tests), since
+    // producers spill over into other shards when their own one is full.
+    for (int i = 0;
+        i < SENTRY_BATCHER_QUEUE_LENGTH * SENTRY_BATCHER_SHARD_COUNT; i++) {
         TEST_CHECK(sentry__batcher_enqueue(batcher, sentry_value_new_null()));
     }
 
@@ -586,3 +589,75 @@ SENTRY_TEST(client_report_concurrent)
 
     sentry_close();
 }
+
+static volatile long g_overflow_requests = 0;
+static volatile long g_overflow_released = 0;
+
+static bool
+send_blocked_request(void *UNUSED(client),
+    sentry_prepared_http_request_t *UNUSED(req), sentry_http_response_t *resp)
+{
+    for (int i = 0; i < 500 && !sentry__atomic_fetch(&g_overflow_released);
+        i++) {
+        sleep_ms(10);
+    }
+    sentry__atomic_fetch_and_add(&g_overflow_requests, 1);
+    resp->status_code = 200;
+    return true;
+}
+
+static void
+send_log_envelope(sentry_transport_t *transport)
+{
+    sentry_envelope_t *envelope = sentry__envelope_new();
+    TEST_ASSERT(!!envelope);
+    sentry__envelope_add_from_buffer(envelope, "{}", 2, "log");
+    sentry__transport_send_envelope(transport, envelope);
+}
+
+SENTRY_TEST(client_report_transport_queue_overflow)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_send_client_reports(options, false);
+    // the queue is unbounded unless a capacity is set
+    TEST_CHECK_INT_EQUAL(sentry_options_get_http_queue_capacity(options), 0);
+    sentry_options_set_http_queue_capacity(options, 2);
+    sentry_transport_t *transport
+        = sentry__http_transport_new(NULL, send_blocked_request);
+    TEST_ASSERT(!!transport);
+    sentry_options_set_transport(options, transport);
+    sentry_init(options);
+    sentry__client_report_reset();
+
+    // the event and one log fill the queue, the other logs are shed
+    sentry_capture_event(
+        sentry_value_new_message_event(SENTRY_LEVEL_INFO, NULL, "test"));
+    send_log_envelope(transport);
+    send_log_envelope(transport);
+    send_log_envelope(transport);
+
+    // another event replaces the queued log
+    sentry_capture_event(
+        sentry_value_new_message_event(SENTRY_LEVEL_INFO, NULL, "test"));
+
+    sentry_client_report_t report = { { 0 } };
+    TEST_CHECK(sentry__client_report_save(&report));
+    TEST_CHECK_INT_EQUAL(report.counts[SENTRY_DISCARD_REASON_QUEUE_OVERFLOW]
+                                      [SENTRY_DATA_CATEGORY_LOG_ITEM],
+        3);
+    TEST_CHECK_INT_EQUAL(report.counts[SENTRY_DISCARD_REASON_QUEUE_OVERFLOW]
+                                      [SENTRY_DATA_CATEGORY_ERROR],
+        0);
+
+    sentry__atomic_store(&g_overflow_released, 1);
+    TEST_CHECK_INT_EQUAL(sentry_flush(5000), 0);
+    TEST_CHECK_INT_EQUAL(sentry__atomic_fetch(&g_overflow_requests), 2);
+
+    sentry_http_transport_stats_t stats;
+    sentry__http_transport_get_stats(transport, &stats);
+    TEST_CHECK_INT_EQUAL(stats.queued, 0);
+
+    sentry__client_report_reset();
+    sentry_close();
+}
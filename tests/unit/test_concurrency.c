@@ -1,5 +1,11 @@
 #include "sentry_core.h"
+#include "sentry_database.h"
+#include "sentry_envelope.h"
+#include "sentry_options.h"
+#include "sentry_path.h"
 #include "sentry_testsupport.h"
+#include "sentry_value.h"
+#include "transports/sentry_http_transport.h"
 
 #include <sentry_sync.h>
 
@@ -150,3 +156,271 @@ SENTRY_TEST(concurrent_uninit)
 
     sentry_close();
 }
+
+static volatile long g_primary_requests = 0;
+static volatile long g_worker_requests = 0;
+static volatile long g_in_flight = 0;
+static volatile long g_max_in_flight = 0;
+
+static void *
+new_concurrent_client(void *UNUSED(client))
+{
+    return (void *)&g_worker_requests;
+}
+
+static bool
+send_concurrent_request(void *client,
+    sentry_prepared_http_request_t *UNUSED(req), sentry_http_response_t *resp)
+{
+    long in_flight = sentry__atomic_fetch_and_add(&g_in_flight, 1) + 1;
+    long max_in_flight = sentry__atomic_fetch(&g_max_in_flight);
+    while (in_flight > max_in_flight
+        && !sentry__atomic_compare_swap(
+            &g_max_in_flight, max_in_flight, in_flight)) {
+        max_in_flight = sentry__atomic_fetch(&g_max_in_flight);
+    }
+
+    // the first requests of both workers wait for each other
+    for (int i = 0; i < 500 && sentry__atomic_fetch(&g_max_in_flight) < 2;
+        i++) {
+        sleep_ms(10);
+    }
+    sentry__atomic_fetch_and_add((volatile long *)client, 1);
+
+    sentry__atomic_fetch_and_add(&g_in_flight, -1);
+    resp->status_code = 200;
+    return true;
+}
+
+SENTRY_TEST(concurrent_http_transport)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_http_concurrency(options, 2);
+    sentry_transport_t *transport = sentry__http_transport_new(
+        (void *)&g_primary_requests, send_concurrent_request);
+    TEST_ASSERT(!!transport);
+    sentry__http_transport_set_new_client(transport, new_concurrent_client);
+    sentry_options_set_transport(options, transport);
+    sentry_init(options);
+
+    sentry_http_transport_stats_t stats;
+    sentry__http_transport_get_stats(transport, &stats);
+    TEST_CHECK_INT_EQUAL(stats.workers, 2);
+
+    sentry_capture_event(
+        sentry_value_new_message_event(SENTRY_LEVEL_INFO, NULL, "test"));
+    for (int i = 0; i < 3; i++) {
+        sentry_envelope_t *envelope = sentry__envelope_new();
+        TEST_ASSERT(!!envelope);
+        sentry__envelope_add_from_buffer(envelope, "{}", 2, "session");
+        sentry__transport_send_envelope(transport, envelope);
+    }
+
+    TEST_CHECK_INT_EQUAL(sentry_flush(10000), 0);
+    TEST_CHECK_INT_EQUAL(sentry__atomic_fetch(&g_primary_requests), 1);
+    TEST_CHECK_INT_EQUAL(sentry__atomic_fetch(&g_worker_requests), 3);
+    TEST_CHECK_INT_EQUAL(sentry__atomic_fetch(&g_max_in_flight), 2);
+
+    sentry__http_transport_get_stats(transport, &stats);
+    TEST_CHECK_INT_EQUAL(stats.queued, 0);
+    TEST_CHECK_INT_EQUAL(stats.in_flight, 0);
+
+    sentry_close();
+}
+
+static volatile long g_coalesced_requests = 0;
+
+static bool
+send_coalesced_request(void *UNUSED(client),
+    sentry_prepared_http_request_t *UNUSED(req), sentry_http_response_t *resp)
+{
+    sentry__atomic_fetch_and_add(&g_coalesced_requests, 1);
+    resp->status_code = 200;
+    return true;
+}
+
+SENTRY_TEST(coalesced_http_transport)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_send_client_reports(options, false);
+    // fits the payloads of two envelopes
+    sentry_options_set_http_coalesce_size(options, 4);
+    sentry_options_set_http_coalesce_delay(options, 200);
+    sentry_transport_t *transport
+        = sentry__http_transport_new(NULL, send_coalesced_request);
+    TEST_ASSERT(!!transport);
+    sentry_options_set_transport(options, transport);
+    sentry_init(options);
+
+    sentry_capture_event(
+        sentry_value_new_message_event(SENTRY_LEVEL_INFO, NULL, "test"));
+    for (int i = 0; i < 5; i++) {
+        sentry_envelope_t *envelope = sentry__envelope_new();
+        TEST_ASSERT(!!envelope);
+        sentry__envelope_add_from_buffer(envelope, "{}", 2, "log");
+        sentry__transport_send_envelope(transport, envelope);
+    }
+
+    // the event on its own, and the logs in pairs
+    TEST_CHECK_INT_EQUAL(sentry_flush(10000), 0);
+    TEST_CHECK_INT_EQUAL(sentry__atomic_fetch(&g_coalesced_requests), 4);
+
+    sentry_http_transport_stats_t stats;
+    sentry__http_transport_get_stats(transport, &stats);
+    TEST_CHECK_INT_EQUAL(stats.queued, 0);
+
+    // held back envelopes are still sent on shutdown
+    sentry_envelope_t *envelope = sentry__envelope_new();
+    TEST_ASSERT(!!envelope);
+    sentry__envelope_add_from_buffer(envelope, "{}", 2, "log");
+    sentry__transport_send_envelope(transport, envelope);
+    sentry_close();
+    TEST_CHECK_INT_EQUAL(sentry__atomic_fetch(&g_coalesced_requests), 5);
+}
+
+static volatile long g_retry_primary_requests = 0;
+static volatile long g_retry_worker_requests = 0;
+
+static void *
+new_retry_client(void *UNUSED(client))
+{
+    return (void *)&g_retry_worker_requests;
+}
+
+static bool
+send_retry_request(void *client, sentry_prepared_http_request_t *UNUSED(req),
+    sentry_http_response_t *resp)
+{
+    sentry__atomic_fetch_and_add((volatile long *)client, 1);
+    resp->status_code = 200;
+    return true;
+}
+
+SENTRY_TEST(retry_batch_http_transport)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_send_client_reports(options, false);
+    sentry_options_set_http_retry(options, true);
+    sentry_options_set_http_concurrency(options, 2);
+    sentry_transport_t *transport = sentry__http_transport_new(
+        (void *)&g_retry_primary_requests, send_retry_request);
+    TEST_ASSERT(!!transport);
+    sentry__http_transport_set_new_client(transport, new_retry_client);
+    sentry_options_set_transport(options, transport);
+    sentry_init(options);
+
+    const sentry_path_t *cache_path = options->run->cache_path;
+    sentry__path_remove_all(cache_path);
+    for (int i = 0; i < 2; i++) {
+        sentry_envelope_t *envelope = sentry__envelope_new();
+        TEST_ASSERT(!!envelope);
+        sentry_uuid_t event_id = sentry_uuid_new_v4();
+        sentry__envelope_add_event(
+            envelope, sentry__value_new_event_with_id(&event_id));
+        TEST_CHECK(sentry__run_write_cache(options->run, envelope, 0));
+        sentry_envelope_free(envelope);
+    }
+
+    // the transport's own worker and the additional one send one each
+    sentry_transport_retry(transport);
+    TEST_CHECK_INT_EQUAL(sentry_flush(10000), 0);
+    TEST_CHECK_INT_EQUAL(sentry__atomic_fetch(&g_retry_primary_requests), 1);
+    TEST_CHECK_INT_EQUAL(sentry__atomic_fetch(&g_retry_worker_requests), 1);
+
+    sentry_close();
+}
+
+typedef struct {
+    volatile long in_request;
+    volatile long shutdown;
+    uint64_t shutdown_at;
+} cancelable_client_t;
+
+static cancelable_client_t g_cancel_primary;
+static cancelable_client_t g_cancel_worker;
+
+static void *
+new_cancelable_client(void *UNUSED(client))
+{
+    return &g_cancel_worker;
+}
+
+static void
+shutdown_cancelable_client(void *_client)
+{
+    cancelable_client_t *client = _client;
+    if (!sentry__atomic_fetch(&client->shutdown)) {
+        client->shutdown_at = sentry__monotonic_time();
+        sentry__atomic_store(&client->shutdown, 1);
+    }
+}
+
+static bool
+send_cancelable_request(void *_client,
+    sentry_prepared_http_request_t *UNUSED(req), sentry_http_response_t *resp)
+{
+    cancelable_client_t *client = _client;
+    if (client == &g_cancel_primary) {
+        resp->status_code = 200;
+        return true;
+    }
+    // the additional worker's request hangs until it is cancelled
+    sentry__atomic_store(&client->in_request, 1);
+    while (!sentry__atomic_fetch(&client->shutdown)) {
+        sleep_ms(10);
+    }
+    resp->shutdown = true;
+    return false;
+}
+
+SENTRY_TEST(retry_batch_http_transport_shutdown)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_send_client_reports(options, false);
+    sentry_options_set_http_retry(options, true);
+    sentry_options_set_http_concurrency(options, 2);
+    sentry_transport_t *transport = sentry__http_transport_new(
+        &g_cancel_primary, send_cancelable_request);
+    TEST_ASSERT(!!transport);
+    sentry__http_transport_set_new_client(transport, new_cancelable_client);
+    sentry__http_transport_set_shutdown_client(
+        transport, shutdown_cancelable_client);
+    sentry_options_set_transport(options, transport);
+    sentry_init(options);
+
+    const sentry_path_t *cache_path = options->run->cache_path;
+    sentry__path_remove_all(cache_path);
+    for (int i = 0; i < 2; i++) {
+        sentry_envelope_t *envelope = sentry__envelope_new();
+        TEST_ASSERT(!!envelope);
+        sentry_uuid_t event_id = sentry_uuid_new_v4();
+        sentry__envelope_add_event(
+            envelope, sentry__value_new_event_with_id(&event_id));
+        TEST_CHECK(sentry__run_write_cache(options->run, envelope, 0));
+        sentry_envelope_free(envelope);
+    }
+
+    sentry_transport_retry(transport);
+    for (int i = 0;
+        i < 500 && !sentry__atomic_fetch(&g_cancel_worker.in_request); i++) {
+        sleep_ms(10);
+    }
+    TEST_ASSERT(sentry__atomic_fetch(&g_cancel_worker.in_request));
+
+    // the timeout of the transport's own worker cancels the request of the
+    // additional worker right away, instead of leaving its batch blocked
+    // until the additional worker is shut down after the grace period
+    uint64_t started = sentry__monotonic_time();
+    sentry__transport_shutdown(transport, 100);
+    TEST_CHECK(sentry__atomic_fetch(&g_cancel_primary.shutdown));
+    TEST_CHECK(sentry__atomic_fetch(&g_cancel_worker.shutdown));
+    TEST_CHECK(g_cancel_worker.shutdown_at - started < 300);
+    TEST_CHECK(
+        g_cancel_worker.shutdown_at - g_cancel_primary.shutdown_at < 50);
+
+    sentry_close();
+}
@@ -12,6 +12,13 @@
 #include "sentry_value.h"
 #include "transports/sentry_http_transport.h"
 
+#ifdef SENTRY_TRANSPORT_COMPRESSION
+#    include "zlib.h"
+#endif
+#ifdef SENTRY_TRANSPORT_ZSTD
+#    include <zstd.h>
+#endif
+
 static char *const SERIALIZED_ENVELOPE_STR
     = "{\"dsn\":\"https://foo@sentry.invalid/42\","
       "\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\",\"trace\":{"
@@ -39,16 +46,14 @@ SENTRY_TEST(basic_http_request_preparation_for_event)
     sentry__envelope_add_event(envelope, event);
 
     sentry_prepared_http_request_t *req
-        = sentry__prepare_http_request(envelope, dsn, NULL, NULL);
+        = sentry__prepare_http_request(envelope, dsn, NULL, NULL, NULL);
     TEST_CHECK_STRING_EQUAL(req->method, "POST");
     TEST_CHECK_STRING_EQUAL(
         req->url, "https://sentry.invalid:443/api/42/envelope/");
-#ifndef SENTRY_TRANSPORT_COMPRESSION
     TEST_CHECK_STRING_EQUAL(req->body,
         "{\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\"}\n"
         "{\"type\":\"event\",\"length\":51}\n"
         "{\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\"}");
-#endif
     sentry__prepared_http_request_free(req);
     sentry_envelope_free(envelope);
 
@@ -70,11 +75,10 @@ SENTRY_TEST(basic_http_request_preparation_for_transaction)
     sentry__envelope_add_transaction(envelope, transaction);
 
     sentry_prepared_http_request_t *req
-        = sentry__prepare_http_request(envelope, dsn, NULL, NULL);
+        = sentry__prepare_http_request(envelope, dsn, NULL, NULL, NULL);
     TEST_CHECK_STRING_EQUAL(req->method, "POST");
     TEST_CHECK_STRING_EQUAL(
         req->url, "https://sentry.invalid:443/api/42/envelope/");
-#ifndef SENTRY_TRANSPORT_COMPRESSION
     TEST_CHECK_STRING_EQUAL(req->body,
         "{\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\","
         "\"sent_at\":"
@@ -82,7 +86,6 @@ SENTRY_TEST(basic_http_request_preparation_for_transaction)
         "{\"type\":\"transaction\",\"length\":72}\n"
         "{\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\",\"type\":"
         "\"transaction\"}");
-#endif
     sentry__prepared_http_request_free(req);
     sentry_envelope_free(envelope);
 
@@ -103,18 +106,16 @@ SENTRY_TEST(basic_http_request_preparation_for_user_report)
     sentry__envelope_add_user_report(envelope, user_report);
 
     sentry_prepared_http_request_t *req
-        = sentry__prepare_http_request(envelope, dsn, NULL, NULL);
+        = sentry__prepare_http_request(envelope, dsn, NULL, NULL, NULL);
     TEST_CHECK_STRING_EQUAL(req->method, "POST");
     TEST_CHECK_STRING_EQUAL(
         req->url, "https://sentry.invalid:443/api/42/envelope/");
-#ifndef SENTRY_TRANSPORT_COMPRESSION
     TEST_CHECK_STRING_EQUAL(req->body,
         "{\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\"}\n"
         "{\"type\":\"user_report\",\"length\":117}\n"
         "{\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\",\"name\":"
         "\"some-name\",\"email\":\"some-email\",\"comments\":"
         "\"some-comment\"}");
-#endif
     sentry__prepared_http_request_free(req);
     sentry_value_decref(user_report);
     sentry_envelope_free(envelope);
@@ -134,11 +135,10 @@ SENTRY_TEST(basic_http_request_preparation_for_user_feedback)
     sentry__envelope_add_user_feedback(envelope, user_feedback);
 
     sentry_prepared_http_request_t *req
-        = sentry__prepare_http_request(envelope, dsn, NULL, NULL);
+        = sentry__prepare_http_request(envelope, dsn, NULL, NULL, NULL);
     TEST_CHECK_STRING_EQUAL(req->method, "POST");
     TEST_CHECK_STRING_EQUAL(
         req->url, "https://sentry.invalid:443/api/42/envelope/");
-#ifndef SENTRY_TRANSPORT_COMPRESSION
     char *line1 = req->body;
     char *line1_end = strchr(line1, '\n');
     TEST_CHECK(line1_end != NULL);
@@ -184,7 +184,6 @@ SENTRY_TEST(basic_http_request_preparation_for_user_feedback)
                                 actual, "associated_event_id")),
         "c993afb6b4ac48a6b61b2558e601d65d");
     sentry_value_decref(line3_json);
-#endif
     sentry__prepared_http_request_free(req);
     sentry_envelope_free(envelope);
 
@@ -207,18 +206,16 @@ SENTRY_TEST(basic_http_request_preparation_for_event_with_attachment)
         envelope, msg, sizeof(msg) - 1, "attachment");
 
     sentry_prepared_http_request_t *req
-        = sentry__prepare_http_request(envelope, dsn, NULL, NULL);
+        = sentry__prepare_http_request(envelope, dsn, NULL, NULL, NULL);
     TEST_CHECK_STRING_EQUAL(req->method, "POST");
     TEST_CHECK_STRING_EQUAL(
         req->url, "https://sentry.invalid:443/api/42/envelope/");
-#ifndef SENTRY_TRANSPORT_COMPRESSION
     TEST_CHECK_STRING_EQUAL(req->body,
         "{\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\"}\n"
         "{\"type\":\"event\",\"length\":51}\n"
         "{\"event_id\":\"c993afb6-b4ac-48a6-b61b-2558e601d65d\"}\n"
         "{\"type\":\"attachment\",\"length\":12}\n"
         "Hello World!");
-#endif
     sentry__prepared_http_request_free(req);
     sentry_envelope_free(envelope);
 
@@ -238,24 +235,264 @@ SENTRY_TEST(basic_http_request_preparation_for_minidump)
         envelope, msg, sizeof(msg) - 1, "attachment");
 
     sentry_prepared_http_request_t *req
-        = sentry__prepare_http_request(envelope, dsn, NULL, NULL);
+        = sentry__prepare_http_request(envelope, dsn, NULL, NULL, NULL);
     TEST_CHECK_STRING_EQUAL(req->method, "POST");
     TEST_CHECK_STRING_EQUAL(
         req->url, "https://sentry.invalid:443/api/42/envelope/");
-#ifndef SENTRY_TRANSPORT_COMPRESSION
     TEST_CHECK_STRING_EQUAL(req->body,
         "{}\n"
         "{\"type\":\"minidump\",\"length\":4}\n"
         "MDMP\n"
         "{\"type\":\"attachment\",\"length\":12}\n"
         "Hello World!");
-#endif
     sentry__prepared_http_request_free(req);
     sentry_envelope_free(envelope);
 
     sentry__dsn_decref(dsn);
 }
 
+static char *
+read_body_stream(sentry_http_body_stream_t *body, size_t *len_out)
+{
+    sentry_stringbuilder_t sb;
+    sentry__stringbuilder_init(&sb);
+    char buf[5];
+    size_t read;
+    while ((read = sentry__http_body_stream_read(body, buf, sizeof(buf))) > 0
+        && read != SIZE_MAX) {
+        sentry__stringbuilder_append_buf(&sb, buf, read);
+    }
+    TEST_CHECK(read == 0);
+    *len_out = sentry__stringbuilder_len(&sb);
+    return sentry__stringbuilder_into_string(&sb);
+}
+
+SENTRY_TEST(streamed_http_request_preparation)
+{
+    SENTRY_TEST_DSN_NEW_DEFAULT(dsn);
+
+    sentry_envelope_t *envelope = sentry__envelope_new();
+    char dmp[] = "MDMP";
+    sentry__envelope_add_from_buffer(
+        envelope, dmp, sizeof(dmp) - 1, "minidump");
+    char msg[] = "Hello World!";
+    sentry__envelope_add_from_buffer(
+        envelope, msg, sizeof(msg) - 1, "attachment");
+    sentry__envelope_add_from_buffer(envelope, "{}", 2, "session");
+
+    sentry_rate_limiter_t *rl = sentry__rate_limiter_new();
+    sentry__rate_limiter_update_from_header(rl, "60:session:organization");
+
+    sentry_prepared_http_request_t *req
+        = sentry__prepare_http_request_streamed(envelope, dsn, rl, NULL, NULL);
+    TEST_ASSERT(!!req);
+    TEST_CHECK_STRING_EQUAL(req->method, "POST");
+    TEST_CHECK_STRING_EQUAL(
+        req->url, "https://sentry.invalid:443/api/42/envelope/");
+    TEST_CHECK(!req->body);
+    TEST_ASSERT(!!req->body_stream);
+
+    const char *expected = "{}\n"
+                           "{\"type\":\"minidump\",\"length\":4}\n"
+                           "MDMP\n"
+                           "{\"type\":\"attachment\",\"length\":12}\n"
+                           "Hello World!";
+    size_t body_len = 0;
+    char *body = read_body_stream(req->body_stream, &body_len);
+    TEST_CHECK_INT_EQUAL(req->body_len, strlen(expected));
+    TEST_CHECK_INT_EQUAL(body_len, strlen(expected));
+    TEST_CHECK_STRING_EQUAL(body, expected);
+    sentry_free(body);
+
+    // a body that was partially sent can be sent again from the start
+    char partial[8];
+    TEST_CHECK(sentry__http_body_stream_rewind(req->body_stream));
+    TEST_CHECK_INT_EQUAL(sentry__http_body_stream_read(
+                             req->body_stream, partial, sizeof(partial)),
+        sizeof(partial));
+    TEST_CHECK(sentry__http_body_stream_rewind(req->body_stream));
+    body = read_body_stream(req->body_stream, &body_len);
+    TEST_CHECK_STRING_EQUAL(body, expected);
+    sentry_free(body);
+    sentry__prepared_http_request_free(req);
+
+#ifdef SENTRY_TRANSPORT_COMPRESSION
+    sentry_compressor_t *compressor
+        = sentry__compressor_new(SENTRY_HTTP_COMPRESSION_GZIP, 0, 0);
+    TEST_ASSERT(!!compressor);
+    req = sentry__prepare_http_request_streamed(
+        envelope, dsn, rl, NULL, compressor);
+    TEST_ASSERT(!!req);
+    TEST_ASSERT(!!req->body_stream);
+    body = read_body_stream(req->body_stream, &body_len);
+    TEST_CHECK_INT_EQUAL(req->body_len, 0);
+    TEST_ASSERT(body_len > 2);
+    TEST_CHECK((unsigned char)body[0] == 0x1f);
+    TEST_CHECK((unsigned char)body[1] == 0x8b);
+
+    char inflated[256];
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    TEST_ASSERT(inflateInit2(&stream, MAX_WBITS + 16) == Z_OK);
+    stream.next_in = (unsigned char *)body;
+    stream.avail_in = (unsigned int)body_len;
+    stream.next_out = (unsigned char *)inflated;
+    stream.avail_out = sizeof(inflated) - 1;
+    TEST_CHECK(inflate(&stream, Z_FINISH) == Z_STREAM_END);
+    inflated[stream.total_out] = '\0';
+    inflateEnd(&stream);
+    TEST_CHECK_STRING_EQUAL(inflated, expected);
+
+    // restarting compresses the body again
+    TEST_CHECK(sentry__http_body_stream_rewind(req->body_stream));
+    size_t resent_len = 0;
+    char *resent = read_body_stream(req->body_stream, &resent_len);
+    TEST_CHECK_INT_EQUAL(resent_len, body_len);
+    TEST_CHECK(memcmp(resent, body, body_len) == 0);
+    sentry_free(resent);
+    sentry_free(body);
+    sentry__prepared_http_request_free(req);
+    sentry__compressor_free(compressor);
+#endif
+
+    // nothing to send when all items are rate-limited
+    sentry__rate_limiter_update_from_header(rl, "60::organization");
+    TEST_CHECK(
+        !sentry__prepare_http_request_streamed(envelope, dsn, rl, NULL, NULL));
+
+    sentry__rate_limiter_free(rl);
+    sentry_envelope_free(envelope);
+    sentry__dsn_decref(dsn);
+}
+
+SENTRY_TEST(http_compressor)
+{
+    TEST_CHECK(!sentry__compressor_new(SENTRY_HTTP_COMPRESSION_NONE, 0, 0));
+#ifndef SENTRY_TRANSPORT_COMPRESSION
+    // without zlib, gzip falls back to sending bodies uncompressed
+    TEST_CHECK(!sentry__compressor_new(SENTRY_HTTP_COMPRESSION_GZIP, 0, 0));
+    SKIP_TEST();
+#else
+    sentry_compressor_t *compressor
+        = sentry__compressor_new(SENTRY_HTTP_COMPRESSION_GZIP, 0, 64);
+    TEST_ASSERT(!!compressor);
+    TEST_CHECK_STRING_EQUAL(sentry__compressor_encoding(compressor), "gzip");
+#ifndef SENTRY_TRANSPORT_ZSTD
+    sentry_compressor_t *fallback
+        = sentry__compressor_new(SENTRY_HTTP_COMPRESSION_ZSTD, 0, 0);
+    TEST_ASSERT(!!fallback);
+    TEST_CHECK_STRING_EQUAL(sentry__compressor_encoding(fallback), "gzip");
+    sentry__compressor_free(fallback);
+#endif
+
+    // bodies below the threshold are sent as they are
+    size_t compressed_len = 0;
+    TEST_CHECK(!sentry__compressor_begin(compressor, 63));
+    TEST_CHECK(!sentry__compressor_compress_buffer(
+        compressor, "Hello World!", 12, &compressed_len));
+
+    char body[4096];
+    memset(body, 'x', sizeof(body));
+    // the context is reused for every body
+    for (int i = 0; i < 2; i++) {
+        char *compressed = sentry__compressor_compress_buffer(
+            compressor, body, sizeof(body), &compressed_len);
+        TEST_ASSERT(!!compressed);
+        TEST_CHECK(compressed_len < sizeof(body));
+
+        char inflated[sizeof(body)];
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        TEST_ASSERT(inflateInit2(&stream, MAX_WBITS + 16) == Z_OK);
+        stream.next_in = (unsigned char *)compressed;
+        stream.avail_in = (unsigned int)compressed_len;
+        stream.next_out = (unsigned char *)inflated;
+        stream.avail_out = sizeof(inflated);
+        TEST_CHECK(inflate(&stream, Z_FINISH) == Z_STREAM_END);
+        TEST_CHECK_INT_EQUAL(stream.total_out, sizeof(body));
+        TEST_CHECK(memcmp(inflated, body, sizeof(body)) == 0);
+        inflateEnd(&stream);
+        sentry_free(compressed);
+    }
+
+    sentry_compression_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    sentry__compressor_get_stats(compressor, &stats);
+    TEST_CHECK_INT_EQUAL(stats.bodies, 2);
+    TEST_CHECK_INT_EQUAL(stats.bytes_in, 2 * sizeof(body));
+    TEST_CHECK_INT_EQUAL(stats.bytes_out, 2 * compressed_len);
+
+    sentry__compressor_free(compressor);
+#endif
+}
+
+SENTRY_TEST(http_compressor_zstd)
+{
+#ifndef SENTRY_TRANSPORT_ZSTD
+    SKIP_TEST();
+#else
+    sentry_compressor_t *compressor
+        = sentry__compressor_new(SENTRY_HTTP_COMPRESSION_ZSTD, 3, 64);
+    TEST_ASSERT(!!compressor);
+    TEST_CHECK_STRING_EQUAL(sentry__compressor_encoding(compressor), "zstd");
+
+    char body[4096];
+    for (size_t i = 0; i < sizeof(body); i++) {
+        body[i] = (char)('a' + i % 7);
+    }
+    // the context is reused for every body
+    for (int i = 0; i < 2; i++) {
+        size_t compressed_len = 0;
+        char *compressed = sentry__compressor_compress_buffer(
+            compressor, body, sizeof(body), &compressed_len);
+        TEST_ASSERT(!!compressed);
+        TEST_CHECK(compressed_len < sizeof(body));
+        TEST_CHECK(ZSTD_getFrameContentSize(compressed, compressed_len)
+            == sizeof(body));
+
+        char decompressed[sizeof(body)];
+        size_t decompressed_len = ZSTD_decompress(
+            decompressed, sizeof(decompressed), compressed, compressed_len);
+        TEST_CHECK(!ZSTD_isError(decompressed_len));
+        TEST_CHECK_INT_EQUAL(decompressed_len, sizeof(body));
+        TEST_CHECK(memcmp(decompressed, body, sizeof(body)) == 0);
+        sentry_free(compressed);
+    }
+
+    // streamed in small pieces, as request bodies are
+    TEST_ASSERT(sentry__compressor_begin(compressor, sizeof(body)));
+    const char *in = body;
+    size_t in_len = sizeof(body);
+    char streamed[sizeof(body)];
+    size_t streamed_len = 0;
+    bool finished = false;
+    while (!finished && streamed_len < sizeof(streamed)) {
+        size_t chunk_len = MIN(in_len, 1000);
+        size_t chunk_left = chunk_len;
+        size_t produced = sentry__compressor_compress(compressor, &in,
+            &chunk_left, chunk_len == in_len, streamed + streamed_len,
+            MIN(sizeof(streamed) - streamed_len, 256), &finished);
+        TEST_ASSERT(produced != SIZE_MAX);
+        in_len -= chunk_len - chunk_left;
+        streamed_len += produced;
+    }
+    TEST_CHECK(finished);
+    char decompressed[sizeof(body)];
+    TEST_CHECK_INT_EQUAL(ZSTD_decompress(decompressed, sizeof(decompressed),
+                             streamed, streamed_len),
+        sizeof(body));
+    TEST_CHECK(memcmp(decompressed, body, sizeof(body)) == 0);
+
+    sentry_compression_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+    sentry__compressor_get_stats(compressor, &stats);
+    TEST_CHECK_INT_EQUAL(stats.bodies, 3);
+    TEST_CHECK_INT_EQUAL(stats.bytes_in, 3 * sizeof(body));
+
+    sentry__compressor_free(compressor);
+#endif
+}
+
 sentry_envelope_t *
 create_test_envelope()
 {
@@ -301,6 +538,34 @@ SENTRY_TEST(serialize_envelope)
     sentry_close();
 }
 
+SENTRY_TEST(envelope_reader)
+{
+    sentry_envelope_t *envelope = create_test_envelope();
+
+    sentry_envelope_reader_t *reader
+        = sentry__envelope_reader_new(envelope, NULL);
+    TEST_ASSERT(!!reader);
+    TEST_CHECK_INT_EQUAL(sentry__envelope_reader_len(reader),
+        strlen(SERIALIZED_ENVELOPE_STR));
+
+    // read in chunks that don't line up with the item boundaries
+    sentry_stringbuilder_t sb;
+    sentry__stringbuilder_init(&sb);
+    char buf[3];
+    size_t read;
+    while ((read = sentry__envelope_reader_read(reader, buf, sizeof(buf)))) {
+        sentry__stringbuilder_append_buf(&sb, buf, read);
+    }
+    char *str = sentry__stringbuilder_into_string(&sb);
+    TEST_CHECK_STRING_EQUAL(str, SERIALIZED_ENVELOPE_STR);
+    TEST_CHECK_INT_EQUAL(sentry__envelope_reader_read(reader, buf, 1), 0);
+
+    sentry_free(str);
+    sentry__envelope_reader_free(reader);
+    sentry_envelope_free(envelope);
+    sentry_close();
+}
+
 SENTRY_TEST(basic_write_envelope_to_file)
 {
     sentry_envelope_t *envelope = create_test_envelope();
@@ -515,6 +780,43 @@ SENTRY_TEST(read_envelope_from_file)
     sentry_close();
 }
 
+SENTRY_TEST(read_large_envelope_from_file)
+{
+    const char *test_file_str
+        = SENTRY_TEST_PATH_PREFIX "sentry_test_large_envelope";
+    sentry_path_t *test_file_path = sentry__path_from_str(test_file_str);
+
+    const size_t payload_len = 128 * 1024;
+    char *payload = sentry_malloc(payload_len);
+    TEST_ASSERT(!!payload);
+    memset(payload, 'x', payload_len);
+    sentry_envelope_t *envelope = sentry__envelope_new();
+    sentry__envelope_add_from_buffer(
+        envelope, payload, payload_len, "attachment");
+    TEST_CHECK_INT_EQUAL(
+        sentry_envelope_write_to_path(envelope, test_file_path), 0);
+    sentry_envelope_free(envelope);
+
+    envelope = sentry_envelope_read_from_file(test_file_str);
+    TEST_ASSERT(!!envelope);
+
+    // the file belongs to the caller, who may change it at any time
+    TEST_CHECK_INT_EQUAL(sentry__path_write_buffer(test_file_path, "", 0), 0);
+
+    const sentry_envelope_item_t *item = sentry__envelope_get_item(envelope, 0);
+    TEST_ASSERT(!!item);
+    size_t item_len = 0;
+    const char *item_payload
+        = sentry__envelope_item_get_payload(item, &item_len);
+    TEST_CHECK_INT_EQUAL(item_len, payload_len);
+    TEST_CHECK(item_payload && memcmp(item_payload, payload, payload_len) == 0);
+
+    sentry_envelope_free(envelope);
+    sentry_free(payload);
+    sentry__path_remove(test_file_path);
+    sentry__path_free(test_file_path);
+}
+
 SENTRY_TEST(deserialize_envelope)
 {
     const char *buf
@@ -759,6 +1061,69 @@ SENTRY_TEST(envelope_materialize)
     sentry__path_free(path);
 }
 
+SENTRY_TEST(envelope_materialize_mapped)
+{
+    const char *path_str
+        = SENTRY_TEST_PATH_PREFIX "sentry_test_envelope_materialize_mapped";
+    sentry_path_t *path = sentry__path_from_str(path_str);
+
+    // large enough for the file to be mapped and the payload to be borrowed
+    size_t big_len = 256 * 1024;
+    char *big = sentry_malloc(big_len);
+    TEST_ASSERT(!!big);
+    for (size_t i = 0; i < big_len; i++) {
+        big[i] = (char)(i % 251);
+    }
+
+    sentry_envelope_t *src = sentry__envelope_new_with_dsn(NULL);
+    sentry__envelope_add_from_buffer(src, big, big_len, "log");
+    sentry__envelope_add_from_buffer(src, "{\"a\":1}", 7, "log");
+    size_t expected_len = 0;
+    char *expected = sentry_envelope_serialize(src, &expected_len);
+    TEST_ASSERT(sentry_envelope_write_to_path(src, path) == 0);
+    sentry_envelope_free(src);
+
+    sentry_envelope_t *raw = sentry__envelope_from_path(path);
+    TEST_ASSERT(!!raw);
+    // the contents stay available once the file is gone
+    sentry__path_remove(path);
+
+    size_t raw_len = 0;
+    bool owned = true;
+    char *raw_buf
+        = sentry_envelope_serialize_ratelimited(raw, NULL, &raw_len, &owned);
+    TEST_CHECK(!owned);
+    TEST_CHECK_INT_EQUAL(raw_len, expected_len);
+    TEST_CHECK(memcmp(raw_buf, expected, expected_len) == 0);
+
+    TEST_CHECK(sentry__envelope_materialize(raw));
+    TEST_CHECK_INT_EQUAL(sentry__envelope_get_item_count(raw), 2);
+    size_t payload_len = 0;
+    const char *payload = sentry__envelope_item_get_payload(
+        sentry__envelope_get_item(raw, 0), &payload_len);
+    TEST_CHECK_INT_EQUAL(payload_len, big_len);
+    TEST_CHECK(memcmp(payload, big, big_len) == 0);
+    // small payloads are still copied and NUL-terminated
+    TEST_CHECK_STRING_EQUAL(sentry__envelope_item_get_payload(
+                                sentry__envelope_get_item(raw, 1), NULL),
+        "{\"a\":1}");
+
+    // borrowed payloads outlive the envelope they were loaded into
+    sentry_envelope_t *dst = sentry__envelope_new_with_dsn(NULL);
+    sentry__envelope_add_from_buffer(dst, "{\"b\":2}", 7, "log");
+    TEST_CHECK(sentry__envelope_coalesce(dst, raw, SIZE_MAX));
+    sentry_envelope_free(raw);
+    payload = sentry__envelope_item_get_payload(
+        sentry__envelope_get_item(dst, 1), &payload_len);
+    TEST_CHECK_INT_EQUAL(payload_len, big_len);
+    TEST_CHECK(memcmp(payload, big, big_len) == 0);
+    sentry_envelope_free(dst);
+
+    sentry_free(expected);
+    sentry_free(big);
+    sentry__path_free(path);
+}
+
 SENTRY_TEST(envelope_remove_item)
 {
     sentry_envelope_t *envelope = sentry__envelope_new();
@@ -1186,3 +1551,58 @@ SENTRY_TEST(envelope_can_add_client_report)
     sentry__rate_limiter_free(rl);
     sentry_close();
 }
+
+SENTRY_TEST(envelope_coalesce)
+{
+    sentry_dsn_t *dsn = sentry__dsn_new("https://foo@sentry.invalid/42");
+    sentry_dsn_t *other_dsn = sentry__dsn_new("https://bar@sentry.invalid/42");
+
+    sentry_envelope_t *logs = sentry__envelope_new_with_dsn(dsn);
+    sentry__envelope_add_from_buffer(logs, "{\"a\":1}", 7, "log");
+    sentry_envelope_t *session = sentry__envelope_new_with_dsn(dsn);
+    sentry__envelope_add_from_buffer(session, "{\"b\":2}", 7, "session");
+    sentry_envelope_t *event = sentry__envelope_new_with_dsn(dsn);
+    sentry__envelope_add_event(event, sentry_value_new_event());
+    sentry_envelope_t *other = sentry__envelope_new_with_dsn(other_dsn);
+    sentry__envelope_add_from_buffer(other, "{\"c\":3}", 7, "log");
+    sentry_envelope_t *empty = sentry__envelope_new_with_dsn(dsn);
+
+    TEST_CHECK(sentry__envelope_is_coalescable(logs));
+    TEST_CHECK(sentry__envelope_is_coalescable(session));
+    TEST_CHECK(!sentry__envelope_is_coalescable(event));
+    TEST_CHECK(!sentry__envelope_is_coalescable(empty));
+
+    // events, other DSNs and payloads beyond the size stay on their own
+    TEST_CHECK(!sentry__envelope_coalesce(logs, event, 1024));
+    TEST_CHECK(!sentry__envelope_coalesce(event, logs, 1024));
+    TEST_CHECK(!sentry__envelope_coalesce(logs, other, 1024));
+    TEST_CHECK(!sentry__envelope_coalesce(logs, session, 13));
+    TEST_CHECK(!sentry__envelope_coalesce(logs, logs, 1024));
+    TEST_CHECK_INT_EQUAL(sentry__envelope_get_item_count(logs), 1);
+    TEST_CHECK_INT_EQUAL(sentry__envelope_get_item_count(session), 1);
+
+    TEST_CHECK(sentry__envelope_coalesce(logs, session, 14));
+    TEST_CHECK_INT_EQUAL(sentry__envelope_get_item_count(logs), 2);
+    TEST_CHECK_INT_EQUAL(sentry__envelope_get_item_count(session), 0);
+
+    char *serialized = sentry_envelope_serialize(logs, NULL);
+    TEST_CHECK_STRING_EQUAL(serialized,
+        "{\"dsn\":\"https://foo@sentry.invalid/42\"}\n"
+        "{\"type\":\"log\",\"length\":7}\n"
+        "{\"a\":1}\n"
+        "{\"type\":\"session\",\"length\":7}\n"
+        "{\"b\":2}");
+    sentry_free(serialized);
+
+    // the items of the emptied envelope can be added to again
+    sentry__envelope_add_from_buffer(session, "{\"d\":4}", 7, "session");
+    TEST_CHECK_INT_EQUAL(sentry__envelope_get_item_count(session), 1);
+
+    sentry_envelope_free(logs);
+    sentry_envelope_free(session);
+    sentry_envelope_free(event);
+    sentry_envelope_free(other);
+    sentry_envelope_free(empty);
+    sentry__dsn_decref(dsn);
+    sentry__dsn_decref(other_dsn);
+}
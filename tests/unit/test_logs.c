@@ -1,8 +1,11 @@
+#include "sentry_batcher.h"
 #include "sentry_logs.h"
 #include "sentry_sync.h"
 #include "sentry_testsupport.h"
 
 #include "sentry_envelope.h"
+#include "sentry_json.h"
+#include <stdio.h>
 #include <string.h>
 
 typedef struct {
@@ -560,3 +563,356 @@ SENTRY_TEST(logs_reinit_stress)
         sentry__thread_join(threads[t]);
     }
 }
+
+typedef struct {
+    volatile long envelope_count;
+    volatile long item_count;
+    volatile long max_batch_len;
+} batch_count_data_t;
+
+static void
+count_batch_envelope(sentry_envelope_t *envelope, void *data)
+{
+    batch_count_data_t *counts = data;
+    const sentry_envelope_item_t *item = sentry__envelope_get_item(envelope, 0);
+    const long len = (long)sentry_value_as_int32(
+        sentry__envelope_item_get_header(item, "item_count"));
+    sentry__atomic_fetch_and_add(&counts->envelope_count, 1);
+    sentry__atomic_fetch_and_add(&counts->item_count, len);
+    if (len > sentry__atomic_fetch(&counts->max_batch_len)) {
+        sentry__atomic_store(&counts->max_batch_len, len);
+    }
+    sentry_envelope_free(envelope);
+}
+
+static void
+init_with_batch_counter(sentry_options_t *options, batch_count_data_t *counts)
+{
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_transport_t *transport = sentry_transport_new(count_batch_envelope);
+    sentry_transport_set_state(transport, counts);
+    sentry_options_set_transport(options, transport);
+    sentry_init(options);
+}
+
+static sentry_batcher_t *
+start_batcher(size_t capacity)
+{
+    sentry_batcher_t *batcher = sentry__batcher_new(
+        sentry__envelope_add_logs, SENTRY_DATA_CATEGORY_LOG_ITEM, capacity);
+    SENTRY_WITH_OPTIONS (opts) {
+        sentry__batcher_startup(batcher, opts);
+    }
+    sentry__batcher_wait_for_thread_startup(batcher);
+    return batcher;
+}
+
+static void
+enqueue_logs(sentry_batcher_t *batcher, int count)
+{
+    for (int i = 0; i < count; i++) {
+        sentry_value_t log = sentry_value_new_object();
+        sentry_value_set_by_key(log, "body", sentry_value_new_string("log"));
+        TEST_CHECK(sentry__batcher_enqueue(batcher, log));
+    }
+}
+
+static void
+wait_for_envelopes(
+    sentry_batcher_t *batcher, batch_count_data_t *counts, long count)
+{
+    for (int i = 0;
+        i < 250 && sentry__atomic_fetch(&counts->envelope_count) < count;
+        i++) {
+        sleep_ms(20);
+    }
+    // let the flush finish, so the next items start a new batch
+    while (sentry__atomic_fetch(&batcher->flushing)) {
+        sleep_ms(1);
+    }
+}
+
+SENTRY_THREAD_FN
+batcher_producer_thread(void *data)
+{
+    sentry_batcher_t *batcher = data;
+    for (int i = 0; i < SENTRY_BATCHER_QUEUE_LENGTH; i++) {
+        if (!sentry__batcher_enqueue(batcher, sentry_value_new_null())) {
+            TEST_CHECK(false);
+        }
+    }
+    return 0;
+}
+
+SENTRY_TEST(logs_batcher_sharded_enqueue)
+{
+    batch_count_data_t counts = { 0, 0, 0 };
+    SENTRY_TEST_OPTIONS_NEW(options);
+    init_with_batch_counter(options, &counts);
+
+    sentry_batcher_t *batcher = sentry__batcher_new(sentry__envelope_add_logs,
+        SENTRY_DATA_CATEGORY_LOG_ITEM, SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_ASSERT(!!batcher);
+
+    // Without a running batching thread, every producer fills one shard's
+    // worth of items, which only fits if colliding producers spill over into
+    // the remaining shards.
+    sentry_threadid_t threads[SENTRY_BATCHER_SHARD_COUNT];
+    for (int t = 0; t < SENTRY_BATCHER_SHARD_COUNT; t++) {
+        sentry__thread_init(&threads[t]);
+        sentry__thread_spawn(&threads[t], batcher_producer_thread, batcher);
+    }
+    for (int t = 0; t < SENTRY_BATCHER_SHARD_COUNT; t++) {
+        sentry__thread_join(threads[t]);
+        sentry__thread_free(&threads[t]);
+    }
+    TEST_CHECK(!sentry__batcher_enqueue(batcher, sentry_value_new_null()));
+
+    // The flusher drains all shards in one pass, but never sends more than
+    // SENTRY_BATCHER_QUEUE_LENGTH items per envelope.
+    SENTRY_WITH_OPTIONS (opts) {
+        sentry__batcher_startup(batcher, opts);
+    }
+    sentry__batcher_shutdown(batcher, 0);
+    TEST_CHECK_INT_EQUAL(counts.item_count,
+        SENTRY_BATCHER_QUEUE_LENGTH * SENTRY_BATCHER_SHARD_COUNT);
+    TEST_CHECK_INT_EQUAL(counts.max_batch_len, SENTRY_BATCHER_QUEUE_LENGTH);
+
+    sentry__batcher_release(batcher);
+    sentry_close();
+}
+
+SENTRY_TEST(logs_batcher_capacity)
+{
+    batch_count_data_t counts = { 0, 0, 0 };
+    SENTRY_TEST_OPTIONS_NEW(options);
+    init_with_batch_counter(options, &counts);
+
+    // a larger capacity results in larger batches
+    sentry_batcher_t *batcher = start_batcher(3 * SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_CHECK_INT_EQUAL(sentry__batcher_get_batch_size(batcher),
+        3 * SENTRY_BATCHER_QUEUE_LENGTH);
+    enqueue_logs(batcher, 3 * SENTRY_BATCHER_QUEUE_LENGTH);
+    wait_for_envelopes(batcher, &counts, 1);
+    TEST_CHECK_INT_EQUAL(counts.envelope_count, 1);
+    TEST_CHECK_INT_EQUAL(counts.max_batch_len, 3 * SENTRY_BATCHER_QUEUE_LENGTH);
+
+    sentry__batcher_shutdown(batcher, 0);
+    sentry__batcher_release(batcher);
+    sentry_close();
+}
+
+SENTRY_TEST(logs_batcher_max_bytes)
+{
+    batch_count_data_t counts = { 0, 0, 0 };
+    SENTRY_TEST_OPTIONS_NEW(options);
+    // too small for even a single log, so every log ends up in its own batch
+    sentry_options_set_batch_max_bytes(options, 1);
+    init_with_batch_counter(options, &counts);
+
+    sentry_batcher_t *batcher = start_batcher(SENTRY_BATCHER_QUEUE_LENGTH);
+    enqueue_logs(batcher, SENTRY_BATCHER_QUEUE_LENGTH);
+    sentry__batcher_shutdown(batcher, 0);
+
+    TEST_CHECK_INT_EQUAL(counts.envelope_count, SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_CHECK_INT_EQUAL(counts.item_count, SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_CHECK_INT_EQUAL(counts.max_batch_len, 1);
+
+    sentry__batcher_release(batcher);
+    sentry_close();
+}
+
+SENTRY_TEST(logs_batcher_adaptive)
+{
+    batch_count_data_t counts = { 0, 0, 0 };
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_batch_adaptive(options, 1);
+    init_with_batch_counter(options, &counts);
+
+    sentry_batcher_t *batcher = start_batcher(4 * SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_CHECK_INT_EQUAL(
+        sentry__batcher_get_batch_size(batcher), SENTRY_BATCHER_QUEUE_LENGTH);
+
+    // every filled batch doubles the batch size...
+    enqueue_logs(batcher, SENTRY_BATCHER_QUEUE_LENGTH);
+    wait_for_envelopes(batcher, &counts, 1);
+    TEST_CHECK_INT_EQUAL(sentry__batcher_get_batch_size(batcher),
+        2 * SENTRY_BATCHER_QUEUE_LENGTH);
+
+    enqueue_logs(batcher, 2 * SENTRY_BATCHER_QUEUE_LENGTH);
+    wait_for_envelopes(batcher, &counts, 2);
+    TEST_CHECK_INT_EQUAL(counts.max_batch_len, 2 * SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_CHECK_INT_EQUAL(sentry__batcher_get_batch_size(batcher),
+        4 * SENTRY_BATCHER_QUEUE_LENGTH);
+
+    // ...up to the capacity
+    enqueue_logs(batcher, 4 * SENTRY_BATCHER_QUEUE_LENGTH);
+    wait_for_envelopes(batcher, &counts, 3);
+    TEST_CHECK_INT_EQUAL(counts.max_batch_len, 4 * SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_CHECK_INT_EQUAL(sentry__batcher_get_batch_size(batcher),
+        4 * SENTRY_BATCHER_QUEUE_LENGTH);
+
+    sentry__batcher_shutdown(batcher, 0);
+    TEST_CHECK_INT_EQUAL(counts.item_count, 7 * SENTRY_BATCHER_QUEUE_LENGTH);
+
+    sentry__batcher_release(batcher);
+    sentry_close();
+}
+
+static void
+collect_logs_envelope(sentry_envelope_t *envelope, void *data)
+{
+    sentry_value_t logs = *(sentry_value_t *)data;
+    for (size_t i = 0; i < sentry__envelope_get_item_count(envelope); i++) {
+        const sentry_envelope_item_t *item
+            = sentry__envelope_get_item(envelope, i);
+        const char *type = sentry_value_as_string(
+            sentry__envelope_item_get_header(item, "type"));
+        if (strcmp(type, "log") != 0) {
+            continue;
+        }
+        size_t len = 0;
+        const char *payload = sentry__envelope_item_get_payload(item, &len);
+        sentry_value_t batch = sentry__value_from_json(payload, len);
+        sentry_value_t items = sentry_value_get_by_key(batch, "items");
+        for (size_t j = 0; j < sentry_value_get_length(items); j++) {
+            sentry_value_t log = sentry_value_get_by_index(items, j);
+            sentry_value_incref(log);
+            sentry_value_append(logs, log);
+        }
+        sentry_value_decref(batch);
+    }
+    sentry_envelope_free(envelope);
+}
+
+#define DEFERRABLE_FORMAT "[%-6s|%.3s] %c %5.1f%% 0x%08x %hhd %zu %lld %+d"
+
+static const char *
+log_param_value(sentry_value_t log, int index)
+{
+    char key[64];
+    snprintf(key, sizeof(key), "sentry.message.parameter.%d", index);
+    sentry_value_t param = sentry_value_get_by_key(
+        sentry_value_get_by_key(log, "attributes"), key);
+    return sentry_value_as_string(sentry_value_get_by_key(param, "value"));
+}
+
+/**
+ * Logs the calls of `logs_deferred_formatting` with deferred formatting on or
+ * off, and returns the logs that were sent.
+ */
+static sentry_value_t
+log_deferrable_calls(bool deferred)
+{
+    sentry_value_t logs = sentry_value_new_list();
+
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    // debug output needs the formatted log right away, which is the default
+    // of debug builds
+    sentry_options_set_debug(options, 0);
+    sentry_options_set_logs_deferred(options, deferred);
+    sentry_options_set_logs_with_attributes(options, true);
+    TEST_CHECK(sentry_options_get_logs_deferred(options) == deferred);
+
+    sentry_transport_t *transport
+        = sentry_transport_new(collect_logs_envelope);
+    sentry_transport_set_state(transport, &logs);
+    sentry_options_set_transport(options, transport);
+
+    sentry_init(options);
+    sentry__logs_wait_for_thread_startup();
+    size_t deferred_before = sentry__logs_deferred_count();
+
+    // string arguments are copied when logging, not when flushing
+    char name[16];
+    snprintf(name, sizeof(name), "%s", "Alice");
+    sentry_value_t attributes = sentry_value_new_object();
+    sentry_value_set_by_key(attributes, "my.custom.attribute",
+        sentry_value_new_attribute(sentry_value_new_string("custom"), NULL));
+    TEST_CHECK_INT_EQUAL(
+        sentry_log_info("User %s logged in", attributes, name), 0);
+    snprintf(name, sizeof(name), "%s", "Bob");
+
+    TEST_CHECK_INT_EQUAL(
+        sentry_log_warn(DEFERRABLE_FORMAT, sentry_value_new_null(), "ab",
+            "truncated", 'Z', 42.25, 0xbeefu, (signed char)-3, (size_t)7,
+            -9000000000LL, 12),
+        0);
+
+    // `*` width falls back to formatting on the calling thread
+    TEST_CHECK_INT_EQUAL(
+        sentry_log_error("%*d items", sentry_value_new_null(), 4, 7), 0);
+
+    TEST_CHECK_INT_EQUAL(sentry__logs_deferred_count() - deferred_before,
+        deferred ? 2 : 0);
+
+    sentry_close();
+
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(logs), 3);
+    return logs;
+}
+
+SENTRY_TEST(logs_deferred_formatting)
+{
+    sentry_value_t logs = log_deferrable_calls(true);
+
+    sentry_value_t log = sentry_value_get_by_index(logs, 0);
+    sentry_value_t log_attributes = sentry_value_get_by_key(log, "attributes");
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(log, "body")),
+        "User Alice logged in");
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(log, "level")), "info");
+    TEST_CHECK_STRING_EQUAL(log_param_value(log, 0), "Alice");
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(
+            sentry_value_get_by_key(log_attributes, "sentry.message.template"),
+            "value")),
+        "User %s logged in");
+    TEST_CHECK(!sentry_value_is_null(
+        sentry_value_get_by_key(log_attributes, "my.custom.attribute")));
+    TEST_CHECK(!sentry_value_is_null(
+        sentry_value_get_by_key(log_attributes, "sentry.sdk.name")));
+
+    // the body matches what printf produces
+    char expected[256];
+    snprintf(expected, sizeof(expected), DEFERRABLE_FORMAT, "ab", "truncated",
+        'Z', 42.25, 0xbeefu, (signed char)-3, (size_t)7, -9000000000LL, 12);
+    log = sentry_value_get_by_index(logs, 1);
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(log, "body")), expected);
+    TEST_CHECK_STRING_EQUAL(log_param_value(log, 0), "ab");
+    TEST_CHECK_STRING_EQUAL(log_param_value(log, 1), "truncated");
+    TEST_CHECK_STRING_EQUAL(log_param_value(log, 2), "Z");
+    TEST_CHECK_STRING_EQUAL(log_param_value(log, 4), "beef");
+
+    log = sentry_value_get_by_index(logs, 2);
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(log, "body")),
+        "   7 items");
+
+    // formatting eagerly produces the same body and parameters
+    sentry_value_t eager_logs = log_deferrable_calls(false);
+    for (size_t i = 0; i < 3; i++) {
+        sentry_value_t deferred_log = sentry_value_get_by_index(logs, i);
+        sentry_value_t eager_log = sentry_value_get_by_index(eager_logs, i);
+        TEST_CHECK_STRING_EQUAL(sentry_value_as_string(sentry_value_get_by_key(
+                                    deferred_log, "body")),
+            sentry_value_as_string(sentry_value_get_by_key(eager_log, "body")));
+        for (int j = 0; j < 9; j++) {
+            char key[64];
+            snprintf(key, sizeof(key), "sentry.message.parameter.%d", j);
+            char *deferred_param = sentry_value_to_json(sentry_value_get_by_key(
+                sentry_value_get_by_key(deferred_log, "attributes"), key));
+            char *eager_param = sentry_value_to_json(sentry_value_get_by_key(
+                sentry_value_get_by_key(eager_log, "attributes"), key));
+            TEST_CHECK_STRING_EQUAL(deferred_param, eager_param);
+            sentry_free(deferred_param);
+            sentry_free(eager_param);
+        }
+    }
+
+    sentry_value_decref(eager_logs);
+    sentry_value_decref(logs);
+}
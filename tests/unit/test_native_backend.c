@@ -5,14 +5,31 @@
  * and low-level crash handling functionality.
  */
 
+#include "sentry_alloc.h"
 #include "sentry_options.h"
+#include "sentry_sync.h"
 #include "sentry_testsupport.h"
 #include <string.h>
 
 #ifdef SENTRY_BACKEND_NATIVE
 // Include native backend headers
+#    include "../../src/backends/native/minidump/sentry_minidump_common.h"
 #    include "../../src/backends/native/minidump/sentry_minidump_format.h"
+#    include "../../src/backends/native/minidump/sentry_minidump_writer.h"
 #    include "../../src/backends/native/sentry_crash_context.h"
+#    include "../../src/backends/native/sentry_crash_ipc.h"
+#    include "../../src/backends/native/sentry_crash_journal.h"
+#    include "../../src/backends/native/sentry_crash_module_cache.h"
+#    include "sentry_value.h"
+#    if defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID)
+#        include "sentry_path.h"
+#        include <fcntl.h>
+#        include <signal.h>
+#        include <sys/mman.h>
+#        include <sys/stat.h>
+#        include <sys/wait.h>
+#        include <unistd.h>
+#    endif
 #endif
 
 /**
@@ -510,3 +527,545 @@ SENTRY_TEST(minidump_structures_packed)
     SKIP_TEST();
 #endif
 }
+
+/**
+ * Test the scope and breadcrumb journal in the shared crash context
+ */
+SENTRY_TEST(crash_journal)
+{
+#ifdef SENTRY_BACKEND_NATIVE
+    sentry_crash_journal_t *journal = sentry_malloc(sizeof(*journal));
+    TEST_ASSERT(!!journal);
+    sentry__crash_journal_init(journal, 3);
+    TEST_CHECK(sentry_value_is_null(sentry__crash_journal_read_event(journal)));
+
+    // the latest scope snapshot wins
+    const char *scope1 = "{\"level\":\"info\"}";
+    const char *scope2 = "{\"level\":\"fatal\",\"tags\":{\"a\":\"b\"}}";
+    TEST_CHECK(
+        sentry__crash_journal_write_scope(journal, scope1, strlen(scope1)));
+    TEST_CHECK(
+        sentry__crash_journal_write_scope(journal, scope2, strlen(scope2)));
+    sentry_value_t event = sentry__crash_journal_read_event(journal);
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(event, "level")),
+        "fatal");
+    TEST_CHECK(sentry_value_is_null(
+        sentry_value_get_by_key(event, "breadcrumbs")));
+    sentry_value_decref(event);
+
+    // only the most recent breadcrumbs are kept, in order
+    char buf[64];
+    for (int i = 0; i < 5; i++) {
+        int len = snprintf(buf, sizeof(buf), "{\"message\":\"%d\"}", i);
+        TEST_CHECK(
+            sentry__crash_journal_add_breadcrumb(journal, buf, (size_t)len));
+    }
+    event = sentry__crash_journal_read_event(journal);
+    sentry_value_t breadcrumbs = sentry_value_get_by_key(event, "breadcrumbs");
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(breadcrumbs), 3);
+    for (size_t i = 0; i < 3; i++) {
+        snprintf(buf, sizeof(buf), "%d", (int)i + 2);
+        TEST_CHECK_STRING_EQUAL(
+            sentry_value_as_string(sentry_value_get_by_key(
+                sentry_value_get_by_index(breadcrumbs, i), "message")),
+            buf);
+    }
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(event, "level")),
+        "fatal");
+    sentry_value_decref(event);
+
+    // large breadcrumbs wrap around the ring and evict the ones they overwrite
+    size_t big_len = SENTRY_CRASH_JOURNAL_MAX_BREADCRUMB_SIZE;
+    char *big = sentry_malloc(big_len + 1);
+    TEST_ASSERT(!!big);
+    sentry__crash_journal_init(journal, 100);
+    for (int i = 0; i < 20; i++) {
+        memset(big, ' ', big_len);
+        int len = snprintf(big, big_len, "{\"message\":\"%d\"", i);
+        big[len] = ' ';
+        big[big_len - 1] = '}';
+        TEST_CHECK(sentry__crash_journal_add_breadcrumb(journal, big, big_len));
+    }
+    event = sentry__crash_journal_read_event(journal);
+    breadcrumbs = sentry_value_get_by_key(event, "breadcrumbs");
+    size_t kept = sentry_value_get_length(breadcrumbs);
+    TEST_CHECK(kept > 0);
+    TEST_CHECK(kept
+        <= SENTRY_CRASH_JOURNAL_BREADCRUMBS_SIZE
+            / SENTRY_CRASH_JOURNAL_MAX_BREADCRUMB_SIZE);
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(
+            sentry_value_get_by_index(breadcrumbs, kept - 1), "message")),
+        "19");
+    TEST_CHECK(sentry_value_is_null(sentry_value_get_by_key(event, "level")));
+    sentry_value_decref(event);
+
+    // data that does not fit into the journal is rejected
+    TEST_CHECK(
+        !sentry__crash_journal_add_breadcrumb(journal, big, big_len + 1));
+    sentry_free(big);
+    big = sentry_malloc(SENTRY_CRASH_JOURNAL_SCOPE_SIZE + 1);
+    TEST_ASSERT(!!big);
+    TEST_CHECK(!sentry__crash_journal_write_scope(
+        journal, big, SENTRY_CRASH_JOURNAL_SCOPE_SIZE + 1));
+    sentry_free(big);
+
+    sentry_free(journal);
+#else
+    SKIP_TEST();
+#endif
+}
+
+/**
+ * Test that module identities are parsed once and survive a save and load,
+ * and that the cache is only warmed again once the mapped code changes.
+ */
+SENTRY_TEST(crash_module_cache)
+{
+#if defined(SENTRY_BACKEND_NATIVE)                                             \
+    && (defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID))
+    const char *cache_path = SENTRY_TEST_PATH_PREFIX ".module-cache";
+    sentry__crash_module_cache_clear();
+
+    // every mapped file is parsed once
+    TEST_CHECK(sentry__crash_module_cache_warm(getpid()) > 0);
+    TEST_CHECK_INT_EQUAL(sentry__crash_module_cache_warm(getpid()), 0);
+
+    // mapping data leaves the code unchanged, so nothing is warmed again
+    const char *mapped_path = SENTRY_TEST_PATH_PREFIX ".mapped-file";
+    int fd = open(mapped_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    TEST_ASSERT(fd >= 0);
+    TEST_CHECK(write(fd, "mapped", 6) == 6);
+    void *mapping = mmap(NULL, 6, PROT_READ, MAP_PRIVATE, fd, 0);
+    TEST_ASSERT(mapping != MAP_FAILED);
+    TEST_CHECK_INT_EQUAL(sentry__crash_module_cache_warm(getpid()), 0);
+    munmap(mapping, 6);
+
+    // mapping code does, and the new file is parsed
+    mapping = mmap(NULL, 6, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+    close(fd);
+    TEST_ASSERT(mapping != MAP_FAILED);
+    TEST_CHECK_INT_EQUAL(sentry__crash_module_cache_warm(getpid()), 1);
+    TEST_CHECK_INT_EQUAL(sentry__crash_module_cache_warm(getpid()), 0);
+    munmap(mapping, 6);
+    unlink(mapped_path);
+
+    sentry_crash_module_identity_t identity;
+    TEST_CHECK(sentry__crash_module_cache_get("/proc/self/exe", &identity));
+    TEST_CHECK(identity.elf_size > 0);
+    TEST_CHECK(!sentry__crash_module_cache_get("/proc/self/maps", &identity));
+    TEST_CHECK(!sentry__crash_module_cache_get(
+        SENTRY_TEST_PATH_PREFIX ".does-not-exist", &identity));
+
+    // a persisted cache resolves the same modules without parsing them
+    TEST_CHECK(sentry__crash_module_cache_save(cache_path));
+    sentry__crash_module_cache_clear();
+    TEST_CHECK(sentry__crash_module_cache_load(cache_path));
+    TEST_CHECK_INT_EQUAL(sentry__crash_module_cache_warm(getpid()), 0);
+    sentry_crash_module_identity_t loaded;
+    TEST_CHECK(sentry__crash_module_cache_get("/proc/self/exe", &loaded));
+    TEST_CHECK(memcmp(&identity, &loaded, sizeof(identity)) == 0);
+
+    sentry__crash_module_cache_clear();
+    unlink(cache_path);
+#else
+    SKIP_TEST();
+#endif
+}
+
+/**
+ * Test the layout of the variable-sized crash context: the tables fit the
+ * size, strings are interned, and growing keeps the captured data.
+ */
+SENTRY_TEST(crash_context_layout)
+{
+#ifdef SENTRY_BACKEND_NATIVE
+    size_t size = sentry__crash_context_size(4, 2, 64);
+    TEST_CHECK(size >= sizeof(sentry_crash_context_t));
+    sentry_crash_context_t *ctx = sentry_malloc(size);
+    TEST_ASSERT(!!ctx);
+    sentry__crash_context_init(ctx, 4, 2, 64);
+    TEST_CHECK(sentry__crash_context_validate(ctx, size));
+    TEST_CHECK(!sentry__crash_context_validate(ctx, size - 1));
+    TEST_CHECK_INT_EQUAL(ctx->thread_table.capacity, 4);
+    TEST_CHECK_INT_EQUAL(ctx->module_table.capacity, 2);
+
+    // offset 0 is the empty string, and strings that don't fit are dropped
+    TEST_CHECK_STRING_EQUAL(sentry__crash_context_string(ctx, 0), "");
+    TEST_CHECK_STRING_EQUAL(sentry__crash_context_string(ctx, 1000), "");
+    uint32_t libc = sentry__crash_context_add_string(ctx, "libc.so.6", 9);
+    TEST_CHECK(libc != 0);
+    TEST_CHECK_STRING_EQUAL(
+        sentry__crash_context_string(ctx, libc), "libc.so.6");
+    char long_name[80];
+    memset(long_name, 'x', sizeof(long_name));
+    TEST_CHECK_INT_EQUAL(
+        sentry__crash_context_add_string(ctx, long_name, sizeof(long_name)), 0);
+
+    sentry__crash_context_modules(ctx)[1].base_address = 0x1000;
+    sentry__crash_context_modules(ctx)[1].name_offset = libc;
+    ctx->module_count = 2;
+    ctx->platform.num_threads = 4;
+
+    sentry_crash_context_t *grown
+        = sentry__crash_context_grow(ctx, 16, 8, 256);
+    TEST_ASSERT(!!grown);
+    TEST_CHECK(sentry__crash_context_validate(grown, grown->size));
+    TEST_CHECK_INT_EQUAL(grown->thread_table.capacity, 16);
+    TEST_CHECK_INT_EQUAL(grown->module_table.capacity, 8);
+    TEST_CHECK_INT_EQUAL(grown->module_count, 2);
+    TEST_CHECK_INT_EQUAL(grown->platform.num_threads, 4);
+    TEST_CHECK(sentry__crash_context_modules(grown)[1].base_address == 0x1000);
+    uint32_t name_offset = sentry__crash_context_modules(grown)[1].name_offset;
+    TEST_CHECK_STRING_EQUAL(
+        sentry__crash_context_string(grown, name_offset), "libc.so.6");
+    TEST_CHECK(
+        sentry__crash_context_add_string(grown, long_name, sizeof(long_name))
+        != 0);
+
+    sentry_free(grown);
+    sentry_free(ctx);
+#else
+    SKIP_TEST();
+#endif
+}
+
+#if defined(SENTRY_BACKEND_NATIVE)                                             \
+    && (defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID))
+static int g_shared_listen_fd = -1;
+static sentry_crash_ipc_t *g_shared_accepted = NULL;
+
+SENTRY_THREAD_FN
+accept_shared_app(void *data)
+{
+    (void)data;
+    g_shared_accepted = sentry__crash_ipc_accept(g_shared_listen_fd);
+    return 0;
+}
+#endif
+
+/**
+ * Test that an app registers with a shared daemon, which attaches to its
+ * crash context and receives its crash notifications.
+ */
+SENTRY_TEST(crash_ipc_shared_registration)
+{
+#if defined(SENTRY_BACKEND_NATIVE)                                             \
+    && (defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID))
+    char name[SENTRY_CRASH_IPC_NAME_SIZE];
+    char other_name[SENTRY_CRASH_IPC_NAME_SIZE];
+    sentry_crash_context_t *config = SENTRY_MAKE(sentry_crash_context_t);
+    TEST_ASSERT(!!config);
+    snprintf(config->database_path, sizeof(config->database_path),
+        "/tmp/sentry-test-%d", (int)getpid());
+    strcpy(config->dsn, "dsn-a");
+    sentry__crash_ipc_shared_name(name, sizeof(name), config);
+    strcpy(config->dsn, "dsn-b");
+    sentry__crash_ipc_shared_name(other_name, sizeof(other_name), config);
+    TEST_CHECK(strcmp(name, other_name) != 0);
+    strcpy(config->dsn, "dsn-a");
+    sentry__crash_ipc_shared_name(other_name, sizeof(other_name), config);
+    TEST_CHECK_STRING_EQUAL(name, other_name);
+
+    // apps that the daemon would treat differently do not share it
+    config->require_user_consent = true;
+    sentry__crash_ipc_shared_name(other_name, sizeof(other_name), config);
+    TEST_CHECK(strcmp(name, other_name) != 0);
+    config->require_user_consent = false;
+    strcpy(config->external_reporter_path, "/usr/bin/reporter");
+    sentry__crash_ipc_shared_name(other_name, sizeof(other_name), config);
+    TEST_CHECK(strcmp(name, other_name) != 0);
+    config->external_reporter_path[0] = '\0';
+    config->shutdown_timeout = 1000;
+    sentry__crash_ipc_shared_name(other_name, sizeof(other_name), config);
+    TEST_CHECK(strcmp(name, other_name) != 0);
+    sentry_free(config);
+
+    // no daemon listens yet
+    sentry_crash_ipc_t *app = sentry__crash_ipc_init_app(NULL);
+    TEST_ASSERT(!!app);
+    uint64_t tid = (uint64_t)pthread_self();
+    TEST_CHECK_INT_EQUAL(sentry__crash_ipc_register(app, name, tid), -1);
+    TEST_CHECK_INT_EQUAL(app->daemon_fd, -1);
+
+    // only one daemon gets to listen
+    g_shared_listen_fd = sentry__crash_ipc_listen(name);
+    TEST_ASSERT(g_shared_listen_fd >= 0);
+    TEST_CHECK_INT_EQUAL(sentry__crash_ipc_listen(name), -1);
+
+    sentry_threadid_t thread;
+    sentry__thread_init(&thread);
+    TEST_ASSERT(sentry__thread_spawn(&thread, &accept_shared_app, NULL) == 0);
+    pid_t daemon_pid = sentry__crash_ipc_register(app, name, tid);
+    sentry__thread_join(thread);
+    TEST_CHECK_INT_EQUAL(daemon_pid, getpid());
+    TEST_CHECK(app->daemon_fd >= 0);
+
+    sentry_crash_ipc_t *daemon = g_shared_accepted;
+    TEST_ASSERT(!!daemon);
+    TEST_CHECK(daemon->is_daemon);
+    TEST_CHECK_INT_EQUAL(daemon->parent_handle, getpid());
+    TEST_CHECK(sentry__crash_context_validate(daemon->shmem, daemon->shm_size));
+
+    // the daemon shares the crash context and notifications of the app
+    app->shmem->crashed_pid = 1234;
+    TEST_CHECK_INT_EQUAL(daemon->shmem->crashed_pid, 1234);
+    TEST_CHECK(!sentry__crash_ipc_wait(daemon, 0));
+    sentry__crash_ipc_notify(app);
+    TEST_CHECK(sentry__crash_ipc_wait(daemon, 1000));
+
+    sentry__crash_ipc_free(daemon);
+    sentry__crash_ipc_free(app);
+    close(g_shared_listen_fd);
+    g_shared_listen_fd = -1;
+    g_shared_accepted = NULL;
+#else
+    SKIP_TEST();
+#endif
+}
+
+#if defined(SENTRY_BACKEND_NATIVE)                                             \
+    && (defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID))
+static const minidump_memory_descriptor_t *
+find_memory_range(const char *dump, size_t dump_size, uint64_t addr)
+{
+    const minidump_header_t *header = (const minidump_header_t *)dump;
+    const minidump_directory_t *dirs
+        = (const minidump_directory_t *)(dump + header->stream_directory_rva);
+    for (uint32_t i = 0; i < header->stream_count; i++) {
+        if (dirs[i].stream_type != MINIDUMP_STREAM_MEMORY_LIST
+            || dirs[i].rva + dirs[i].data_size > dump_size) {
+            continue;
+        }
+        const minidump_memory_list_t *list
+            = (const minidump_memory_list_t *)(dump + dirs[i].rva);
+        for (uint32_t j = 0; j < list->count; j++) {
+            if (list->ranges[j].start_address == addr) {
+                return &list->ranges[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+static bool
+memory_range_is(const char *dump, size_t dump_size,
+    const minidump_memory_descriptor_t *range, size_t offset, size_t len,
+    uint8_t value)
+{
+    if (!range || range->memory.rva + offset + len > dump_size) {
+        return false;
+    }
+    const uint8_t *bytes
+        = (const uint8_t *)dump + range->memory.rva + offset;
+    for (size_t i = 0; i < len; i++) {
+        if (bytes[i] != value) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+/**
+ * Test that a dump of a running process captures its memory: adjacent
+ * mappings are merged into one range, a range that can only be read in part
+ * keeps what was read, and the ranges after it are still captured.
+ */
+SENTRY_TEST(minidump_memory_capture)
+{
+#if defined(SENTRY_BACKEND_NATIVE)                                             \
+    && (defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID))
+    const char *mapped_path = SENTRY_TEST_PATH_PREFIX ".capture-file";
+    const char *dump_path = SENTRY_TEST_PATH_PREFIX ".capture.dmp";
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    // guard | rw | r | guard | file with 2 pages past its end | rw | guard
+    char *reserve = mmap(
+        NULL, 9 * page, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    TEST_ASSERT(reserve != MAP_FAILED);
+    char *merged = mmap(reserve + page, 2 * page, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    TEST_ASSERT(merged == reserve + page);
+    memset(merged, 0x11, page);
+    memset(merged + page, 0x22, page);
+    TEST_ASSERT(mprotect(merged + page, page, PROT_READ) == 0);
+
+    int fd = open(mapped_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    TEST_ASSERT(fd >= 0);
+    char *contents = sentry_malloc(page);
+    TEST_ASSERT(!!contents);
+    memset(contents, 0x33, page);
+    TEST_CHECK(write(fd, contents, page) == (ssize_t)page);
+    sentry_free(contents);
+    char *partial = mmap(reserve + 4 * page, 3 * page, PROT_READ,
+        MAP_PRIVATE | MAP_FIXED, fd, 0);
+    close(fd);
+    TEST_ASSERT(partial == reserve + 4 * page);
+
+    char *after = mmap(reserve + 7 * page, page, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    TEST_ASSERT(after == reserve + 7 * page);
+    memset(after, 0x44, page);
+
+    pid_t child = fork();
+    TEST_ASSERT(child >= 0);
+    if (child == 0) {
+        for (;;) {
+            pause();
+        }
+    }
+
+    size_t ctx_size = sentry__crash_context_size(1, 1, 64);
+    sentry_crash_context_t *ctx = sentry_malloc(ctx_size);
+    TEST_ASSERT(!!ctx);
+    sentry__crash_context_init(ctx, 1, 1, 64);
+    ctx->crashed_pid = child;
+    ctx->crashed_tid = child;
+    ctx->minidump_mode = SENTRY_MINIDUMP_MODE_FULL;
+    int rv = sentry__write_minidump(ctx, dump_path);
+    sentry_free(ctx);
+    kill(child, SIGKILL);
+    waitpid(child, NULL, 0);
+    munmap(reserve, 9 * page);
+    unlink(mapped_path);
+    TEST_ASSERT(rv == 0);
+
+    sentry_path_t *path = sentry__path_from_str(dump_path);
+    size_t dump_size = 0;
+    char *dump = sentry__path_read_to_buffer(path, &dump_size);
+    sentry__path_remove(path);
+    sentry__path_free(path);
+    TEST_ASSERT(!!dump);
+    TEST_ASSERT(dump_size >= sizeof(minidump_header_t));
+    TEST_CHECK(((minidump_header_t *)dump)->signature == MINIDUMP_SIGNATURE);
+
+    // the rw and r mappings are one range
+    const minidump_memory_descriptor_t *range
+        = find_memory_range(dump, dump_size, (uint64_t)(uintptr_t)merged);
+    TEST_ASSERT(!!range);
+    TEST_CHECK_INT_EQUAL(range->memory.size, 2 * page);
+    TEST_CHECK(memory_range_is(dump, dump_size, range, 0, page, 0x11));
+    TEST_CHECK(memory_range_is(dump, dump_size, range, page, page, 0x22));
+    TEST_CHECK(!find_memory_range(
+        dump, dump_size, (uint64_t)(uintptr_t)(merged + page)));
+
+    // only the page backed by the file can be read
+    range = find_memory_range(dump, dump_size, (uint64_t)(uintptr_t)partial);
+    TEST_ASSERT(!!range);
+    TEST_CHECK_INT_EQUAL(range->memory.size, page);
+    TEST_CHECK(memory_range_is(dump, dump_size, range, 0, page, 0x33));
+
+    // and the batch goes on after it
+    range = find_memory_range(dump, dump_size, (uint64_t)(uintptr_t)after);
+    TEST_ASSERT(!!range);
+    TEST_CHECK_INT_EQUAL(range->memory.size, page);
+    TEST_CHECK(memory_range_is(dump, dump_size, range, 0, page, 0x44));
+
+    sentry_free(dump);
+#else
+    SKIP_TEST();
+#endif
+}
+
+/**
+ * Test that the buffered minidump writer puts every record at its RVA:
+ * staged records, records too large for the buffer, bulk ranges written
+ * after staged data, and the header and directory, and that the file is
+ * truncated to the written size after the preallocation.
+ */
+SENTRY_TEST(minidump_buffered_writer)
+{
+#if defined(SENTRY_BACKEND_NATIVE)                                             \
+    && (defined(SENTRY_PLATFORM_LINUX) || defined(SENTRY_PLATFORM_ANDROID))
+    const char *dump_path = SENTRY_TEST_PATH_PREFIX ".buffered.dmp";
+    const size_t large_size = 300 * 1024 + 1;
+    uint8_t *large = sentry_malloc(large_size);
+    TEST_ASSERT(!!large);
+    memset(large, 0xbb, large_size);
+    uint8_t small[10];
+    memset(small, 0xaa, sizeof(small));
+    uint8_t bulk[8];
+    memset(bulk, 0xcc, sizeof(bulk));
+
+    minidump_writer_base_t writer = { 0 };
+    writer.fd = open(dump_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    TEST_ASSERT(writer.fd >= 0);
+    writer.current_offset
+        = sizeof(minidump_header_t) + 2 * sizeof(minidump_directory_t);
+
+    const uint64_t size_hint = 1024 * 1024;
+    TEST_CHECK(sentry__minidump_buffer_begin(&writer, size_hint) == 0);
+    TEST_ASSERT(!!writer.buffer);
+    struct stat st;
+    TEST_CHECK(fstat(writer.fd, &st) == 0);
+    TEST_CHECK((uint64_t)st.st_size == size_hint);
+
+    minidump_rva_t small_rva
+        = sentry__minidump_write_data(&writer, small, sizeof(small));
+    minidump_rva_t large_rva
+        = sentry__minidump_write_data(&writer, large, large_size);
+    minidump_rva_t staged_rva
+        = sentry__minidump_write_data(&writer, small, sizeof(small));
+    TEST_CHECK(small_rva != 0);
+    TEST_CHECK_INT_EQUAL(large_rva, small_rva + 12);
+    TEST_CHECK_INT_EQUAL(staged_rva, large_rva + large_size + 3);
+
+    // the bulk write goes out after the staged record before it, and is not
+    // padded by the writer
+    minidump_rva_t bulk_rva = (minidump_rva_t)writer.current_offset;
+    struct iovec iov[2] = {
+        { bulk, 5 },
+        { bulk + 5, 3 },
+    };
+    TEST_CHECK(sentry__minidump_write_iov(&writer, iov, 2) == 0);
+    TEST_CHECK_INT_EQUAL(bulk_rva, staged_rva + 12);
+    minidump_rva_t last_rva
+        = sentry__minidump_write_data(&writer, small, sizeof(small));
+    TEST_CHECK_INT_EQUAL(last_rva, bulk_rva + 8);
+    uint64_t end = writer.current_offset;
+    TEST_CHECK(end == (uint64_t)last_rva + 12);
+
+    TEST_CHECK(sentry__minidump_buffer_end(&writer) == 0);
+    TEST_CHECK(!writer.buffer);
+    minidump_directory_t dirs[2] = {
+        { MINIDUMP_STREAM_SYSTEM_INFO, sizeof(small), small_rva },
+        { MINIDUMP_STREAM_MEMORY_LIST, sizeof(bulk), bulk_rva },
+    };
+    TEST_CHECK(sentry__minidump_write_directory(&writer, dirs, 2) == 0);
+    TEST_CHECK(fstat(writer.fd, &st) == 0);
+    TEST_CHECK((uint64_t)st.st_size == end);
+    close(writer.fd);
+
+    sentry_path_t *path = sentry__path_from_str(dump_path);
+    size_t dump_size = 0;
+    uint8_t *dump = (uint8_t *)sentry__path_read_to_buffer(path, &dump_size);
+    sentry__path_remove(path);
+    sentry__path_free(path);
+    TEST_ASSERT(!!dump);
+    TEST_ASSERT(dump_size == end);
+
+    minidump_header_t header;
+    memcpy(&header, dump, sizeof(header));
+    TEST_CHECK(header.signature == MINIDUMP_SIGNATURE);
+    TEST_CHECK_INT_EQUAL(header.stream_count, 2);
+    TEST_CHECK_INT_EQUAL(header.stream_directory_rva, sizeof(header));
+    TEST_CHECK(memcmp(dump + sizeof(header), dirs, sizeof(dirs)) == 0);
+
+    static const uint8_t zeros[4] = { 0 };
+    TEST_CHECK(memcmp(dump + small_rva, small, sizeof(small)) == 0);
+    TEST_CHECK(memcmp(dump + small_rva + sizeof(small), zeros, 2) == 0);
+    TEST_CHECK(memcmp(dump + large_rva, large, large_size) == 0);
+    TEST_CHECK(memcmp(dump + large_rva + large_size, zeros, 3) == 0);
+    TEST_CHECK(memcmp(dump + staged_rva, small, sizeof(small)) == 0);
+    TEST_CHECK(memcmp(dump + bulk_rva, bulk, sizeof(bulk)) == 0);
+    TEST_CHECK(memcmp(dump + last_rva, small, sizeof(small)) == 0);
+
+    sentry_free(dump);
+    sentry_free(large);
+#else
+    SKIP_TEST();
+#endif
+}
@@ -1,3 +1,4 @@
+#include "sentry_batcher.h"
 #include "sentry_options.h"
 #include "sentry_testsupport.h"
 
@@ -86,6 +87,22 @@ SENTRY_TEST(options_crash_reporting_mode_default)
     sentry_options_free(options);
 }
 
+SENTRY_TEST(options_crash_daemon_shared)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+
+    // Every process starts its own daemon by default
+    TEST_CHECK_INT_EQUAL(sentry_options_get_crash_daemon_shared(options), 0);
+
+    sentry_options_set_crash_daemon_shared(options, 42);
+    TEST_CHECK_INT_EQUAL(sentry_options_get_crash_daemon_shared(options), 1);
+
+    sentry_options_set_crash_daemon_shared(options, 0);
+    TEST_CHECK_INT_EQUAL(sentry_options_get_crash_daemon_shared(options), 0);
+
+    sentry_options_free(options);
+}
+
 SENTRY_TEST(options_crash_reporting_mode_set_get)
 {
     SENTRY_TEST_OPTIONS_NEW(options);
@@ -127,3 +144,36 @@ SENTRY_TEST(options_crash_reporting_mode_clamp)
 
     sentry_options_free(options);
 }
+
+SENTRY_TEST(options_batch_defaults)
+{
+    sentry_options_t *options = sentry_options_new();
+    TEST_ASSERT(!!options);
+
+    TEST_CHECK_INT_EQUAL(
+        sentry_options_get_batch_capacity(options), SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_CHECK_INT_EQUAL(
+        sentry_options_get_batch_max_bytes(options), SENTRY_BATCHER_MAX_BYTES);
+    TEST_CHECK_INT_EQUAL(sentry_options_get_batch_flush_interval(options),
+        SENTRY_BATCHER_FLUSH_INTERVAL_MS);
+    TEST_CHECK(!sentry_options_get_batch_adaptive(options));
+
+    sentry_options_set_batch_capacity(options, 1000);
+    sentry_options_set_batch_max_bytes(options, 0);
+    sentry_options_set_batch_flush_interval(options, 100);
+    sentry_options_set_batch_adaptive(options, 42);
+    TEST_CHECK_INT_EQUAL(sentry_options_get_batch_capacity(options), 1000);
+    TEST_CHECK_INT_EQUAL(sentry_options_get_batch_max_bytes(options), 0);
+    TEST_CHECK_INT_EQUAL(sentry_options_get_batch_flush_interval(options), 100);
+    TEST_CHECK(sentry_options_get_batch_adaptive(options) == 1);
+
+    // 0 restores the defaults
+    sentry_options_set_batch_capacity(options, 0);
+    sentry_options_set_batch_flush_interval(options, 0);
+    TEST_CHECK_INT_EQUAL(
+        sentry_options_get_batch_capacity(options), SENTRY_BATCHER_QUEUE_LENGTH);
+    TEST_CHECK_INT_EQUAL(sentry_options_get_batch_flush_interval(options),
+        SENTRY_BATCHER_FLUSH_INTERVAL_MS);
+
+    sentry_options_free(options);
+}
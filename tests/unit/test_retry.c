@@ -54,7 +54,7 @@ find_envelope_attempt(const sentry_path_t *dir)
 }
 
 static void
-write_retry_file(const sentry_run_t *run, uint64_t timestamp, int retry_count,
+write_retry_file(sentry_run_t *run, uint64_t timestamp, int retry_count,
     const sentry_uuid_t *event_id)
 {
     sentry_envelope_t *envelope = sentry__envelope_new();
@@ -67,15 +67,78 @@ write_retry_file(const sentry_run_t *run, uint64_t timestamp, int retry_count,
     sentry_path_t *path
         = sentry__run_make_cache_path(run, timestamp, retry_count, uuid);
     (void)sentry_envelope_write_to_path(envelope, path);
+    sentry__run_journal_retry(run, path);
     sentry__path_free(path);
     sentry_envelope_free(envelope);
 }
 
+static int
+count_envelope_attempts(const sentry_path_t *dir, int attempt)
+{
+    int count = 0;
+    sentry_pathiter_t *iter = sentry__path_iter_directory(dir);
+    const sentry_path_t *file;
+    while (iter && (file = sentry__pathiter_next(iter)) != NULL) {
+        uint64_t ts;
+        int file_attempt;
+        const char *uuid;
+        if (sentry__parse_cache_filename(
+                sentry__path_filename(file), &ts, &file_attempt, &uuid)
+            && file_attempt == attempt) {
+            count++;
+        }
+    }
+    sentry__pathiter_free(iter);
+    return count;
+}
+
+static void
+write_session_retry_file(sentry_run_t *run, uint64_t timestamp)
+{
+    sentry_session_t *session = NULL;
+    SENTRY_WITH_SCOPE (scope) {
+        session = sentry__session_new(scope);
+    }
+    sentry_envelope_t *envelope = sentry__envelope_new();
+    sentry__envelope_add_session(envelope, session);
+
+    sentry_uuid_t id = sentry_uuid_new_v4();
+    char uuid[37];
+    sentry_uuid_as_string(&id, uuid);
+
+    sentry_path_t *path = sentry__run_make_cache_path(run, timestamp, 0, uuid);
+    TEST_CHECK_INT_EQUAL(sentry_envelope_write_to_path(envelope, path), 0);
+    sentry__run_journal_retry(run, path);
+    sentry__path_free(path);
+    sentry_envelope_free(envelope);
+    sentry__session_free(session);
+}
+
 typedef struct {
     int status_code;
     size_t count;
 } retry_test_ctx_t;
 
+typedef struct {
+    int status_code;
+    size_t calls;
+    size_t requests;
+    size_t items;
+} retry_batch_ctx_t;
+
+static void
+test_send_batch_cb(sentry_envelope_t **envelopes, int *status_codes,
+    size_t count, void *_ctx)
+{
+    retry_batch_ctx_t *ctx = _ctx;
+    ctx->calls++;
+    for (size_t i = 0; i < count; i++) {
+        ctx->requests++;
+        ctx->items += sentry__envelope_get_item_count(envelopes[i]);
+        status_codes[i] = ctx->status_code;
+    }
+}
+
 static int
 test_send_cb(sentry_envelope_t *envelope, void *_ctx)
 {
@@ -333,6 +396,245 @@ SENTRY_TEST(retry_restore_report)
     sentry_close();
 }
 
+SENTRY_TEST(retry_index)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_http_retry(options, false);
+    sentry_init(options);
+
+    sentry_retry_t *retry = sentry__retry_new(options);
+    TEST_ASSERT(!!retry);
+
+    const sentry_path_t *cache_path = options->run->cache_path;
+    sentry__path_remove_all(cache_path);
+    sentry__path_create_dir_all(cache_path);
+
+    uint64_t old_ts
+        = sentry__usec_time() / 1000 - 10 * sentry__retry_backoff(0);
+    sentry_uuid_t event_id = sentry_uuid_new_v4();
+    write_retry_file(options->run, old_ts, 0, &event_id);
+
+    // the first poll starts the journal, which then lists the pending file
+    retry_test_ctx_t ctx = { -1, 0 };
+    TEST_CHECK_INT_EQUAL(sentry__retry_send(retry, 0, test_send_cb, &ctx), 1);
+    TEST_CHECK_INT_EQUAL(ctx.count, 1);
+    TEST_CHECK(sentry__path_is_file(options->run->retry_journal_path));
+    TEST_CHECK_INT_EQUAL(find_envelope_attempt(cache_path), 1);
+
+    // a file that bypasses the journal is not picked up by a poll, because
+    // polls don't rescan the cache directory
+    sentry_envelope_t *envelope = sentry__envelope_new();
+    sentry_uuid_t unjournaled_id = sentry_uuid_new_v4();
+    sentry__envelope_add_event(
+        envelope, sentry__value_new_event_with_id(&unjournaled_id));
+    char uuid[37];
+    sentry_uuid_as_string(&unjournaled_id, uuid);
+    sentry_path_t *unjournaled
+        = sentry__run_make_cache_path(options->run, old_ts, 0, uuid);
+    TEST_CHECK_INT_EQUAL(
+        sentry_envelope_write_to_path(envelope, unjournaled), 0);
+    sentry_envelope_free(envelope);
+
+    ctx = (retry_test_ctx_t) { 200, 0 };
+    TEST_CHECK_INT_EQUAL(sentry__retry_send(retry, 0, test_send_cb, &ctx), 1);
+    TEST_CHECK_INT_EQUAL(ctx.count, 0);
+    TEST_CHECK(sentry__path_is_file(unjournaled));
+
+    // a new index restores the pending file from the journal
+    sentry__retry_free(retry);
+    retry = sentry__retry_new(options);
+    TEST_ASSERT(!!retry);
+    ctx = (retry_test_ctx_t) { 200, 0 };
+    TEST_CHECK_INT_EQUAL(
+        sentry__retry_send(retry, UINT64_MAX, test_send_cb, &ctx), 0);
+    TEST_CHECK_INT_EQUAL(ctx.count, 1);
+    TEST_CHECK(sentry__path_is_file(unjournaled));
+
+    // without a journal, the index is rebuilt from the cache directory
+    sentry__path_remove(options->run->retry_journal_path);
+    ctx = (retry_test_ctx_t) { 200, 0 };
+    TEST_CHECK_INT_EQUAL(sentry__retry_send(retry, 0, test_send_cb, &ctx), 0);
+    TEST_CHECK_INT_EQUAL(ctx.count, 1);
+    TEST_CHECK(!sentry__path_is_file(unjournaled));
+    TEST_CHECK_INT_EQUAL(count_envelope_files(cache_path), 0);
+
+    sentry__path_free(unjournaled);
+    sentry__retry_free(retry);
+    sentry_close();
+}
+
+SENTRY_TEST(retry_journal_duplicates)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_http_retry(options, false);
+    sentry_init(options);
+
+    sentry_retry_t *retry = sentry__retry_new(options);
+    TEST_ASSERT(!!retry);
+
+    const sentry_path_t *cache_path = options->run->cache_path;
+    sentry__path_remove_all(cache_path);
+    sentry__path_create_dir_all(cache_path);
+
+    // a file that is not due yet, listed again after the journal started,
+    // as a record that was appended while the journal was rebuilt would be
+    uint64_t now = sentry__usec_time() / 1000;
+    sentry_uuid_t event_id = sentry_uuid_new_v4();
+    write_retry_file(options->run, now, 0, &event_id);
+    retry_test_ctx_t ctx = { 200, 0 };
+    TEST_CHECK_INT_EQUAL(sentry__retry_send(retry, 0, test_send_cb, &ctx), 1);
+    TEST_CHECK_INT_EQUAL(ctx.count, 0);
+
+    char uuid[37];
+    sentry_uuid_as_string(&event_id, uuid);
+    sentry_path_t *path
+        = sentry__run_make_cache_path(options->run, now, 0, uuid);
+    sentry__run_journal_retry(options->run, path);
+    sentry__path_free(path);
+
+    ctx = (retry_test_ctx_t) { 200, 0 };
+    TEST_CHECK_INT_EQUAL(
+        sentry__retry_send(retry, UINT64_MAX, test_send_cb, &ctx), 0);
+    TEST_CHECK_INT_EQUAL(ctx.count, 1);
+    TEST_CHECK_INT_EQUAL(count_envelope_files(cache_path), 0);
+
+    // an index that restores a journal with duplicates sends them once
+    event_id = sentry_uuid_new_v4();
+    write_retry_file(options->run, now, 0, &event_id);
+    sentry_uuid_as_string(&event_id, uuid);
+    path = sentry__run_make_cache_path(options->run, now, 0, uuid);
+    sentry__run_journal_retry(options->run, path);
+    sentry__path_free(path);
+
+    sentry__retry_free(retry);
+    retry = sentry__retry_new(options);
+    TEST_ASSERT(!!retry);
+    ctx = (retry_test_ctx_t) { 200, 0 };
+    TEST_CHECK_INT_EQUAL(
+        sentry__retry_send(retry, UINT64_MAX, test_send_cb, &ctx), 0);
+    TEST_CHECK_INT_EQUAL(ctx.count, 1);
+    TEST_CHECK_INT_EQUAL(count_envelope_files(cache_path), 0);
+
+    sentry__retry_free(retry);
+    sentry_close();
+}
+
+typedef struct {
+    sentry_run_t *run;
+    const sentry_path_t *path;
+} journal_thread_ctx_t;
+
+SENTRY_THREAD_FN
+journal_thread_func(void *data)
+{
+    journal_thread_ctx_t *ctx = data;
+    sentry__run_journal_retry(ctx->run, ctx->path);
+    return 0;
+}
+
+SENTRY_TEST(retry_journal_lock)
+{
+#ifndef SENTRY_PLATFORM_UNIX
+    SKIP_TEST();
+#else
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_http_retry(options, false);
+    sentry_init(options);
+
+    sentry_run_t *run = options->run;
+    sentry__path_remove_all(run->cache_path);
+    sentry__path_create_dir_all(run->cache_path);
+
+    // another process that holds the journal lock, e.g. while rewriting it
+    sentry_filelock_t *lock = sentry__filelock_new(
+        sentry__path_append_str(run->retry_journal_path, ".lock"));
+    TEST_ASSERT(!!lock);
+    TEST_ASSERT(sentry__filelock_lock(lock));
+
+    sentry_path_t *path = sentry__path_join_str(run->cache_path, "a.envelope");
+    journal_thread_ctx_t ctx = { run, path };
+    sentry_threadid_t thread;
+    sentry__thread_init(&thread);
+    TEST_ASSERT(
+        sentry__thread_spawn(&thread, journal_thread_func, &ctx) == 0);
+
+    // the append waits for the lock to be released
+    sleep_ms(100);
+    TEST_CHECK(!sentry__path_is_file(run->retry_journal_path));
+    sentry__filelock_unlock(lock);
+    sentry__thread_join(thread);
+    sentry__thread_free(&thread);
+
+    size_t size = 0;
+    char *contents
+        = sentry__path_read_to_buffer(run->retry_journal_path, &size);
+    TEST_CHECK_STRING_EQUAL(contents, "a.envelope\n");
+    sentry_free(contents);
+
+    sentry__filelock_free(lock);
+    sentry__path_free(path);
+    sentry_close();
+#endif
+}
+
+SENTRY_TEST(retry_batch)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_dsn(options, "https://foo@sentry.invalid/42");
+    sentry_options_set_release(options, "test@1.0.0");
+    sentry_options_set_http_retry(options, false);
+    sentry_init(options);
+
+    sentry_retry_t *retry = sentry__retry_new(options);
+    TEST_ASSERT(!!retry);
+
+    const sentry_path_t *cache_path = options->run->cache_path;
+    sentry__path_remove_all(cache_path);
+    sentry__path_create_dir_all(cache_path);
+
+    uint64_t old_ts
+        = sentry__usec_time() / 1000 - 10 * sentry__retry_backoff(0);
+    sentry_uuid_t event_id = sentry_uuid_new_v4();
+    write_retry_file(options->run, old_ts - 1, 0, &event_id);
+    for (int i = 0; i < 4; i++) {
+        write_session_retry_file(options->run, old_ts);
+    }
+    TEST_CHECK_INT_EQUAL(count_envelope_files(cache_path), 5);
+
+    // the sessions are combined into one request, which is sent concurrently
+    // with the one of the event; every file is bumped on network failure
+    retry_batch_ctx_t ctx = { -1, 0, 0, 0 };
+    size_t remaining
+        = sentry__retry_send_batch(retry, 0, test_send_batch_cb, 2, &ctx);
+    TEST_CHECK_INT_EQUAL(remaining, 5);
+    TEST_CHECK_INT_EQUAL(ctx.calls, 1);
+    TEST_CHECK_INT_EQUAL(ctx.requests, 2);
+    TEST_CHECK_INT_EQUAL(ctx.items, 5);
+    TEST_CHECK_INT_EQUAL(count_envelope_attempts(cache_path, 1), 5);
+
+    // without concurrency, the groups are sent one after another
+    sentry__path_remove_all(cache_path);
+    sentry__path_create_dir_all(cache_path);
+    write_retry_file(options->run, old_ts - 1, 0, &event_id);
+    for (int i = 0; i < 4; i++) {
+        write_session_retry_file(options->run, old_ts);
+    }
+    ctx = (retry_batch_ctx_t) { 200, 0, 0, 0 };
+    remaining = sentry__retry_send_batch(
+        retry, UINT64_MAX, test_send_batch_cb, 1, &ctx);
+    TEST_CHECK_INT_EQUAL(remaining, 0);
+    TEST_CHECK_INT_EQUAL(ctx.calls, 2);
+    TEST_CHECK_INT_EQUAL(ctx.requests, 2);
+    TEST_CHECK_INT_EQUAL(ctx.items, 5);
+    TEST_CHECK_INT_EQUAL(count_envelope_files(cache_path), 0);
+
+    sentry__retry_free(retry);
+    sentry_close();
+}
+
 SENTRY_TEST(retry_session)
 {
     SENTRY_TEST_OPTIONS_NEW(options);
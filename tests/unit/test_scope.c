@@ -1009,3 +1009,106 @@ SENTRY_TEST(scope_local_attributes)
 
     sentry_close();
 }
+
+SENTRY_TEST(scope_attributes_snapshot)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_options_set_environment(options, "test-env");
+    sentry_init(options);
+
+    sentry_set_attribute("key",
+        sentry_value_new_attribute(sentry_value_new_string("first"), NULL));
+
+    // unmodified scopes share the same snapshot
+    sentry_scope_attributes_t *snapshot = sentry__scope_get_attributes();
+    sentry_scope_attributes_t *same = sentry__scope_get_attributes();
+    TEST_ASSERT(!!snapshot);
+    TEST_CHECK(snapshot == same);
+    sentry__scope_attributes_decref(same);
+
+    // read-only access doesn't invalidate the snapshot
+    SENTRY_WITH_SCOPE (scope) {
+        (void)scope;
+    }
+    same = sentry__scope_get_attributes();
+    TEST_CHECK(snapshot == same);
+    sentry__scope_attributes_decref(same);
+
+    // a modification publishes a new snapshot, old ones stay valid
+    sentry_set_attribute("key",
+        sentry_value_new_attribute(sentry_value_new_string("second"), NULL));
+    sentry_scope_attributes_t *updated = sentry__scope_get_attributes();
+    TEST_ASSERT(!!updated);
+    TEST_CHECK(snapshot != updated);
+    TEST_CHECK(updated->version > snapshot->version);
+
+    sentry_value_t telemetry = sentry_value_new_object();
+    sentry_value_t attributes = sentry_value_new_object();
+    sentry__scope_attributes_apply(snapshot, telemetry, attributes);
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(
+            sentry_value_get_by_key(attributes, "key"), "value")),
+        "first");
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(
+            sentry_value_get_by_key(attributes, "sentry.environment"),
+            "value")),
+        "test-env");
+    TEST_CHECK(
+        !sentry_value_is_null(sentry_value_get_by_key(telemetry, "trace_id")));
+    sentry_value_decref(attributes);
+
+    // custom attributes take precedence over the scope attributes
+    attributes = sentry_value_new_object();
+    sentry_value_set_by_key(attributes, "key",
+        sentry_value_new_attribute(sentry_value_new_string("custom"), NULL));
+    sentry__scope_attributes_apply(updated, telemetry, attributes);
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(
+            sentry_value_get_by_key(attributes, "key"), "value")),
+        "custom");
+    sentry_value_decref(attributes);
+    sentry_value_decref(telemetry);
+
+    sentry__scope_attributes_decref(updated);
+    sentry__scope_attributes_decref(snapshot);
+    sentry_close();
+}
+
+SENTRY_TEST(scope_attributes_snapshot_copy)
+{
+    SENTRY_TEST_OPTIONS_NEW(options);
+    sentry_init(options);
+
+    sentry_set_attribute("key",
+        sentry_value_new_attribute(sentry_value_new_string("scope"), NULL));
+    sentry_scope_attributes_t *snapshot = sentry__scope_get_attributes();
+    TEST_ASSERT(!!snapshot);
+
+    // a hook that modifies the attributes of one record
+    sentry_value_t telemetry = sentry_value_new_object();
+    sentry_value_t attributes = sentry_value_new_object();
+    sentry__scope_attributes_apply(snapshot, telemetry, attributes);
+    sentry_value_t attribute = sentry_value_get_by_key(attributes, "key");
+    TEST_CHECK_INT_EQUAL(sentry_value_set_by_key(attribute, "value",
+                             sentry_value_new_string("modified")),
+        0);
+    sentry_value_decref(attributes);
+
+    // affects neither the snapshot nor the other records
+    attributes = sentry_value_new_object();
+    sentry__scope_attributes_apply(snapshot, telemetry, attributes);
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(
+            sentry_value_get_by_key(attributes, "key"), "value")),
+        "scope");
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_key(
+            sentry_value_get_by_key(snapshot->attributes, "key"), "value")),
+        "scope");
+    sentry_value_decref(attributes);
+    sentry_value_decref(telemetry);
+
+    sentry__scope_attributes_decref(snapshot);
+    sentry_close();
+}
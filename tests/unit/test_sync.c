@@ -580,3 +580,184 @@ SENTRY_TEST(bgworker_delayed_shutdown)
 
     sentry__bgworker_decref(bgw);
 }
+
+SENTRY_TEST(bgworker_task_priority)
+{
+    struct order_state os;
+    os.count = 0;
+
+    sentry_bgworker_t *bgw = sentry__bgworker_new(&os, NULL);
+    TEST_ASSERT(!!bgw);
+
+    uint64_t base = sentry__monotonic_time();
+    sentry__bgworker_submit_prioritized(bgw, record_order_task, NULL,
+        (void *)1, base, SENTRY_TASK_PRIORITY_LOW);
+    sentry__bgworker_submit_prioritized(bgw, record_order_task, NULL,
+        (void *)2, base, SENTRY_TASK_PRIORITY_NORMAL);
+    sentry__bgworker_submit_prioritized(bgw, record_order_task, NULL,
+        (void *)3, base, SENTRY_TASK_PRIORITY_HIGH);
+    sentry__bgworker_submit_prioritized(bgw, record_order_task, NULL,
+        (void *)4, base, SENTRY_TASK_PRIORITY_NORMAL);
+    sentry__bgworker_submit_prioritized(bgw, record_order_task, NULL,
+        (void *)5, base, SENTRY_TASK_PRIORITY_HIGH);
+    // delayed tasks wait for their turn regardless of priority
+    sentry__bgworker_submit_prioritized(bgw, record_order_task, NULL,
+        (void *)6, base + 50, SENTRY_TASK_PRIORITY_HIGH);
+
+    sentry__bgworker_start(bgw);
+    // the flush waits for all tasks that are due, even low priority ones
+    TEST_CHECK_INT_EQUAL(sentry__bgworker_flush(bgw, 5000), 0);
+
+    TEST_CHECK_INT_EQUAL(os.count, 6);
+    TEST_CHECK_INT_EQUAL(os.order[0], 3);
+    TEST_CHECK_INT_EQUAL(os.order[1], 5);
+    TEST_CHECK_INT_EQUAL(os.order[2], 2);
+    TEST_CHECK_INT_EQUAL(os.order[3], 4);
+    TEST_CHECK_INT_EQUAL(os.order[4], 1);
+    TEST_CHECK_INT_EQUAL(os.order[5], 6);
+
+    TEST_CHECK_INT_EQUAL(sentry__bgworker_shutdown(bgw, 1000), 0);
+    sentry__bgworker_decref(bgw);
+}
+
+static struct order_state shed_order;
+static int cleaned_up;
+
+static void
+record_shed_task(void *data, void *UNUSED(state))
+{
+    shed_order.order[shed_order.count++] = (int)(size_t)data;
+}
+
+static void
+count_cleanup(void *UNUSED(data))
+{
+    cleaned_up++;
+}
+
+SENTRY_TEST(bgworker_try_submit)
+{
+    struct order_state os;
+    os.count = 0;
+    shed_order.count = 0;
+    cleaned_up = 0;
+
+    sentry_bgworker_t *bgw = sentry__bgworker_new(&os, NULL);
+    TEST_ASSERT(!!bgw);
+    sentry__bgworker_set_capacity(bgw, 3, record_shed_task);
+
+    TEST_CHECK_INT_EQUAL(
+        sentry__bgworker_try_submit(bgw, record_order_task, count_cleanup,
+            (void *)1, SENTRY_TASK_PRIORITY_LOW),
+        0);
+    TEST_CHECK_INT_EQUAL(
+        sentry__bgworker_try_submit(bgw, record_order_task, count_cleanup,
+            (void *)2, SENTRY_TASK_PRIORITY_LOW),
+        0);
+    TEST_CHECK_INT_EQUAL(
+        sentry__bgworker_try_submit(bgw, record_order_task, count_cleanup,
+            (void *)3, SENTRY_TASK_PRIORITY_NORMAL),
+        0);
+    // unbounded tasks don't count against the capacity
+    sentry__bgworker_submit(bgw, record_order_task, count_cleanup, (void *)4);
+
+    // the queue is full, and there is nothing with a lower priority to shed
+    TEST_CHECK_INT_EQUAL(
+        sentry__bgworker_try_submit(bgw, record_order_task, count_cleanup,
+            (void *)5, SENTRY_TASK_PRIORITY_LOW),
+        1);
+    // the most recent of the lowest priority tasks makes room
+    TEST_CHECK_INT_EQUAL(
+        sentry__bgworker_try_submit(bgw, record_order_task, count_cleanup,
+            (void *)6, SENTRY_TASK_PRIORITY_HIGH),
+        0);
+    TEST_CHECK_INT_EQUAL(
+        sentry__bgworker_try_submit(bgw, record_order_task, count_cleanup,
+            (void *)7, SENTRY_TASK_PRIORITY_HIGH),
+        0);
+    TEST_CHECK_INT_EQUAL(shed_order.count, 3);
+    TEST_CHECK_INT_EQUAL(shed_order.order[0], 5);
+    TEST_CHECK_INT_EQUAL(shed_order.order[1], 2);
+    TEST_CHECK_INT_EQUAL(shed_order.order[2], 1);
+    TEST_CHECK_INT_EQUAL(cleaned_up, 3);
+
+    sentry__bgworker_start(bgw);
+    TEST_CHECK_INT_EQUAL(sentry__bgworker_flush(bgw, 5000), 0);
+
+    TEST_CHECK_INT_EQUAL(os.count, 4);
+    TEST_CHECK_INT_EQUAL(os.order[0], 6);
+    TEST_CHECK_INT_EQUAL(os.order[1], 7);
+    TEST_CHECK_INT_EQUAL(os.order[2], 3);
+    TEST_CHECK_INT_EQUAL(os.order[3], 4);
+
+    TEST_CHECK_INT_EQUAL(sentry__bgworker_shutdown(bgw, 1000), 0);
+    sentry__bgworker_decref(bgw);
+    TEST_CHECK_INT_EQUAL(cleaned_up, 7);
+}
+
+#define SUBMIT_THREADS 8
+#define SUBMIT_PER_THREAD 2000
+
+struct submit_state {
+    long last_seq[SUBMIT_THREADS];
+    long executed;
+    long out_of_order;
+};
+
+static void
+record_submit_task(void *data, void *_state)
+{
+    struct submit_state *state = _state;
+    size_t thread = (size_t)data / SUBMIT_PER_THREAD;
+    long seq = (long)((size_t)data % SUBMIT_PER_THREAD);
+    if (seq <= state->last_seq[thread]) {
+        state->out_of_order++;
+    }
+    state->last_seq[thread] = seq;
+    state->executed++;
+}
+
+static sentry_bgworker_t *g_submit_bgw;
+
+SENTRY_THREAD_FN
+submit_thread_func(void *data)
+{
+    size_t thread = (size_t)data;
+    for (size_t i = 0; i < SUBMIT_PER_THREAD; i++) {
+        sentry__bgworker_submit(g_submit_bgw, record_submit_task, NULL,
+            (void *)(thread * SUBMIT_PER_THREAD + i));
+    }
+    return 0;
+}
+
+SENTRY_TEST(bgworker_concurrent_submit)
+{
+    struct submit_state state;
+    memset(&state, 0, sizeof(state));
+    for (size_t i = 0; i < SUBMIT_THREADS; i++) {
+        state.last_seq[i] = -1;
+    }
+
+    g_submit_bgw = sentry__bgworker_new(&state, NULL);
+    TEST_ASSERT(!!g_submit_bgw);
+    sentry__bgworker_start(g_submit_bgw);
+
+    sentry_threadid_t threads[SUBMIT_THREADS];
+    for (size_t i = 0; i < SUBMIT_THREADS; i++) {
+        sentry__thread_init(&threads[i]);
+        sentry__thread_spawn(&threads[i], submit_thread_func, (void *)i);
+    }
+    for (size_t i = 0; i < SUBMIT_THREADS; i++) {
+        sentry__thread_join(threads[i]);
+        sentry__thread_free(&threads[i]);
+    }
+
+    TEST_CHECK_INT_EQUAL(sentry__bgworker_flush(g_submit_bgw, 5000), 0);
+    // every task ran exactly once, in the order of its producer
+    TEST_CHECK_INT_EQUAL(state.executed, SUBMIT_THREADS * SUBMIT_PER_THREAD);
+    TEST_CHECK_INT_EQUAL(state.out_of_order, 0);
+
+    TEST_CHECK_INT_EQUAL(sentry__bgworker_shutdown(g_submit_bgw, 1000), 0);
+    sentry__bgworker_decref(g_submit_bgw);
+    g_submit_bgw = NULL;
+}
@@ -1,7 +1,13 @@
 #include "sentry_testsupport.h"
 
+#include "sentry_random.h"
 #include "sentry_uuid.h"
 
+#ifdef SENTRY_PLATFORM_LINUX
+#    include <sys/wait.h>
+#    include <unistd.h>
+#endif
+
 SENTRY_TEST(uuid_api)
 {
     sentry_uuid_t uuid
@@ -28,6 +34,51 @@ SENTRY_TEST(uuid_v4)
     }
 }
 
+SENTRY_TEST(uuid_v4_bulk)
+{
+    sentry_uuid_t uuids[64];
+    sentry__uuids_new_v4(uuids, 64);
+    for (size_t i = 0; i < 64; i++) {
+        TEST_CHECK(!sentry_uuid_is_nil(&uuids[i]));
+        TEST_CHECK(uuids[i].bytes[6] >> 4 == 4);
+        for (size_t j = 0; j < i; j++) {
+            TEST_CHECK(memcmp(&uuids[i], &uuids[j], sizeof(uuids[i])) != 0);
+        }
+    }
+}
+
+SENTRY_TEST(getrandom_after_fork)
+{
+#ifndef SENTRY_PLATFORM_LINUX
+    SKIP_TEST();
+#else
+    // seed this thread's generator before forking
+    uint64_t rnd;
+    TEST_ASSERT(!sentry__getrandom(&rnd, sizeof(rnd)));
+
+    int fds[2];
+    TEST_ASSERT(pipe(fds) == 0);
+    pid_t pid = fork();
+    TEST_ASSERT(pid >= 0);
+    if (pid == 0) {
+        uint64_t child = 0;
+        sentry__getrandom(&child, sizeof(child));
+        _exit(write(fds[1], &child, sizeof(child)) == sizeof(child) ? 0 : 1);
+    }
+    close(fds[1]);
+    uint64_t child = 0;
+    TEST_CHECK(read(fds[0], &child, sizeof(child)) == sizeof(child));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    // the child must not repeat the bytes its parent produces next
+    TEST_ASSERT(!sentry__getrandom(&rnd, sizeof(rnd)));
+    TEST_CHECK(child != 0);
+    TEST_CHECK(child != rnd);
+#endif
+}
+
 SENTRY_TEST(internal_uuid_api)
 {
     sentry_uuid_t uuid
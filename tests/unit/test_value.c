@@ -1,6 +1,7 @@
 #include "sentry_json.h"
 #include "sentry_testsupport.h"
 #include "sentry_value.h"
+#include <float.h>
 #include <locale.h>
 #include <math.h>
 #include <stdint.h>
@@ -345,6 +346,300 @@ SENTRY_TEST(value_object)
     sentry_value_decref(val);
 }
 
+SENTRY_TEST(value_object_large)
+{
+    // large enough to use the hashed key index
+    const int count = 1000;
+    sentry_value_t val = sentry_value_new_object();
+    for (int i = 0; i < count; i++) {
+        char key[100];
+        snprintf(key, sizeof(key), "key%d", i);
+        sentry_value_set_by_key(val, key, sentry_value_new_int32(i));
+    }
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(val), count);
+    for (int i = 0; i < 2 * count; i++) {
+        char key[100];
+        snprintf(key, sizeof(key), "key%d", i);
+        sentry_value_t child = sentry_value_get_by_key(val, key);
+        if (i < count) {
+            TEST_CHECK_INT_EQUAL(sentry_value_as_int32(child), i);
+        } else {
+            TEST_CHECK(sentry_value_is_null(child));
+        }
+    }
+
+    // replacing keeps the position, removing shifts the following keys
+    sentry_value_set_by_key(val, "key1", sentry_value_new_int32(-1));
+    for (int i = 0; i < count; i += 2) {
+        char key[100];
+        snprintf(key, sizeof(key), "key%d", i);
+        TEST_CHECK_INT_EQUAL(sentry_value_remove_by_key(val, key), 0);
+    }
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(val), count / 2);
+    TEST_CHECK_INT_EQUAL(
+        sentry_value_as_int32(sentry_value_get_by_key(val, "key1")), -1);
+    for (int i = 3; i < count; i += 2) {
+        char key[100];
+        snprintf(key, sizeof(key), "key%d", i);
+        TEST_CHECK_INT_EQUAL(
+            sentry_value_as_int32(sentry_value_get_by_key(val, key)), i);
+    }
+    TEST_CHECK(sentry_value_is_null(sentry_value_get_by_key(val, "key0")));
+
+    // the insertion order is kept for serialization
+    sentry_value_t small = sentry_value_new_object();
+    for (int i = 0; i < 30; i++) {
+        char key[100];
+        snprintf(key, sizeof(key), "k%d", 29 - i);
+        sentry_value_set_by_key(small, key, sentry_value_new_int32(i));
+    }
+    for (int i = 0; i < 25; i++) {
+        char key[100];
+        snprintf(key, sizeof(key), "k%d", i);
+        sentry_value_remove_by_key(small, key);
+    }
+    sentry_value_set_by_key(small, "k29", sentry_value_new_int32(-1));
+    TEST_CHECK_JSON_VALUE(
+        small, "{\"k29\":-1,\"k28\":1,\"k27\":2,\"k26\":3,\"k25\":4}");
+    sentry_value_decref(small);
+
+    sentry_value_t clone = sentry__value_clone(val);
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(clone), count / 2);
+    TEST_CHECK_INT_EQUAL(
+        sentry_value_as_int32(sentry_value_get_by_key(clone, "key999")), 999);
+    sentry_value_decref(clone);
+    sentry_value_decref(val);
+}
+
+SENTRY_TEST(value_object_interned_keys)
+{
+    size_t count = 0;
+    const char *const *keys = sentry__value_interned_keys(&count);
+    TEST_CHECK(count > 0);
+    for (size_t i = 0; i < count; i++) {
+        TEST_CHECK(i == 0 || strcmp(keys[i - 1], keys[i]) < 0);
+        TEST_CHECK(
+            sentry__value_intern_key(keys[i], strlen(keys[i])) == keys[i]);
+    }
+
+    const char *type = sentry__value_intern_key("type", 4);
+    TEST_CHECK(type && strcmp(type, "type") == 0);
+    TEST_CHECK(sentry__value_intern_key("typ", 3) == NULL);
+    TEST_CHECK(sentry__value_intern_key("types", 5) == NULL);
+    TEST_CHECK(sentry__value_intern_key("types", 4) == type);
+    TEST_CHECK(sentry__value_intern_key("not-a-key", 9) == NULL);
+    // a suffix of an interned key is not interned itself
+    const char *user_email = sentry__value_intern_key("user.email", 10);
+    TEST_CHECK(user_email != NULL);
+    TEST_CHECK(sentry__value_intern_key(user_email + 5, 5)
+        == sentry__value_intern_key("email", 5));
+
+    // interned and owned keys behave the same
+    sentry_value_t val = sentry_value_new_object();
+    char owned[] = "value";
+    sentry_value_set_by_key(val, "custom", sentry_value_new_int32(1));
+    sentry_value_set_by_key(val, "type", sentry_value_new_int32(2));
+    sentry_value_set_by_key(val, owned, sentry_value_new_int32(3));
+    sentry_value_set_by_key_n(val, "level-x", 5, sentry_value_new_int32(4));
+    memcpy(owned, "unit", 5);
+    sentry_value_set_by_key(val, type, sentry_value_new_int32(5));
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(val), 4);
+    TEST_CHECK_INT_EQUAL(
+        sentry_value_as_int32(sentry_value_get_by_key(val, "type")), 5);
+    TEST_CHECK_INT_EQUAL(
+        sentry_value_as_int32(sentry_value_get_by_key(val, "value")), 3);
+    TEST_CHECK_INT_EQUAL(
+        sentry_value_as_int32(sentry_value_get_by_key_n(val, "levels", 5)),
+        4);
+    TEST_CHECK(sentry_value_is_null(sentry_value_get_by_key(val, owned)));
+    // lookups resolve copies of interned keys to them
+    char type_copy[] = "type";
+    TEST_CHECK_INT_EQUAL(
+        sentry_value_as_int32(sentry_value_get_by_key(val, type_copy)), 5);
+    TEST_CHECK_JSON_VALUE(
+        val, "{\"custom\":1,\"type\":5,\"value\":3,\"level\":4}");
+
+    sentry_value_t clone = sentry__value_clone(val);
+    TEST_CHECK_INT_EQUAL(sentry_value_remove_by_key(clone, type), 0);
+    TEST_CHECK_INT_EQUAL(sentry_value_remove_by_key(clone, "custom"), 0);
+    TEST_CHECK_INT_EQUAL(sentry_value_remove_by_key(clone, "type"), 1);
+    TEST_CHECK_JSON_VALUE(clone, "{\"value\":3,\"level\":4}");
+    sentry_value_decref(clone);
+    sentry_value_decref(val);
+}
+
+SENTRY_TEST(value_arena)
+{
+    sentry_value_t outside = sentry_value_new_object();
+    TEST_CHECK(!sentry__value_is_arena_allocated(outside));
+
+    sentry_value_arena_t *arena = sentry__value_arena_begin();
+    TEST_ASSERT(!!arena);
+    sentry_value_t obj = sentry_value_new_object();
+    sentry_value_t list = sentry__value_new_list_with_size(2);
+    for (int i = 0; i < 40; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "key%d", i);
+        sentry_value_set_by_key(obj, key, sentry_value_new_int32(i));
+        sentry_value_append(list, sentry_value_new_string(key));
+    }
+    sentry_value_t num = sentry_value_new_double(1e300);
+    sentry_value_set_by_key(obj, "num", num);
+    sentry_value_set_by_key(obj, "list", list);
+    // values that outlive the scope keep the arena alive
+    sentry_value_t escaped = sentry_value_new_string("escaped");
+    sentry_value_set_by_key(outside, "escaped", escaped);
+    // values from outside of the arena keep growing on the heap
+    sentry_value_set_by_key(outside, "custom", sentry_value_new_int32(1));
+
+    // nested arenas are independent of each other
+    sentry_value_arena_t *inner = sentry__value_arena_begin();
+    TEST_ASSERT(!!inner);
+    sentry_value_t nested = sentry_value_new_list();
+    sentry__value_arena_end(inner);
+    sentry_value_append(nested, sentry_value_new_string("nested"));
+    sentry_value_set_by_key(obj, "nested", nested);
+
+    sentry__value_arena_end(arena);
+
+    TEST_CHECK(sentry__value_is_arena_allocated(obj));
+    TEST_CHECK(sentry__value_is_arena_allocated(list));
+    TEST_CHECK(sentry__value_is_arena_allocated(num));
+    TEST_CHECK(sentry__value_is_arena_allocated(
+        sentry_value_get_by_index(list, 39)));
+    TEST_CHECK(!sentry__value_is_arena_allocated(outside));
+
+    // values stay regular values after the scope has ended
+    for (int i = 40; i < 80; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "key%d", i);
+        sentry_value_set_by_key(obj, key, sentry_value_new_int32(i));
+    }
+    TEST_CHECK_INT_EQUAL(sentry_value_remove_by_key(obj, "key0"), 0);
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(obj), 82);
+    TEST_CHECK_INT_EQUAL(
+        sentry_value_as_int32(sentry_value_get_by_key(obj, "key79")), 79);
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(list), 40);
+    TEST_CHECK_STRING_EQUAL(
+        sentry_value_as_string(sentry_value_get_by_index(list, 39)), "key39");
+    TEST_CHECK(sentry_value_as_double(num) == 1e300);
+    TEST_CHECK_JSON_VALUE(nested, "[\"nested\"]");
+
+    sentry_value_t clone = sentry__value_clone(obj);
+    TEST_CHECK(!sentry__value_is_arena_allocated(clone));
+    sentry_value_freeze(obj);
+    TEST_CHECK(sentry_value_is_frozen(list));
+    sentry_value_decref(obj);
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(clone), 82);
+    sentry_value_decref(clone);
+
+    TEST_CHECK_JSON_VALUE(outside, "{\"escaped\":\"escaped\",\"custom\":1}");
+    sentry_value_decref(outside);
+
+    // ending a failed arena is a no-op
+    sentry__value_arena_end(NULL);
+}
+
+SENTRY_TEST(value_arena_outlives_record)
+{
+    sentry_value_arena_t *arena = sentry__value_arena_begin();
+    TEST_ASSERT(!!arena);
+    sentry_value_t record = sentry_value_new_object();
+    sentry_value_t attributes = sentry_value_new_object();
+    sentry_value_t items = sentry_value_new_list();
+    sentry_value_set_by_key(attributes, "items", items);
+    sentry_value_set_by_key(record, "attributes", attributes);
+    sentry_value_set_by_key(
+        record, "body", sentry_value_new_string("the record"));
+    sentry__value_arena_end(arena);
+
+    // e.g. a hook that holds on to a part of the record
+    sentry_value_incref(attributes);
+    sentry_value_decref(record);
+    TEST_CHECK(sentry__value_is_arena_allocated(items));
+
+    // growing after the scope frees the buffers that are replaced
+    for (int i = 0; i < 1000; i++) {
+        sentry_value_append(items, sentry_value_new_int32(i));
+    }
+    TEST_CHECK_INT_EQUAL(sentry__value_arena_foreign_chunks(items), 1);
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(items), 1000);
+    TEST_CHECK_INT_EQUAL(
+        sentry_value_as_int32(sentry_value_get_by_index(items, 999)), 999);
+
+    sentry_value_decref(attributes);
+}
+
+SENTRY_TEST(value_inline_scalars)
+{
+    const double doubles[] = { 0.0, -0.0, 1.5, -2.25, 0.1, 1718000000.123456,
+        1e-200, 1e300, DBL_MAX, -DBL_MIN, INFINITY, -INFINITY };
+    for (size_t i = 0; i < sizeof(doubles) / sizeof(doubles[0]); i++) {
+        sentry_value_t val = sentry_value_new_double(doubles[i]);
+        TEST_CHECK(sentry_value_get_type(val) == SENTRY_VALUE_TYPE_DOUBLE);
+        const double rv = sentry_value_as_double(val);
+        TEST_CHECK(memcmp(&rv, &doubles[i], sizeof(rv)) == 0);
+        TEST_MSG("%g", doubles[i]);
+        sentry_value_decref(val);
+    }
+    sentry_value_t nan = sentry_value_new_double(NAN);
+    TEST_CHECK(isnan(sentry_value_as_double(nan)));
+    sentry_value_decref(nan);
+
+    const int64_t limit = (int64_t)1 << 58;
+    const int64_t int64s[] = { 0, -1, limit - 1, limit, -limit, -limit - 1,
+        INT64_MIN, INT64_MAX };
+    for (size_t i = 0; i < sizeof(int64s) / sizeof(int64s[0]); i++) {
+        sentry_value_t val = sentry_value_new_int64(int64s[i]);
+        TEST_CHECK(sentry_value_get_type(val) == SENTRY_VALUE_TYPE_INT64);
+        TEST_CHECK(sentry_value_as_int64(val) == int64s[i]);
+        TEST_CHECK(sentry_value_as_int32(val) == 0);
+        TEST_CHECK(isnan(sentry_value_as_double(val)));
+        sentry_value_decref(val);
+    }
+
+    const uint64_t uint64s[]
+        = { 0, 1, ((uint64_t)1 << 59) - 1, (uint64_t)1 << 59, UINT64_MAX };
+    for (size_t i = 0; i < sizeof(uint64s) / sizeof(uint64s[0]); i++) {
+        sentry_value_t val = sentry_value_new_uint64(uint64s[i]);
+        TEST_CHECK(sentry_value_get_type(val) == SENTRY_VALUE_TYPE_UINT64);
+        TEST_CHECK(sentry_value_as_uint64(val) == uint64s[i]);
+        TEST_CHECK(sentry_value_as_int64(val) == 0);
+        sentry_value_decref(val);
+    }
+
+    // common strings share a static table, everything else is allocated
+    sentry_value_t info = sentry_value_new_string("info");
+    sentry_value_t empty = sentry_value_new_string("");
+    sentry_value_t other = sentry_value_new_string("inform");
+    TEST_CHECK(sentry_value_get_type(info) == SENTRY_VALUE_TYPE_STRING);
+    TEST_CHECK(sentry_value_get_type(empty) == SENTRY_VALUE_TYPE_STRING);
+    TEST_CHECK(sentry_value_as_string(info)
+        == sentry_value_as_string(sentry_value_new_string("info")));
+    sentry_value_t other2 = sentry_value_new_string("inform");
+    TEST_CHECK(sentry_value_as_string(other) != sentry_value_as_string(other2));
+    sentry_value_decref(other2);
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(info), 4);
+    TEST_CHECK_INT_EQUAL(sentry_value_get_length(empty), 0);
+    TEST_CHECK(sentry_value_is_true(info));
+    TEST_CHECK(!sentry_value_is_true(empty));
+
+    sentry_value_t obj = sentry_value_new_object();
+    sentry_value_set_by_key(obj, "level", info);
+    sentry_value_set_by_key(obj, "message", empty);
+    sentry_value_set_by_key(obj, "other", other);
+    sentry_value_set_by_key(obj, "ts", sentry_value_new_double(1.5));
+    sentry_value_set_by_key(obj, "n", sentry_value_new_int64(-42));
+    sentry_value_set_by_key(obj, "u", sentry_value_new_uint64(42));
+    sentry_value_t clone = sentry__value_clone(obj);
+    sentry_value_freeze(clone);
+    TEST_CHECK_JSON_VALUE(clone,
+        "{\"level\":\"info\",\"message\":\"\",\"other\":\"inform\","
+        "\"ts\":1.5,\"n\":-42,\"u\":42}");
+    sentry_value_decref(clone);
+    sentry_value_decref(obj);
+}
+
 SENTRY_TEST(value_object_merge)
 {
     sentry_value_t dst = sentry_value_new_object();